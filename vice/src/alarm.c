@@ -112,6 +112,10 @@ static void alarm_init(alarm_t *alarm, alarm_context_t *context,
 
     alarm->pending_idx = -1;      /* Not pending.  */
 
+#ifdef FEATURE_PERFCOUNTERS
+    alarm->perf = perfcounters_named_get(PERFCOUNTERS_KIND_ALARM, name);
+#endif
+
     /* Add to the head of the alarm list of the alarm context.  */
     if (context->alarms == NULL) {
         context->alarms = alarm;
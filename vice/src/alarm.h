@@ -28,6 +28,7 @@
 #ifndef VICE_ALARM_H
 #define VICE_ALARM_H
 
+#include "perfcounters.h"
 #include "types.h"
 
 #define ALARM_CONTEXT_MAX_PENDING_ALARMS 0x100
@@ -54,6 +55,11 @@ struct alarm_s {
 
     /* Link to the next and previous alarms in the list.  */
     struct alarm_s *next, *prev;
+
+#ifdef FEATURE_PERFCOUNTERS
+    /* Dispatch counter, shared by all alarms with the same name.  */
+    perfcounters_named_t *perf;
+#endif
 };
 typedef struct alarm_s alarm_t;
 
@@ -140,6 +146,8 @@ inline static void alarm_context_dispatch(alarm_context_t *context,
     idx = context->next_pending_alarm_idx;
     alarm = context->pending_alarms[idx].alarm;
 
+    PERFCOUNTERS_NAMED_INC(alarm->perf, 0);
+
     (alarm->callback)(offset, alarm->data);
 }
 
@@ -172,7 +172,7 @@ static void on_widget_realized(GtkWidget *widget, gpointer data)
         ShowWindow(context->window, SW_SHOW);
     }
 
-    context->render_queue = render_queue_create();
+    context->render_queue = render_queue_create(canvas);
     context->render_bg_colour.a = 1.0f;
 
     /* Create an exclusive single thread 'pool' for executing render jobs */
@@ -263,6 +263,22 @@ static void vice_directx_update_context(video_canvas_t *canvas, unsigned int wid
     CANVAS_UNLOCK();
 }
 
+/** \brief Finish the colour conversions deferred to the render thread */
+static void vice_directx_complete_conversions(video_canvas_t *canvas)
+{
+    void *render_queue = NULL;
+
+    CANVAS_LOCK();
+    if (canvas->renderer_context) {
+        render_queue = ((context_t *)canvas->renderer_context)->render_queue;
+    }
+    CANVAS_UNLOCK();
+
+    if (render_queue) {
+        render_queue_complete_conversions(render_queue, canvas);
+    }
+}
+
 /** \brief It's time to draw a complete emulated frame */
 static void vice_directx_refresh_rect(video_canvas_t *canvas,
                                      unsigned int xs, unsigned int ys,
@@ -272,6 +288,10 @@ static void vice_directx_refresh_rect(video_canvas_t *canvas,
     context_t *context;
     backbuffer_t *backbuffer;
     int pixel_data_size_bytes;
+    tick_t frame_tick = tick_now();
+
+    /* Frames still being converted use the render config we may be about to change */
+    vice_directx_complete_conversions(canvas);
 
     CANVAS_LOCK();
 
@@ -281,6 +301,10 @@ static void vice_directx_refresh_rect(video_canvas_t *canvas,
         return;
     }
 
+    render_queue_configure(context->render_queue,
+                           canvas->videoconfig->render_queue_depth,
+                           canvas->videoconfig->present_mode);
+
     /* Obtain an unused backbuffer to render to */
     pixel_data_size_bytes = context->emulated_width_next * context->emulated_height_next * 4;
     backbuffer = render_queue_get_from_pool(context->render_queue, pixel_data_size_bytes);
@@ -290,6 +314,8 @@ static void vice_directx_refresh_rect(video_canvas_t *canvas,
         return;
     }
 
+    backbuffer->frame_tick = frame_tick;
+
     backbuffer->width = context->emulated_width_next;
     backbuffer->height = context->emulated_height_next;
     backbuffer->pixel_aspect_ratio = context->pixel_aspect_ratio_next;
@@ -298,7 +324,12 @@ static void vice_directx_refresh_rect(video_canvas_t *canvas,
 
     CANVAS_UNLOCK();
 
-    video_canvas_render(canvas, backbuffer->pixel_data, w, h, xs, ys, xi, yi, backbuffer->width * 4);
+    if (canvas->videoconfig->threaded_render) {
+        /* Leave the colour conversion to the render thread */
+        render_queue_prepare_conversion(backbuffer, canvas, xs, ys, xi, yi, w, h);
+    } else {
+        video_canvas_render(canvas, backbuffer->pixel_data, w, h, xs, ys, xi, yi, backbuffer->width * 4);
+    }
 
     CANVAS_LOCK();
     render_queue_enqueue_for_display(context->render_queue, backbuffer);
@@ -349,7 +380,8 @@ vice_renderer_backend_t vice_directx_backend = {
     vice_directx_destroy_context,
     vice_directx_refresh_rect,
     vice_directx_on_ui_frame_clock,
-    vice_directx_set_palette
+    vice_directx_set_palette,
+    vice_directx_complete_conversions
 };
 
 #endif
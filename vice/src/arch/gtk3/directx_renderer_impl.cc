@@ -502,6 +502,8 @@ void vice_directx_impl_async_render(void *job_data, void *pool_data)
     video_canvas_t *canvas = (video_canvas_t *)pool_data;
     vice_directx_renderer_context_t *context = (vice_directx_renderer_context_t *)canvas->renderer_context;
     backbuffer_t *backbuffer;
+    bool new_frame = false;
+    tick_t frame_tick = 0;
     HRESULT result = S_OK;
     bool interlaced;
     int vsync = canvas->videoconfig->vsync;
@@ -526,6 +528,15 @@ void vice_directx_impl_async_render(void *job_data, void *pool_data)
 
     CANVAS_LOCK();
 
+    backbuffer = render_queue_dequeue_for_display(context->render_queue);
+
+    if (backbuffer && backbuffer->conversion != BACKBUFFER_CONVERSION_NONE) {
+        /* Convert outside of the canvas lock so the emulation can continue */
+        CANVAS_UNLOCK();
+        render_queue_convert(context->render_queue, canvas, backbuffer);
+        CANVAS_LOCK();
+    }
+
     if (context->resized) {
         destroy_size_dependent_resources(context);
         context->resized = false;
@@ -538,9 +549,10 @@ void vice_directx_impl_async_render(void *job_data, void *pool_data)
      * especially when the monitor is open and stepping through code.
      */
 
-    backbuffer = render_queue_dequeue_for_display(context->render_queue);
     if (backbuffer) {
         build_render_bitmap(context, backbuffer);
+        new_frame = true;
+        frame_tick = backbuffer->frame_tick;
         render_queue_return_to_pool(context->render_queue, backbuffer);
     }
 
@@ -616,6 +628,9 @@ void vice_directx_impl_async_render(void *job_data, void *pool_data)
         destroy_device_dependent_resources(context);
     } else {
         context->d3d_swap_chain->Present1(vsync ? 1 : 0, 0, &present_parameters);
+        if (new_frame) {
+            video_latency_presented(canvas, frame_tick);
+        }
     }
 
     RENDER_UNLOCK();
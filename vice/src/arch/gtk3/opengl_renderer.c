@@ -130,7 +130,7 @@ static void vice_opengl_initialise_canvas(video_canvas_t *canvas)
 
     context->canvas_lock_ptr = &canvas->lock;
     pthread_mutex_init(&context->render_lock, NULL);
-    context->render_queue = render_queue_create();
+    context->render_queue = render_queue_create(canvas);
 
     canvas->renderer_context = context;
 
@@ -326,6 +326,22 @@ static void vice_opengl_update_context(video_canvas_t *canvas, unsigned int widt
     CANVAS_UNLOCK();
 }
 
+/** \brief Finish the colour conversions deferred to the render thread */
+static void vice_opengl_complete_conversions(video_canvas_t *canvas)
+{
+    void *render_queue = NULL;
+
+    CANVAS_LOCK();
+    if (canvas->renderer_context) {
+        render_queue = ((context_t *)canvas->renderer_context)->render_queue;
+    }
+    CANVAS_UNLOCK();
+
+    if (render_queue) {
+        render_queue_complete_conversions(render_queue, canvas);
+    }
+}
+
 /** \brief It's time to draw a complete emulated frame */
 static void vice_opengl_refresh_rect(video_canvas_t *canvas,
                                      unsigned int xs, unsigned int ys,
@@ -335,6 +351,10 @@ static void vice_opengl_refresh_rect(video_canvas_t *canvas,
     context_t *context;
     backbuffer_t *backbuffer;
     int pixel_data_size_bytes;
+    tick_t frame_tick = tick_now();
+
+    /* Frames still being converted use the render config we may be about to change */
+    vice_opengl_complete_conversions(canvas);
 
     CANVAS_LOCK();
 
@@ -344,6 +364,10 @@ static void vice_opengl_refresh_rect(video_canvas_t *canvas,
         return;
     }
 
+    render_queue_configure(context->render_queue,
+                           canvas->videoconfig->render_queue_depth,
+                           canvas->videoconfig->present_mode);
+
     /* Obtain an unused backbuffer to render to */
     pixel_data_size_bytes = context->emulated_width_next * context->emulated_height_next * 4;
     backbuffer = render_queue_get_from_pool(context->render_queue, pixel_data_size_bytes);
@@ -353,6 +377,8 @@ static void vice_opengl_refresh_rect(video_canvas_t *canvas,
         return;
     }
 
+    backbuffer->frame_tick = frame_tick;
+
     backbuffer->width = context->emulated_width_next;
     backbuffer->height = context->emulated_height_next;
     backbuffer->pixel_aspect_ratio = context->pixel_aspect_ratio_next;
@@ -361,7 +387,12 @@ static void vice_opengl_refresh_rect(video_canvas_t *canvas,
 
     CANVAS_UNLOCK();
 
-    video_canvas_render(canvas, backbuffer->pixel_data, w, h, xs, ys, xi, yi, backbuffer->width * 4);
+    if (canvas->videoconfig->threaded_render) {
+        /* Leave the colour conversion to the render thread */
+        render_queue_prepare_conversion(backbuffer, canvas, xs, ys, xi, yi, w, h);
+    } else {
+        video_canvas_render(canvas, backbuffer->pixel_data, w, h, xs, ys, xi, yi, backbuffer->width * 4);
+    }
 
     CANVAS_LOCK();
     if (context->render_thread) {
@@ -690,6 +721,8 @@ static void render(void *job_data, void *pool_data)
     video_canvas_t *canvas = pool_data;
     vice_opengl_renderer_context_t *context = (vice_opengl_renderer_context_t *)canvas->renderer_context;
     backbuffer_t *backbuffer;
+    bool new_frame = false;
+    tick_t frame_tick = 0;
     int vsync = 1;
     float scale_x = 1.0f;
     float scale_y = 1.0f;
@@ -726,6 +759,13 @@ static void render(void *job_data, void *pool_data)
         return;
     }
 
+    if (backbuffer && backbuffer->conversion != BACKBUFFER_CONVERSION_NONE) {
+        /* Convert outside of the canvas lock so the emulation can continue */
+        CANVAS_UNLOCK();
+        render_queue_convert(context->render_queue, canvas, backbuffer);
+        CANVAS_LOCK();
+    }
+
     RENDER_LOCK();
 
     vice_opengl_renderer_make_current(context);
@@ -733,6 +773,8 @@ static void render(void *job_data, void *pool_data)
     if (backbuffer) {
         /* Upload the frame(s) to the GPU and then return it */
         update_frame_textures(context, backbuffer);
+        new_frame = true;
+        frame_tick = backbuffer->frame_tick;
         render_queue_return_to_pool(context->render_queue, backbuffer);
     }
 
@@ -804,6 +846,10 @@ static void render(void *job_data, void *pool_data)
     vice_opengl_renderer_present_backbuffer(context);
     glFinish();
 
+    if (new_frame) {
+        video_latency_presented(canvas, frame_tick);
+    }
+
     vice_opengl_renderer_clear_current(context);
 
     RENDER_UNLOCK();
@@ -973,5 +1019,6 @@ vice_renderer_backend_t vice_opengl_backend = {
     vice_opengl_destroy_context,
     vice_opengl_refresh_rect,
     vice_opengl_on_ui_frame_clock,
-    vice_opengl_set_palette
+    vice_opengl_set_palette,
+    vice_opengl_complete_conversions
 };
@@ -33,6 +33,8 @@
 #include <string.h>
 
 #include "lib.h"
+#include "video.h"
+#include "videoarch.h"
 #include "vsyncapi.h"
 
 #define LOCK() pthread_mutex_lock(&rq->lock)
@@ -58,23 +60,92 @@ typedef struct vice_render_queue_s {
 
     /** Allows discarding of late buffer returns */
     unsigned int backbuffer_generation;
+
+    /** How many backbuffers are in BACKBUFFER_CONVERSION_RUNNING state */
+    unsigned int conversions_running;
+
+    /** Signalled whenever a conversion finishes */
+    pthread_cond_t conversion_cond;
+
+    /** How many backbuffers may be out of the pool, see render_queue_configure() */
+    unsigned int depth;
+
+    /** VIDEO_PRESENT_MODE_QUEUE or VIDEO_PRESENT_MODE_LATEST */
+    int present_mode;
+
+    /** The canvas displaying the frames, for the latency statistics */
+    struct video_canvas_s *canvas;
 } render_queue_t;
 
 static void free_backbuffer(backbuffer_t *backbuffer) {
     lib_free(backbuffer->pixel_data);
+    lib_free(backbuffer->source_data);
     lib_free(backbuffer);
 }
 
+/* Must be called with the lock held */
+static void conversion_finished(render_queue_t *rq, backbuffer_t *backbuffer)
+{
+    if (backbuffer->conversion == BACKBUFFER_CONVERSION_RUNNING) {
+        rq->conversions_running--;
+    }
+    backbuffer->conversion = BACKBUFFER_CONVERSION_NONE;
+    pthread_cond_broadcast(&rq->conversion_cond);
+}
+
+/*
+ * Take the oldest backbuffer out of the render queue, unless it is being
+ * converted. Must be called with the lock held.
+ */
+static backbuffer_t *drop_oldest(render_queue_t *rq)
+{
+    backbuffer_t *backbuffer;
+
+    if (!rq->render_queue_length) {
+        return NULL;
+    }
+
+    backbuffer = rq->render_queue[rq->render_queue_next];
+    if (backbuffer->conversion == BACKBUFFER_CONVERSION_RUNNING) {
+        return NULL;
+    }
+
+    rq->render_queue_next = (rq->render_queue_next + 1) % RENDER_QUEUE_MAX_BACKBUFFERS;
+    rq->render_queue_length--;
+
+    /* The frame will never be displayed, so don't bother converting it */
+    if (backbuffer->conversion != BACKBUFFER_CONVERSION_NONE) {
+        conversion_finished(rq, backbuffer);
+    }
+
+    return backbuffer;
+}
+
+static void convert_backbuffer(struct video_canvas_s *canvas, backbuffer_t *backbuffer)
+{
+    video_canvas_render_source(canvas,
+                               backbuffer->source_data, backbuffer->source_pitch,
+                               backbuffer->pixel_data,
+                               backbuffer->w, backbuffer->h,
+                               backbuffer->xs, backbuffer->ys,
+                               backbuffer->xi, backbuffer->yi,
+                               backbuffer->width * 4);
+}
+
 /****/
 
-/** \brief Allocate, initialise and return a new render queue. */
-void *render_queue_create(void)
+/** \brief Allocate, initialise and return a new render queue for a canvas. */
+void *render_queue_create(struct video_canvas_s *canvas)
 {
     render_queue_t *rq;
     backbuffer_t *bb;
 
     rq = lib_calloc(1, sizeof(render_queue_t));
     pthread_mutex_init(&rq->lock, NULL);
+    pthread_cond_init(&rq->conversion_cond, NULL);
+    rq->depth = VIDEO_RENDER_QUEUE_DEPTH_DEFAULT;
+    rq->present_mode = VIDEO_PRESENT_MODE_QUEUE;
+    rq->canvas = canvas;
 
     /* Seed the pool with the maximum number of backbuffers */
     for (int i = 0; i < RENDER_QUEUE_MAX_BACKBUFFERS; i++) {
@@ -85,6 +156,9 @@ void *render_queue_create(void)
         bb->width = 0;
         bb->height = 0;
         bb->pixel_aspect_ratio = 0.0f;
+        bb->conversion = BACKBUFFER_CONVERSION_NONE;
+        bb->source_data = lib_malloc(0);
+        bb->source_data_size_bytes = 0;
 
         rq->backbuffer_stack[rq->backbuffer_stack_size++] = bb;
     }
@@ -109,10 +183,35 @@ void render_queue_destroy(void *render_queue)
         rq->render_queue_next = rq->render_queue_next % RENDER_QUEUE_MAX_BACKBUFFERS;
     }
 
+    pthread_cond_destroy(&rq->conversion_cond);
     pthread_mutex_destroy(&rq->lock);
     lib_free(render_queue);
 }
 
+/** \brief Set the depth and present mode of a render queue
+ *
+ * \param render_queue  the render queue
+ * \param depth         how many backbuffers may be queued or displayed at once
+ * \param present_mode  VIDEO_PRESENT_MODE_QUEUE to display every queued
+ *                      frame, VIDEO_PRESENT_MODE_LATEST to only display the
+ *                      most recent one
+ */
+void render_queue_configure(void *render_queue, unsigned int depth, int present_mode)
+{
+    render_queue_t *rq = (render_queue_t *)render_queue;
+
+    if (depth < 1) {
+        depth = 1;
+    } else if (depth > RENDER_QUEUE_MAX_BACKBUFFERS) {
+        depth = RENDER_QUEUE_MAX_BACKBUFFERS;
+    }
+
+    LOCK();
+    rq->depth = depth;
+    rq->present_mode = present_mode;
+    UNLOCK();
+}
+
 /****/
 
 /** Obtain unused backbuffer for offscreen rendering, or NULL if none available */
@@ -123,15 +222,24 @@ backbuffer_t *render_queue_get_from_pool(void *render_queue, int pixel_data_size
 
     LOCK();
 
-    if (!rq->backbuffer_stack_size) {
-        /* no buffers available, skip this frame */
-        UNLOCK();
-        return NULL;
+    /* The backbuffers that are not in the pool are queued or being displayed */
+    if (!rq->backbuffer_stack_size
+        || RENDER_QUEUE_MAX_BACKBUFFERS - rq->backbuffer_stack_size >= rq->depth) {
+        bb = NULL;
+        if (rq->present_mode == VIDEO_PRESENT_MODE_LATEST) {
+            /* replace the oldest frame that is still waiting to be displayed */
+            bb = drop_oldest(rq);
+        }
+        if (!bb) {
+            /* no buffers available, skip this frame */
+            UNLOCK();
+            return NULL;
+        }
+    } else {
+        bb = rq->backbuffer_stack[rq->backbuffer_stack_size - 1];
+        rq->backbuffer_stack_size--;
     }
 
-    bb = rq->backbuffer_stack[rq->backbuffer_stack_size - 1];
-    rq->backbuffer_stack_size--;
-
     UNLOCK();
 
     /* Make sure there's at least the requested size in bytes */
@@ -144,6 +252,7 @@ backbuffer_t *render_queue_get_from_pool(void *render_queue, int pixel_data_size
     bb->width = 0;
     bb->height = 0;
     bb->pixel_aspect_ratio = 0.0f;
+    bb->conversion = BACKBUFFER_CONVERSION_NONE;
 
     return bb;
 }
@@ -152,6 +261,7 @@ backbuffer_t *render_queue_get_from_pool(void *render_queue, int pixel_data_size
 void render_queue_enqueue_for_display(void *render_queue, backbuffer_t *backbuffer)
 {
     render_queue_t *rq = (render_queue_t *)render_queue;
+    tick_t frame_tick = backbuffer->frame_tick;
 
     LOCK();
 
@@ -161,6 +271,8 @@ void render_queue_enqueue_for_display(void *render_queue, backbuffer_t *backbuff
     rq->render_queue_length++;
 
     UNLOCK();
+
+    video_latency_record(rq->canvas, VIDEO_LATENCY_QUEUED, frame_tick);
 }
 
 unsigned int render_queue_length(void *render_queue)
@@ -191,12 +303,36 @@ backbuffer_t *render_queue_dequeue_for_display(void *render_queue)
         return NULL;
     }
 
-    void *backbuffer = rq->render_queue[rq->render_queue_next];
+    /* Skip straight to the most recent frame */
+    if (rq->present_mode == VIDEO_PRESENT_MODE_LATEST) {
+        while (rq->render_queue_length > 1) {
+            backbuffer_t *stale = drop_oldest(rq);
+            if (!stale) {
+                break;
+            }
+            rq->backbuffer_stack[rq->backbuffer_stack_size++] = stale;
+        }
+    }
+
+    backbuffer_t *backbuffer = rq->render_queue[rq->render_queue_next];
     rq->render_queue_next = (rq->render_queue_next + 1) % RENDER_QUEUE_MAX_BACKBUFFERS;
     rq->render_queue_length--;
 
+    /* The emulation thread may be converting this one itself, see render_queue_complete_conversions() */
+    while (backbuffer->conversion == BACKBUFFER_CONVERSION_RUNNING) {
+        pthread_cond_wait(&rq->conversion_cond, &rq->lock);
+    }
+
+    /* The caller now owns the conversion, and must call render_queue_convert() or return it to the pool */
+    if (backbuffer->conversion == BACKBUFFER_CONVERSION_PENDING) {
+        backbuffer->conversion = BACKBUFFER_CONVERSION_RUNNING;
+        rq->conversions_running++;
+    }
+
     UNLOCK();
 
+    video_latency_record(rq->canvas, VIDEO_LATENCY_DEQUEUED, backbuffer->frame_tick);
+
     return backbuffer;
 }
 
@@ -208,8 +344,117 @@ void render_queue_return_to_pool(void *render_queue, backbuffer_t *backbuffer)
 
     assert(rq->backbuffer_stack_size < RENDER_QUEUE_MAX_BACKBUFFERS);
 
+    /* A skipped frame may never have been converted */
+    if (backbuffer->conversion != BACKBUFFER_CONVERSION_NONE) {
+        conversion_finished(rq, backbuffer);
+    }
+
     rq->backbuffer_stack[rq->backbuffer_stack_size] = backbuffer;
     rq->backbuffer_stack_size++;
 
     UNLOCK();
 }
+
+/****/
+
+/* Make sure a backbuffer can hold a draw buffer copy of the given size */
+static void alloc_source(backbuffer_t *backbuffer, unsigned int source_data_size_bytes)
+{
+    if (backbuffer->source_data_size_bytes < source_data_size_bytes) {
+        lib_free(backbuffer->source_data);
+        backbuffer->source_data = lib_malloc(source_data_size_bytes);
+        backbuffer->source_data_size_bytes = source_data_size_bytes;
+    }
+}
+
+/** \brief Fill a backbuffer with a copy of the draw buffer for deferred conversion
+ *
+ * Called on the emulation thread instead of video_canvas_render(), with the
+ * same arguments. The backbuffer must already have its width set.
+ */
+void render_queue_prepare_conversion(backbuffer_t *backbuffer, struct video_canvas_s *canvas,
+                                     unsigned int xs, unsigned int ys,
+                                     unsigned int xi, unsigned int yi,
+                                     unsigned int w, unsigned int h)
+{
+    video_canvas_render_prepare(canvas, w, h, xs, ys);
+
+    alloc_source(backbuffer, video_canvas_render_source_size(canvas));
+    video_canvas_render_copy_source(canvas, backbuffer->source_data);
+    backbuffer->source_pitch = canvas->draw_buffer->draw_buffer_width;
+
+    backbuffer->xs = xs;
+    backbuffer->ys = ys;
+    backbuffer->xi = xi;
+    backbuffer->yi = yi;
+    backbuffer->w = w;
+    backbuffer->h = h;
+    backbuffer->conversion = BACKBUFFER_CONVERSION_PENDING;
+}
+
+/** \brief Perform the deferred conversion of a dequeued backbuffer, if any
+ *
+ * The emulation thread can enqueue a backbuffer that only holds a copy of the
+ * draw buffer (BACKBUFFER_CONVERSION_PENDING), leaving the colour conversion
+ * to the render thread. Call this after render_queue_dequeue_for_display(),
+ * without holding the canvas lock.
+ */
+void render_queue_convert(void *render_queue, struct video_canvas_s *canvas, backbuffer_t *backbuffer)
+{
+    render_queue_t *rq = (render_queue_t *)render_queue;
+
+    if (backbuffer->conversion == BACKBUFFER_CONVERSION_NONE) {
+        return;
+    }
+
+    convert_backbuffer(canvas, backbuffer);
+
+    LOCK();
+    conversion_finished(rq, backbuffer);
+    UNLOCK();
+}
+
+/** \brief Finish all deferred conversions of a render queue
+ *
+ * Backbuffers still waiting in the queue are converted on the calling thread,
+ * then this blocks until the conversions running on other threads are done.
+ * Called by the emulation thread before it touches the render configuration
+ * of the canvas again. Must not be called with the canvas lock held.
+ */
+void render_queue_complete_conversions(void *render_queue, struct video_canvas_s *canvas)
+{
+    render_queue_t *rq = (render_queue_t *)render_queue;
+    backbuffer_t *bb;
+    unsigned int i;
+
+    LOCK();
+
+    for (;;) {
+        bb = NULL;
+        for (i = 0; i < rq->render_queue_length; i++) {
+            bb = rq->render_queue[(rq->render_queue_next + i) % RENDER_QUEUE_MAX_BACKBUFFERS];
+            if (bb->conversion == BACKBUFFER_CONVERSION_PENDING) {
+                break;
+            }
+            bb = NULL;
+        }
+        if (!bb) {
+            break;
+        }
+
+        bb->conversion = BACKBUFFER_CONVERSION_RUNNING;
+        rq->conversions_running++;
+        UNLOCK();
+
+        convert_backbuffer(canvas, bb);
+
+        LOCK();
+        conversion_finished(rq, bb);
+    }
+
+    while (rq->conversions_running) {
+        pthread_cond_wait(&rq->conversion_cond, &rq->lock);
+    }
+
+    UNLOCK();
+}
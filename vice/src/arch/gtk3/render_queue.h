@@ -27,10 +27,22 @@
 #ifndef VICE_RENDER_QUEUE_H
 #define VICE_RENDER_QUEUE_H
 
-#define RENDER_QUEUE_MAX_BACKBUFFERS 2
-
 #include <stdbool.h>
 
+#include "video.h"
+
+/** \brief Number of backbuffers per queue, the upper limit of <CHIP>RenderQueueDepth */
+#define RENDER_QUEUE_MAX_BACKBUFFERS VIDEO_RENDER_QUEUE_DEPTH_MAX
+
+struct video_canvas_s;
+
+/** \brief Colour conversion state of a backbuffer */
+typedef enum {
+    BACKBUFFER_CONVERSION_NONE,     /**< pixel_data holds the converted frame */
+    BACKBUFFER_CONVERSION_PENDING,  /**< source_data still needs converting */
+    BACKBUFFER_CONVERSION_RUNNING   /**< a thread is converting source_data */
+} backbuffer_conversion_t;
+
 typedef struct {
     bool interlaced;
     int interlace_field;
@@ -39,10 +51,21 @@ typedef struct {
     unsigned int width;
     unsigned int height;
     float pixel_aspect_ratio;
+
+    /** tick_now() when the emulated frame was complete, see video_latency_record() */
+    tick_t frame_tick;
+
+    /* Deferred conversion, see render_queue_convert() */
+    backbuffer_conversion_t conversion;
+    unsigned char *source_data;
+    unsigned int source_data_size_bytes;
+    int source_pitch;
+    unsigned int xs, ys, xi, yi, w, h;
 } backbuffer_t;
 
-void *render_queue_create(void);
+void *render_queue_create(struct video_canvas_s *canvas);
 void render_queue_destroy(void *render_queue);
+void render_queue_configure(void *render_queue, unsigned int depth, int present_mode);
 
 backbuffer_t *render_queue_get_from_pool(void *render_queue, int pixel_data_size_bytes);
 void render_queue_enqueue_for_display(void *render_queue, backbuffer_t *backbuffer);
@@ -50,4 +73,11 @@ unsigned int render_queue_length(void *render_queue);
 backbuffer_t *render_queue_dequeue_for_display(void *render_queue);
 void render_queue_return_to_pool(void *render_queue, backbuffer_t *backbuffer);
 
+void render_queue_prepare_conversion(backbuffer_t *backbuffer, struct video_canvas_s *canvas,
+                                     unsigned int xs, unsigned int ys,
+                                     unsigned int xi, unsigned int yi,
+                                     unsigned int w, unsigned int h);
+void render_queue_convert(void *render_queue, struct video_canvas_s *canvas, backbuffer_t *backbuffer);
+void render_queue_complete_conversions(void *render_queue, struct video_canvas_s *canvas);
+
 #endif /* #ifndef VICE_RENDER_QUEUE_H */
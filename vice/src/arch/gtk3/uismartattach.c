@@ -41,6 +41,7 @@
 #include "tape.h"
 #include "debug_gtk3.h"
 #include "contentpreviewwidget.h"
+#include "contentscache.h"
 #include "diskcontents.h"
 #include "diskimage.h"
 #include "driveimage.h"
@@ -499,6 +500,8 @@ static GtkWidget *create_extra_widget(GtkWidget *parent)
  *
  * First treats \a path as disk image file and when that fails it falls back
  * to treating \a path as a tape image, when that fails as well, it gives up.
+ * Both are looked up in the contents cache, so autostart can use the
+ * directory read here.
  *
  * \param[in]   path    path to image file
  *
@@ -509,10 +512,10 @@ static image_contents_t *read_contents_wrapper(const char *path)
     image_contents_t *content;
 
     /* try disk contents first */
-    content = diskcontents_filesystem_read(path);
+    content = contentscache_read(path, diskcontents_filesystem_read);
     if (content == NULL) {
         /* fall back to tape */
-        content = tapecontents_read(path);
+        content = contentscache_read(path, tapecontents_read);
     }
     return content;
 }
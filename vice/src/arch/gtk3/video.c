@@ -328,6 +328,24 @@ void video_canvas_refresh(struct video_canvas_s *canvas,
     }
 }
 
+/** \brief Finish the colour conversions deferred to the render threads
+ *
+ * Called on the emulation thread before the UI thread gets the mainlock,
+ * so the UI can safely change the render configuration of any canvas.
+ */
+void video_canvas_render_sync_all(void)
+{
+    int i;
+
+    for (i = PRIMARY_WINDOW; i <= SECONDARY_WINDOW; i++) {
+        video_canvas_t *canvas = ui_get_canvas_for_window(i);
+
+        if (canvas && canvas->renderer_backend) {
+            canvas->renderer_backend->complete_conversions(canvas);
+        }
+    }
+}
+
 /** \brief Update canvas size to match the draw buffer size requested
  *         by the emulation core.
  * \param canvas The video canvas to update.
@@ -413,5 +431,5 @@ int video_init(void)
 /** \brief Perform any frontend-specific uninitialization. */
 void video_shutdown(void)
 {
-    /* It's a no-op */
+    video_latency_log();
 }
@@ -152,6 +152,9 @@ typedef struct video_canvas_s {
 
     /** \brief Used to limit frame rate under warp. */
     tick_t warp_next_render_tick;
+
+    /** \brief Consecutive frames skipped because emulation was behind. */
+    int skipped_frames;
 } video_canvas_t;
 
 /** \brief Rescale and reposition the screen inside the canvas if the
@@ -220,6 +223,14 @@ typedef struct vice_renderer_backend_s {
      * \param canvas The canvas being initialized
      */
     void (*set_palette)(video_canvas_t *canvas);
+    /** \brief Finish any colour conversions deferred to the render thread.
+     *
+     * Called on the emulation thread before the render configuration
+     * of the canvas may change.
+     *
+     * \param canvas The canvas whose conversions are to be completed
+     */
+    void (*complete_conversions)(video_canvas_t *canvas);
 } vice_renderer_backend_t;
 
 #endif
@@ -32,6 +32,7 @@
 
 #include "basedialogs.h"
 #include "charset.h"
+#include "contentscache.h"
 #include "debug_gtk3.h"
 #include "imagecontents.h"
 #include "lib.h"
@@ -68,6 +69,38 @@ static GtkWidget *content_view = NULL;
 static GtkWidget *parent_dialog;
 
 
+/** \brief  ID of the pending contents request, 0 if none
+ */
+static unsigned int request_id = 0;
+
+
+/** \brief  Serial number of the image last set, to drop outdated contents
+ */
+static unsigned int request_serial = 0;
+
+
+/** \brief  Thread calling contentscache_request(), NULL otherwise
+ *
+ * Without a worker thread the contents are passed to the callback right
+ * away, on the calling thread. These end up in #request_contents and are
+ * shown immediately.
+ */
+static GThread *request_thread = NULL;
+
+
+/** \brief  Contents returned to #request_thread
+ */
+static image_contents_t *request_contents = NULL;
+
+
+/** \brief  Contents read in the background, passed on to the UI thread
+ */
+typedef struct preview_result_s {
+    unsigned int serial;        /**< value of #request_serial at request time */
+    image_contents_t *contents; /**< contents, or NULL on error */
+} preview_result_t;
+
+
 /** \brief  Handler for the "row-activated" event of the view
  *
  * This function handles auto-starting a file selected in the preview. It
@@ -122,15 +155,14 @@ static void on_row_activated(
  * '\<blocks\> "\<filename\>" \<filetype-and-flags\>' and an integer which indicates
  * the file's index in the image's "directory".
  *
- * \param[in]   path    path to image file
+ * \param[in]   contents    image contents, freed by this function
  *
- * \return  model (empty if reading the image failed)
+ * \return  model (with an error message if reading the image failed)
  */
-static GtkListStore *create_model(const char *path)
+static GtkListStore *create_model(image_contents_t *contents)
 {
     GtkListStore *model;
     GtkTreeIter iter;
-    image_contents_t *contents;
     image_contents_file_list_t *entry;
     char *tmp;
     char *sep;
@@ -139,21 +171,6 @@ static GtkListStore *create_model(const char *path)
     int blocks;
 
     model = gtk_list_store_new(2, G_TYPE_STRING, G_TYPE_INT);
-    if (path == NULL) {
-        return model;
-    }
-    /* don't try to read from a directory: avoid error messages from
-     * vdrive/fsimage */
-    if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
-        return model;
-    }
-
-    if (content_func == NULL) {
-        log_error(LOG_ERR, "no content-get function specified, bailing!");
-        return model;
-    }
-
-    contents = content_func(path);
     if (contents == NULL) {
         gtk_list_store_append(model, &iter);
         gtk_list_store_set(model, &iter,
@@ -222,22 +239,116 @@ static GtkListStore *create_model(const char *path)
 }
 
 
-/** \brief  Create the view for the content widget
+/** \brief  Create a model showing a single line of text
  *
- * Creates a GtkTreeView to display the contents of image \a path
+ * \param[in]   text    text to show, or NULL for an empty model
  *
- * \param[in]   path    path to image file
+ * \return  model
+ */
+static GtkListStore *create_text_model(const char *text)
+{
+    GtkListStore *model;
+    GtkTreeIter iter;
+
+    model = gtk_list_store_new(2, G_TYPE_STRING, G_TYPE_INT);
+    if (text != NULL) {
+        gtk_list_store_append(model, &iter);
+        gtk_list_store_set(model, &iter, 0, text, 1, -1, -1);
+    }
+    return model;
+}
+
+
+/** \brief  Replace the model of the view
+ *
+ * \param[in]   model   new model, the reference is taken over
+ */
+static void set_model(GtkListStore *model)
+{
+    if (content_view != NULL) {
+        gtk_tree_view_set_model(GTK_TREE_VIEW(content_view), GTK_TREE_MODEL(model));
+    }
+    g_object_unref(model);
+}
+
+
+/** \brief  Show contents read in the background
+ *
+ * Runs on the UI thread, contents of an image that isn't shown anymore are
+ * dropped.
+ *
+ * \param[in]   data    preview result
+ *
+ * \return  G_SOURCE_REMOVE
+ */
+static gboolean on_contents_idle(gpointer data)
+{
+    preview_result_t *result = data;
+
+    if (result->serial == request_serial && content_view != NULL) {
+        request_id = 0;
+        set_model(create_model(result->contents));
+    } else if (result->contents != NULL) {
+        image_contents_destroy(result->contents);
+    }
+    lib_free(result);
+    return G_SOURCE_REMOVE;
+}
+
+
+/** \brief  Callback for contentscache_request()
+ *
+ * Called on the worker thread, or right away if there is none.
+ *
+ * \param[in]   path        image file (unused)
+ * \param[in]   contents    image contents or NULL
+ * \param[in]   data        serial number of the request
+ */
+static void on_contents_read(const char *path, image_contents_t *contents, void *data)
+{
+    preview_result_t *result;
+
+    if (request_thread == g_thread_self()) {
+        request_contents = contents;
+        return;
+    }
+    result = lib_malloc(sizeof(preview_result_t));
+    result->serial = GPOINTER_TO_UINT(data);
+    result->contents = contents;
+    g_idle_add(on_contents_idle, result);
+}
+
+
+/** \brief  Handler for the "destroy" event of the view
+ *
+ * \param[in]   view    tree view
+ * \param[in]   data    extra event data (unused)
+ */
+static void on_view_destroy(GtkWidget *view, gpointer data)
+{
+    if (view == content_view) {
+        contentscache_cancel(request_id);
+        request_id = 0;
+        request_serial++;
+        content_view = NULL;
+    }
+}
+
+
+/** \brief  Create the view for the content widget
+ *
+ * Creates an empty GtkTreeView to display the contents of an image
  *
  * \return  GtkTreeView
  */
-static GtkWidget *create_view(const char *path)
+static GtkWidget *create_view(void)
 {
     GtkTreeView *view;
     GtkTreeViewColumn *column;
     GtkListStore *model;
     GtkCellRenderer *renderer;
 
-    model = create_model(path);
+    model = create_text_model(NULL);
 
     view = GTK_TREE_VIEW(gtk_tree_view_new_with_model(GTK_TREE_MODEL(model)));
     g_object_unref(model);
@@ -279,6 +390,7 @@ static GtkWidget *create_view(const char *path)
     gtk_widget_set_vexpand(GTK_WIDGET(view), TRUE);
 
     g_signal_connect(view, "row-activated", G_CALLBACK(on_row_activated), NULL);
+    g_signal_connect_unlocked(view, "destroy", G_CALLBACK(on_view_destroy), NULL);
 
     return GTK_WIDGET(view);
 }
@@ -327,7 +439,7 @@ GtkWidget *content_preview_widget_create(
 
     /* create scrolled window to contain the GktTreeView */
     scroll = gtk_scrolled_window_new(NULL, NULL);
-    content_view = create_view(NULL);
+    content_view = create_view();
     gtk_container_add(GTK_CONTAINER(scroll), content_view);
 
     /* set scrolled window properties */
@@ -347,18 +459,46 @@ GtkWidget *content_preview_widget_create(
 
 
 /** \brief  Set image file for the widget
+ *
+ * The contents are read in the background, unless they're cached already.
  *
  * \param[in,out]   widget  preview widget
  * \param[in]       path    path to image file
  */
 void content_preview_widget_set_image(GtkWidget *widget, const char *path)
 {
-    GtkListStore *model;
+    unsigned int id;
+
+    /* forget about the previous image */
+    contentscache_cancel(request_id);
+    request_id = 0;
+    request_serial++;
 
-    model = create_model(path);
-    gtk_tree_view_set_model(GTK_TREE_VIEW(content_view), GTK_TREE_MODEL(model));
-    if (model != NULL) {
-        g_object_unref(model);
+    /* don't try to read from a directory: avoid error messages from
+     * vdrive/fsimage */
+    if (path == NULL || g_file_test(path, G_FILE_TEST_IS_DIR)) {
+        set_model(create_text_model(NULL));
+        return;
+    }
+    if (content_func == NULL) {
+        log_error(LOG_ERR, "no content-get function specified, bailing!");
+        set_model(create_text_model(NULL));
+        return;
+    }
+
+    request_thread = g_thread_self();
+    request_contents = NULL;
+    id = contentscache_request(path, content_func, on_contents_read,
+                               GUINT_TO_POINTER(request_serial));
+    request_thread = NULL;
+
+    if (id == 0) {
+        /* the callback has been called already */
+        set_model(create_model(request_contents));
+        request_contents = NULL;
+    } else {
+        request_id = id;
+        set_model(create_text_model("<READING IMAGE CONTENTS>"));
     }
 }
 
@@ -51,6 +51,7 @@
 #include "uiactions.h"
 #include "uimenu.h"
 #include "uistatusbar.h"
+#include "video.h"
 #include "vsync.h"
 #include "vsyncapi.h"
 
@@ -334,6 +335,53 @@ static gboolean on_widget_hover(GtkWidget *widget,
 }
 
 
+/** \brief  Append the frame latency statistics of a canvas to a tooltip
+ *
+ * \param[in]  canvas  canvas shown in the window of the widget
+ * \param[out] buffer  where to put the text
+ * \param[in]  size    size of \a buffer
+ */
+static void latency_tooltip_text(video_canvas_t *canvas, char *buffer, size_t size)
+{
+    video_latency_stats_t stats;
+    size_t len = 0;
+    int stage;
+    int i;
+
+    for (stage = 0; stage < VIDEO_LATENCY_NUM_STAGES && len < size; stage++) {
+        video_latency_get_stats(canvas, stage, &stats);
+        if (stats.count == 0) {
+            continue;
+        }
+        len += g_snprintf(buffer + len, size - len,
+                          "\nFrame %s: %.1f ms (avg %.1f, max %.1f)",
+                          video_latency_stage_name(stage),
+                          stats.last / 1000.0,
+                          stats.average / 1000.0,
+                          stats.max / 1000.0);
+    }
+
+    /* histogram of the time until the frames were on screen */
+    video_latency_get_stats(canvas, VIDEO_LATENCY_PRESENTED, &stats);
+    if (stats.count == 0 || len >= size) {
+        return;
+    }
+    len += g_snprintf(buffer + len, size - len, "\nFrames presented within:");
+    for (i = 0; i < VIDEO_LATENCY_NUM_BUCKETS && len < size; i++) {
+        unsigned long limit = video_latency_bucket_limit(i);
+        double percent = stats.buckets[i] * 100.0 / stats.count;
+
+        if (limit) {
+            len += g_snprintf(buffer + len, size - len, "\n  < %4.1f ms: %5.1f%%",
+                              limit / 1000.0, percent);
+        } else {
+            len += g_snprintf(buffer + len, size - len, "\n  longer: %5.1f%%",
+                              percent);
+        }
+    }
+}
+
+
 /** \brief  Create widget to display CPU/FPS/pause
  *
  * \param[in,out]   state   current widget state
@@ -355,6 +403,8 @@ GtkWidget *statusbar_speed_widget_create(statusbar_speed_widget_state_t *state)
 
     state->last_cpu_int = -1;
     state->last_fps_int = -1;
+    state->last_skipped_frames = 0;
+    state->last_tooltip_tick = 0;
     state->last_paused = -1;
     state->last_warp = -1;
     state->last_shiftlock = -1;
@@ -479,6 +529,8 @@ void statusbar_speed_widget_update(GtkWidget *widget,
     double vsync_metric_cpu_percent;
     double vsync_metric_emulated_fps;
     int vsync_metric_warp_enabled;
+    double vsync_metric_skipped_fps;
+    unsigned long vsync_metric_skipped_frames;
     tick_t now;
 
     /*
@@ -535,7 +587,8 @@ void statusbar_speed_widget_update(GtkWidget *widget,
         }
     }
 
-    vsyncarch_get_metrics(&vsync_metric_cpu_percent, &vsync_metric_emulated_fps, &vsync_metric_warp_enabled);
+    vsyncarch_get_metrics(&vsync_metric_cpu_percent, &vsync_metric_emulated_fps, &vsync_metric_warp_enabled,
+                          &vsync_metric_skipped_fps, &vsync_metric_skipped_frames);
 
     /*
      * Updating GTK labels is expensive and this is called each frame,
@@ -633,6 +686,26 @@ void statusbar_speed_widget_update(GtkWidget *widget,
         }
     }
 
+    if (state->last_skipped_frames != vsync_metric_skipped_frames
+            || now - state->last_tooltip_tick >= tick_per_second()) {
+        size_t len;
+
+        /* frames skipped by AdaptiveFrameSkip and the frame latency of the
+         * canvas shown in this window go into the tooltip */
+        len = g_snprintf(buffer,
+                         sizeof(buffer),
+                         "%lu frames skipped (%.1f per second)",
+                         vsync_metric_skipped_frames,
+                         vsync_metric_skipped_fps);
+        latency_tooltip_text(ui_get_canvas_for_window(window_identity),
+                             buffer + len, sizeof(buffer) - len);
+
+        gtk_widget_set_tooltip_text(widget, buffer);
+
+        state->last_skipped_frames = vsync_metric_skipped_frames;
+        state->last_tooltip_tick = now;
+    }
+
 #   undef CPU_DECIMAL_PLACES
 #   undef FPS_DECIMAL_PLACES
 #   undef STR_
@@ -39,6 +39,8 @@ typedef struct statusbar_speed_widget_state_s {
     tick_t last_render_tick;
     int last_cpu_int;
     int last_fps_int;
+    unsigned long last_skipped_frames;
+    tick_t last_tooltip_tick;
     int last_warp;
     int last_paused;
     int last_shiftlock;
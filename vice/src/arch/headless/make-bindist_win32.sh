@@ -54,7 +54,7 @@ SCRIPTNAME=$(basename $0)
 VERBOSE=""
 
 EMUS="x64sc x64dtv xscpu64 x128 xvic xplus4 xpet xcbm2 xcbm5x0 vsid"
-TOOLS="c1541 tools/cartconv/cartconv tools/petcat/petcat"
+TOOLS="c1541 tools/cartconv/cartconv tools/petcat/petcat tools/vicetrace/vicetrace"
 
 
 # Print usage message on stdout
@@ -62,6 +62,9 @@ typedef struct video_canvas_s {
 
     /** \brief Used to limit frame rate under warp. */
     tick_t warp_next_render_tick;
+
+    /** \brief Consecutive frames skipped because emulation was behind. */
+    int skipped_frames;
 } video_canvas_t;
 
 typedef struct vice_renderer_backend_s {
@@ -96,7 +96,7 @@ else X64FILE=""
 fi
 
 EMULATORS="$X64FILE x64sc xscpu64 x64dtv x128 xcbm2 xcbm5x0 xpet xplus4 xvic vsid"
-CONSOLE_TOOLS="c1541 tools/cartconv/cartconv tools/petcat/petcat"
+CONSOLE_TOOLS="c1541 tools/cartconv/cartconv tools/petcat/petcat tools/vicetrace/vicetrace"
 EXECUTABLES="$EMULATORS $CONSOLE_TOOLS"
 
 unset CONSOLE_TOOLS EMULATORS X64FILE svnrev svnrev_string CPU X64INC
@@ -32,6 +32,7 @@
 
 #include "archdep.h"
 #include "charset.h"
+#include "contentscache.h"
 #include "diskcontents.h"
 #include "tapecontents.h"
 #include "imagecontents.h"
@@ -132,9 +133,9 @@ int sdl_ui_image_file_selection_dialog(const char* filename, ui_menu_filereq_mod
 
     menu_draw = sdl_ui_get_menu_param();
 
-    contents = tapecontents_read(filename);
+    contents = contentscache_read(filename, tapecontents_read);
     if (contents == NULL) {
-        contents = diskcontents_filesystem_read(filename);
+        contents = contentscache_read(filename, diskcontents_filesystem_read);
         if (contents == NULL) {
             return 0;
         }
@@ -125,10 +125,14 @@ static void display_speed(void)
     double vsync_metric_cpu_percent;
     double vsync_metric_emulated_fps;
     int vsync_metric_warp_enabled;
+    double vsync_metric_skipped_fps;
+    unsigned long vsync_metric_skipped_frames;
 
-    vsyncarch_get_metrics(&vsync_metric_cpu_percent, &vsync_metric_emulated_fps, &vsync_metric_warp_enabled);
+    vsyncarch_get_metrics(&vsync_metric_cpu_percent, &vsync_metric_emulated_fps, &vsync_metric_warp_enabled,
+                          &vsync_metric_skipped_fps, &vsync_metric_skipped_frames);
 
-    sep = ui_pause_active() ? ('P' | 0x80) : vsync_metric_warp_enabled ? ('W' | 0x80) : '/';
+    /* 'S' while frames are being skipped because emulation is behind */
+    sep = ui_pause_active() ? ('P' | 0x80) : vsync_metric_warp_enabled ? ('W' | 0x80) : (vsync_metric_skipped_fps >= 0.5) ? ('S' | 0x80) : '/';
 
     len = sprintf(&(statusbar_text[STATUSBAR_SPEED_POS]), "%3d%%%c%2dfps", (int)(vsync_metric_cpu_percent + 0.5), sep, (int)(vsync_metric_emulated_fps + 0.5));
     statusbar_text[STATUSBAR_SPEED_POS + len] = ' ';
@@ -421,6 +421,8 @@ void video_shutdown(void)
     }
 
     sdl_active_canvas = NULL;
+
+    video_latency_log();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -766,6 +768,7 @@ video_canvas_t *video_canvas_create(video_canvas_t *canvas, unsigned int *width,
 void video_canvas_refresh(struct video_canvas_s *canvas, unsigned int xs, unsigned int ys, unsigned int xi, unsigned int yi, unsigned int w, unsigned int h)
 {
     uint8_t *backup;
+    tick_t frame_tick = tick_now();
 
     if ((canvas == NULL) || (canvas->screen == NULL) || (canvas != sdl_active_canvas)) {
         return;
@@ -898,6 +901,7 @@ void video_canvas_refresh(struct video_canvas_s *canvas, unsigned int xs, unsign
 #else
     SDL_UpdateRect(canvas->screen, xi, yi, w, h);
 #endif
+    video_latency_presented(canvas, frame_tick);
     ui_autohide_mouse_cursor();
 }
 
@@ -503,6 +503,8 @@ void video_shutdown(void)
     }
 
     sdl_active_canvas = NULL;
+
+    video_latency_log();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -740,6 +742,7 @@ void video_canvas_refresh(struct video_canvas_s *canvas,
     uint8_t *backup;
     SDL_RendererFlip flip = 0;
     double angle = 0;
+    tick_t frame_tick = tick_now();
 
     /* If the canvas isn't initialized, skip this */
     if ((canvas == NULL) || (canvas->screen == NULL)) {
@@ -833,6 +836,7 @@ void video_canvas_refresh(struct video_canvas_s *canvas,
     SDL_RenderCopyEx(canvas->container->renderer, canvas->texture, NULL, NULL, angle, NULL, flip);
 
     SDL_RenderPresent(canvas->container->renderer);
+    video_latency_presented(canvas, frame_tick);
 
     /* Swap the textures references so we can easily re-render this frame under the next frame. */
     texture_swap = canvas->previous_frame_texture;
@@ -128,6 +128,9 @@ struct video_canvas_s {
 
     /** \brief Used to limit frame rate under warp. */
     tick_t warp_next_render_tick;
+
+    /** \brief Consecutive frames skipped because emulation was behind. */
+    int skipped_frames;
 };
 typedef struct video_canvas_s video_canvas_t;
 
@@ -91,6 +91,7 @@
 #include "archdep_list_drives.h"
 #include "archdep_make_backup_filename.h"
 #include "archdep_mkdir.h"
+#include "archdep_mkstemp_beside_fd.h"
 #include "archdep_mkstemp_fd.h"
 #include "archdep_network.h"
 #include "archdep_open_default_log_file.h"
@@ -103,6 +104,7 @@
 #include "archdep_real_path.h"
 #include "archdep_remove.h"
 #include "archdep_rename.h"
+#include "archdep_replace_file.h"
 #include "archdep_require_vkbd.h"
 #include "archdep_rmdir.h"
 #include "archdep_rtc_get_centisecond.h"
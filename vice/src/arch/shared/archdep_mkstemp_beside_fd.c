@@ -0,0 +1,109 @@
+/** \file   archdep_mkstemp_beside_fd.c
+ * \brief   Create temporary file next to another file
+ *
+ * A file created this way is on the same file system as \a path, so it can
+ * be renamed over it with archdep_replace_file().
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "archdep_defs.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>
+#endif
+#ifdef HAVE_IO_H
+# include <io.h>
+#endif
+#if defined(UNIX_COMPILE) || defined(HAIKU_COMPILE)
+# include <unistd.h>
+#endif
+
+#include "lib.h"
+#include "util.h"
+
+#include "archdep_remove.h"
+
+#include "archdep_mkstemp_beside_fd.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+
+/** \brief  Create a temporary file with a unique name next to \a path
+ *
+ * The file is called "<path>.XXXXXX", with the X's replaced to make the
+ * name unique.  It is created exclusively, so an existing file is never
+ * reused.
+ *
+ * \param[out]  filename    target of temporary file's name
+ * \param[in]   path        file to create the temporary file next to
+ * \param[in]   mode        file mode
+ *
+ * \return  file pointer, or NULL on error
+ *
+ * \note    The filename must be freed with lib_free().
+ */
+FILE *archdep_mkstemp_beside_fd(char **filename, const char *path, const char *mode)
+{
+    char *tmp;
+    int fildes;
+    FILE *fd;
+#ifdef HAVE_MKSTEMP
+
+    tmp = util_concat(path, ".XXXXXX", NULL);
+    fildes = mkstemp(tmp);
+#else
+    unsigned int i;
+
+    tmp = NULL;
+    fildes = -1;
+    for (i = 0; i < 100 && fildes < 0; i++) {
+        lib_free(tmp);
+        tmp = lib_msprintf("%s.%06x", path, (unsigned int)rand() & 0xffffff);
+        fildes = open(tmp, O_CREAT | O_EXCL | O_RDWR | O_BINARY, 0666);
+        if (fildes < 0 && errno != EEXIST) {
+            break;
+        }
+    }
+#endif
+    if (fildes < 0) {
+        lib_free(tmp);
+        return NULL;
+    }
+
+    fd = fdopen(fildes, mode);
+    if (fd == NULL) {
+        close(fildes);
+        archdep_remove(tmp);
+        lib_free(tmp);
+        return NULL;
+    }
+
+    *filename = tmp;
+    return fd;
+}
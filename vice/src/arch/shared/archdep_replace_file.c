@@ -0,0 +1,66 @@
+/** \file   archdep_replace_file.c
+ * \brief   Replace a file by another one
+ *
+ * OS support:
+ *  - Linux
+ *  - Windows
+ *  - BSD
+ *  - MacOS
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "archdep_defs.h"
+
+#include <stdio.h>
+
+#ifdef WINDOWS_COMPILE
+# include <windows.h>
+#endif
+
+#include "archdep_replace_file.h"
+
+
+/** \brief  Rename \a src to \a dest, replacing \a dest if it exists
+ *
+ * \a dest is never removed first, so if this fails it keeps its old
+ * contents.  Where the OS allows it (everywhere but Windows) it is replaced
+ * atomically.
+ *
+ * \param[in]   src     file to rename
+ * \param[in]   dest    file to replace
+ *
+ * \return  0 on success, -1 on error
+ */
+int archdep_replace_file(const char *src, const char *dest)
+{
+#ifdef WINDOWS_COMPILE
+    /* rename() refuses to replace an existing file here */
+    if (MoveFileExA(src, dest, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        return 0;
+    }
+    return -1;
+#else
+    return rename(src, dest);
+#endif
+}
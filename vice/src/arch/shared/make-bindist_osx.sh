@@ -76,7 +76,7 @@ mkdir $BUILD_DIR
 
 # define emulators and command line tools
 EMULATORS="xscpu64 x64dtv x64sc x128 xcbm2 xcbm5x0 xpet xplus4 xvic vsid"
-TOOLS="c1541 tools/petcat/petcat tools/cartconv/cartconv"
+TOOLS="c1541 tools/petcat/petcat tools/cartconv/cartconv tools/vicetrace/vicetrace"
 
 # define data files for emulators
 ROM_COMMON="DRIVES PRINTER"
@@ -56,6 +56,7 @@
 #include "imagecontents.h"
 #include "tapecontents.h"
 #include "diskcontents.h"
+#include "contentscache.h"
 #include "initcmdline.h"
 #include "interrupt.h"
 #include "kbdbuf.h"
@@ -1672,7 +1673,8 @@ int autostart_disk(int unit, int drive, const char *file_name, const char *progr
     /* Get program name first to avoid more than one file handle open on
        image.  */
     if (!program_name && program_number > 0) {
-        image_contents_t *contents = diskcontents_filesystem_read(file_name);
+        /* the file browser has most likely read the directory already */
+        image_contents_t *contents = contentscache_read(file_name, diskcontents_filesystem_read);
         if (contents) {
             name = image_contents_filename_by_number(contents, program_number);
             image_contents_destroy(contents);
@@ -47,9 +47,6 @@
 
 static int dma_request = 0;
 
-static uint8_t *z80_bank_base;
-static int z80_bank_limit;
-
 static void z80core_reset(void);
 
 void z80_trigger_dma(void)
@@ -62,29 +59,35 @@ void z80_reset(void)
     z80core_reset();
 }
 
-inline static uint8_t *z80mem_read_base(int addr)
+/* Look up the opcode fetch window for z80core.c, see FETCH_OPCODE.  */
+static void z80mem_fetch_translate(int addr, uint8_t **base, int *start, int *limit)
 {
-    uint8_t *p = _z80mem_read_base_tab_ptr[addr >> 8];
+    uint8_t *p = NULL;
 
-    if (p == 0) {
-        return p;
+    if (addr <= 0xffff) {
+        p = _z80mem_read_base_tab_ptr[addr >> 8];
     }
 
-    return p - (addr & 0xff00);
-}
+    if (p != NULL) {
+        int limits = z80mem_read_limit_tab_ptr[addr >> 8];
 
-inline static int z80mem_read_limit(int addr)
-{
-    return z80mem_read_limit_tab_ptr[addr >> 8];
+        *base = p - (addr & 0xff00);
+        *start = limits >> 16;
+        *limit = limits & 0xffff;
+    } else {
+        *base = NULL;
+        *start = addr & ~0xff;
+        *limit = addr | 0xff;
+    }
 }
 
-#define JUMP(addr)                                      \
-    do {                                                \
-        z80_reg_pc = (addr);                            \
-        z80_bank_base = z80mem_read_base(z80_reg_pc);   \
-        z80_bank_limit = z80mem_read_limit(z80_reg_pc); \
+#define JUMP(addr)              \
+    do {                        \
+        z80_reg_pc = (addr);    \
     } while (0)
 
+#define Z80_FETCH_TRANSLATE(addr, base, start, limit) z80mem_fetch_translate(addr, base, start, limit)
+
 #define LOAD(addr) ((uint32_t)(*_z80mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr)))
 
 #define STORE(addr, value) (*_z80mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value))
@@ -133,8 +136,7 @@ void z80_clock_stretch(void)
 
 void z80_resync_limits(void)
 {
-    z80_bank_base = z80mem_read_base(z80_reg_pc);
-    z80_bank_limit = z80mem_read_limit(z80_reg_pc);
+    Z80_FETCH_INVALIDATE();
 }
 
 void z80_mainloop(interrupt_cpu_status_t *cpu_int_status, alarm_context_t *cpu_alarm_context)
@@ -946,6 +946,17 @@ void z80mem_initialize(void)
     io_write_tab[0xde] = z80_c64io_de00_store;
     io_read_tab[0xdf] = z80_c64io_df00_read;
     io_write_tab[0xdf] = z80_c64io_df00_store;
+
+    /* Opcodes can be fetched directly from the BIOS ROM, the limit holds the
+       first and the last address a four byte opcode can be fetched from.  */
+    for (j = 0; j < NUM_CONFIGS; j++) {
+        for (i = 0; i < 0x10; i++) {
+            if (mem_read_tab[j][i] == bios_read) {
+                mem_read_base_tab[j][i] = z80bios_rom + (i << 8);
+                mem_read_limit_tab[j][i] = 0x0ffc;
+            }
+        }
+    }
 }
 
 static int c64mode_bit = 0;
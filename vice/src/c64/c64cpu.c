@@ -25,6 +25,7 @@
 
 #include "vice.h"
 
+#include "c64mem.h"
 #include "maincpu.h"
 #include "mem.h"
 
@@ -51,9 +52,33 @@
  - DMA_FUNC
  - DMA_ON_RESET
  - CHECK_AND_RUN_ALTERNATE_CPU
+ - HAVE_IDLE_SKIP
 
 */
 
+/* Data accesses to plain RAM and ROM pages use the direct pointers set up
+   by c64mem.c, everything else goes through the handlers.  */
+inline static uint8_t c64cpu_mem_read(unsigned int addr)
+{
+    uint8_t *p = _mem_read_ptr_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        return p[addr];
+    }
+    return (*_mem_read_tab_ptr[addr >> 8])((uint16_t)addr);
+}
+
+inline static void c64cpu_mem_store(unsigned int addr, unsigned int value)
+{
+    uint8_t *p = _mem_write_ptr_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        p[addr] = (uint8_t)value;
+    } else {
+        (*_mem_write_tab_ptr[addr >> 8])((uint16_t)addr, (uint8_t)value);
+    }
+}
+
 #ifdef FEATURE_CPUMEMHISTORY
 /* FIXME do proper ROM/RAM/IO tests */
 
@@ -101,13 +126,13 @@ inline static void memmap_mem_update(unsigned int addr, int write)
 static void memmap_mem_store(unsigned int addr, unsigned int value)
 {
     memmap_mem_update(addr, 1);
-    (*_mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value));
+    c64cpu_mem_store(addr, value);
 }
 
 static uint8_t memmap_mem_read(unsigned int addr)
 {
     memmap_mem_update(addr, 0);
-    return (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    return c64cpu_mem_read(addr);
 }
 
 static void memmap_mark_read(unsigned int addr)
@@ -126,6 +151,9 @@ static uint8_t memmap_mem_read_dummy(unsigned int addr)
     memmap_mem_update(addr, 0);
     return (*_mem_read_tab_ptr_dummy[(addr) >> 8])((uint16_t)(addr));
 }
+#else
+#define STORE(addr, value) c64cpu_mem_store(addr, value)
+#define LOAD(addr) c64cpu_mem_read(addr)
 #endif
 
 static void check_and_run_alternate_cpu(void)
@@ -137,4 +165,6 @@ static void check_and_run_alternate_cpu(void)
 
 #define HAVE_Z80_REGS
 
+#define HAVE_IDLE_SKIP
+
 #include "../maincpu.c"
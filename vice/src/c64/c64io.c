@@ -306,6 +306,7 @@ static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
     while (current) {
         if (current->device->read != NULL) {
             if ((addr >= current->device->start_address) && (addr <= current->device->end_address)) {
+                PERFCOUNTERS_NAMED_INC(current->perf, 0);
                 retval = current->device->read((uint16_t)(addr & current->device->address_mask));
                 if (current->device->io_source_valid) {
                     /* high prio always overrides others, return immediatly */
@@ -395,6 +396,9 @@ static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value
     uint16_t addy = 0xffff;
     io_source_list_t *current = list->next;
     void (*store)(uint16_t address, uint8_t data) = NULL;
+#ifdef FEATURE_PERFCOUNTERS
+    io_source_list_t *mirror = NULL;
+#endif
 
     vicii_handle_pending_alarms_external_write();
 
@@ -403,11 +407,15 @@ static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value
             if (addr >= current->device->start_address && addr <= current->device->end_address) {
                 /* delay mirror writes, ensuring real device writes in mirror area */
                 if (current->device->io_source_prio != IO_PRIO_LOW) {
+                    PERFCOUNTERS_NAMED_INC(current->perf, 1);
                     current->device->store((uint16_t)(addr & current->device->address_mask), value);
                     writes++;
                 } else {
                     addy = (uint16_t)(addr & current->device->address_mask);
                     store = current->device->store;
+#ifdef FEATURE_PERFCOUNTERS
+                    mirror = current;
+#endif
                 }
             }
         }
@@ -415,6 +423,7 @@ static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value
     }
     /* if a mirror write needed to be done and no real device write was done */
     if (store && !writes && addy != 0xffff) {
+        PERFCOUNTERS_NAMED_INC(mirror->perf, 1);
         store(addy, value);
     }
 }
@@ -475,6 +484,9 @@ io_source_list_t *io_source_register(io_source_t *device)
     current->next = retval;
     retval->previous = current;
     retval->device = device;
+#ifdef FEATURE_PERFCOUNTERS
+    retval->perf = perfcounters_named_get(PERFCOUNTERS_KIND_IO, device->name);
+#endif
     retval->next = NULL;
     retval->device->order = order++;
 
@@ -43,9 +43,11 @@
 #include "c64meminit.h"
 #include "c64memlimit.h"
 #include "c64memrom.h"
+#include "c64memstock.h"
 #include "c64pla.h"
 #include "c64ui.h"
 #include "c64cartmem.h"
+#include "c64cartsystem.h"
 #include "cartio.h"
 #include "cartridge.h"
 #include "cia.h"
@@ -106,6 +108,81 @@ static uint32_t mem_read_limit_tab[NUM_CONFIGS][0x101];
 static store_func_ptr_t mem_write_tab_watch[0x101];
 static read_func_ptr_t mem_read_tab_watch[0x101];
 
+static uint8_t *mem_write_ptr_tab[NUM_VBANKS][NUM_CONFIGS][0x101];
+static uint8_t *mem_read_ptr_tab[NUM_CONFIGS][0x101];
+
+/* Used while watchpoints are active, every access goes to the handlers.  */
+static uint8_t *mem_ptr_tab_none[0x101];
+
+/* Direct pointers for the CPU's data accesses, indexed like the read and
+   write tables.  A page that is plain RAM or ROM points at memory that can be
+   indexed with the full address, a NULL page has to go through its handler.  */
+uint8_t **_mem_read_ptr_tab_ptr = mem_ptr_tab_none;
+uint8_t **_mem_write_ptr_tab_ptr = mem_ptr_tab_none;
+
+/* Stock memory tables, used instead of the generic ones while no cartridge
+   is attached.  Besides RAM, ROM and I/O, the only difference in the write
+   tables between the video banks is the VIC-II bus snooping in the current
+   bank.  */
+#define STOCK_VB    vicii_mem_vbank_store
+
+#define STOCK_WRITE_0000_VBANK                                          \
+    C64MEMSTOCK_P32(STOCK_VB) C64MEMSTOCK_P16(STOCK_VB) C64MEMSTOCK_P8(STOCK_VB) \
+    vicii_mem_vbank_39xx_store, C64MEMSTOCK_P4(STOCK_VB) C64MEMSTOCK_P1(STOCK_VB) \
+    vicii_mem_vbank_3fxx_store,
+#define STOCK_WRITE_0000_RAM                                            \
+    C64MEMSTOCK_P32(ram_store) C64MEMSTOCK_P16(ram_store) C64MEMSTOCK_P8(ram_store) \
+    C64MEMSTOCK_P4(ram_store) C64MEMSTOCK_P2(ram_store) C64MEMSTOCK_P1(ram_store)
+#define STOCK_WRITE_4000_VBANK                                          \
+    C64MEMSTOCK_P32(STOCK_VB) C64MEMSTOCK_P16(STOCK_VB) C64MEMSTOCK_P8(STOCK_VB) \
+    C64MEMSTOCK_P1(STOCK_VB)                                            \
+    vicii_mem_vbank_39xx_store, C64MEMSTOCK_P4(STOCK_VB) C64MEMSTOCK_P1(STOCK_VB) \
+    vicii_mem_vbank_3fxx_store,
+#define STOCK_WRITE_4000_RAM    C64MEMSTOCK_P64(ram_store)
+#define STOCK_WRITE_C000_VBANK  C64MEMSTOCK_P16(STOCK_VB)
+#define STOCK_WRITE_C000_RAM    C64MEMSTOCK_P16(ram_store)
+#define STOCK_WRITE_E000_VBANK                                          \
+    C64MEMSTOCK_P16(STOCK_VB) C64MEMSTOCK_P8(STOCK_VB) C64MEMSTOCK_P1(STOCK_VB) \
+    vicii_mem_vbank_39xx_store, C64MEMSTOCK_P4(STOCK_VB) C64MEMSTOCK_P1(STOCK_VB)
+#define STOCK_WRITE_E000_RAM                                            \
+    C64MEMSTOCK_P16(ram_store) C64MEMSTOCK_P8(ram_store) C64MEMSTOCK_P4(ram_store) \
+    C64MEMSTOCK_P2(ram_store) C64MEMSTOCK_P1(ram_store)
+
+/* Configs 0-4 have RAM or ROM at $D000-$DFFF (writes go to RAM), 5-7 have
+   I/O.  $FF00 is the REU trigger page.  */
+#define STOCK_WRITE_VBANK(q0000, q4000, c000, e000)                     \
+    {                                                                   \
+        { zero_store, q0000 q4000 C64MEMSTOCK_P64(ram_store) c000 c000 e000 ram_hi_store, zero_store }, \
+        { zero_store, q0000 q4000 C64MEMSTOCK_P64(ram_store) c000 c000 e000 ram_hi_store, zero_store }, \
+        { zero_store, q0000 q4000 C64MEMSTOCK_P64(ram_store) c000 c000 e000 ram_hi_store, zero_store }, \
+        { zero_store, q0000 q4000 C64MEMSTOCK_P64(ram_store) c000 c000 e000 ram_hi_store, zero_store }, \
+        { zero_store, q0000 q4000 C64MEMSTOCK_P64(ram_store) c000 c000 e000 ram_hi_store, zero_store }, \
+        { zero_store, q0000 q4000 C64MEMSTOCK_P64(ram_store) c000 C64MEMSTOCK_WRITE_D000_IO e000 ram_hi_store, zero_store }, \
+        { zero_store, q0000 q4000 C64MEMSTOCK_P64(ram_store) c000 C64MEMSTOCK_WRITE_D000_IO e000 ram_hi_store, zero_store }, \
+        { zero_store, q0000 q4000 C64MEMSTOCK_P64(ram_store) c000 C64MEMSTOCK_WRITE_D000_IO e000 ram_hi_store, zero_store }  \
+    }
+
+static const read_func_ptr_t mem_read_tab_stock[C64MEMSTOCK_NUM_CONFIGS][0x101] = C64MEMSTOCK_READ_TAB;
+
+static const store_func_ptr_t mem_write_tab_stock[NUM_VBANKS][C64MEMSTOCK_NUM_CONFIGS][0x101] = {
+    STOCK_WRITE_VBANK(STOCK_WRITE_0000_VBANK, STOCK_WRITE_4000_RAM,
+                      STOCK_WRITE_C000_RAM, STOCK_WRITE_E000_RAM),
+    STOCK_WRITE_VBANK(STOCK_WRITE_0000_RAM, STOCK_WRITE_4000_VBANK,
+                      STOCK_WRITE_C000_RAM, STOCK_WRITE_E000_RAM),
+    STOCK_WRITE_VBANK(STOCK_WRITE_0000_RAM, STOCK_WRITE_4000_RAM,
+                      STOCK_WRITE_C000_RAM, STOCK_WRITE_E000_RAM),
+    STOCK_WRITE_VBANK(STOCK_WRITE_0000_RAM, STOCK_WRITE_4000_RAM,
+                      STOCK_WRITE_C000_VBANK, STOCK_WRITE_E000_VBANK)
+};
+
+static uint8_t *mem_write_ptr_tab_stock[NUM_VBANKS][C64MEMSTOCK_NUM_CONFIGS][0x101];
+
+/* The stock tables may be used (board and expansions match them).  */
+static int mem_stock_ok = 0;
+
+/* The stock tables are in use.  */
+static int mem_stock = 0;
+
 /* Current video bank (0, 1, 2 or 3).  */
 static int vbank;
 
@@ -153,26 +230,68 @@ static void store_watch(uint16_t addr, uint8_t value)
     mem_write_tab[vbank][mem_config][addr >> 8](addr, value);
 }
 
+/* The tables for the current memory configuration, stock or generic.  */
+static read_func_ptr_t *mem_cur_read_tab(void)
+{
+    if (mem_stock) {
+        return (read_func_ptr_t *)mem_read_tab_stock[mem_config];
+    }
+    return mem_read_tab[mem_config];
+}
+
+static store_func_ptr_t *mem_cur_write_tab(int bank)
+{
+    if (mem_stock) {
+        return (store_func_ptr_t *)mem_write_tab_stock[bank][mem_config];
+    }
+    return mem_write_tab[bank][mem_config];
+}
+
+static uint8_t **mem_cur_write_ptr_tab(int bank)
+{
+    if (mem_stock) {
+        return mem_write_ptr_tab_stock[bank][mem_config];
+    }
+    return mem_write_ptr_tab[bank][mem_config];
+}
+
+/* Select the stock tables when the generic ones were found to match them
+   and nothing sits in the expansion port.  Every cartridge attach, enable
+   and detach ends up in mem_pla_config_changed(), so this is re-checked
+   there.  */
+static void mem_stock_update(void)
+{
+    mem_stock = mem_stock_ok
+                && mem_config < C64MEMSTOCK_NUM_CONFIGS
+                && cart_getid_slotmain() == CARTRIDGE_NONE
+                && cart_getid_slot0() == CARTRIDGE_NONE
+                && cart_getid_slot1() == CARTRIDGE_NONE;
+}
+
 /* called by mem_pla_config_changed(), mem_toggle_watchpoints() */
 static void mem_update_tab_ptrs(int flag)
 {
     if (flag) {
         _mem_read_tab_ptr = mem_read_tab_watch;
         _mem_write_tab_ptr = mem_write_tab_watch;
+        _mem_read_ptr_tab_ptr = mem_ptr_tab_none;
+        _mem_write_ptr_tab_ptr = mem_ptr_tab_none;
         if (flag > 1) {
             /* enable watchpoints on dummy accesses */
             _mem_read_tab_ptr_dummy = mem_read_tab_watch;
             _mem_write_tab_ptr_dummy = mem_write_tab_watch;
         } else {
-            _mem_read_tab_ptr_dummy = mem_read_tab[mem_config];
-            _mem_write_tab_ptr_dummy = mem_write_tab[vbank][mem_config];
+            _mem_read_tab_ptr_dummy = mem_cur_read_tab();
+            _mem_write_tab_ptr_dummy = mem_cur_write_tab(vbank);
         }
     } else {
         /* all watchpoints disabled */
-        _mem_read_tab_ptr = mem_read_tab[mem_config];
-        _mem_write_tab_ptr = mem_write_tab[vbank][mem_config];
-        _mem_read_tab_ptr_dummy = mem_read_tab[mem_config];
-        _mem_write_tab_ptr_dummy = mem_write_tab[vbank][mem_config];
+        _mem_read_tab_ptr = mem_cur_read_tab();
+        _mem_write_tab_ptr = mem_cur_write_tab(vbank);
+        _mem_read_ptr_tab_ptr = mem_read_ptr_tab[mem_config];
+        _mem_write_ptr_tab_ptr = mem_cur_write_ptr_tab(vbank);
+        _mem_read_tab_ptr_dummy = mem_cur_read_tab();
+        _mem_write_tab_ptr_dummy = mem_cur_write_tab(vbank);
     }
 }
 
@@ -211,6 +330,7 @@ void mem_pla_config_changed(void)
 
     c64pla_config_changed(tape_sense, tape_write_in, tape_motor_in, 1, 0x17);
 
+    mem_stock_update();
     mem_update_tab_ptrs(watchpoints_active);
 
     _mem_read_base_tab_ptr = mem_read_base_tab[mem_config];
@@ -672,11 +792,89 @@ void mem_read_base_set(unsigned int base, unsigned int index, uint8_t *mem_ptr)
     mem_read_base_tab[base][index] = mem_ptr;
 }
 
+/* Fill the direct pointer tables from the read and write tables.  Only pages
+   whose handler is a plain RAM or ROM access get a pointer, so anything
+   hooked by cartridges, RAM expansions or the I/O area keeps its handler.
+   Called whenever the tables have been (re)built.  */
+static void mem_update_ptr_tabs(void)
+{
+    int i, j, k;
+    uint8_t *p;
+
+    for (i = 0; i < NUM_CONFIGS; i++) {
+        for (j = 0; j <= 0x100; j++) {
+            read_func_ptr_t read_func = mem_read_tab[i][j];
+
+            p = NULL;
+            if (j == 0 || j == 0x100) {
+                /* the processor port lives here */
+            } else if (read_func == ram_read) {
+                p = mem_ram;
+            } else if (read_func == chargen_read) {
+                p = mem_chargen_rom - ((j & 0xf0) << 8);
+            } else if (read_func == c64memrom_basic64_read) {
+                p = c64memrom_basic64_rom - ((j & 0xe0) << 8);
+            } else if (read_func == c64memrom_kernal64_read) {
+                p = c64memrom_kernal64_rom - ((j & 0xe0) << 8);
+            }
+            mem_read_ptr_tab[i][j] = p;
+
+            for (k = 0; k < NUM_VBANKS; k++) {
+                p = NULL;
+                if (j != 0 && j != 0x100 && mem_write_tab[k][i][j] == ram_store) {
+                    p = mem_ram;
+                }
+                mem_write_ptr_tab[k][i][j] = p;
+
+                if (i < C64MEMSTOCK_NUM_CONFIGS) {
+                    p = NULL;
+                    if (j != 0 && j != 0x100 && mem_write_tab_stock[k][i][j] == ram_store) {
+                        p = mem_ram;
+                    }
+                    mem_write_ptr_tab_stock[k][i][j] = p;
+                }
+            }
+        }
+    }
+}
+
+/* Check whether the generic tables for configs 0-7 behave exactly like the
+   stock ones.  This fails for the MAX board and whenever an internal RAM
+   expansion or memory hack has patched the map.  The RAM under ROML/ROMH
+   goes through the cartridge hooks in the generic tables, those end up in
+   plain RAM while no cartridge is attached.  */
+static int mem_stock_check(void)
+{
+    int i, j, k;
+    store_func_ptr_t store_func;
+
+    for (i = 0; i < C64MEMSTOCK_NUM_CONFIGS; i++) {
+        for (j = 0; j <= 0x100; j++) {
+            if (mem_read_tab[i][j] != mem_read_tab_stock[i][j]) {
+                return 0;
+            }
+            for (k = 0; k < NUM_VBANKS; k++) {
+                store_func = mem_write_tab[k][i][j];
+                if (store_func == raml_no_ultimax_store || store_func == ramh_no_ultimax_store) {
+                    store_func = ram_store;
+                }
+                if (store_func != mem_write_tab_stock[k][i][j]) {
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
 void mem_initialize_memory(void)
 {
     int i, j, k;
     int board;
 
+    /* Use the generic tables until they have been rebuilt.  */
+    mem_stock_ok = 0;
+
     mem_chargen_rom_ptr = mem_chargen_rom;
     mem_color_ram_cpu = mem_color_ram;
     mem_color_ram_vicii = mem_color_ram;
@@ -780,6 +978,8 @@ void mem_initialize_memory(void)
     _mem_write_tab_ptr = mem_write_tab[vbank][7];
     _mem_read_base_tab_ptr = mem_read_base_tab[7];
     mem_read_limit_tab_ptr = mem_read_limit_tab[7];
+    _mem_read_ptr_tab_ptr = mem_read_ptr_tab[7];
+    _mem_write_ptr_tab_ptr = mem_write_ptr_tab[vbank][7];
 
     vicii_set_chargen_addr_options(0x7000, 0x1000);
 
@@ -797,6 +997,12 @@ void mem_initialize_memory(void)
     plus256k_init_config();
     c64_256k_init_config();
 
+    mem_update_ptr_tabs();
+
+    mem_stock_ok = mem_stock_check();
+    mem_stock_update();
+    mem_update_tab_ptrs(watchpoints_active);
+
     if (board == 1) {
         mem_limit_max_init(mem_read_limit_tab);
     }
@@ -836,7 +1042,8 @@ void mem_set_vbank(int new_vbank)
 
     /* Do not override watchpoints on vbank switches.  */
     if (_mem_write_tab_ptr != mem_write_tab_watch) {
-        _mem_write_tab_ptr = mem_write_tab[new_vbank][mem_config];
+        _mem_write_tab_ptr = mem_cur_write_tab(new_vbank);
+        _mem_write_ptr_tab_ptr = mem_cur_write_ptr_tab(new_vbank);
     }
 
     vicii_set_vbank(new_vbank);
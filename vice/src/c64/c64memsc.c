@@ -43,9 +43,11 @@
 #include "c64meminit.h"
 #include "c64memlimit.h"
 #include "c64memrom.h"
+#include "c64memstock.h"
 #include "c64pla.h"
 #include "c64ui.h"
 #include "c64cartmem.h"
+#include "c64cartsystem.h"
 #include "cartio.h"
 #include "cartridge.h"
 #include "cia.h"
@@ -109,6 +111,44 @@ static uint32_t mem_read_limit_tab[NUM_CONFIGS][0x101];
 static store_func_ptr_t mem_write_tab_watch[0x101];
 static read_func_ptr_t mem_read_tab_watch[0x101];
 
+/* Stock memory tables, used instead of the generic ones while no cartridge
+   is attached.  Configs 0-4 have RAM or ROM at $D000-$DFFF (writes go to
+   RAM), 5-7 have I/O.  $FF00 is the REU trigger page.  */
+#define STOCK_WRITE_ROW(d000)                                           \
+    {                                                                   \
+        zero_store,                                                     \
+        C64MEMSTOCK_P64(ram_store) C64MEMSTOCK_P64(ram_store)           \
+        C64MEMSTOCK_P64(ram_store) C64MEMSTOCK_P8(ram_store)            \
+        C64MEMSTOCK_P4(ram_store) C64MEMSTOCK_P2(ram_store)             \
+        C64MEMSTOCK_P1(ram_store)                                       \
+        d000                                                            \
+        C64MEMSTOCK_P16(ram_store) C64MEMSTOCK_P8(ram_store)            \
+        C64MEMSTOCK_P4(ram_store) C64MEMSTOCK_P2(ram_store)             \
+        C64MEMSTOCK_P1(ram_store)                                       \
+        ram_hi_store,                                                   \
+        zero_store                                                      \
+    }
+#define STOCK_WRITE_D000_RAM    C64MEMSTOCK_P16(ram_store)
+
+static const read_func_ptr_t mem_read_tab_stock[C64MEMSTOCK_NUM_CONFIGS][0x101] = C64MEMSTOCK_READ_TAB;
+
+static const store_func_ptr_t mem_write_tab_stock[C64MEMSTOCK_NUM_CONFIGS][0x101] = {
+    STOCK_WRITE_ROW(STOCK_WRITE_D000_RAM),
+    STOCK_WRITE_ROW(STOCK_WRITE_D000_RAM),
+    STOCK_WRITE_ROW(STOCK_WRITE_D000_RAM),
+    STOCK_WRITE_ROW(STOCK_WRITE_D000_RAM),
+    STOCK_WRITE_ROW(STOCK_WRITE_D000_RAM),
+    STOCK_WRITE_ROW(C64MEMSTOCK_WRITE_D000_IO),
+    STOCK_WRITE_ROW(C64MEMSTOCK_WRITE_D000_IO),
+    STOCK_WRITE_ROW(C64MEMSTOCK_WRITE_D000_IO)
+};
+
+/* The stock tables may be used (board and expansions match them).  */
+static int mem_stock_ok = 0;
+
+/* The stock tables are in use.  */
+static int mem_stock = 0;
+
 /* Current video bank (0, 1, 2 or 3).  */
 static int vbank;
 
@@ -156,6 +196,36 @@ static void store_watch(uint16_t addr, uint8_t value)
     mem_write_tab[mem_config][addr >> 8](addr, value);
 }
 
+/* The tables for the current memory configuration, stock or generic.  */
+static read_func_ptr_t *mem_cur_read_tab(void)
+{
+    if (mem_stock) {
+        return (read_func_ptr_t *)mem_read_tab_stock[mem_config];
+    }
+    return mem_read_tab[mem_config];
+}
+
+static store_func_ptr_t *mem_cur_write_tab(void)
+{
+    if (mem_stock) {
+        return (store_func_ptr_t *)mem_write_tab_stock[mem_config];
+    }
+    return mem_write_tab[mem_config];
+}
+
+/* Select the stock tables when the generic ones were found to match them
+   and nothing sits in the expansion port.  Every cartridge attach, enable
+   and detach ends up in mem_pla_config_changed(), so this is re-checked
+   there.  */
+static void mem_stock_update(void)
+{
+    mem_stock = mem_stock_ok
+                && mem_config < C64MEMSTOCK_NUM_CONFIGS
+                && cart_getid_slotmain() == CARTRIDGE_NONE
+                && cart_getid_slot0() == CARTRIDGE_NONE
+                && cart_getid_slot1() == CARTRIDGE_NONE;
+}
+
 /* called by mem_pla_config_changed(), mem_toggle_watchpoints() */
 static void mem_update_tab_ptrs(int flag)
 {
@@ -167,15 +237,15 @@ static void mem_update_tab_ptrs(int flag)
             _mem_read_tab_ptr_dummy = mem_read_tab_watch;
             _mem_write_tab_ptr_dummy = mem_write_tab_watch;
         } else {
-            _mem_read_tab_ptr_dummy = mem_read_tab[mem_config];
-            _mem_write_tab_ptr_dummy = mem_write_tab[mem_config];
+            _mem_read_tab_ptr_dummy = mem_cur_read_tab();
+            _mem_write_tab_ptr_dummy = mem_cur_write_tab();
         }
     } else {
         /* all watchpoints disabled */
-        _mem_read_tab_ptr = mem_read_tab[mem_config];
-        _mem_write_tab_ptr = mem_write_tab[mem_config];
-        _mem_read_tab_ptr_dummy = mem_read_tab[mem_config];
-        _mem_write_tab_ptr_dummy = mem_write_tab[mem_config];
+        _mem_read_tab_ptr = mem_cur_read_tab();
+        _mem_write_tab_ptr = mem_cur_write_tab();
+        _mem_read_tab_ptr_dummy = mem_cur_read_tab();
+        _mem_write_tab_ptr_dummy = mem_cur_write_tab();
     }
 }
 
@@ -219,6 +289,7 @@ void mem_pla_config_changed(void)
 
     c64pla_config_changed(tape_sense, tape_write_in, tape_motor_in, 1, 0x17);
 
+    mem_stock_update();
     mem_update_tab_ptrs(watchpoints_active);
 
     _mem_read_base_tab_ptr = mem_read_base_tab[mem_config];
@@ -632,11 +703,41 @@ void mem_read_base_set(unsigned int base, unsigned int index, uint8_t *mem_ptr)
     mem_read_base_tab[base][index] = mem_ptr;
 }
 
+/* Check whether the generic tables for configs 0-7 behave exactly like the
+   stock ones.  This fails for the MAX board and whenever an internal RAM
+   expansion or memory hack has patched the map.  The RAM under ROML/ROMH
+   goes through the cartridge hooks in the generic tables, those end up in
+   plain RAM while no cartridge is attached.  */
+static int mem_stock_check(void)
+{
+    int i, j;
+    store_func_ptr_t store_func;
+
+    for (i = 0; i < C64MEMSTOCK_NUM_CONFIGS; i++) {
+        for (j = 0; j <= 0x100; j++) {
+            if (mem_read_tab[i][j] != mem_read_tab_stock[i][j]) {
+                return 0;
+            }
+            store_func = mem_write_tab[i][j];
+            if (store_func == raml_no_ultimax_store || store_func == ramh_no_ultimax_store) {
+                store_func = ram_store;
+            }
+            if (store_func != mem_write_tab_stock[i][j]) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
 void mem_initialize_memory(void)
 {
     int i, j;
     int board;
 
+    /* Use the generic tables until they have been rebuilt.  */
+    mem_stock_ok = 0;
+
     mem_chargen_rom_ptr = mem_chargen_rom;
     mem_color_ram_cpu = mem_color_ram;
     mem_color_ram_vicii = mem_color_ram;
@@ -735,6 +836,10 @@ void mem_initialize_memory(void)
     plus256k_init_config();
     c64_256k_init_config();
 
+    mem_stock_ok = mem_stock_check();
+    mem_stock_update();
+    mem_update_tab_ptrs(watchpoints_active);
+
     if (board == 1) {
         mem_limit_max_init(mem_read_limit_tab);
     }
@@ -0,0 +1,93 @@
+/*
+ * c64memstock.h -- Constant C64 memory tables for the stock configuration.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_C64MEMSTOCK_H
+#define VICE_C64MEMSTOCK_H
+
+/* Without a cartridge (EXROM and GAME both inactive) only the memory
+   configurations 0-7 can be selected, and with nothing else hooked into the
+   memory map their tables never change.  These macros spell out those
+   tables so the compiler can build them as constant data.  Every row has
+   0x101 entries, the last one being the copy of page 0 used for the stack
+   wrap-around.  */
+
+#define C64MEMSTOCK_NUM_CONFIGS 8
+
+/* Repeat `f' for n pages.  */
+#define C64MEMSTOCK_P1(f)   f,
+#define C64MEMSTOCK_P2(f)   C64MEMSTOCK_P1(f) C64MEMSTOCK_P1(f)
+#define C64MEMSTOCK_P4(f)   C64MEMSTOCK_P2(f) C64MEMSTOCK_P2(f)
+#define C64MEMSTOCK_P8(f)   C64MEMSTOCK_P4(f) C64MEMSTOCK_P4(f)
+#define C64MEMSTOCK_P16(f)  C64MEMSTOCK_P8(f) C64MEMSTOCK_P8(f)
+#define C64MEMSTOCK_P32(f)  C64MEMSTOCK_P16(f) C64MEMSTOCK_P16(f)
+#define C64MEMSTOCK_P64(f)  C64MEMSTOCK_P32(f) C64MEMSTOCK_P32(f)
+
+/* $D000-$DFFF as seen by the CPU.  */
+#define C64MEMSTOCK_READ_D000_RAM     C64MEMSTOCK_P16(ram_read)
+#define C64MEMSTOCK_READ_D000_CHARGEN C64MEMSTOCK_P16(chargen_read)
+#define C64MEMSTOCK_READ_D000_IO                                    \
+    c64io_d000_read, c64io_d100_read, c64io_d200_read, c64io_d300_read, \
+    c64io_d400_read, c64io_d500_read, c64io_d600_read, c64io_d700_read, \
+    colorram_read, colorram_read, colorram_read, colorram_read,     \
+    cia1_read, cia2_read, c64io_de00_read, c64io_df00_read,
+
+#define C64MEMSTOCK_WRITE_D000_IO                                       \
+    c64io_d000_store, c64io_d100_store, c64io_d200_store, c64io_d300_store, \
+    c64io_d400_store, c64io_d500_store, c64io_d600_store, c64io_d700_store, \
+    colorram_store, colorram_store, colorram_store, colorram_store,     \
+    cia1_store, cia2_store, c64io_de00_store, c64io_df00_store,
+
+/* One read table row: RAM everywhere except $A000-$BFFF (`a000'),
+   $D000-$DFFF (`d000', one of the lists above) and $E000-$FFFF (`e000').  */
+#define C64MEMSTOCK_READ_ROW(a000, d000, e000)                  \
+    {                                                           \
+        zero_read,                                              \
+        C64MEMSTOCK_P64(ram_read) C64MEMSTOCK_P32(ram_read)     \
+        C64MEMSTOCK_P16(ram_read) C64MEMSTOCK_P8(ram_read)      \
+        C64MEMSTOCK_P4(ram_read) C64MEMSTOCK_P2(ram_read)       \
+        C64MEMSTOCK_P1(ram_read) C64MEMSTOCK_P32(ram_read)      \
+        C64MEMSTOCK_P32(a000)                                   \
+        C64MEMSTOCK_P16(ram_read)                               \
+        d000                                                    \
+        C64MEMSTOCK_P32(e000)                                   \
+        zero_read                                               \
+    }
+
+/* Read tables for configs 0-7, the same for x64 and x64sc.  */
+#define C64MEMSTOCK_READ_TAB                                                            \
+    {                                                                                   \
+        C64MEMSTOCK_READ_ROW(ram_read, C64MEMSTOCK_READ_D000_RAM, ram_read),            \
+        C64MEMSTOCK_READ_ROW(ram_read, C64MEMSTOCK_READ_D000_CHARGEN, ram_read),        \
+        C64MEMSTOCK_READ_ROW(ram_read, C64MEMSTOCK_READ_D000_CHARGEN,                   \
+                             c64memrom_kernal64_read),                                  \
+        C64MEMSTOCK_READ_ROW(c64memrom_basic64_read, C64MEMSTOCK_READ_D000_CHARGEN,     \
+                             c64memrom_kernal64_read),                                  \
+        C64MEMSTOCK_READ_ROW(ram_read, C64MEMSTOCK_READ_D000_RAM, ram_read),            \
+        C64MEMSTOCK_READ_ROW(ram_read, C64MEMSTOCK_READ_D000_IO, ram_read),             \
+        C64MEMSTOCK_READ_ROW(ram_read, C64MEMSTOCK_READ_D000_IO,                        \
+                             c64memrom_kernal64_read),                                  \
+        C64MEMSTOCK_READ_ROW(c64memrom_basic64_read, C64MEMSTOCK_READ_D000_IO,          \
+                             c64memrom_kernal64_read)                                   \
+    }
+
+#endif
@@ -71,6 +71,39 @@ static void cpmcart_wrap_store(uint16_t addr, uint8_t value)
     mem_dma_store((uint16_t)address, value);
 }
 
+/* Look up the opcode fetch window for z80core.c, see FETCH_OPCODE.  The C64
+   side comes from mem_mmu_translate(), the same lookup the 6510 uses for its
+   opcode fetches.  The window is shifted into the Z80 address space and
+   clipped to the part that does not wrap around at $10000.  */
+static void cpmcart_fetch_translate(int addr, uint8_t **base, int *start, int *limit)
+{
+    uint8_t *p = NULL;
+    int offset, c64_start = 0, c64_limit = -1;
+
+    if (addr <= 0xffff) {
+        offset = (addr < 0xf000) ? 0x1000 : -0xf000;
+        mem_mmu_translate((unsigned int)(addr + offset), &p, &c64_start, &c64_limit);
+
+        /* the C64 limit allows three byte opcodes, the Z80 fetches four */
+        c64_limit--;
+        if (offset > 0) {
+            c64_start = (c64_start < 0x1000) ? 0x1000 : c64_start;
+        } else {
+            c64_limit = (c64_limit > 0x0ffc) ? 0x0ffc : c64_limit;
+        }
+        if (p != NULL && addr + offset >= c64_start && addr + offset <= c64_limit) {
+            *base = p + offset;
+            *start = c64_start - offset;
+            *limit = c64_limit - offset;
+            return;
+        }
+    }
+
+    *base = NULL;
+    *start = addr & ~0xff;
+    *limit = addr | 0xff;
+}
+
 static void cpmcart_io_store(uint16_t addr, uint8_t byte)
 {
     int val = byte & 1;
@@ -201,7 +234,14 @@ void cpmcart_reset(void)
 
 #define LOAD(addr) (cpmcart_wrap_read((uint16_t)(addr)))
 
-#define STORE(addr, value) (cpmcart_wrap_store((uint16_t)(addr), (uint8_t)(value)))
+/* Any store may switch the C64 memory configuration or a cartridge bank */
+#define STORE(addr, value)                                              \
+    do {                                                                \
+        cpmcart_wrap_store((uint16_t)(addr), (uint8_t)(value));         \
+        Z80_FETCH_INVALIDATE();                                         \
+    } while (0)
+
+#define Z80_FETCH_TRANSLATE(addr, base, start, limit) cpmcart_fetch_translate(addr, base, start, limit)
 
 /* undefine IN and OUT first for platforms that have them already defined as something else */
 #undef IN
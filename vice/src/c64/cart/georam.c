@@ -41,6 +41,7 @@
 #include "mem.h"
 #include "monitor.h"
 #include "ram.h"
+#include "ramimage.h"
 #include "resources.h"
 #include "georam.h"
 #include "snapshot.h"
@@ -108,6 +109,9 @@ static uint8_t georam[2];
 static uint8_t *georam_ram = NULL;
 static int old_georam_ram_size = 0;
 
+/* Backing store of georam_ram, mapped from the image file if possible.  */
+static ramimage_t georam_image;
+
 static log_t georam_log = LOG_ERR;
 
 static int georam_activate(void);
@@ -196,7 +200,10 @@ static uint8_t georam_io1_read(uint16_t addr)
 
 static void georam_io1_store(uint16_t addr, uint8_t byte)
 {
-    georam_ram[(georam[1] * 16384) + (georam[0] * 256) + addr] = byte;
+    unsigned int offset = (georam[1] * 16384) + (georam[0] * 256) + addr;
+
+    georam_ram[offset] = byte;
+    RAMIMAGE_SET_DIRTY(&georam_image, offset);
 }
 
 static uint8_t georam_io2_peek(uint16_t addr)
@@ -253,6 +260,7 @@ void georam_powerup(void)
     }
     if (georam_ram) {
         ram_init_with_pattern(georam_ram, georam_size, &ramparam);
+        ramimage_set_dirty_range(&georam_image, 0, (size_t)georam_size);
     }
 }
 
@@ -262,29 +270,37 @@ static int georam_activate(void)
         return 0;
     }
 
-    georam_ram = lib_realloc((void *)georam_ram, (size_t)georam_size);
+    georam_ram = ramimage_map(&georam_image, georam_filename, (size_t)georam_size);
+    if (georam_ram == NULL) {
+        georam_ram = ramimage_alloc(&georam_image, (size_t)georam_size);
 
-    /* Clear newly allocated RAM.  */
-    if (georam_size > old_georam_ram_size) {
-        /* memset(georam_ram, 0, (size_t)(georam_size - old_georam_ram_size)); */
-        ram_init_with_pattern(&georam_ram[old_georam_ram_size],
-                              (unsigned int)(georam_size - old_georam_ram_size), &ramparam);
+        /* Clear newly allocated RAM.  */
+        if (georam_size > old_georam_ram_size) {
+            /* memset(georam_ram, 0, (size_t)(georam_size - old_georam_ram_size)); */
+            ram_init_with_pattern(&georam_ram[old_georam_ram_size],
+                                  (unsigned int)(georam_size - old_georam_ram_size), &ramparam);
+        }
+        ramimage_set_dirty_range(&georam_image, 0, (size_t)georam_size);
     }
 
     old_georam_ram_size = georam_size;
 
     log_message(georam_log, "%dKiB unit installed.", georam_size >> 10);
 
-    if (!util_check_null_string(georam_filename)) {
+    if (georam_image.mapped) {
+        log_message(georam_log, "Mapping GEORAM image %s.", georam_filename);
+    } else if (!util_check_null_string(georam_filename)) {
         if (util_file_load(georam_filename, georam_ram, (size_t)georam_size, UTIL_FILE_LOAD_RAW) < 0) {
             log_message(georam_log, "Reading GEORAM image %s failed.", georam_filename);
             if (util_file_save(georam_filename, georam_ram, georam_size) < 0) {
                 log_message(georam_log, "Creating GEORAM image %s failed.", georam_filename);
                 return -1;
             }
+            ramimage_set_synced(&georam_image, georam_filename);
             log_message(georam_log, "Creating GEORAM image %s.", georam_filename);
             return 0;
         }
+        ramimage_set_synced(&georam_image, georam_filename);
         log_message(georam_log, "Reading GEORAM image %s.", georam_filename);
     }
 
@@ -307,7 +323,7 @@ static int georam_deactivate(void)
         }
     }
 
-    lib_free(georam_ram);
+    ramimage_free(&georam_image);
     georam_ram = NULL;
     old_georam_ram_size = 0;
 
@@ -567,7 +583,8 @@ int georam_disable(void)
 
 void georam_config_setup(uint8_t *rawcart)
 {
-    if (georam_size > 0) {
+    /* a mapped image file already has the same contents */
+    if (georam_size > 0 && !georam_image.mapped) {
         memcpy(georam_ram, rawcart, georam_size);
     }
 }
@@ -613,7 +630,8 @@ int georam_bin_save(const char *filename)
         return -1;
     }
 
-    if (util_file_save(filename, georam_ram, georam_size) < 0) {
+    /* only the changed pages are written if the image came from this file */
+    if (ramimage_flush(&georam_image, filename) < 0) {
         return -1;
     }
 
@@ -709,6 +727,7 @@ int georam_read_snapshot_module(snapshot_t *s)
     if (SMR_BA(m, georam, sizeof(georam)) < 0 || SMR_BA(m, georam_ram, georam_size) < 0) {
         goto fail;
     }
+    ramimage_set_dirty_range(&georam_image, 0, (size_t)georam_size);
 
     snapshot_module_close(m);
     georam_enabled = 1;
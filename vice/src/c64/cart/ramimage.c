@@ -0,0 +1,316 @@
+/*
+ * ramimage.c - Backing store for RAM expansions saved to image files.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * RAM expansions like the REU, GeoRAM and RAMLink can keep their contents
+ * in an image file, which can be several megabytes large.
+ *
+ * If the image file already exists with the right size it is mapped into
+ * memory instead of being read in full, so only the pages read or written
+ * by the emulation are ever loaded.  The mapping is always private: the
+ * file only changes when the RAM is saved with ramimage_flush(), so the
+ * write back setting of the expansion can be changed at any time.
+ *
+ * Whether mapped or not, the pages changed since the image was last loaded
+ * or saved are tracked, so saving the image to the same file only writes
+ * those pages.
+ *
+ * Files are told apart by device and inode, not by name, since the same
+ * file can be given as a relative or an absolute path.  The mapped file is
+ * never truncated: the pages not yet copied on write are still read from
+ * it, and would fault if the file became shorter.
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+#define RAMIMAGE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "archdep.h"
+#include "lib.h"
+#include "ramimage.h"
+#include "types.h"
+#include "util.h"
+
+#define IS_DIRTY(img, page) ((img)->dirty[(page) >> 3] & (1 << ((page) & 7)))
+
+static size_t num_pages(size_t size)
+{
+    return (size + RAMIMAGE_PAGE_SIZE - 1) >> RAMIMAGE_PAGE_SHIFT;
+}
+
+static void set_size(ramimage_t *img, size_t size)
+{
+    lib_free(img->dirty);
+    img->dirty = lib_calloc((num_pages(size) + 7) >> 3, 1);
+    img->size = size;
+}
+
+#ifdef RAMIMAGE_MMAP
+/* Get the device and inode of a file, both 0 if it does not exist.  */
+static void file_id(const char *filename, uint64_t *dev, uint64_t *ino)
+{
+    struct stat st;
+
+    if (stat(filename, &st) < 0) {
+        *dev = 0;
+        *ino = 0;
+        return;
+    }
+    *dev = (uint64_t)st.st_dev;
+    *ino = (uint64_t)st.st_ino;
+}
+
+static int is_file(const char *filename, uint64_t dev, uint64_t ino)
+{
+    uint64_t file_dev, file_ino;
+
+    file_id(filename, &file_dev, &file_ino);
+    return file_ino != 0 && file_dev == dev && file_ino == ino;
+}
+#endif
+
+/* Write the pages marked dirty, or all pages, to an image file of the
+   right size without truncating it.  */
+static int write_pages(ramimage_t *img, const char *filename, int all)
+{
+    size_t page, first, pages, start, end;
+    FILE *fd;
+    int res = 0;
+
+    fd = fopen(filename, MODE_READ_WRITE);
+    if (fd == NULL) {
+        return -1;
+    }
+    if (archdep_file_size(fd) != (off_t)img->size) {
+        fclose(fd);
+        return -1;
+    }
+
+    pages = num_pages(img->size);
+    for (page = 0; page < pages && res == 0; ) {
+        if (!all && !IS_DIRTY(img, page)) {
+            page++;
+            continue;
+        }
+        for (first = page; page < pages && (all || IS_DIRTY(img, page)); page++) {
+        }
+        start = first << RAMIMAGE_PAGE_SHIFT;
+        end = page << RAMIMAGE_PAGE_SHIFT;
+        if (end > img->size) {
+            end = img->size;
+        }
+        if (util_fpwrite(fd, img->data + start, end - start, (long)start) < 0) {
+            res = -1;
+        }
+    }
+    if (fclose(fd) != 0) {
+        res = -1;
+    }
+    return res;
+}
+
+static int save_all(ramimage_t *img, const char *filename)
+{
+#ifdef RAMIMAGE_MMAP
+    if (img->mapped && is_file(filename, img->mapped_dev, img->mapped_ino)) {
+        /* util_file_save() would truncate the mapped file first */
+        if (write_pages(img, filename, 1) < 0) {
+            return -1;
+        }
+        ramimage_set_synced(img, filename);
+        return 0;
+    }
+#endif
+    if (util_file_save(filename, img->data, (int)img->size) < 0) {
+        return -1;
+    }
+    ramimage_set_synced(img, filename);
+    return 0;
+}
+
+/** \brief  Map an existing image file as RAM contents
+ *
+ * \param[in,out]   img         RAM image
+ * \param[in]       filename    image file
+ * \param[in]       size        size of the RAM
+ *
+ * \return  RAM contents, or NULL if the file could not be mapped
+ */
+uint8_t *ramimage_map(ramimage_t *img, const char *filename, size_t size)
+{
+#ifdef RAMIMAGE_MMAP
+    struct stat st;
+    void *data;
+    int fd;
+
+    ramimage_free(img);
+
+    if (util_check_null_string(filename)) {
+        return NULL;
+    }
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size != size) {
+        close(fd);
+        return NULL;
+    }
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    img->data = data;
+    img->mapped = 1;
+    img->mapped_dev = (uint64_t)st.st_dev;
+    img->mapped_ino = (uint64_t)st.st_ino;
+    set_size(img, size);
+    ramimage_set_synced(img, filename);
+    return img->data;
+#else
+    return NULL;
+#endif
+}
+
+/** \brief  Allocate RAM contents in memory
+ *
+ * Existing contents in memory are kept like with lib_realloc().
+ *
+ * \param[in,out]   img     RAM image
+ * \param[in]       size    size of the RAM
+ *
+ * \return  RAM contents
+ */
+uint8_t *ramimage_alloc(ramimage_t *img, size_t size)
+{
+    if (img->mapped) {
+        ramimage_free(img);
+    }
+    img->data = lib_realloc(img->data, size);
+    set_size(img, size);
+    lib_free(img->synced);
+    img->synced = NULL;
+    return img->data;
+}
+
+/** \brief  Release the RAM contents
+ *
+ * Nothing is saved, see ramimage_flush().
+ *
+ * \param[in,out]   img     RAM image
+ */
+void ramimage_free(ramimage_t *img)
+{
+    if (img->data != NULL) {
+#ifdef RAMIMAGE_MMAP
+        if (img->mapped) {
+            munmap(img->data, img->size);
+        } else
+#endif
+        {
+            lib_free(img->data);
+        }
+    }
+    img->data = NULL;
+    img->size = 0;
+    img->mapped = 0;
+    lib_free(img->dirty);
+    img->dirty = NULL;
+    lib_free(img->synced);
+    img->synced = NULL;
+}
+
+/** \brief  Note that the RAM contents match an image file
+ *
+ * \param[in,out]   img         RAM image
+ * \param[in]       filename    image file just loaded or saved
+ */
+void ramimage_set_synced(ramimage_t *img, const char *filename)
+{
+    util_string_set(&img->synced, filename);
+#ifdef RAMIMAGE_MMAP
+    file_id(filename, &img->synced_dev, &img->synced_ino);
+#endif
+    memset(img->dirty, 0, (num_pages(img->size) + 7) >> 3);
+}
+
+/** \brief  Note that a range of the RAM has been changed
+ *
+ * \param[in,out]   img     RAM image
+ * \param[in]       start   first changed byte
+ * \param[in]       len     number of bytes
+ */
+void ramimage_set_dirty_range(ramimage_t *img, size_t start, size_t len)
+{
+    size_t page;
+
+    if (len == 0) {
+        return;
+    }
+    for (page = start >> RAMIMAGE_PAGE_SHIFT; page <= (start + len - 1) >> RAMIMAGE_PAGE_SHIFT; page++) {
+        img->dirty[page >> 3] |= (uint8_t)(1 << (page & 7));
+    }
+}
+
+/** \brief  Save the RAM contents to an image file
+ *
+ * If the file is the one the RAM contents were loaded from or last saved
+ * to, only the pages changed since then are written.
+ *
+ * \param[in,out]   img         RAM image
+ * \param[in]       filename    image file
+ *
+ * \return  0 on success, -1 on error
+ */
+int ramimage_flush(ramimage_t *img, const char *filename)
+{
+    if (img->data == NULL || util_check_null_string(filename)) {
+        return -1;
+    }
+#ifdef RAMIMAGE_MMAP
+    if (img->synced == NULL || !is_file(filename, img->synced_dev, img->synced_ino)) {
+        return save_all(img, filename);
+    }
+#else
+    if (img->synced == NULL || strcmp(img->synced, filename) != 0) {
+        return save_all(img, filename);
+    }
+#endif
+
+    if (write_pages(img, filename, 0) < 0) {
+        return save_all(img, filename);
+    }
+    ramimage_set_synced(img, filename);
+    return 0;
+}
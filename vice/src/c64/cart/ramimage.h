@@ -0,0 +1,58 @@
+/*
+ * ramimage.h - Backing store for RAM expansions saved to image files.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_RAMIMAGE_H
+#define VICE_RAMIMAGE_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+#define RAMIMAGE_PAGE_SHIFT 12
+#define RAMIMAGE_PAGE_SIZE  (1 << RAMIMAGE_PAGE_SHIFT)
+
+typedef struct ramimage_s {
+    uint8_t *data;      /* the RAM contents */
+    size_t size;
+    int mapped;         /* data is mapped (privately) from the image file */
+    char *synced;       /* file which held the RAM contents when last loaded or saved */
+    uint64_t synced_dev;    /* device and inode of that file, if known */
+    uint64_t synced_ino;
+    uint64_t mapped_dev;    /* device and inode of the mapped file */
+    uint64_t mapped_ino;
+    uint8_t *dirty;     /* pages changed since then, one bit each */
+} ramimage_t;
+
+/* Remember that a byte of the RAM has been changed */
+#define RAMIMAGE_SET_DIRTY(img, addr) \
+    ((img)->dirty[(addr) >> (RAMIMAGE_PAGE_SHIFT + 3)] |= (uint8_t)(1 << (((addr) >> RAMIMAGE_PAGE_SHIFT) & 7)))
+
+uint8_t *ramimage_map(ramimage_t *img, const char *filename, size_t size);
+uint8_t *ramimage_alloc(ramimage_t *img, size_t size);
+void ramimage_free(ramimage_t *img);
+
+void ramimage_set_synced(ramimage_t *img, const char *filename);
+void ramimage_set_dirty_range(ramimage_t *img, size_t start, size_t len);
+int ramimage_flush(ramimage_t *img, const char *filename);
+
+#endif
@@ -50,6 +50,7 @@
 #include "lib.h"
 #include "machine.h"
 #include "ram.h"
+#include "ramimage.h"
 #include "resources.h"
 #include "cmdline.h"
 #include "maincpu.h"
@@ -136,6 +137,7 @@ static i8255a_state rl_i8255a;
 static uint8_t rl_i8255a_i[3];
 static uint8_t rl_i8255a_o[3];
 static uint8_t *rl_card = NULL;
+static ramimage_t rl_image; /* backing store of rl_card */
 static uint32_t rl_cardsize = 0;
 static uint32_t rl_cardsize_old = 0;
 static uint32_t rl_scanned = 0;
@@ -704,7 +706,8 @@ int ramlink_ram_save(const char *filename)
 
     if (!util_check_null_string(filename)) {
         LOG1((LOG, "RAMLINK: Writing RAMLINK memory image %s.", filename));
-        if (util_file_save(filename, rl_card, rl_cardsize) < 0) {
+        /* only the changed pages are written if the image came from this file */
+        if (ramimage_flush(&rl_image, filename) < 0) {
             CRIT((ERR, "RAMLINK: Writing RAMLINK memory image %s failed.",
                 filename));
             return -1;
@@ -772,10 +775,12 @@ static int ramlink_load_image(void)
                         rl_filename));
                     return -1;
                 }
+                ramimage_set_synced(&rl_image, rl_filename);
                 LOG1((LOG, "RAMLINK: Creating RAMLINK memory image %s.", rl_filename));
             }
             return 0;
         }
+        ramimage_set_synced(&rl_image, rl_filename);
         LOG1((LOG, "RAMLINK: Reading RAMLINK memory image %s.", rl_filename));
     }
 
@@ -809,7 +814,15 @@ static int ramlink_activate(void)
         return 0;
     }
 
-    rl_card = lib_realloc(rl_card, rl_cardsize);
+    rl_card = ramimage_map(&rl_image, rl_filename, rl_cardsize);
+    if (rl_card != NULL) {
+        rl_cardsize_old = rl_cardsize;
+        LOG1((LOG, "RAMLINK: %dMiB unit installed.", rl_cardsizemb));
+        LOG1((LOG, "RAMLINK: Mapping RAMLINK memory image %s.", rl_filename));
+        return 0;
+    }
+
+    rl_card = ramimage_alloc(&rl_image, rl_cardsize);
 
     /* Clear newly allocated RAM.  */
     if (rl_cardsize > rl_cardsize_old) {
@@ -817,6 +830,7 @@ static int ramlink_activate(void)
         ram_init_with_pattern(&rl_card[rl_cardsize_old],
                               (unsigned int)(rl_cardsize - rl_cardsize_old), &ramparam);
     }
+    ramimage_set_dirty_range(&rl_image, 0, rl_cardsize);
 
     rl_cardsize_old = rl_cardsize;
 
@@ -840,7 +854,7 @@ static int ramlink_deactivate(void)
 
     res = ramlink_save_image();
 
-    lib_free(rl_card);
+    ramimage_free(&rl_image);
     rl_card = NULL;
 
     return res;
@@ -1099,7 +1113,8 @@ int ramlink_resources_shutdown(void)
     }
 
     if (rl_card) {
-        lib_free(rl_card);
+        ramimage_free(&rl_image);
+        rl_card = NULL;
     }
 
     if (rl_ram) {
@@ -1320,6 +1335,7 @@ static void ramlink_io1_store(uint16_t addr, uint8_t value)
         old_val = rl_card[rl_cardbase | (addr & 0xff)];
 #endif
         rl_card[rl_cardbase | (addr & 0xff)] = value;
+        RAMIMAGE_SET_DIRTY(&rl_image, rl_cardbase | (addr & 0xff));
         IDBG((LOG, "RAMLINK: io1 w card[%06x] < %02x (%02x) at 0x%04x", rl_cardbase |
             (addr & 0xff), value, old_val, reg_pc));
         return;
@@ -1901,6 +1917,7 @@ int ramlink_snapshot_read_module(snapshot_t *s)
     if (SMR_BA(m, rl_card, rl_cardsize) < 0) {
         goto fail;
     }
+    ramimage_set_dirty_range(&rl_image, 0, rl_cardsize);
 
     snapshot_module_close(m);
 
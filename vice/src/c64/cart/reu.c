@@ -57,6 +57,7 @@
 #include "maincpu.h"
 #include "mem.h"
 #include "ram.h"
+#include "ramimage.h"
 #include "resources.h"
 #include "snapshot.h"
 #include "types.h"
@@ -229,6 +230,8 @@ static int reu_dma_active = 0;
 
 /*! \brief pointer to a buffer which holds the REU image.  */
 static uint8_t *reu_ram = NULL;
+/*! \brief backing store of reu_ram, mapped from the image file if possible */
+static ramimage_t reu_image;
 /*! \brief the old ram size of reu_ram. Used to determine if and how much of the
     buffer has to cleared when resizing the REU. */
 static unsigned int old_reu_ram_size = 0;
@@ -580,7 +583,8 @@ void reu_init(void)
 
 void reu_config_setup(uint8_t *rawcart)
 {
-    if (reu_size > 0) {
+    /* a mapped image file already has the same contents */
+    if (reu_size > 0 && !reu_image.mapped) {
         memcpy(reu_ram, rawcart, reu_size); /* FIXME */
     }
 }
@@ -660,6 +664,7 @@ static void reu_init_ram(void)
                 invertblock(0x02ac00 + ((i + b) << 16), 0x2a00);
             }
         }
+        ramimage_set_dirty_range(&reu_image, 0, reu_size);
     }
 }
 
@@ -680,16 +685,21 @@ static int reu_activate(void)
         return 0;
     }
 
-    reu_ram = lib_realloc(reu_ram, reu_size);
+    reu_ram = ramimage_map(&reu_image, reu_filename, reu_size);
+    if (reu_ram == NULL) {
+        reu_ram = ramimage_alloc(&reu_image, reu_size);
 
-    /* Clear newly allocated RAM.  */
-    reu_init_ram();
+        /* Clear newly allocated RAM.  */
+        reu_init_ram();
+    }
 
     old_reu_ram_size = reu_size;
 
     log_message(reu_log, "%uKiB unit installed.", reu_size >> 10);
 
-    if (!util_check_null_string(reu_filename)) {
+    if (reu_image.mapped) {
+        log_message(reu_log, "Mapping REU image %s.", reu_filename);
+    } else if (!util_check_null_string(reu_filename)) {
         if (util_file_load(reu_filename, reu_ram, (size_t)reu_size, UTIL_FILE_LOAD_RAW) < 0) {
             log_error(reu_log, "Reading REU image %s failed.", reu_filename);
             /* only create a new file if no file exists, so we dont accidently overwrite any files */
@@ -698,10 +708,12 @@ static int reu_activate(void)
                     log_error(reu_log, "Creating REU image %s failed.", reu_filename);
                     return -1;
                 }
+                ramimage_set_synced(&reu_image, reu_filename);
                 log_message(reu_log, "Creating REU image %s.", reu_filename);
             }
             return 0;
         }
+        ramimage_set_synced(&reu_image, reu_filename);
         log_message(reu_log, "Reading REU image %s.", reu_filename);
     }
 
@@ -724,7 +736,7 @@ static int reu_deactivate(void)
         }
     }
 
-    lib_free(reu_ram);
+    ramimage_free(&reu_image);
     reu_ram = NULL;
     old_reu_ram_size = 0;
 
@@ -793,7 +805,8 @@ int reu_bin_save(const char *filename)
         return -1;
     }
 
-    if (util_file_save(filename, reu_ram, reu_size) < 0) {
+    /* only the changed pages are written if the image came from this file */
+    if (ramimage_flush(&reu_image, filename) < 0) {
         return -1;
     }
 
@@ -1112,6 +1125,7 @@ inline static void store_to_reu(unsigned int reu_addr, uint8_t value)
     if (reu_addr < rec_options.not_backedup_addresses) {
         assert(reu_addr < reu_size);
         reu_ram[reu_addr] = value;
+        RAMIMAGE_SET_DIRTY(&reu_image, reu_addr);
     } else {
         DEBUG_LOG(DEBUG_LEVEL_NO_DRAM, (reu_log, "--> writing to REU address %05X, but no DRAM!", reu_addr));
     }
@@ -1665,6 +1679,7 @@ int reu_read_snapshot_module(snapshot_t *s)
     if (SMR_BA(m, reu, sizeof(reu)) < 0 || SMR_BA(m, reu_ram, reu_size) < 0) {
         goto fail;
     }
+    ramimage_set_dirty_range(&reu_image, 0, reu_size);
 
     if (reu[REU_REG_R_STATUS] & 0x80) {
         interrupt_restore_irq(maincpu_int_status, reu_int_num, 1);
@@ -0,0 +1,91 @@
+/*
+ * z80flags.c - Precomputed Z80 flag tables.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#include "types.h"
+#include "z80flags.h"
+
+/* Same as in z80core.c */
+#define C_FLAG  0x01
+#define N_FLAG  0x02
+#define P_FLAG  0x04
+#define H_FLAG  0x10
+#define Z_FLAG  0x40
+#define S_FLAG  0x80
+
+uint8_t z80flags_add[2 * 256 * 256];
+uint8_t z80flags_sub[2 * 256 * 256];
+uint8_t z80flags_inc[256];
+uint8_t z80flags_dec[256];
+
+static int z80flags_initialized = 0;
+
+static uint8_t z80flags_sz(unsigned int value)
+{
+    return (uint8_t)((value & S_FLAG) | (value ? 0 : Z_FLAG));
+}
+
+/* Fill the tables, the P flag holds the overflow for all of them.  */
+void z80flags_init(void)
+{
+    unsigned int a, value, carry, tmp;
+    uint8_t f;
+
+    if (z80flags_initialized) {
+        return;
+    }
+
+    for (carry = 0; carry < 2; carry++) {
+        for (a = 0; a < 256; a++) {
+            for (value = 0; value < 256; value++) {
+                unsigned int index = (carry << 16) | (a << 8) | value;
+
+                tmp = a + value + carry;
+                f = z80flags_sz(tmp & 0xff);
+                f |= (tmp & 0x100) ? C_FLAG : 0;
+                f |= (a ^ value ^ tmp) & H_FLAG;
+                f |= ((~(a ^ value)) & (a ^ tmp) & 0x80) ? P_FLAG : 0;
+                z80flags_add[index] = f;
+
+                tmp = (a - value - carry) & 0xff;
+                f = N_FLAG | z80flags_sz(tmp);
+                f |= (value + carry > a) ? C_FLAG : 0;
+                f |= (a ^ value ^ tmp) & H_FLAG;
+                f |= ((a ^ value) & (a ^ tmp) & 0x80) ? P_FLAG : 0;
+                z80flags_sub[index] = f;
+            }
+        }
+    }
+
+    for (tmp = 0; tmp < 256; tmp++) {
+        z80flags_inc[tmp] = z80flags_sz(tmp)
+                            | ((tmp == 0x80) ? P_FLAG : 0)
+                            | ((tmp & 0x0f) ? 0 : H_FLAG);
+        z80flags_dec[tmp] = N_FLAG | z80flags_sz(tmp)
+                            | ((tmp == 0x7f) ? P_FLAG : 0)
+                            | (((tmp & 0x0f) == 0x0f) ? H_FLAG : 0);
+    }
+
+    z80flags_initialized = 1;
+}
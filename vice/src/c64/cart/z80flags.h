@@ -0,0 +1,40 @@
+/*
+ * z80flags.h - Precomputed Z80 flag tables.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_Z80FLAGS_H
+#define VICE_Z80FLAGS_H
+
+#include "types.h"
+
+/* Flags after ADD/ADC and SUB/SBC/CP, indexed by
+   (carry << 16) | (a << 8) | value.  */
+extern uint8_t z80flags_add[2 * 256 * 256];
+extern uint8_t z80flags_sub[2 * 256 * 256];
+
+/* Flags after INC/DEC except for the carry, indexed by the result.  */
+extern uint8_t z80flags_inc[256];
+extern uint8_t z80flags_dec[256];
+
+void z80flags_init(void);
+
+#endif
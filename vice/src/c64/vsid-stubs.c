@@ -41,6 +41,7 @@
 #include "cbmdos.h"
 #include "cia.h"
 #include "clockport.h"
+#include "contentscache.h"
 #include "diskcontents.h"
 #include "diskcontents-block.h"
 #include "diskimage.h"
@@ -600,6 +601,15 @@ image_contents_t *diskcontents_block_read(struct vdrive_s *vdrive, int part)
     return NULL;
 }
 
+image_contents_t *contentscache_read(const char *path, read_contents_func_type func)
+{
+    return NULL;
+}
+
+void contentscache_shutdown(void)
+{
+}
+
 /*******************************************************************************
     fileio
 *******************************************************************************/
@@ -1060,6 +1070,25 @@ int tap_seek_to_offset(tap_t *tap, unsigned long offset)
     return 0;
 }
 
+int tap_index_total(tap_t *tap, tap_index_point_t *point)
+{
+    return -1;
+}
+
+int tap_index_next_point(tap_t *tap, int offset, tap_index_point_t *point)
+{
+    return -1;
+}
+
+int tap_index_prev_point(tap_t *tap, int offset, tap_index_point_t *point)
+{
+    return -1;
+}
+
+void tap_index_invalidate(tap_t *tap)
+{
+}
+
 int iec_available_busses(void)
 {
     return 0;
@@ -27,6 +27,7 @@
 #ifndef VICE_CARTIO_H
 #define VICE_CARTIO_H
 
+#include "perfcounters.h"
 #include "types.h"
 
 #define IO_DETACH_CART     0
@@ -264,6 +265,9 @@ typedef struct io_source_list_s {
     struct io_source_list_s *previous;
     io_source_t *device;
     struct io_source_list_s *next;
+#ifdef FEATURE_PERFCOUNTERS
+    perfcounters_named_t *perf; /*!< read/store counters for this device name */
+#endif
 } io_source_list_t;
 
 typedef struct io_source_detach_s {
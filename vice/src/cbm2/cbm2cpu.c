@@ -47,6 +47,7 @@
  - PAGE_ONE
  - STORE_IND
  - LOAD_IND
+ - HAVE_IDLE_SKIP
 
 */
 
@@ -64,6 +65,8 @@
 #define LOAD_IND(addr) \
     (*_mem_read_ind_tab_ptr[(addr) >> 8])((uint16_t)(addr))
 
+#define HAVE_IDLE_SKIP
+
 #ifdef FEATURE_CPUMEMHISTORY
 static void memmap_mem_store(unsigned int addr, unsigned int value)
 {
@@ -44,6 +44,7 @@
 #include "alarm.h"
 #include "maincpu.h"
 #include "monitor.h"
+#include "sectorcache.h"
 
 #define ATA_UNC  0x40
 #define ATA_IDNF 0x10
@@ -79,6 +80,7 @@ struct ata_drive_s {
     int bufp;
     uint8_t *buffer;
     FILE *file;
+    sectorcache_t *cache;
     char *filename;
     char *myname;
     ata_drive_geometry_t geometry;
@@ -92,6 +94,7 @@ struct ata_drive_s {
     ata_drive_type_t type;
     int busy; /* bits: spinup, seek, reset */
     int pos;
+    int xpos; /* next sector of the transfer */
     int standby, standby_max;
     alarm_t *spindle_alarm;
     alarm_t *head_alarm;
@@ -242,10 +245,8 @@ static int seek_sector(ata_drive_t *drv)
     drv->busy |= 2;
     alarm_set(drv->head_alarm, maincpu_clk + (CLOCK)(abs(drv->pos - lba) * drv->seek_time / drv->geometry.size));
     ata_change_power_mode(drv, 0xff);
-    if (archdep_fseeko(drv->file, (off_t)lba * drv->sector_size, SEEK_SET)) {
-        drv->error = drv->atapi ? 0x54 : ATA_IDNF;
-    }
     drv->pos = lba;
+    drv->xpos = lba;
     return drv->error;
 }
 
@@ -277,17 +278,13 @@ static int read_sector(ata_drive_t *drv)
         return drv->error;
     }
 
-    clearerr(drv->file);
-    if (fread(drv->buffer, drv->sector_size, 1, drv->file) != 1) {
-        memset(drv->buffer, 0, drv->sector_size);
-    }
-
-    if (ferror(drv->file)) {
+    if (sectorcache_read(drv->cache, (unsigned int)drv->xpos, drv->buffer) < 0) {
         ata_set_command_block(drv);
         drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
         drv->cmd = 0x00;
     } else {
         drv->pos++;
+        drv->xpos++;
         drv->bufp = 0;
     }
     return drv->error;
@@ -319,20 +316,14 @@ static int write_sector(ata_drive_t *drv)
         return drv->error;
     }
 
-    if (fwrite(drv->buffer, 1, drv->sector_size, drv->file) != (size_t)drv->sector_size) {
+    /* with the write cache enabled the sector is written in the background */
+    if (sectorcache_write(drv->cache, (unsigned int)drv->xpos, drv->buffer, drv->wcache) < 0) {
         ata_set_command_block(drv);
         drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
         drv->cmd = 0x00;
     } else {
         drv->pos++;
-    }
-
-    if (!drv->wcache) {
-        if (fflush(drv->file)) {
-            ata_set_command_block(drv);
-            drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
-            drv->cmd = 0x00;
-        }
+        drv->xpos++;
     }
     return drv->error;
 }
@@ -721,7 +712,7 @@ static void ata_execute_command(ata_drive_t *drv, uint8_t value)
             }
             debug((drv->log, "FLUSH CACHE"));
             if (drv->file) {
-                if (fflush(drv->file)) {
+                if (sectorcache_flush(drv->cache)) {
                     drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
                 }
             }
@@ -826,7 +817,7 @@ static void ata_execute_command(ata_drive_t *drv, uint8_t value)
                     debug((drv->log, "SET DISABLE WRITE CACHE"));
                     drv->wcache = 0;
                     if (drv->file) {
-                        fflush(drv->file);
+                        sectorcache_flush(drv->cache);
                     }
                     return;
                 case 0x99:
@@ -1188,7 +1179,7 @@ void ata_register_store(ata_drive_t *drv, uint16_t addr, uint16_t value)
                                     drv->bufp = 0;
                                     return;
                                 }
-                                if (!drv->file || fflush(drv->file)) {
+                                if (!drv->file) {
                                     drv->error = drv->atapi ? 0x54 : (ATA_UNC | ATA_ABRT);
                                     break;
                                 }
@@ -1253,6 +1244,8 @@ void ata_register_store(ata_drive_t *drv, uint16_t addr, uint16_t value)
 void ata_image_attach(ata_drive_t *drv, char *filename, ata_drive_type_t type, ata_drive_geometry_t geometry)
 {
     if (drv->file != NULL) {
+        sectorcache_close(drv->cache);
+        drv->cache = NULL;
         fclose(drv->file);
         drv->file = NULL;
     }
@@ -1297,6 +1290,7 @@ void ata_image_attach(ata_drive_t *drv, char *filename, ata_drive_type_t type, a
     }
 
     if (drv->file) {
+        drv->cache = sectorcache_open(drv->file, drv->sector_size);
         if (drv->atapi) {
             log_message(drv->log, "Attached `%s' %u sectors total.",
                     drv->filename, (unsigned int)drv->geometry.size);
@@ -1317,6 +1311,10 @@ void ata_image_attach(ata_drive_t *drv, char *filename, ata_drive_type_t type, a
 void ata_image_detach(ata_drive_t *drv)
 {
     if (drv->file != NULL) {
+        if (sectorcache_close(drv->cache) < 0) {
+            log_error(drv->log, "Cannot write cached sectors to `%s'.", drv->filename);
+        }
+        drv->cache = NULL;
         fclose(drv->file);
         drv->file = NULL;
         log_message(drv->log, "Detached.");
@@ -1368,7 +1366,6 @@ int ata_snapshot_write_module(ata_drive_t *drv, snapshot_t *s)
     CLOCK spindle_clk = CLOCK_MAX;
     CLOCK head_clk = CLOCK_MAX;
     CLOCK standby_clk = CLOCK_MAX;
-    off_t pos = 0;
 
     m = snapshot_module_create(s, drv->myname,
                                CART_DUMP_VER_MAJOR, CART_DUMP_VER_MINOR);
@@ -1386,10 +1383,7 @@ int ata_snapshot_write_module(ata_drive_t *drv, snapshot_t *s)
         standby_clk = drv->standby_alarm->context->pending_alarms[drv->standby_alarm->pending_idx].clk;
     }
     if (drv->file) {
-        pos = archdep_ftello(drv->file);
-        if (pos < 0) {
-            pos = 0;
-        }
+        sectorcache_flush(drv->cache);
     }
 
     SMW_STR(m, drv->filename);
@@ -1415,7 +1409,7 @@ int ata_snapshot_write_module(ata_drive_t *drv, snapshot_t *s)
     SMW_B(m, (uint8_t)drv->heads);
     SMW_B(m, (uint8_t)drv->sectors);
     SMW_DW(m, drv->pos);
-    SMW_DW(m, (uint32_t)(pos / drv->sector_size));
+    SMW_DW(m, (uint32_t)drv->xpos);
     SMW_B(m, (uint8_t)drv->wcache);
     SMW_B(m, (uint8_t)drv->lookahead);
     SMW_B(m, (uint8_t)drv->busy);
@@ -1436,7 +1430,7 @@ int ata_snapshot_read_module(ata_drive_t *drv, snapshot_t *s)
     CLOCK spindle_clk;
     CLOCK head_clk;
     CLOCK standby_clk;
-    int pos, type;
+    int type;
 
     m = snapshot_module_open(s, drv->myname, &vmajor, &vminor);
     if (m == NULL) {
@@ -1524,7 +1518,10 @@ int ata_snapshot_read_module(ata_drive_t *drv, snapshot_t *s)
     if (drv->pos < 0 || drv->pos > 268435455) {
         drv->pos = 0;
     }
-    SMR_DW_INT(m, &pos);
+    SMR_DW_INT(m, &drv->xpos);
+    if (drv->xpos < 0 || drv->xpos > 268435455) {
+        drv->xpos = 0;
+    }
     SMR_B_INT(m, &drv->wcache);
     if (drv->wcache) {
         drv->wcache = 1;
@@ -1556,9 +1553,6 @@ int ata_snapshot_read_module(ata_drive_t *drv, snapshot_t *s)
         alarm_unset(drv->standby_alarm);
     }
 
-    if (drv->file) {
-        archdep_fseeko(drv->file, (off_t)pos * drv->sector_size, SEEK_SET);
-    }
     if (!drv->atapi) { /* atapi supports disc change events */
         drv->readonly = 1; /* make sure for ata that there's no filesystem corruption */
     }
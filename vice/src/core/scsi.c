@@ -39,6 +39,7 @@
 #include "types.h"
 #include "snapshot.h"
 #include "scsi.h"
+#include "sectorcache.h"
 
 /* #define SCSILOG1 */
 /* #define SCSILOG2 */
@@ -70,6 +71,13 @@
 #define MAXIDS 7
 #define MAXLUNS 8
 
+/* sectors are written in the background if there's a thread to do it */
+#ifdef USE_VICE_THREAD
+#define SCSI_WRITEBACK 1
+#else
+#define SCSI_WRITEBACK 0
+#endif
+
 static off_t scsi_getmaxsize(struct scsi_context_s *context)
 {
     off_t work;
@@ -83,6 +91,7 @@ static off_t scsi_getmaxsize(struct scsi_context_s *context)
     if (context->file[(context->target << 3) | context->lun]) {
         if (!context->max_imagesize) {
             /* if the max length setting is zero, return the image length */
+            scsi_image_flush(context, (context->target << 3) | context->lun);
             work = archdep_file_size(context->file[(context->target << 3) | context->lun]);
             /* turn the file size into 512 byte sectors */
             work = (work >> 9) + (work & 511 ? 1 : 0);
@@ -116,12 +125,57 @@ static int32_t scsi_imagecheck(struct scsi_context_s *context)
     return 0;
 }
 
+/* The file may also be set directly by the user of the context, so the
+   cache is created on first use */
+static sectorcache_t *scsi_getcache(struct scsi_context_s *context)
+{
+    int disk = (context->target << 3) | context->lun;
+
+    if (!context->cache[disk]) {
+        context->cache[disk] = sectorcache_open(context->file[disk], 512);
+    }
+    return context->cache[disk];
+}
+
+/* write all cached sectors of a disk */
+int scsi_image_flush(struct scsi_context_s *context, int disk)
+{
+    if (disk < 0 || disk > 55) {
+        return 2;
+    }
+
+    if (context->cache[disk] && sectorcache_flush(context->cache[disk]) < 0) {
+        CRIT((ERR, "SCSI: error writing disk %d", disk >> 3));
+        return -1;
+    }
+
+    return 0;
+}
+
+/* write all cached sectors of a disk and drop the cache, must be called
+   before the file of a disk is changed or closed */
+void scsi_image_release(struct scsi_context_s *context, int disk)
+{
+    if (disk < 0 || disk > 55) {
+        return;
+    }
+
+    if (context->cache[disk]) {
+        if (sectorcache_close(context->cache[disk]) < 0) {
+            CRIT((ERR, "SCSI: error writing disk %d", disk >> 3));
+        }
+        context->cache[disk] = NULL;
+    }
+}
+
 int scsi_image_detach(struct scsi_context_s *context, int disk)
 {
     if (disk < 0 || disk > 55) {
         return 2;
     }
 
+    scsi_image_release(context, disk);
+
     if (context->file[disk]) {
         fclose(context->file[disk]);
         context->file[disk] = NULL;
@@ -161,33 +215,16 @@ int scsi_image_attach(struct scsi_context_s *context, int disk, char *filename)
 
 int32_t scsi_image_read(struct scsi_context_s *context)
 {
-    int32_t i;
-    FILE *fhd;
-
     if (scsi_imagecheck(context)) {
         return -1;
     }
 
-    fhd = context->file[(context->target << 3) | context->lun];
-
-    if (archdep_fseeko(fhd, (off_t)context->address * 512, SEEK_SET) < 0) {
-        CRIT((ERR, "SCSI: error seeking disk %d at sector 0x%x",
+    /* a read beyond the EOF is filled with zeros and is good */
+    if (sectorcache_read(scsi_getcache(context), context->address,
+            context->data_buf) < 0) {
+        CRIT((ERR, "SCSI: error reading disk %d at sector 0x%x",
             context->target, context->address));
-        return -3;
-    }
-
-    if (fread(context->data_buf, 512, 1, fhd) < 1) {
-        if (!feof(fhd)) {
-            CRIT((ERR, "SCSI: error reading disk %d at sector 0x%x",
-                context->target, context->address));
-            return -4;
-        }
-
-        /* if there is a read beyond the EOF, fill it with zeros and say it
-            is good */
-        for ( i = 0; i < 512; i++) {
-            context->data_buf[i] = 0;
-        }
+        return -4;
     }
 
     LOG2((LOG, "SCSI: read disk %d at sector 0x%x", context->target,
@@ -204,8 +241,6 @@ int32_t scsi_image_read(struct scsi_context_s *context)
 
 int32_t scsi_image_write(struct scsi_context_s *context)
 {
-    FILE *fhd;
-
     if (scsi_imagecheck(context)) {
         return -1;
     }
@@ -216,20 +251,12 @@ int32_t scsi_image_write(struct scsi_context_s *context)
         context->user_write(context);
     }
 
-    fhd = context->file[(context->target << 3) | context->lun];
-
-    if (archdep_fseeko(fhd, (off_t)context->address * 512, SEEK_SET) < 0) {
-        CRIT((ERR, "SCSI: error seeking disk %d at sector 0x%x",
-            context->target, context->address));
-        return -3;
-    }
-
-    if (fwrite(context->data_buf, 512, 1, fhd) < 1) {
+    if (sectorcache_write(scsi_getcache(context), context->address,
+            context->data_buf, SCSI_WRITEBACK) < 0) {
         CRIT((ERR, "SCSI: error writing disk %d at sector 0x%x",
             context->target, context->address));
         return -4;
     }
-    fflush(fhd);
 
     LOG2((LOG, "SCSI: write disk %d at sector 0x%x", context->target,
         context->address));
@@ -516,6 +543,8 @@ void scsi_process_ack(struct scsi_context_s *context)
                 case SCSI_COMMAND_WRITE_VERIFY:
                     /* fall through */
                 case SCSI_COMMAND_VERIFY:
+                    /* fall through */
+                case SCSI_COMMAND_SYNCHRONIZE_CACHE:
                     context->cmd_size = 10;
                     break;
                 default:
@@ -792,6 +821,18 @@ void scsi_process_ack(struct scsi_context_s *context)
                     context->status = SCSI_STATUS_GOOD;
                     context->state = SCSI_STATE_STATUS;
                     break;
+                case SCSI_COMMAND_SYNCHRONIZE_CACHE:
+                    context->lun = (context->cmd_buf[1] >> 5) & 7;
+                    context->link = context->cmd_buf[9] & 1;
+                    if (!scsi_imagecheck(context) &&
+                        !scsi_image_flush(context, (context->target << 3) | context->lun)) {
+                        context->status = SCSI_STATUS_GOOD;
+                    } else {
+                        context->sensekey = SCSI_SENSEKEY_MEDIUMERROR;
+                        context->status = SCSI_STATUS_CHECKCONDITION;
+                    }
+                    context->state = SCSI_STATE_STATUS;
+                    break;
                 }
             }
         } while (0);
@@ -921,6 +962,12 @@ void scsi_reset(struct scsi_context_s *context)
 int scsi_snapshot_write_module(struct scsi_context_s *context, snapshot_t *s)
 {
     snapshot_module_t *m;
+    int i;
+
+    /* make sure the images are up to date */
+    for (i = 0; i < 56; i++) {
+        scsi_image_flush(context, i);
+    }
 
     m = snapshot_module_create(s, context->myname, SNAP_MAJOR, SNAP_MINOR);
 
@@ -0,0 +1,597 @@
+/*
+ * sectorcache.c - Sector cache for block device images.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * The ATA and SCSI devices transfer one sector at a time, which used to be
+ * one seek and one read or write (plus a flush) on the image file each.
+ *
+ * The cache keeps the most recently used sectors of an image.  Misses
+ * which continue a sequential run read ahead, starting with one sector
+ * and doubling up to SECTORCACHE_RUN sectors per read.
+ *
+ * Writes are either written through (and flushed) right away, or only
+ * marked dirty when the caller asks for write-back, which the devices do
+ * when the emulated write cache is enabled.  Dirty sectors are written by
+ * a writer thread in sorted, coalesced runs.  sectorcache_flush() writes
+ * all of them before it returns, and reports any error the writer ran
+ * into since the last flush, just like a FLUSH CACHE command would.
+ *
+ * Without threads the dirty sectors are written out once
+ * SECTORCACHE_DIRTY_MAX of them have accumulated, when one of them has
+ * to be evicted, or on a flush.
+ *
+ * Two locks are used: "lock" protects the cache structures and "io_lock"
+ * the file.  Whoever needs both takes io_lock first.  Hits only need the
+ * cache lock, so they do not wait for the writer thread doing I/O.
+ */
+
+#include "vice.h"
+
+/* required for off_t on some platforms */
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "lib.h"
+#include "log.h"
+#include "sectorcache.h"
+#include "types.h"
+
+#ifdef USE_VICE_THREAD
+#   include <pthread.h>
+#   define CACHE_LOCK(c) pthread_mutex_lock(&(c)->lock)
+#   define CACHE_UNLOCK(c) pthread_mutex_unlock(&(c)->lock)
+#   define IO_LOCK(c) pthread_mutex_lock(&(c)->io_lock)
+#   define IO_UNLOCK(c) pthread_mutex_unlock(&(c)->io_lock)
+#else
+#   define CACHE_LOCK(c)
+#   define CACHE_UNLOCK(c)
+#   define IO_LOCK(c)
+#   define IO_UNLOCK(c)
+#endif
+
+/* number of cached sectors */
+#define SECTORCACHE_ENTRIES 1024
+
+/* number of hash buckets, must be a power of two */
+#define SECTORCACHE_HASH_SIZE 2048
+
+/* maximum number of sectors read ahead or written in one go */
+#define SECTORCACHE_RUN 64
+
+/* dirty sectors kept back when there's no writer thread */
+#define SECTORCACHE_DIRTY_MAX 256
+
+#define NONE (-1)
+
+typedef struct sectorcache_entry_s {
+    unsigned int lba;
+    unsigned int gen;   /* changes whenever the data is changed */
+    int valid;
+    int dirty;
+    int hash_next;
+    int lru_prev;       /* towards the most recently used one */
+    int lru_next;
+} sectorcache_entry_t;
+
+typedef struct sectorcache_order_s {
+    unsigned int lba;
+    int index;
+} sectorcache_order_t;
+
+struct sectorcache_s {
+    FILE *file;
+    int sector_size;
+    uint8_t *data;
+    uint8_t *read_run;      /* staging buffers, used with io_lock held */
+    uint8_t *write_run;
+    sectorcache_entry_t entries[SECTORCACHE_ENTRIES];
+    sectorcache_order_t order[SECTORCACHE_ENTRIES];
+    int hash[SECTORCACHE_HASH_SIZE];
+    int lru_first;
+    int lru_last;
+    int dirty_count;
+    unsigned int gen;
+    unsigned int next_lba;  /* sector following the last one read */
+    int readahead;
+    int error;
+#ifdef USE_VICE_THREAD
+    pthread_mutex_t lock;
+    pthread_mutex_t io_lock;
+    pthread_cond_t cond;
+    pthread_t writer;
+    int writer_state;       /* 0: not started, 1: running, -1: failed */
+    int quit;
+#endif
+};
+
+/* ------------------------------------------------------------------------- */
+
+static int hash_bucket(unsigned int lba)
+{
+    return (int)(lba & (SECTORCACHE_HASH_SIZE - 1));
+}
+
+static int lookup(sectorcache_t *cache, unsigned int lba)
+{
+    int i;
+
+    for (i = cache->hash[hash_bucket(lba)]; i != NONE; i = cache->entries[i].hash_next) {
+        if (cache->entries[i].lba == lba) {
+            break;
+        }
+    }
+    return i;
+}
+
+static void hash_remove(sectorcache_t *cache, int i)
+{
+    int *p = &cache->hash[hash_bucket(cache->entries[i].lba)];
+
+    while (*p != i) {
+        p = &cache->entries[*p].hash_next;
+    }
+    *p = cache->entries[i].hash_next;
+}
+
+static void touch(sectorcache_t *cache, int i)
+{
+    sectorcache_entry_t *e = &cache->entries[i];
+
+    if (cache->lru_first == i) {
+        return;
+    }
+    /* unlink */
+    cache->entries[e->lru_prev].lru_next = e->lru_next;
+    if (e->lru_next != NONE) {
+        cache->entries[e->lru_next].lru_prev = e->lru_prev;
+    } else {
+        cache->lru_last = e->lru_prev;
+    }
+    /* and put it in front */
+    e->lru_prev = NONE;
+    e->lru_next = cache->lru_first;
+    cache->entries[cache->lru_first].lru_prev = i;
+    cache->lru_first = i;
+}
+
+static void mark_dirty(sectorcache_t *cache, int i)
+{
+    sectorcache_entry_t *e = &cache->entries[i];
+
+    e->gen = ++cache->gen;
+    if (!e->dirty) {
+        e->dirty = 1;
+        cache->dirty_count++;
+    }
+#ifdef USE_VICE_THREAD
+    pthread_cond_signal(&cache->cond);
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Read sectors from the file, the part beyond the end reads as zeros */
+static int file_read(sectorcache_t *cache, unsigned int lba, uint8_t *buf, int count)
+{
+    size_t n;
+
+    clearerr(cache->file);
+    if (archdep_fseeko(cache->file, (off_t)lba * cache->sector_size, SEEK_SET)) {
+        return -1;
+    }
+    n = fread(buf, (size_t)cache->sector_size, (size_t)count, cache->file);
+    if (n < (size_t)count) {
+        if (ferror(cache->file)) {
+            return -1;
+        }
+        memset(buf + n * cache->sector_size, 0, (count - n) * cache->sector_size);
+    }
+    return 0;
+}
+
+static int file_write(sectorcache_t *cache, unsigned int lba, const uint8_t *buf, int count)
+{
+    if (archdep_fseeko(cache->file, (off_t)lba * cache->sector_size, SEEK_SET)) {
+        return -1;
+    }
+    if (fwrite(buf, (size_t)cache->sector_size, (size_t)count, cache->file) != (size_t)count) {
+        return -1;
+    }
+    return 0;
+}
+
+static int compare_order(const void *a, const void *b)
+{
+    unsigned int la = ((const sectorcache_order_t *)a)->lba;
+    unsigned int lb = ((const sectorcache_order_t *)b)->lba;
+
+    return (la > lb) - (la < lb);
+}
+
+/* Write all dirty sectors in sorted, coalesced runs.  Called with both
+   locks held, the cache lock is released during the actual writes. */
+static void write_dirty(sectorcache_t *cache)
+{
+    unsigned int gens[SECTORCACHE_RUN];
+    int i, j, k, n = 0, res;
+    sectorcache_entry_t *e;
+
+    for (i = 0; i < SECTORCACHE_ENTRIES; i++) {
+        if (cache->entries[i].dirty) {
+            cache->order[n].lba = cache->entries[i].lba;
+            cache->order[n].index = i;
+            n++;
+        }
+    }
+    if (n == 0) {
+        return;
+    }
+    qsort(cache->order, (size_t)n, sizeof(cache->order[0]), compare_order);
+
+    for (i = 0; i < n; i = j) {
+        for (j = i; j < n && j - i < SECTORCACHE_RUN
+             && cache->order[j].lba == cache->order[i].lba + (unsigned int)(j - i); j++) {
+            k = cache->order[j].index;
+            memcpy(cache->write_run + (j - i) * cache->sector_size,
+                   cache->data + k * cache->sector_size, (size_t)cache->sector_size);
+            gens[j - i] = cache->entries[k].gen;
+        }
+        CACHE_UNLOCK(cache);
+        res = file_write(cache, cache->order[i].lba, cache->write_run, j - i);
+        CACHE_LOCK(cache);
+        if (res < 0 && !cache->error) {
+            log_error(LOG_DEFAULT, "Sector cache: cannot write sectors %u-%u.",
+                      cache->order[i].lba, cache->order[j - 1].lba);
+            cache->error = 1;
+        }
+        /* sectors changed in the meantime stay dirty */
+        for (k = i; k < j; k++) {
+            e = &cache->entries[cache->order[k].index];
+            if (e->dirty && e->gen == gens[k - i]) {
+                e->dirty = 0;
+                cache->dirty_count--;
+            }
+        }
+    }
+
+    CACHE_UNLOCK(cache);
+    if (fflush(cache->file)) {
+        cache->error = 1;
+    }
+    CACHE_LOCK(cache);
+}
+
+/* Get an entry for a sector which is not in the cache, called with both
+   locks held */
+static int alloc_entry(sectorcache_t *cache, unsigned int lba)
+{
+    int i = cache->lru_last;
+    int bucket = hash_bucket(lba);
+    sectorcache_entry_t *e = &cache->entries[i];
+
+    if (e->dirty) {
+        write_dirty(cache);
+    }
+    if (e->valid) {
+        hash_remove(cache, i);
+    }
+    e->lba = lba;
+    e->gen = ++cache->gen;
+    e->valid = 1;
+    e->dirty = 0;
+    e->hash_next = cache->hash[bucket];
+    cache->hash[bucket] = i;
+    touch(cache, i);
+    return i;
+}
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef USE_VICE_THREAD
+static void *writer_thread(void *arg)
+{
+    sectorcache_t *cache = arg;
+
+    CACHE_LOCK(cache);
+    while (!cache->quit) {
+        if (cache->dirty_count == 0) {
+            pthread_cond_wait(&cache->cond, &cache->lock);
+            continue;
+        }
+        CACHE_UNLOCK(cache);
+        IO_LOCK(cache);
+        CACHE_LOCK(cache);
+        write_dirty(cache);
+        CACHE_UNLOCK(cache);
+        IO_UNLOCK(cache);
+        CACHE_LOCK(cache);
+    }
+    CACHE_UNLOCK(cache);
+    return NULL;
+}
+
+/* Start the writer on the first write-back, returns 0 if it's running */
+static int writer_start(sectorcache_t *cache)
+{
+    if (cache->writer_state == 0) {
+        if (pthread_create(&cache->writer, NULL, writer_thread, cache)) {
+            log_warning(LOG_DEFAULT, "Sector cache: cannot start writer thread, writing through.");
+            cache->writer_state = -1;
+        } else {
+            cache->writer_state = 1;
+        }
+    }
+    return cache->writer_state > 0 ? 0 : -1;
+}
+#endif
+
+/* Without a writer thread dirty sectors may only pile up so much */
+static void writer_check(sectorcache_t *cache)
+{
+#ifndef USE_VICE_THREAD
+    if (cache->dirty_count >= SECTORCACHE_DIRTY_MAX) {
+        write_dirty(cache);
+    }
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+
+/** \brief  Create a sector cache for an image file
+ *
+ * The file remains owned by the caller, but must not be accessed directly
+ * until the cache is closed.
+ *
+ * \param[in]   file        image file
+ * \param[in]   sector_size sector size in bytes
+ *
+ * \return  sector cache
+ */
+sectorcache_t *sectorcache_open(FILE *file, int sector_size)
+{
+    sectorcache_t *cache = lib_calloc(1, sizeof(sectorcache_t));
+    int i;
+
+    cache->file = file;
+    cache->sector_size = sector_size;
+    cache->data = lib_malloc((size_t)SECTORCACHE_ENTRIES * sector_size);
+    cache->read_run = lib_malloc((size_t)SECTORCACHE_RUN * sector_size);
+    cache->write_run = lib_malloc((size_t)SECTORCACHE_RUN * sector_size);
+
+    for (i = 0; i < SECTORCACHE_HASH_SIZE; i++) {
+        cache->hash[i] = NONE;
+    }
+    for (i = 0; i < SECTORCACHE_ENTRIES; i++) {
+        cache->entries[i].hash_next = NONE;
+        cache->entries[i].lru_prev = i - 1;
+        cache->entries[i].lru_next = (i + 1 < SECTORCACHE_ENTRIES) ? i + 1 : NONE;
+    }
+    cache->lru_first = 0;
+    cache->lru_last = SECTORCACHE_ENTRIES - 1;
+    cache->next_lba = 0;
+    cache->readahead = 1;
+
+#ifdef USE_VICE_THREAD
+    pthread_mutex_init(&cache->lock, NULL);
+    pthread_mutex_init(&cache->io_lock, NULL);
+    pthread_cond_init(&cache->cond, NULL);
+#endif
+    return cache;
+}
+
+/** \brief  Write all dirty sectors and free the cache
+ *
+ * \param[in]   cache   sector cache
+ *
+ * \return  0 on success, -1 if sectors could not be written
+ */
+int sectorcache_close(sectorcache_t *cache)
+{
+    int res;
+
+    if (cache == NULL) {
+        return 0;
+    }
+
+#ifdef USE_VICE_THREAD
+    if (cache->writer_state > 0) {
+        CACHE_LOCK(cache);
+        cache->quit = 1;
+        pthread_cond_signal(&cache->cond);
+        CACHE_UNLOCK(cache);
+        pthread_join(cache->writer, NULL);
+    }
+#endif
+    res = sectorcache_flush(cache);
+
+#ifdef USE_VICE_THREAD
+    pthread_cond_destroy(&cache->cond);
+    pthread_mutex_destroy(&cache->io_lock);
+    pthread_mutex_destroy(&cache->lock);
+#endif
+    lib_free(cache->write_run);
+    lib_free(cache->read_run);
+    lib_free(cache->data);
+    lib_free(cache);
+    return res;
+}
+
+/** \brief  Read a sector
+ *
+ * \param[in]   cache   sector cache
+ * \param[in]   lba     sector number
+ * \param[out]  buf     sector data, zeros beyond the end of the file
+ *
+ * \return  0 on success, -1 on error
+ */
+int sectorcache_read(sectorcache_t *cache, unsigned int lba, uint8_t *buf)
+{
+    int i, k, count;
+
+    CACHE_LOCK(cache);
+    i = lookup(cache, lba);
+    if (i != NONE) {
+        memcpy(buf, cache->data + i * cache->sector_size, (size_t)cache->sector_size);
+        touch(cache, i);
+        cache->next_lba = lba + 1;
+        CACHE_UNLOCK(cache);
+        return 0;
+    }
+    CACHE_UNLOCK(cache);
+
+    IO_LOCK(cache);
+    CACHE_LOCK(cache);
+    if (lba == cache->next_lba) {
+        cache->readahead *= 2;
+        if (cache->readahead > SECTORCACHE_RUN) {
+            cache->readahead = SECTORCACHE_RUN;
+        }
+    } else {
+        cache->readahead = 1;
+    }
+    count = cache->readahead;
+
+    if (file_read(cache, lba, cache->read_run, count) < 0) {
+        CACHE_UNLOCK(cache);
+        IO_UNLOCK(cache);
+        return -1;
+    }
+    memcpy(buf, cache->read_run, (size_t)cache->sector_size);
+
+    /* sectors already cached may be newer than the file */
+    for (k = count - 1; k >= 0; k--) {
+        if (lookup(cache, lba + k) == NONE) {
+            i = alloc_entry(cache, lba + k);
+            memcpy(cache->data + i * cache->sector_size,
+                   cache->read_run + k * cache->sector_size, (size_t)cache->sector_size);
+        }
+    }
+    cache->next_lba = lba + 1;
+    CACHE_UNLOCK(cache);
+    IO_UNLOCK(cache);
+    return 0;
+}
+
+/** \brief  Write a sector
+ *
+ * \param[in]   cache       sector cache
+ * \param[in]   lba         sector number
+ * \param[in]   buf         sector data
+ * \param[in]   writeback   write the sector later instead of right away
+ *
+ * \return  0 on success, -1 on error
+ */
+int sectorcache_write(sectorcache_t *cache, unsigned int lba, const uint8_t *buf, int writeback)
+{
+    sectorcache_entry_t *e;
+    int i, res = 0;
+
+#ifdef USE_VICE_THREAD
+    if (writeback && writer_start(cache) < 0) {
+        writeback = 0;
+    }
+#endif
+
+    if (writeback) {
+        CACHE_LOCK(cache);
+        i = lookup(cache, lba);
+        if (i != NONE) {
+            memcpy(cache->data + i * cache->sector_size, buf, (size_t)cache->sector_size);
+            touch(cache, i);
+            mark_dirty(cache, i);
+            writer_check(cache);
+            CACHE_UNLOCK(cache);
+            return 0;
+        }
+        CACHE_UNLOCK(cache);
+    }
+
+    IO_LOCK(cache);
+    CACHE_LOCK(cache);
+    i = lookup(cache, lba);
+    if (i == NONE) {
+        i = alloc_entry(cache, lba);
+    } else {
+        touch(cache, i);
+    }
+    memcpy(cache->data + i * cache->sector_size, buf, (size_t)cache->sector_size);
+
+    if (writeback) {
+        mark_dirty(cache, i);
+        writer_check(cache);
+    } else {
+        e = &cache->entries[i];
+        e->gen = ++cache->gen;
+        if (e->dirty) {
+            e->dirty = 0;
+            cache->dirty_count--;
+        }
+        if (file_write(cache, lba, buf, 1) < 0 || fflush(cache->file)) {
+            res = -1;
+        }
+    }
+    CACHE_UNLOCK(cache);
+    IO_UNLOCK(cache);
+    return res;
+}
+
+/** \brief  Write all dirty sectors to the file
+ *
+ * \param[in]   cache   sector cache
+ *
+ * \return  0 on success, -1 if sectors could not be written since the
+ *          last flush
+ */
+int sectorcache_flush(sectorcache_t *cache)
+{
+    int res;
+
+    IO_LOCK(cache);
+    CACHE_LOCK(cache);
+    write_dirty(cache);
+    if (fflush(cache->file)) {
+        cache->error = 1;
+    }
+    res = cache->error ? -1 : 0;
+    cache->error = 0;
+    CACHE_UNLOCK(cache);
+    IO_UNLOCK(cache);
+    return res;
+}
+
+/** \brief  Get the image file of a sector cache
+ *
+ * \param[in]   cache   sector cache
+ *
+ * \return  image file
+ */
+FILE *sectorcache_file(sectorcache_t *cache)
+{
+    return cache->file;
+}
@@ -0,0 +1,41 @@
+/*
+ * sectorcache.h - Sector cache for block device images.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_SECTORCACHE_H
+#define VICE_SECTORCACHE_H
+
+#include <stdio.h>
+
+#include "types.h"
+
+typedef struct sectorcache_s sectorcache_t;
+
+sectorcache_t *sectorcache_open(FILE *file, int sector_size);
+int sectorcache_close(sectorcache_t *cache);
+
+int sectorcache_read(sectorcache_t *cache, unsigned int lba, uint8_t *buf);
+int sectorcache_write(sectorcache_t *cache, unsigned int lba, const uint8_t *buf, int writeback);
+int sectorcache_flush(sectorcache_t *cache);
+FILE *sectorcache_file(sectorcache_t *cache);
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * cpudispatch.h - Opcode dispatch for the CPU emulation cores.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_CPUDISPATCH_H
+#define VICE_CPUDISPATCH_H
+
+/*
+ * The CPU cores dispatch their opcodes with
+ *
+ *     OPCODE_SWITCH(p0) {
+ *         OPCODE_CASE(0x00):
+ *             ...
+ *             OPCODE_NEXT;
+ *         ...
+ *     } OPCODE_SWITCH_END
+ *
+ * Normally this is a plain `switch' and every core defines OPCODE_NEXT as
+ * `break'.  When configured with --enable-threaded-dispatch and the
+ * compiler supports labels as values (GCC and Clang), every opcode gets a
+ * label instead and OPCODE_DISPATCH() jumps through a table of their
+ * addresses.  The cores then define OPCODE_NEXT to fetch the next opcode
+ * and dispatch it right at the end of each opcode whenever nothing else
+ * (interrupts, alarms, the loop around the core) needs attention first, so
+ * every opcode has an indirect jump of its own for the branch predictor to
+ * learn from.  Otherwise OPCODE_NEXT leaves the opcode for the main loop,
+ * as does a `break', which leaves the surrounding `do { } while (0)'.
+ *
+ * Every value the opcode can take needs an OPCODE_CASE(), written as a
+ * lower case two digit hex number; cores with more than 256 values use
+ * OPCODE_SWITCH_TABLE() with their own list.
+ */
+
+#if defined(USE_THREADED_DISPATCH) && defined(__GNUC__)
+
+#define OPCODE_CASE(n)  op_##n
+#define OPCODE_LABEL(n) &&op_##n
+
+#define OPCODE_LABEL_ROW(h)                                           \
+    OPCODE_LABEL(0x##h##0), OPCODE_LABEL(0x##h##1),                   \
+    OPCODE_LABEL(0x##h##2), OPCODE_LABEL(0x##h##3),                   \
+    OPCODE_LABEL(0x##h##4), OPCODE_LABEL(0x##h##5),                   \
+    OPCODE_LABEL(0x##h##6), OPCODE_LABEL(0x##h##7),                   \
+    OPCODE_LABEL(0x##h##8), OPCODE_LABEL(0x##h##9),                   \
+    OPCODE_LABEL(0x##h##a), OPCODE_LABEL(0x##h##b),                   \
+    OPCODE_LABEL(0x##h##c), OPCODE_LABEL(0x##h##d),                   \
+    OPCODE_LABEL(0x##h##e), OPCODE_LABEL(0x##h##f)
+
+#define OPCODE_LABELS_256                                             \
+    OPCODE_LABEL_ROW(0), OPCODE_LABEL_ROW(1), OPCODE_LABEL_ROW(2),    \
+    OPCODE_LABEL_ROW(3), OPCODE_LABEL_ROW(4), OPCODE_LABEL_ROW(5),    \
+    OPCODE_LABEL_ROW(6), OPCODE_LABEL_ROW(7), OPCODE_LABEL_ROW(8),    \
+    OPCODE_LABEL_ROW(9), OPCODE_LABEL_ROW(a), OPCODE_LABEL_ROW(b),    \
+    OPCODE_LABEL_ROW(c), OPCODE_LABEL_ROW(d), OPCODE_LABEL_ROW(e),    \
+    OPCODE_LABEL_ROW(f)
+
+/* The table stays in scope up to OPCODE_SWITCH_END, so that OPCODE_NEXT
+   can use it.  */
+#define OPCODE_SWITCH_TABLE(op, labels)                               \
+    {                                                                 \
+        static const void * const opcode_dispatch_tab[] = { labels }; \
+        OPCODE_DISPATCH(op);                                          \
+        do
+
+#define OPCODE_SWITCH_END while (0); }
+
+#define OPCODE_DISPATCH(op) goto *opcode_dispatch_tab[(op)]
+
+/* GCC merges all the computed gotos of a function into one and copies it
+   back into each opcode late, if it is still small enough.  When the SLP
+   vectorizer packs the CPU registers together, unpacking them makes the
+   merged jump too big for that, so the functions running a core are
+   declared with OPCODE_DISPATCH_FUNC.  */
+#ifdef __clang__
+#define OPCODE_DISPATCH_FUNC
+#else
+#define OPCODE_DISPATCH_FUNC __attribute__((optimize("no-tree-slp-vectorize")))
+#endif
+
+#else
+
+#define OPCODE_CASE(n) case n
+
+#define OPCODE_SWITCH_TABLE(op, labels) switch (op)
+
+#define OPCODE_SWITCH_END
+
+#define OPCODE_DISPATCH_FUNC
+
+#endif
+
+#define OPCODE_SWITCH(op) OPCODE_SWITCH_TABLE(op, OPCODE_LABELS_256)
+
+#endif
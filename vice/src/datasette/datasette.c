@@ -687,6 +687,58 @@ static CLOCK datasette_read_gap(int port, int direction)
     return gap;
 }
 
+/* counter position of a point of the TAP index, as datasette_read_gap() would
+   count it */
+static int datasette_index_counter(int port, const tap_index_point_t *point)
+{
+    uint64_t cycles = point->cycles;
+    uint64_t gaps = (uint64_t)point->pulse;
+
+    if (current_image[port]->version == 2) {
+        /* every half wave is a gap */
+        gaps *= 2;
+    }
+    cycles += gaps * (uint64_t)datasette_speed_tuning;
+    if ((machine_tape_behaviour() == TAPE_BEHAVIOUR_C16)
+        && (current_image[port]->version >= 1)) {
+        cycles *= 2;
+    }
+    return (int)(cycles / 8);
+}
+
+/* when winding, jump to the next point of the TAP index instead of reading
+   every gap; returns the gap covered or 0 if there is no point */
+static CLOCK datasette_wind_gap(int port, int direction)
+{
+    tap_t *tap = current_image[port];
+    tap_index_point_t point;
+    int counter, diff;
+
+    if (direction > 0) {
+        if (tap_index_next_point(tap, tap->current_file_seek_position, &point) < 0) {
+            return 0;
+        }
+    } else {
+        if (tap_index_prev_point(tap, tap->current_file_seek_position, &point) < 0) {
+            return 0;
+        }
+    }
+
+    counter = datasette_index_counter(port, &point);
+    diff = (counter - tap->cycle_counter) * direction;
+    if (diff < 1) {
+        /* the counter drifted away from the index */
+        tap->cycle_counter = counter - direction;
+        diff = 1;
+    }
+
+    tap->current_file_seek_position = point.offset;
+    last_tap[port] = next_tap[port] = 0;
+    fullwave[port] = 0;
+
+    return (CLOCK)diff * 8;
+}
+
 /* this is the alarm function */
 static void datasette_read_bit(CLOCK offset, void *data)
 {
@@ -776,7 +828,13 @@ static void datasette_read_bit(CLOCK offset, void *data)
         gap = datasette_long_gap_pending[port];
         datasette_long_gap_pending[port] = 0;
     } else {
-        gap = datasette_read_gap(port, direction);
+        gap = 0;
+        if (current_image[port]->mode != DATASETTE_CONTROL_START) {
+            gap = datasette_wind_gap(port, direction);
+        }
+        if (!gap) {
+            gap = datasette_read_gap(port, direction);
+        }
         if (gap) {
             datasette_long_gap_elapsed[port] = 0;
         }
@@ -843,6 +901,7 @@ void datasette_init(void)
 
 void datasette_set_tape_image(int port, tap_t *image)
 {
+    tap_index_point_t end;
     CLOCK gap;
 
     DBG(("datasette_set_tape_image (image present:%s)", image ? "yes" : "no"));
@@ -853,11 +912,15 @@ void datasette_set_tape_image(int port, tap_t *image)
 
     if (image != NULL) {
         /* We need the length of tape for realistic counter. */
-        current_image[port]->cycle_counter_total = 0;
-        do {
-            gap = datasette_read_gap(port, 1);
-            current_image[port]->cycle_counter_total += gap / 8;
-        } while (gap);
+        if (tap_index_total(image, &end) == 0) {
+            current_image[port]->cycle_counter_total = datasette_index_counter(port, &end);
+        } else {
+            current_image[port]->cycle_counter_total = 0;
+            do {
+                gap = datasette_read_gap(port, 1);
+                current_image[port]->cycle_counter_total += gap / 8;
+            } while (gap);
+        }
         current_image[port]->current_file_seek_position = 0;
         datasette_sound_set_halfwaves(current_image[port]->version == 2);
     }
@@ -1202,6 +1265,7 @@ inline static void bit_write(int port)
         current_image[port]->cycle_counter_total = current_image[port]->cycle_counter;
     }
     current_image[port]->has_changed = 1;
+    tap_index_invalidate(current_image[port]);
     datasette_update_ui_counter(port);
 }
 
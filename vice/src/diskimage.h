@@ -146,6 +146,9 @@ unsigned int disk_image_sync_size(unsigned int format, unsigned int track);
 
 int disk_image_read_image(const disk_image_t *image);
 int disk_image_write_p64_image(const disk_image_t *image);
+int disk_image_flush(disk_image_t *image);
+void disk_image_flush_delayed(disk_image_t *image);
+void disk_image_mark_dirty(disk_image_t *image);
 int disk_image_write_half_track(disk_image_t *image, unsigned int half_track, const struct disk_track_s *raw);
 
 unsigned int disk_image_speed_map(unsigned int format, unsigned int track);
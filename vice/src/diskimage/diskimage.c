@@ -739,6 +739,42 @@ int disk_image_write_p64_image(const disk_image_t *image)
     return fsimage_write_p64_image(image);
 }
 
+/** \brief  Write changes kept in memory to the image file
+ *
+ * \param[in]   image   disk image
+ *
+ * \return  0 on success, -1 on error
+ */
+int disk_image_flush(disk_image_t *image)
+{
+    if (image == NULL || image->device != DISK_IMAGE_DEVICE_FS) {
+        return 0;
+    }
+    return fsimage_commit(image);
+}
+
+/** \brief  Write changes kept in memory once they are a few seconds old
+ *
+ * \param[in]   image   disk image
+ */
+void disk_image_flush_delayed(disk_image_t *image)
+{
+    if (image != NULL && image->device == DISK_IMAGE_DEVICE_FS) {
+        fsimage_commit_delayed(image);
+    }
+}
+
+/** \brief  Note that the image was changed in memory
+ *
+ * \param[in]   image   disk image
+ */
+void disk_image_mark_dirty(disk_image_t *image)
+{
+    if (image != NULL && image->device == DISK_IMAGE_DEVICE_FS) {
+        fsimage_mark_dirty(image->media.fsimage);
+    }
+}
+
 /*-----------------------------------------------------------------------*/
 /* Initialization.  */
 
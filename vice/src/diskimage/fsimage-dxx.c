@@ -38,6 +38,7 @@
 #include "gcr.h"
 #include "log.h"
 #include "lib.h"
+#include "mediacache.h"
 #include "types.h"
 #include "util.h"
 #include "x64.h"
@@ -108,7 +109,7 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
         offset += X64_HEADER_LENGTH;
     }
 #endif
-    if (util_fpwrite(fsimage->fd, buffer, max_sector * 256, offset) < 0) {
+    if (fsimage_pwrite(fsimage, buffer, max_sector * 256, offset) < 0) {
         log_error(fsimage_dxx_log, "Error writing T:%u to disk image.",
                   track);
         lib_free(buffer);
@@ -126,10 +127,10 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
 #endif
             fsimage->error_info.dirty = 0;
             if (error_info_created) {
-                res = util_fpwrite(fsimage->fd, fsimage->error_info.map,
+                res = fsimage_pwrite(fsimage, fsimage->error_info.map,
                                    fsimage->error_info.len, fsimage->error_info.len * 256);
             } else {
-                res = util_fpwrite(fsimage->fd, fsimage->error_info.map + sectors,
+                res = fsimage_pwrite(fsimage, fsimage->error_info.map + sectors,
                                    max_sector, offset);
             }
             if (res < 0) {
@@ -142,11 +143,11 @@ int fsimage_dxx_write_half_track(disk_image_t *image, unsigned int half_track,
     }
 
     /* Make sure the stream is visible to other readers.  */
-    fflush(fsimage->fd);
+    fsimage_flush(fsimage);
     return 0;
 }
 
-int fsimage_read_dxx_image(const disk_image_t *image)
+static int dxx_build_gcr(const disk_image_t *image)
 {
     uint8_t buffer[256], *bam_id;
     int gap, headergap, synclen;
@@ -175,7 +176,7 @@ int fsimage_read_dxx_image(const disk_image_t *image)
 
     bam_id[0] = bam_id[1] = 0xa0;
     if (sectors >= 0) {
-        util_fpread(fsimage->fd, buffer, 256, sectors << 8);
+        fsimage_pread(fsimage, buffer, 256, sectors << 8);
     } else {
         return -1;
     }
@@ -242,7 +243,7 @@ int fsimage_read_dxx_image(const disk_image_t *image)
 
                 buffer[BAM_ID_1571] = buffer[BAM_ID_1571 + 1] = 0xa0;
                 if (sectors >= 0) {
-                    util_fpread(fsimage->fd, buffer, 256, sectors << 8);
+                    fsimage_pread(fsimage, buffer, 256, sectors << 8);
                 }
                 header.id1 = buffer[BAM_ID_1571]; /* second side, update id and track */
                 header.id2 = buffer[BAM_ID_1571 + 1];
@@ -269,7 +270,7 @@ int fsimage_read_dxx_image(const disk_image_t *image)
 #endif
                 if (sectors >= 0) {
                     rf = CBMDOS_FDC_ERR_DRIVE;
-                    if (util_fpread(fsimage->fd, buffer, 256, offset) >= 0) {
+                    if (fsimage_pread(fsimage, buffer, 256, offset) >= 0) {
                         if (fsimage->error_info.map != NULL) {
                             rf = fsimage->error_info.map[sectors];
                         }
@@ -332,6 +333,156 @@ int fsimage_read_dxx_image(const disk_image_t *image)
     return 0;
 }
 
+/*-----------------------------------------------------------------------*/
+/* Cache of converted track sets.  */
+
+/* Bump when dxx_build_gcr() changes its output.  */
+#define DXX_GCR_CACHE_VERSION 1
+
+static int dxx_double_sided_drive(const disk_image_t *image)
+{
+    return drive_get_disk_drive_type(image->device) == DRIVE_TYPE_1571;
+}
+
+/* Check whether `half_track' is one of the tracks dxx_build_gcr() sets up.  */
+static int dxx_half_track_built(const disk_image_t *image, unsigned int half_track)
+{
+    if (half_track < image->max_half_tracks) {
+        return 1;
+    }
+    return dxx_double_sided_drive(image)
+           && image->type != DISK_IMAGE_TYPE_D71
+           && half_track >= 70 && half_track < 70 + image->max_half_tracks;
+}
+
+/* Key the track set by the contents of the image and everything else the
+   conversion depends on.  */
+static char *dxx_gcr_cache_key(const disk_image_t *image)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+    uint8_t *data;
+    char *prefix, *key = NULL;
+    long len;
+
+    prefix = lib_msprintf("gcr%d-%u-%u-%d", DXX_GCR_CACHE_VERSION, image->type,
+                          image->max_half_tracks, dxx_double_sided_drive(image));
+
+    if (fsimage->mapping.data != NULL) {
+        key = mediacache_key_from_buffer(prefix, fsimage->mapping.data,
+                                         fsimage->mapping.size);
+    } else {
+        len = (long)fsimage_size(image);
+        if (len > 0) {
+            data = lib_malloc((size_t)len);
+            if (fsimage_pread(fsimage, data, (size_t)len, 0) == 0) {
+                key = mediacache_key_from_buffer(prefix, data, (size_t)len);
+            }
+            lib_free(data);
+        }
+    }
+    lib_free(prefix);
+
+    return key;
+}
+
+/* Store the track set as a list of (half track, size, data) records, with
+   the number of records as tag.  */
+static void dxx_gcr_cache_save(const disk_image_t *image, const char *key)
+{
+    uint8_t *data, *ptr;
+    size_t size = 0;
+    unsigned int half_track;
+    uint32_t count = 0;
+
+    for (half_track = 0; half_track < MAX_GCR_TRACKS; half_track++) {
+        if (dxx_half_track_built(image, half_track)
+            && image->gcr->tracks[half_track].data != NULL) {
+            size += 8 + (size_t)image->gcr->tracks[half_track].size;
+        }
+    }
+    ptr = data = lib_malloc(size > 0 ? size : 1);
+    for (half_track = 0; half_track < MAX_GCR_TRACKS; half_track++) {
+        const disk_track_t *raw = &image->gcr->tracks[half_track];
+
+        if (dxx_half_track_built(image, half_track) && raw->data != NULL) {
+            util_dword_to_le_buf(ptr, half_track);
+            util_dword_to_le_buf(ptr + 4, (uint32_t)raw->size);
+            memcpy(ptr + 8, raw->data, (size_t)raw->size);
+            ptr += 8 + raw->size;
+            count++;
+        }
+    }
+    mediacache_put(key, count, data, size);
+    lib_free(data);
+}
+
+static int dxx_gcr_cache_load(const disk_image_t *image, const char *key)
+{
+    uint8_t *data, *ptr, *end;
+    size_t size;
+    uint32_t count, i;
+
+    data = mediacache_get(key, &count, &size);
+    if (data == NULL) {
+        return -1;
+    }
+
+    ptr = data;
+    end = data + size;
+    for (i = 0; i < count; i++) {
+        unsigned int half_track;
+        uint32_t track_size;
+        disk_track_t *raw;
+
+        if (end - ptr < 8) {
+            break;
+        }
+        half_track = util_le_buf_to_dword(ptr);
+        track_size = util_le_buf_to_dword(ptr + 4);
+        if (half_track >= MAX_GCR_TRACKS || track_size == 0
+            || track_size > NUM_MAX_MEM_BYTES_TRACK
+            || (size_t)(end - ptr - 8) < track_size) {
+            break;
+        }
+        raw = &image->gcr->tracks[half_track];
+        if (raw->data == NULL) {
+            raw->data = lib_malloc(track_size);
+        } else if (raw->size != (int)track_size) {
+            raw->data = lib_realloc(raw->data, track_size);
+        }
+        raw->size = (int)track_size;
+        memcpy(raw->data, ptr + 8, track_size);
+        ptr += 8 + track_size;
+    }
+    lib_free(data);
+
+    /* A damaged entry leaves the tracks half done, the caller rebuilds them.  */
+    return (i == count && ptr == end) ? 0 : -1;
+}
+
+int fsimage_read_dxx_image(const disk_image_t *image)
+{
+    char *key = NULL;
+    int rc;
+
+    if (mediacache_enabled()) {
+        key = dxx_gcr_cache_key(image);
+        if (key != NULL && dxx_gcr_cache_load(image, key) == 0) {
+            lib_free(key);
+            return 0;
+        }
+    }
+
+    rc = dxx_build_gcr(image);
+
+    if (rc == 0 && key != NULL) {
+        dxx_gcr_cache_save(image, key);
+    }
+    lib_free(key);
+
+    return rc;
+}
+
 int fsimage_dxx_read_sector(const disk_image_t *image, uint8_t *buf, const disk_addr_t *dadr)
 {
     int sectors;
@@ -372,7 +523,7 @@ int fsimage_dxx_read_sector(const disk_image_t *image, uint8_t *buf, const disk_
 
     if (harderror == 0) {
         if (image->gcr == NULL) {
-            if (util_fpread(fsimage->fd, buf, 256, offset) < 0) {
+            if (fsimage_pread(fsimage, buf, 256, offset) < 0) {
                 log_error(fsimage_dxx_log,
                         "Error reading T:%u S:%u from disk image.",
                         dadr->track, dadr->sector);
@@ -449,7 +600,7 @@ int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk
         offset += X64_HEADER_LENGTH;
     }
 #endif
-    if (util_fpwrite(fsimage->fd, buf, 256, offset) < 0) {
+    if (fsimage_pwrite(fsimage, buf, 256, offset) < 0) {
         log_error(fsimage_dxx_log, "Error writing T:%u S:%u to disk image.",
                   dadr->track, dadr->sector);
         return -1;
@@ -468,7 +619,7 @@ int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk
         }
 #endif
         fsimage->error_info.map[sectors] = CBMDOS_FDC_ERR_OK;
-        if (util_fpwrite(fsimage->fd, &fsimage->error_info.map[sectors], 1, offset) < 0) {
+        if (fsimage_pwrite(fsimage, &fsimage->error_info.map[sectors], 1, offset) < 0) {
             log_error(fsimage_dxx_log,
                     "Error writing T:%u S:%u error info to disk image.",
                     dadr->track, dadr->sector);
@@ -476,7 +627,7 @@ int fsimage_dxx_write_sector(disk_image_t *image, const uint8_t *buf, const disk
     }
 
     /* Make sure the stream is visible to other readers.  */
-    fflush(fsimage->fd);
+    fsimage_flush(fsimage);
     return 0;
 }
 
@@ -85,7 +85,7 @@ static long fsimage_gcr_seek_half_track(fsimage_t *fsimage, unsigned int half_tr
         log_error(fsimage_gcr_log, "Attempt to read without disk image.");
         return -1;
     }
-    if (util_fpread(fsimage->fd, buf, 12, 0) < 0) {
+    if (fsimage_pread(fsimage, buf, 12, 0) < 0) {
         log_error(fsimage_gcr_log, "Could not read GCR disk image.");
         return -1;
     }
@@ -112,7 +112,7 @@ static long fsimage_gcr_seek_half_track(fsimage_t *fsimage, unsigned int half_tr
     }
 #endif
 
-    if (util_fpread(fsimage->fd, buf, 4, 12 + (half_track - 2) * 4) < 0) {
+    if (fsimage_pread(fsimage, buf, 4, 12 + (half_track - 2) * 4) < 0) {
         log_error(fsimage_gcr_log, "Could not read GCR disk image.");
         return -1;
     }
@@ -137,6 +137,16 @@ int fsimage_gcr_read_half_track(const disk_image_t *image, unsigned int half_tra
     raw->data = NULL;
     raw->size = 0;
 
+    /* changed tracks not yet committed to the file */
+    if (half_track >= 2 && half_track < MAX_GCR_TRACKS + 2
+        && fsimage->pending.tracks != NULL
+        && fsimage->pending.tracks[half_track - 2].data != NULL) {
+        raw->size = fsimage->pending.tracks[half_track - 2].size;
+        raw->data = lib_malloc(raw->size);
+        memcpy(raw->data, fsimage->pending.tracks[half_track - 2].data, raw->size);
+        return 0;
+    }
+
     offset = fsimage_gcr_seek_half_track(fsimage, half_track, &max_track_length, &num_half_tracks);
 
     if (offset < 0) {
@@ -144,7 +154,7 @@ int fsimage_gcr_read_half_track(const disk_image_t *image, unsigned int half_tra
     }
 
     if (offset != 0) {
-        if (util_fpread(fsimage->fd, buf, 2, offset) < 0) {
+        if (fsimage_pread(fsimage, buf, 2, offset) < 0) {
             log_error(fsimage_gcr_log, "Could not read GCR disk image.");
             return -1;
         }
@@ -161,7 +171,7 @@ int fsimage_gcr_read_half_track(const disk_image_t *image, unsigned int half_tra
         raw->data = lib_calloc(1, track_len);
         raw->size = track_len;
 
-        if (fread(raw->data, track_len, 1, fsimage->fd) < 1) {
+        if (fsimage_pread(fsimage, raw->data, track_len, offset + 2) < 0) {
             log_error(fsimage_gcr_log, "Could not read GCR disk image.");
             return -1;
         }
@@ -180,19 +190,19 @@ static int fsimage_gcr_read_track(const disk_image_t *image, unsigned int track,
 }
 
 /*-----------------------------------------------------------------------*/
-/* Write an entire GCR track to the disk image.  */
+/* Write an entire GCR track to the disk image.
+
+   The track is only kept in memory here, fsimage_gcr_commit() writes all
+   changed tracks to the file at once.  */
 
 int fsimage_gcr_write_half_track(disk_image_t *image, unsigned int half_track,
                                  const disk_track_t *raw)
 {
-    int gap;
-    int extend = 0;
-    long res;
     uint16_t max_track_length;
-    uint8_t buf[4];
     long offset;
     fsimage_t *fsimage;
     uint8_t num_half_tracks;
+    disk_track_t *pending;
 
     fsimage = image->media.fsimage;
 
@@ -212,68 +222,123 @@ int fsimage_gcr_write_half_track(disk_image_t *image, unsigned int half_track,
         return -1;
     }
 
-    if (offset == 0) {
-        offset = fseek(fsimage->fd, 0, SEEK_END);
-        if (offset == 0) {
-            offset = ftell(fsimage->fd);
+    if (half_track < 2 || half_track - 2 >= num_half_tracks) {
+        log_error(fsimage_gcr_log,
+                  "Half track %u out of bounds.  Cannot write GCR track.",
+                  half_track);
+        return -1;
+    }
+
+    if (raw->data != NULL) {
+        if (fsimage->pending.tracks == NULL) {
+            fsimage->pending.tracks = lib_calloc(MAX_GCR_TRACKS, sizeof(disk_track_t));
         }
-        if (offset < 0) {
-            log_error(fsimage_gcr_log, "Could not extend GCR disk image.");
-            return -1;
+        pending = &fsimage->pending.tracks[half_track - 2];
+        if (pending->size != raw->size) {
+            lib_free(pending->data);
+            pending->data = lib_malloc(raw->size);
+            pending->size = raw->size;
         }
-        extend = 1;
+        memcpy(pending->data, raw->data, raw->size);
+        fsimage_mark_dirty(fsimage);
     }
 
-    if (raw->data != NULL) {
-        util_word_to_le_buf(buf, (uint16_t)raw->size);
+    return 0;
+}
 
-        if (util_fpwrite(fsimage->fd, buf, 2, offset) < 0) {
-            log_error(fsimage_gcr_log, "Could not write GCR disk image.");
-            return -1;
+/* Write all changed tracks to the file.  */
+int fsimage_gcr_commit(disk_image_t *image)
+{
+    uint16_t max_track_length;
+    uint8_t num_half_tracks;
+    fsimage_t *fsimage;
+    disk_track_t *pending;
+    uint8_t *data;
+    size_t size, new_size;
+    unsigned int i;
+    long offset;
+    int rc;
+
+    fsimage = image->media.fsimage;
+
+    if (fsimage->pending.tracks == NULL) {
+        fsimage->pending.dirty = 0;
+        return 0;
+    }
+
+    if (fsimage_gcr_seek_half_track(fsimage, 2, &max_track_length, &num_half_tracks) < 0) {
+        return -1;
+    }
+
+    offset = (long)fsimage_size(image);
+    if (offset < 0) {
+        log_error(fsimage_gcr_log, "Could not read GCR disk image.");
+        return -1;
+    }
+    size = (size_t)offset;
+
+    /* room for the tracks the image gets extended with */
+    new_size = size;
+    for (i = 0; i < num_half_tracks; i++) {
+        new_size += 2 + max_track_length;
+    }
+    data = lib_calloc(1, new_size);
+
+    if (fsimage_pread(fsimage, data, size, 0) < 0) {
+        log_error(fsimage_gcr_log, "Could not read GCR disk image.");
+        lib_free(data);
+        return -1;
+    }
+
+    for (i = 0; i < num_half_tracks; i++) {
+        pending = &fsimage->pending.tracks[i];
+        if (pending->data == NULL) {
+            continue;
         }
 
-        /* Clear gap between the end of the actual track and the start of
-           the next track.  */
-        if (fwrite(raw->data, raw->size, 1, fsimage->fd) < 1) {
+        offset = (long)util_le_buf_to_dword(data + 12 + i * 4);
+        if (offset == 0) {
+            /* add the track at the end of the image */
+            offset = (long)size;
+            size += 2 + max_track_length;
+            util_dword_to_le_buf(data + 12 + i * 4, (uint32_t)offset);
+            util_dword_to_le_buf(data + 12 + (i + num_half_tracks) * 4,
+                                 disk_image_speed_map(image->type, (i + 2) / 2));
+        } else if ((size_t)offset + 2 + max_track_length > size) {
             log_error(fsimage_gcr_log, "Could not write GCR disk image.");
+            lib_free(data);
             return -1;
         }
-        gap = max_track_length - raw->size;
-
-        if (gap > 0) {
-            uint8_t *padding = lib_calloc(1, gap);
-            res = fwrite(padding, gap, 1, fsimage->fd);
-            lib_free(padding);
-            if (res < 1) {
-                log_error(fsimage_gcr_log, "Could not write GCR disk image.");
-                return -1;
-            }
-        }
 
-        if (extend) {
-            /* FIXME: danger zone: 'DWORD' is a loose term, doesn't indicate
-             *        a size, just that's the next bigger size of 'WORD'.
-             *        Probably these terms are taken from the horrible Win API.
-             *        -- compyx 2020-07-24
-             */
-            util_dword_to_le_buf(buf, (uint32_t)offset);
-            if (util_fpwrite(fsimage->fd, buf, 4, 12 + (half_track - 2) * 4) < 0) {
-                log_error(fsimage_gcr_log, "Could not write GCR disk image.");
-                return -1;
-            }
-
-            util_dword_to_le_buf(buf, disk_image_speed_map(image->type, half_track / 2));
-            if (util_fpwrite(fsimage->fd, buf, 4, 12 + (half_track - 2 + num_half_tracks) * 4) < 0) {
-                log_error(fsimage_gcr_log, "Could not write GCR disk image.");
-                return -1;
-            }
-        }
+        /* the gap up to the start of the next track is cleared */
+        util_word_to_le_buf(data + offset, (uint16_t)pending->size);
+        memcpy(data + offset + 2, pending->data, pending->size);
+        memset(data + offset + 2 + pending->size, 0, max_track_length - pending->size);
     }
 
-    /* Make sure the stream is visible to other readers.  */
-    fflush(fsimage->fd);
+    rc = fsimage_replace(image, data, size);
+    lib_free(data);
 
-    return 0;
+    if (rc == 0) {
+        fsimage_gcr_forget(fsimage);
+        fsimage->pending.dirty = 0;
+    }
+    return rc;
+}
+
+/* Drop the changed tracks kept in memory.  */
+void fsimage_gcr_forget(fsimage_t *fsimage)
+{
+    unsigned int i;
+
+    if (fsimage->pending.tracks == NULL) {
+        return;
+    }
+    for (i = 0; i < MAX_GCR_TRACKS; i++) {
+        lib_free(fsimage->pending.tracks[i].data);
+    }
+    lib_free(fsimage->pending.tracks);
+    fsimage->pending.tracks = NULL;
 }
 
 static int fsimage_gcr_write_track(disk_image_t *image, unsigned int track,
@@ -32,6 +32,7 @@
 struct disk_image_s;
 struct disk_track_s;
 struct disk_addr_s;
+struct fsimage_s;
 
 void fsimage_gcr_init(void);
 
@@ -46,5 +47,7 @@ int fsimage_gcr_read_half_track(const struct disk_image_s *image,
                                 struct disk_track_s *raw);
 int fsimage_gcr_write_half_track(struct disk_image_s *image,
                                  unsigned int half_track, const struct disk_track_s *raw);
+int fsimage_gcr_commit(struct disk_image_s *image);
+void fsimage_gcr_forget(struct fsimage_s *fsimage);
 
 #endif
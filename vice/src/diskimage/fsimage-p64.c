@@ -65,7 +65,7 @@ int fsimage_read_p64_image(const disk_image_t *image)
         return -1;
     }
     buffer = lib_malloc((size_t)lSize);
-    if (util_fpread(fsimage->fd, buffer, (size_t)lSize, 0) < 0) {
+    if (fsimage_pread(fsimage, buffer, (size_t)lSize, 0) < 0) {
         lib_free(buffer);
         log_error(fsimage_p64_log, "Could not read P64 disk image.");
         return -1;
@@ -102,11 +102,11 @@ int fsimage_write_p64_image(const disk_image_t *image)
     P64MemoryStreamCreate(&P64MemoryStreamInstance);
     P64MemoryStreamClear(&P64MemoryStreamInstance);
     if (P64ImageWriteToStream(P64Image, &P64MemoryStreamInstance)) {
-        if (util_fpwrite(fsimage->fd, P64MemoryStreamInstance.Data, P64MemoryStreamInstance.Size, 0) < 0) {
+        if (fsimage_replace(image, P64MemoryStreamInstance.Data, P64MemoryStreamInstance.Size) < 0) {
             rc = -1;
             log_error(fsimage_p64_log, "Could not write P64 disk image.");
         } else {
-            fflush(fsimage->fd);
+            fsimage->pending.dirty = 0;
             rc = 0;
         }
     } else {
@@ -184,12 +184,9 @@ int fsimage_p64_write_half_track(disk_image_t *image, unsigned int half_track,
     }
 
     P64PulseStreamConvertFromGCR(&P64Image->PulseStreams[0][half_track], (void*)raw->data, raw->size << 3);
+    fsimage_mark_dirty(image->media.fsimage);
 
     return 0;
-    /* image flush will happen on close; added by Roberto Muscedere on 20210125 */
-#if 0
-    return fsimage_write_p64_image(image);
-#endif
 }
 
 static int fsimage_p64_write_track(disk_image_t *image, unsigned int track,
@@ -210,12 +207,9 @@ static int fsimage_p64_write_track(disk_image_t *image, unsigned int track,
     }
 
     P64PulseStreamConvertFromGCR(&P64Image->PulseStreams[0][track << 1], (void*)gcr_track_start_ptr, gcr_track_size << 3);
+    fsimage_mark_dirty(image->media.fsimage);
 
     return 0;
-    /* image flush will happen on close; added by Roberto Muscedere on 20210125 */
-#if 0
-    return fsimage_write_p64_image(image);
-#endif
 }
 
 /*-----------------------------------------------------------------------*/
@@ -28,6 +28,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP) && defined(HAVE_MSYNC)
+#define FSIMAGE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "archdep.h"
 #include "diskconstants.h"
@@ -97,6 +105,379 @@ void *fsimage_fd_get(const disk_image_t *image)
 }
 
 /*-----------------------------------------------------------------------*/
+/* Memory mapped images.
+
+   Sector and track access goes through fsimage_pread() and fsimage_pwrite().
+   Where the platform supports it, the image file is mapped into memory once
+   it has been probed, so these become memory copies instead of a seek plus
+   a read or write each.  Written ranges are synced to the file at most once
+   per second from fsimage_flush(), and completely when the image is closed.
+   Images that are not backed by a regular file, like compressed images that
+   zfile keeps in memory, keep using the stdio stream.  */
+
+#ifdef FSIMAGE_MMAP
+static int fsimage_map_fd(fsimage_t *fsimage, int writable)
+{
+    struct stat st;
+    void *data;
+    int fd;
+
+    fd = fileno(fsimage->fd);
+    if (fd < 0 || fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        return -1;
+    }
+    if (fflush(fsimage->fd) != 0) {
+        return -1;
+    }
+
+    data = mmap(NULL, (size_t)st.st_size,
+                writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+    fsimage->mapping.data = data;
+    fsimage->mapping.size = (size_t)st.st_size;
+    fsimage->mapping.writable = writable;
+    fsimage->mapping.dirty_start = fsimage->mapping.size;
+    fsimage->mapping.dirty_end = 0;
+    fsimage->mapping.last_sync = time(NULL);
+    return 0;
+}
+
+static void fsimage_sync(fsimage_t *fsimage, int flags)
+{
+    size_t page, start;
+
+    if (fsimage->mapping.dirty_start >= fsimage->mapping.dirty_end) {
+        return;
+    }
+
+    page = (size_t)sysconf(_SC_PAGESIZE);
+    start = fsimage->mapping.dirty_start - fsimage->mapping.dirty_start % page;
+    if (msync(fsimage->mapping.data + start,
+              fsimage->mapping.dirty_end - start, flags) < 0) {
+        log_error(fsimage_log, "Cannot sync `%s'.", fsimage->name);
+    }
+
+    fsimage->mapping.dirty_start = fsimage->mapping.size;
+    fsimage->mapping.dirty_end = 0;
+    fsimage->mapping.last_sync = time(NULL);
+}
+
+static void fsimage_unmap(fsimage_t *fsimage)
+{
+    if (fsimage->mapping.data == NULL) {
+        return;
+    }
+    fsimage_sync(fsimage, MS_SYNC);
+    munmap(fsimage->mapping.data, fsimage->mapping.size);
+    fsimage->mapping.data = NULL;
+    fsimage->mapping.size = 0;
+}
+
+/* Map the image after it has been probed.  Images used directly through
+   the stream elsewhere (CMD HD) are left alone.  */
+static void fsimage_map(const disk_image_t *image)
+{
+    switch (image->type) {
+        case DISK_IMAGE_TYPE_D64:
+        case DISK_IMAGE_TYPE_D67:
+        case DISK_IMAGE_TYPE_D71:
+        case DISK_IMAGE_TYPE_D81:
+        case DISK_IMAGE_TYPE_D80:
+        case DISK_IMAGE_TYPE_D82:
+#ifdef HAVE_X64_IMAGE
+        case DISK_IMAGE_TYPE_X64:
+#endif
+        case DISK_IMAGE_TYPE_D1M:
+        case DISK_IMAGE_TYPE_D2M:
+        case DISK_IMAGE_TYPE_D4M:
+        case DISK_IMAGE_TYPE_G64:
+        case DISK_IMAGE_TYPE_G71:
+        case DISK_IMAGE_TYPE_P64:
+            fsimage_map_fd(image->media.fsimage, !image->read_only);
+            break;
+        default:
+            break;
+    }
+}
+#else
+static void fsimage_unmap(fsimage_t *fsimage)
+{
+}
+
+static void fsimage_map(const disk_image_t *image)
+{
+}
+#endif
+
+/** \brief  Read \a num bytes at \a offset of the image
+ *
+ * \param[in]   fsimage image
+ * \param[out]  buf     buffer
+ * \param[in]   num     number of bytes to read
+ * \param[in]   offset  offset in the image file
+ *
+ * \return  0 on success, -1 on error
+ */
+int fsimage_pread(fsimage_t *fsimage, void *buf, size_t num, long offset)
+{
+#ifdef FSIMAGE_MMAP
+    if (fsimage->mapping.data != NULL) {
+        if (offset < 0 || (size_t)offset > fsimage->mapping.size
+            || num > fsimage->mapping.size - (size_t)offset) {
+            return -1;
+        }
+        memcpy(buf, fsimage->mapping.data + offset, num);
+        return 0;
+    }
+#endif
+    return util_fpread(fsimage->fd, buf, num, offset);
+}
+
+/** \brief  Write \a num bytes at \a offset of the image
+ *
+ * Writes beyond the end of a mapped image go through the stream, after which
+ * the grown file is mapped again.
+ *
+ * \param[in]   fsimage image
+ * \param[in]   buf     data
+ * \param[in]   num     number of bytes to write
+ * \param[in]   offset  offset in the image file
+ *
+ * \return  0 on success, -1 on error
+ */
+int fsimage_pwrite(fsimage_t *fsimage, const void *buf, size_t num, long offset)
+{
+#ifdef FSIMAGE_MMAP
+    if (fsimage->mapping.data != NULL) {
+        int writable = fsimage->mapping.writable;
+        int rc;
+
+        if (offset < 0 || !writable) {
+            return -1;
+        }
+        if ((size_t)offset <= fsimage->mapping.size
+            && num <= fsimage->mapping.size - (size_t)offset) {
+            memcpy(fsimage->mapping.data + offset, buf, num);
+            if ((size_t)offset < fsimage->mapping.dirty_start) {
+                fsimage->mapping.dirty_start = (size_t)offset;
+            }
+            if ((size_t)offset + num > fsimage->mapping.dirty_end) {
+                fsimage->mapping.dirty_end = (size_t)offset + num;
+            }
+            return 0;
+        }
+
+        fsimage_unmap(fsimage);
+        rc = util_fpwrite(fsimage->fd, buf, num, offset);
+        fsimage_map_fd(fsimage, writable);
+        return rc;
+    }
+#endif
+    return util_fpwrite(fsimage->fd, buf, num, offset);
+}
+
+/** \brief  Make written data visible to other readers of the image file
+ *
+ * For a mapped image the data already is, so this only schedules writing it
+ * back to disk, at most once per second.
+ *
+ * \param[in]   fsimage image
+ */
+void fsimage_flush(fsimage_t *fsimage)
+{
+#ifdef FSIMAGE_MMAP
+    if (fsimage->mapping.data != NULL) {
+        if (time(NULL) != fsimage->mapping.last_sync) {
+            fsimage_sync(fsimage, MS_ASYNC);
+        }
+        return;
+    }
+#endif
+    fflush(fsimage->fd);
+}
+
+/*-----------------------------------------------------------------------*/
+/* Write-back of GCR and P64 images.
+
+   Tracks written to G64, G71 and P64 images are kept in memory and only
+   committed to the file a few seconds after the first change, when the
+   image is flushed or when it is closed.  A commit writes the complete
+   image to a temporary file and renames it over the image, so the file
+   always holds either the old or the new contents.  Where no temporary
+   file can be written the image is written in place, as before.  */
+
+/* seconds between the first change and the commit */
+#define FSIMAGE_COMMIT_DELAY    5
+
+void fsimage_mark_dirty(fsimage_t *fsimage)
+{
+    if (!fsimage->pending.dirty) {
+        fsimage->pending.dirty = 1;
+        fsimage->pending.since = time(NULL);
+    }
+}
+
+/* Can the image file be replaced by renaming another file over it?  Not if
+   zfile uncompressed it, and not if that would break a link.  */
+static int fsimage_can_replace(fsimage_t *fsimage)
+{
+#ifdef FSIMAGE_MMAP
+    struct stat st;
+
+    if (lstat(fsimage->name, &st) < 0 || !S_ISREG(st.st_mode) || st.st_nlink != 1) {
+        return 0;
+    }
+#endif
+    return zfile_is_plain(fsimage->fd);
+}
+
+/* Write the new contents over the old ones in the open image.  */
+static int fsimage_write_in_place(fsimage_t *fsimage, const uint8_t *data, size_t size)
+{
+    if (fsimage_pwrite(fsimage, data, size, 0) < 0) {
+        log_error(fsimage_log, "Cannot write `%s'.", fsimage->name);
+        return -1;
+    }
+    fsimage_flush(fsimage);
+    return 0;
+}
+
+/** \brief  Replace the contents of the image file
+ *
+ * The new contents are written to a temporary file next to the image, which
+ * then replaces it.  If the temporary file cannot be written, for example
+ * because the directory is read-only or the disk is full, the image is
+ * written in place instead.
+ *
+ * \param[in]   image   disk image
+ * \param[in]   data    new contents
+ * \param[in]   size    size of \a data
+ *
+ * \return  0 on success, -1 on error
+ */
+int fsimage_replace(const disk_image_t *image, const uint8_t *data, size_t size)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+    char *tmp_name;
+    FILE *fd;
+    int ok;
+    int rc = 0;
+
+    if (!fsimage_can_replace(fsimage)) {
+        /* zfile compresses it again on close */
+        return fsimage_write_in_place(fsimage, data, size);
+    }
+
+    fd = archdep_mkstemp_beside_fd(&tmp_name, fsimage->name, MODE_WRITE);
+    if (fd == NULL) {
+        log_warning(fsimage_log, "Cannot create temporary file for `%s', writing it in place.",
+                    fsimage->name);
+        return fsimage_write_in_place(fsimage, data, size);
+    }
+    ok = (fwrite(data, 1, size, fd) == size) && (fflush(fd) == 0);
+#ifdef FSIMAGE_MMAP
+    if (ok) {
+        struct stat st;
+
+        if (fstat(fileno(fsimage->fd), &st) == 0) {
+            fchmod(fileno(fd), st.st_mode & 07777);
+        }
+        ok = (fsync(fileno(fd)) == 0);
+    }
+#endif
+    if (fclose(fd) != 0) {
+        ok = 0;
+    }
+    if (!ok) {
+        log_warning(fsimage_log, "Cannot write `%s', writing `%s' in place.",
+                    tmp_name, fsimage->name);
+        archdep_remove(tmp_name);
+        lib_free(tmp_name);
+        return fsimage_write_in_place(fsimage, data, size);
+    }
+
+    /* the new file takes the place of the open one; if that fails the old
+       one is still there and is opened again */
+    fsimage_unmap(fsimage);
+    zfile_fclose(fsimage->fd);
+    if (archdep_replace_file(tmp_name, fsimage->name) < 0) {
+        log_error(fsimage_log, "Cannot rename `%s' to `%s'.",
+                  tmp_name, fsimage->name);
+        archdep_remove(tmp_name);
+        rc = -1;
+    }
+    lib_free(tmp_name);
+
+    fsimage->fd = zfile_fopen(fsimage->name, MODE_READ_WRITE);
+    if (fsimage->fd == NULL) {
+        log_error(fsimage_log, "Cannot reopen `%s'.", fsimage->name);
+        return -1;
+    }
+    fsimage_map(image);
+    return rc;
+}
+
+/** \brief  Write pending changes of a GCR or P64 image to the file
+ *
+ * \param[in]   image   disk image
+ *
+ * \return  0 on success, -1 on error
+ */
+int fsimage_commit(disk_image_t *image)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+
+    if (fsimage == NULL || fsimage->fd == NULL || !fsimage->pending.dirty) {
+        return 0;
+    }
+
+    switch (image->type) {
+        case DISK_IMAGE_TYPE_G64:
+        case DISK_IMAGE_TYPE_G71:
+            return fsimage_gcr_commit(image);
+        case DISK_IMAGE_TYPE_P64:
+            return fsimage_write_p64_image(image);
+        default:
+            fsimage->pending.dirty = 0;
+            return 0;
+    }
+}
+
+/** \brief  Commit pending changes once they are a few seconds old
+ *
+ * \param[in]   image   disk image
+ */
+void fsimage_commit_delayed(disk_image_t *image)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+
+    if (fsimage != NULL && fsimage->pending.dirty
+        && time(NULL) - fsimage->pending.since >= FSIMAGE_COMMIT_DELAY) {
+        fsimage_commit(image);
+    }
+}
+
+/*-----------------------------------------------------------------------*/
+
+/* Let go of the image file and everything kept for it.  */
+static void fsimage_release(fsimage_t *fsimage)
+{
+    fsimage_gcr_forget(fsimage);
+    fsimage->pending.dirty = 0;
+    fsimage_unmap(fsimage);
+
+    if (fsimage->error_info.map) {
+        lib_free(fsimage->error_info.map);
+        fsimage->error_info.map = NULL;
+    }
+    if (fsimage->fd != NULL) {
+        zfile_fclose(fsimage->fd);
+        fsimage->fd = NULL;
+    }
+}
 
 void fsimage_media_create(disk_image_t *image)
 {
@@ -113,8 +494,9 @@ void fsimage_media_destroy(disk_image_t *image)
 
     fsimage = image->media.fsimage;
 
-    if (fsimage->fd) {
-        fsimage_close(image);
+    if (fsimage->fd && fsimage_close(image) < 0) {
+        log_error(fsimage_log, "Changes to `%s' are lost.", fsimage->name);
+        fsimage_release(fsimage);
     }
     lib_free(fsimage->name);
     lib_free(fsimage);
@@ -162,6 +544,7 @@ int fsimage_open(disk_image_t *image)
     }
 
     if (fsimage_probe(image) == 0) {
+        fsimage_map(image);
         return 0;
     }
 
@@ -170,6 +553,15 @@ int fsimage_open(disk_image_t *image)
     return -1;
 }
 
+/** \brief  Close the image file
+ *
+ * If the pending changes cannot be written, the image stays open with the
+ * changes kept in memory.
+ *
+ * \param[in]   image   disk image
+ *
+ * \return  0 on success, -1 on error
+ */
 int fsimage_close(disk_image_t *image)
 {
     fsimage_t *fsimage;
@@ -181,18 +573,12 @@ int fsimage_close(disk_image_t *image)
         return -1;
     }
 
-    /* flush the image when closed; added by Roberto Muscedere on 20210125 */
-    if (image->type == DISK_IMAGE_TYPE_P64) {
-        fsimage_write_p64_image(image);
-    }
-
-    if (fsimage->error_info.map) {
-        lib_free(fsimage->error_info.map);
-        fsimage->error_info.map = NULL;
+    if (fsimage_commit(image) < 0) {
+        log_error(fsimage_log, "Cannot write changes to `%s', not closing it.",
+                  fsimage->name);
+        return -1;
     }
-    zfile_fclose(fsimage->fd);
-    fsimage->fd = NULL;
-
+    fsimage_release(fsimage);
     return 0;
 }
 
@@ -28,11 +28,13 @@
 #define VICE_FSIMAGE_H
 
 #include <stdio.h>
+#include <time.h>
 
 #include "types.h"
 
 struct disk_image_s;
 struct disk_addr_s;
+struct disk_track_s;
 
 typedef struct fsimage_s {
     FILE *fd;
@@ -42,6 +44,21 @@ typedef struct fsimage_s {
         int dirty;
         int len;
     } error_info;
+    /* the image file mapped into memory, see fsimage_pread() */
+    struct {
+        uint8_t *data;          /* NULL if the image is not mapped */
+        size_t size;
+        int writable;
+        size_t dirty_start;     /* range written since the last msync */
+        size_t dirty_end;
+        time_t last_sync;
+    } mapping;
+    /* changes to GCR and P64 images not yet written, see fsimage_commit() */
+    struct {
+        struct disk_track_s *tracks;    /* G64/G71 half tracks, or NULL */
+        int dirty;
+        time_t since;                   /* time of the oldest change */
+    } pending;
 } fsimage_t;
 
 
@@ -61,4 +78,13 @@ int fsimage_write_sector(struct disk_image_s *image, const uint8_t *buf,
                          const struct disk_addr_s *dadr);
 off_t fsimage_size(const disk_image_t *image);
 
+int fsimage_pread(fsimage_t *fsimage, void *buf, size_t num, long offset);
+int fsimage_pwrite(fsimage_t *fsimage, const void *buf, size_t num, long offset);
+void fsimage_flush(fsimage_t *fsimage);
+
+void fsimage_mark_dirty(fsimage_t *fsimage);
+int fsimage_replace(const struct disk_image_s *image, const uint8_t *data, size_t size);
+int fsimage_commit(struct disk_image_s *image);
+void fsimage_commit_delayed(struct disk_image_s *image);
+
 #endif
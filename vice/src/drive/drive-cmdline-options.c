@@ -55,6 +55,12 @@ static const cmdline_option_t cmdline_options[] =
     { "-drivesoundvolume", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "DriveSoundEmulationVolume", NULL,
       "<Volume>", "Set volume for disk drive sound emulation (0-4000)" },
+    { "-drivepredecode", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "DrivePredecode", (void *)1,
+      NULL, "Enable caching of decoded drive CPU instructions" },
+    { "+drivepredecode", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "DrivePredecode", (void *)0,
+      NULL, "Disable caching of decoded drive CPU instructions" },
     CMDLINE_LIST_END
 };
 
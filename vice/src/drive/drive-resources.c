@@ -35,6 +35,7 @@
 #include "drive.h"
 #include "drivecpu.h"
 #include "drivecpu65c02.h"
+#include "drivemem.h"
 #include "driverom.h"
 #include "drivetypes.h"
 #include "ds1216e.h"
@@ -60,6 +61,9 @@ int drive_sound_emulation;
 /* volume of the drive sound */
 int drive_sound_emulation_volume;
 
+/* Are instructions fetched by the drive CPUs predecoded?  */
+int drive_predecode;
+
 static int set_drive_true_emulation(int val, void *param)
 {
     unsigned int dnr;
@@ -122,6 +126,20 @@ static int set_drive_sound_emulation_volume(int val, void *param)
     return 0;
 }
 
+static int set_drive_predecode(int val, void *param)
+{
+    unsigned int dnr;
+
+    drive_predecode = val ? 1 : 0;
+
+    for (dnr = 0; dnr < NUM_DISK_UNITS; dnr++) {
+        if (diskunit_context[dnr] != NULL) {
+            drivemem_predecode_flush(diskunit_context[dnr]);
+        }
+    }
+    return 0;
+}
+
 static int set_drive_extend_image_policy(int val, void *param)
 {
     switch (val) {
@@ -360,6 +378,8 @@ static const resource_int_t resources_int[] = {
       &drive_sound_emulation, set_drive_sound_emulation, NULL },
     { "DriveSoundEmulationVolume", 1000, RES_EVENT_NO, (resource_value_t)1000,
       &drive_sound_emulation_volume, set_drive_sound_emulation_volume, NULL },
+    { "DrivePredecode", 0, RES_EVENT_NO, NULL,
+      &drive_predecode, set_drive_predecode, NULL },
     RESOURCE_INT_LIST_END
 };
 
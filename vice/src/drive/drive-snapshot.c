@@ -1078,6 +1078,8 @@ static int drive_snapshot_read_p64image_module(snapshot_t *s, unsigned int dnr)
 
     drive->P64_image_loaded = 1;
     drive->complicated_image_loaded = 1;
+    /* the image file no longer matches, write it back */
+    drive->P64_dirty = 1;
     drive->image = NULL;
 
     return 0;
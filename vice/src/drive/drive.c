@@ -55,6 +55,7 @@
 #include "drivecpu.h"
 #include "drivecpu65c02.h"
 #include "driveimage.h"
+#include "drivemem.h"
 #include "drivesync.h"
 #include "driverom.h"
 #include "drivetypes.h"
@@ -337,6 +338,7 @@ void drive_shutdown(void)
             lib_free(drive);
             unit->drives[dnr] = NULL;
         }
+        drivemem_predecode_shutdown(unit);
         lib_free(unit);
         diskunit_context[unr] = NULL;
     }
@@ -864,6 +866,7 @@ void drive_gcr_data_writeback_all(void)
                         }
                     }
                 }
+                disk_image_flush(drive->image);
             }
         }
     }
@@ -1016,9 +1019,23 @@ void drive_cpu_set_overflow(diskunit_context_t *drv)
 }
 
 /* This is called at every vsync. */
+/* Changes to GCR and P64 images are written to the file some seconds after
+   they were made, instead of every time the head moves.  */
+static void drive_image_writeback(drive_t *drive)
+{
+    if (drive == NULL || drive->image == NULL) {
+        return;
+    }
+    if (drive->P64_image_loaded && drive->P64_dirty) {
+        drive->P64_dirty = 0;
+        disk_image_mark_dirty(drive->image);
+    }
+    disk_image_flush_delayed(drive->image);
+}
+
 void drive_vsync_hook(void)
 {
-    unsigned int dnr;
+    unsigned int dnr, d;
 
     drive_update_ui_status();
 
@@ -1026,6 +1043,10 @@ void drive_vsync_hook(void)
         diskunit_context_t *unit = diskunit_context[dnr];
         drive_t *drive = unit->drives[0];
 
+        for (d = 0; d < NUM_DRIVES; d++) {
+            drive_image_writeback(unit->drives[d]);
+        }
+
         if (unit->enable) {
             if (unit->idling_method != DRIVE_IDLE_SKIP_CYCLES) {
                 drive_cpu_execute_one(diskunit_context[dnr], maincpu_clk);
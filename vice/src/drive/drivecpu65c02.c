@@ -30,6 +30,7 @@
 
 #include "6510core.h"   /* using 6510core.h because the registers are the same */
 #include "alarm.h"
+#include "cpudispatch.h"
 #include "debug.h"
 #include "drive.h"
 #include "drivecpu65c02.h"
@@ -78,6 +79,7 @@ void drivecpu65c02_setup_context(struct diskunit_context_s *drv, int i)
     cpu->rmw_flag = 0;
     cpu->d_bank_limit = 0;
     cpu->d_bank_start = 0;
+    cpu->d_predecode_base = NULL;
     cpu->pageone = NULL;
     if (i) {
         cpu->snap_module_name = lib_msprintf("DRIVECPU%d", drv->mynumber);
@@ -135,9 +137,14 @@ void drivecpu65c02_setup_context(struct diskunit_context_s *drv, int i)
                 uint32_t limits = drv->cpud->read_limit_tab_ptr[reg_pc >> 8]; \
                 cpu->d_bank_limit = limits & 0xffff;                       \
                 cpu->d_bank_start = limits >> 16;                          \
+                cpu->d_predecode_base = drivemem_predecode_base(drv, p,    \
+                                            cpu->d_bank_start,             \
+                                            cpu->d_bank_limit,             \
+                                            &cpu->d_predecode_check);      \
             } else {                                                       \
                 cpu->d_bank_start = 0;                                     \
                 cpu->d_bank_limit = 0;                                     \
+                cpu->d_predecode_base = NULL;                              \
             }                                                              \
         }                                                                  \
     } while (0)
@@ -331,11 +338,12 @@ inline static int interrupt_check_irq_delay(interrupt_cpu_status_t *cs,
 
 /* Execute up to the current main CPU clock value.  This automatically
    calculates the corresponding number of clock ticks in the drive.  */
-void drivecpu65c02_execute(diskunit_context_t *drv, CLOCK clk_value)
+OPCODE_DISPATCH_FUNC void drivecpu65c02_execute(diskunit_context_t *drv, CLOCK clk_value)
 {
     CLOCK cycles;
     CLOCK tcycles;
     drivecpu_context_t *cpu;
+    uint32_t predecoded;
     int cpu_type = CPU_R65C02;
 
 #define reg_a   (cpu->cpu_R65C02_regs.a)
@@ -401,10 +409,42 @@ void drivecpu65c02_execute(diskunit_context_t *drv, CLOCK clk_value)
 #define bank_start (cpu->d_bank_start)
 #define bank_base (cpu->d_bank_base)
 
+#if !defined WORDS_BIGENDIAN && defined ALLOW_UNALIGNED_ACCESS
+#define PREDECODED_OPCODE(o) (o)
+#define SET_PREDECODED_OPCODE(o, e) ((o) = (e) & 0xffffff)
+#else
+#define PREDECODED_OPCODE(o) ((uint32_t)(o).ins | ((uint32_t)(o).op.op16 << 8))
+#define SET_PREDECODED_OPCODE(o, e) ((o).ins = (uint8_t)(e), (o).op.op16 = (uint16_t)((e) >> 8))
+#endif
+
+/* An entry holds the opcode and operand bytes in bits 0-23 and the fetch
+   cycles above, 0 means not decoded yet.  Entries for RAM are only used
+   while the RAM still holds the bytes they were decoded from.  */
+#define PREDECODED_BYTES(a) \
+    ((uint32_t)bank_base[(a)] | ((uint32_t)bank_base[(a) + 1] << 8) | ((uint32_t)bank_base[(a) + 2] << 16))
+
+#define FETCH_PREDECODED(o)                                                  \
+    (cpu->d_predecode_base != NULL                                           \
+     && (predecoded = cpu->d_predecode_base[reg_pc]) != 0                    \
+     && (!cpu->d_predecode_check                                             \
+         || (predecoded & 0xffffff) == PREDECODED_BYTES(reg_pc))             \
+     && (SET_PREDECODED_OPCODE(o, predecoded),                               \
+         CLK_ADD(CLK, predecoded >> 24), 1))
+
+#define STORE_PREDECODED(o, cycles)                                          \
+    do {                                                                     \
+        if (cpu->d_predecode_base != NULL) {                                 \
+            cpu->d_predecode_base[reg_pc] = PREDECODED_OPCODE(o)             \
+                                            | ((uint32_t)(cycles) << 24);    \
+        }                                                                    \
+    } while (0)
+
 /* WDC_STP() and WDC_WAI() are not used on the R65C02. */
 #define WDC_STP()
 #define WDC_WAI()
 
+#define CPU_LOOP_CONTINUES() ((int)(CLK - cpu->stop_clk) < 0)
+
 #include "65c02core.c"
     }
 
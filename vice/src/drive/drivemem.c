@@ -32,11 +32,13 @@
 
 #include "cartio.h"
 #include "ciad.h"
+#include "drive-resources.h"
 #include "drive.h"
 #include "drivemem.h"
 #include "driverom.h"
 #include "drivetypes.h"
 #include "ds1216e.h"
+#include "lib.h"
 #include "log.h"
 #include "machine-drive.h"
 #include "mem.h"
@@ -171,6 +173,79 @@ void drivemem_set_func(drivecpud_context_t *cpud,
     }
 }
 
+/* ------------------------------------------------------------------------- */
+/* Predecoded instructions.
+
+   With DrivePredecode set, the drive CPUs remember the opcode, the operand
+   bytes and the fetch cycles of the instructions they fetch from the trap
+   ROM and the RAM, and take them from one table entry the next time (see
+   FETCH_PREDECODED() in drivecpu.c).  The tables are indexed by the offset
+   into the ROM or RAM, so mirrors share their entries.
+
+   The ROM only changes when the traps are set up again, which calls
+   drivemem_predecode_flush().  The RAM is written by the CPU, the IEEE
+   floppy controller, the monitor and snapshots alike, so rather than
+   following all of them an entry for RAM is checked against the bytes it
+   was decoded from whenever it is used, and decoded again if they have
+   changed.  */
+
+/* Return the table of predecoded instructions for code fetched through
+   `base' from `start' up to `limit', or NULL if those addresses are not all
+   in the trap ROM or all in the RAM.  `*check' is set if the entries have
+   to be checked against the memory.  */
+uint32_t *drivemem_predecode_base(diskunit_context_t *drv, uint8_t *base,
+                                  unsigned int start, unsigned int limit,
+                                  int *check)
+{
+    /* a fetch reads up to 3 bytes beyond `limit' - 1 */
+    if (!drive_predecode) {
+        return NULL;
+    }
+    if (base + start >= drv->trap_rom
+        && base + limit + 2 <= drv->trap_rom + DRIVE_ROM_SIZE) {
+        if (drv->rom_predecode == NULL) {
+            drv->rom_predecode = lib_calloc(DRIVE_ROM_SIZE, sizeof(uint32_t));
+        }
+        *check = 0;
+        return drv->rom_predecode + (base - drv->trap_rom);
+    }
+    if (base + start >= drv->drive_ram
+        && base + limit + 2 <= drv->drive_ram + DRIVE_RAM_SIZE) {
+        if (drv->ram_predecode == NULL) {
+            drv->ram_predecode = lib_calloc(DRIVE_RAM_SIZE, sizeof(uint32_t));
+        }
+        *check = 1;
+        return drv->ram_predecode + (base - drv->drive_ram);
+    }
+    return NULL;
+}
+
+/* Forget the predecoded instructions, must be called whenever the trap ROM
+   changes.  */
+void drivemem_predecode_flush(diskunit_context_t *drv)
+{
+    if (drv->rom_predecode != NULL) {
+        memset(drv->rom_predecode, 0, DRIVE_ROM_SIZE * sizeof(uint32_t));
+    }
+    if (drv->ram_predecode != NULL) {
+        memset(drv->ram_predecode, 0, DRIVE_RAM_SIZE * sizeof(uint32_t));
+    }
+    if (drv->cpu != NULL) {
+        /* make the next JUMP() look up the bank again */
+        drv->cpu->d_predecode_base = NULL;
+        drv->cpu->d_bank_start = 0;
+        drv->cpu->d_bank_limit = 0;
+    }
+}
+
+void drivemem_predecode_shutdown(diskunit_context_t *drv)
+{
+    lib_free(drv->rom_predecode);
+    drv->rom_predecode = NULL;
+    lib_free(drv->ram_predecode);
+    drv->ram_predecode = NULL;
+}
+
 /* ------------------------------------------------------------------------- */
 /* This is the external interface for banked memory access.  */
 
@@ -49,6 +49,12 @@ void drivemem_set_func(struct drivecpud_context_s *cpud,
                        drive_peek_func_t *peek_func,
                        uint8_t *base, uint32_t limit);
 
+uint32_t *drivemem_predecode_base(struct diskunit_context_s *drv, uint8_t *base,
+                                  unsigned int start, unsigned int limit,
+                                  int *check);
+void drivemem_predecode_flush(struct diskunit_context_s *drv);
+void drivemem_predecode_shutdown(struct diskunit_context_s *drv);
+
 struct mem_ioreg_list_s *drivemem_ioreg_list_get(void *context);
 
 #endif
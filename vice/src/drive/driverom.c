@@ -32,6 +32,7 @@
 #include <string.h>
 
 #include "drive.h"
+#include "drivemem.h"
 #include "drivetypes.h"
 #include "driverom.h"
 #include "log.h"
@@ -146,6 +147,7 @@ int driverom_load_images(void)
 void driverom_initialize_traps(diskunit_context_t *unit)
 {
     memcpy(unit->trap_rom, unit->rom, DRIVE_ROM_SIZE);
+    drivemem_predecode_flush(unit);
 
     unit->trap = -1;
     unit->trapcont = -1;
@@ -87,6 +87,12 @@ typedef struct drivecpu_context_s {
     unsigned int d_bank_start;
     unsigned int d_bank_limit;
 
+    /* Predecoded instructions matching `d_bank_base', NULL if the current
+       bank is neither ROM nor RAM, see drivemem_predecode_base().  Entries
+       for RAM are checked against the RAM before they are used.  */
+    uint32_t *d_predecode_base;
+    int d_predecode_check;
+
     /* Information about the last executed opcode.  */
     unsigned int last_opcode_info;
 
@@ -240,6 +246,11 @@ typedef struct diskunit_context_s {
     /* Drive RAM */
     uint8_t drive_ram[DRIVE_RAM_SIZE];
 
+    /* Predecoded instructions of the trap ROM and the RAM, allocated when
+       first used.  */
+    uint32_t *rom_predecode;
+    uint32_t *ram_predecode;
+
 } diskunit_context_t;
 
 #endif
@@ -1155,6 +1155,8 @@ void cmdhd_init(diskunit_context_t *ctxptr)
 
 void cmdhd_shutdown(cmdhd_context_t *hd)
 {
+    int i;
+
     CLOG((LOG, "CMDHD: shutdown"));
 
     /* leave if no context provided */
@@ -1167,6 +1169,9 @@ void cmdhd_shutdown(cmdhd_context_t *hd)
 /*    alarm_destroy(hd->reset_alarm); */
     viacore_shutdown(hd->via9);
     viacore_shutdown(hd->via10);
+    for (i = 0; i < 56; i++) {
+        scsi_image_release(hd->scsi, i);
+    }
     lib_free(hd->scsi->myname);
     lib_free(hd->scsi);
     lib_free(hd->i8255a);
@@ -1268,7 +1273,9 @@ void cmdhd_reset(cmdhd_context_t *hd)
     CLOG((LOG, "CMDHD: alarm set for %lu from %lu", c, *(hd->mycontext->clk_ptr)));
     alarm_set(hd->reset_alarm, c);
 
-    /* look for base lba as it may have changed on reset */
+    /* look for base lba as it may have changed on reset, it's read from
+       the image directly */
+    scsi_image_flush(hd->scsi, 0);
     cmdhd_findbaselba(hd);
 
     /* check if write protect button is pressed */
@@ -1309,6 +1316,7 @@ void cmdhd_reset(cmdhd_context_t *hd)
             }
         } else {
             /* remove scsi ID 0 */
+            scsi_image_release(hd->scsi, 0);
             hd->scsi->file[0] = NULL;
         }
     }
@@ -1367,6 +1375,7 @@ int cmdhd_attach_image(disk_image_t *image, unsigned int unit)
     }
 
     /* copy file FD to the scsi module */
+    scsi_image_release(hd->scsi, 0);
     hd->scsi->file[0] = image->media.fsimage->fd;
 
     /* find the base lba */
@@ -1475,6 +1484,8 @@ int cmdhd_detach_image(disk_image_t *image, unsigned int unit)
     hd->image = NULL;
     hd->imagesize = 0;
     hd->baselba = UINT32_MAX;
+    /* the DHD image itself is closed by the caller */
+    scsi_image_release(hd->scsi, 0);
     hd->scsi->file[0] = NULL;
 
     /* close all additional SCSI ID files */
@@ -1482,8 +1493,7 @@ int cmdhd_detach_image(disk_image_t *image, unsigned int unit)
         /* if it isn't NULL, it must be a file */
         if (hd->scsi->file[i]) {
             /* close it and set to NULL */
-            fclose(hd->scsi->file[i]);
-            hd->scsi->file[i] = NULL;
+            scsi_image_detach(hd->scsi, i);
         }
     }
 
@@ -33,6 +33,7 @@
 #include "drive.h"
 #include "drivetypes.h"
 #include "lib.h"
+#include "perfcounters.h"
 #include "rotation.h"
 #include "types.h"
 #include "p64.h"
@@ -436,6 +437,7 @@ static void rotation_1541_gcr(drive_t *dptr, CLOCK ref_cycles)
                 /* the rising edge of UF4 stage B drives the shifter */
                 if ((rptr->uf4_counter & 0x3) == 2) {
                     /* 8+2 bit shifter */
+                    PERFCOUNTERS_INC(PERFCOUNTERS_DRIVE(dnr), rotation_bits);
 
                     /* UE5 NOR gate shifts in a 1 only at C2 when DC is 0 */
                     rptr->last_read_data = ((rptr->last_read_data << 1) & 0x3fe) | (((rptr->uf4_counter + 0x1c) >> 4) & 0x01);
@@ -531,6 +533,7 @@ static void rotation_1541_gcr(drive_t *dptr, CLOCK ref_cycles)
                 /* the rising edge of UF4 stage B drives the shifter */
                 if ((rptr->uf4_counter & 0x3) == 2) {
                     /* 8+2 bit shifter */
+                    PERFCOUNTERS_INC(PERFCOUNTERS_DRIVE(dnr), rotation_bits);
 
                     /* UE5 NOR gate shifts in a 1 only at C2 when DC is 0 */
                     rptr->last_read_data = ((rptr->last_read_data << 1) & 0x3fe) | (((rptr->uf4_counter + 0x1c) >> 4) & 0x01);
@@ -727,6 +730,8 @@ static void rotation_1541_p64(drive_t *dptr, CLOCK ref_cycles)
 
                     rptr->uf4_counter = (rptr->uf4_counter + 1) & 0xf;
                     if ((rptr->uf4_counter & 3) == 2) {
+                        PERFCOUNTERS_INC(PERFCOUNTERS_DRIVE(dptr->unit), rotation_bits);
+
                         /****************************************************************************************************************************************/
                         {
                             /* Decoder logic */
@@ -857,6 +862,8 @@ static void rotation_1541_p64(drive_t *dptr, CLOCK ref_cycles)
 
                     rptr->uf4_counter = (rptr->uf4_counter + 1) & 0xf;
                     if ((rptr->uf4_counter & 3) == 2) {
+                        PERFCOUNTERS_INC(PERFCOUNTERS_DRIVE(dptr->unit), rotation_bits);
+
                         /****************************************************************************************************************************************/
 
                         /* Encoder logic */
@@ -1009,6 +1016,8 @@ static void rotation_1541_simple(drive_t *dptr)
         rptr->accum %= rpmscale;
     }
 
+    PERFCOUNTERS_ADD(PERFCOUNTERS_DRIVE(dptr->unit), rotation_bits, bits_moved);
+
     if (dptr->read_write_mode) {
         int off = dptr->GCR_head_offset;
         unsigned int byte, last_read_data = rptr->last_read_data << 7;
@@ -0,0 +1,617 @@
+/** \file   src/lib/dbindex.c
+ * \brief   Index of the SLDB and STIL files
+ *
+ * Looking up a SID in the SLDB or STIL used to mean scanning the text file
+ * from the start, which takes a noticable amount of time for each lookup.
+ *
+ * Instead the files are indexed on first use: a hash table maps the keys
+ * (the HVSC paths, and for the SLDB the MD5 digests as well) to the offset
+ * and line number of the line holding the key. The table is stored in the
+ * user's cache directory and read slot by slot, so very little memory is
+ * used. It is rebuilt when the path, size or modification time of the text
+ * file changes.
+ *
+ * The hash only selects candidate lines, each candidate is read from the text
+ * file and compared against the key, so the results are the same as with a
+ * sequential scan.
+ */
+
+/*
+ *  HVSClib - a library to work with High Voltage SID Collection files
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.*
+ */
+
+#ifndef HVSC_STANDALONE
+# include "vice.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifndef HVSC_STANDALONE
+# include "archdep_mkdir.h"
+# include "archdep_user_cache_path.h"
+# include "log.h"
+#endif
+#include "hvsc.h"
+#include "hvsc_defs.h"
+#include "base.h"
+
+#include "dbindex.h"
+
+
+/** \brief  Magic bytes at the start of an index file
+ */
+#define INDEX_MAGIC         "HVSCIDX1"
+
+/** \brief  Size of the index file header
+ *
+ * Magic (8), hash of the text file's path (8), size (8) and modification time
+ * (8) of the text file, number of slots (4) and number of keys (4).
+ */
+#define INDEX_HEADER_SIZE   40
+
+/** \brief  Size of a slot in the hash table
+ *
+ * Hash of the key (8), offset (4) and line number (4) of the line in the text
+ * file. A line number of 0 marks an empty slot.
+ */
+#define INDEX_SLOT_SIZE     16
+
+/** \brief  Subdirectory of the user cache directory for the index files
+ */
+#define INDEX_CACHE_DIR     "hvsc"
+
+
+/** \brief  Index of a text file
+ */
+typedef struct hvsc_index_s {
+    const char *name;       /**< name of the index file */
+    FILE *      fp;         /**< index file, `NULL` when not used */
+    uint8_t *   table;      /**< hash table, when the index file could not
+                                 be written */
+    uint32_t    slots;      /**< number of slots, a power of two */
+    uint64_t    path_hash;  /**< hash of the path of the text file */
+    uint64_t    size;       /**< size of the text file */
+    int64_t     mtime;      /**< modification time of the text file */
+    bool        valid;      /**< index can be used */
+} hvsc_index_t;
+
+
+/** \brief  Indexes of the SLDB and STIL
+ */
+static hvsc_index_t indexes[HVSC_INDEX_COUNT] = {
+    { "Songlengths.idx", NULL, NULL, 0, 0, 0, 0, false },
+    { "STIL.idx",        NULL, NULL, 0, 0, 0, 0, false }
+};
+
+
+/** \brief  Store \a n bytes of \a value in little endian order
+ *
+ * \param[out]  dest    destination
+ * \param[in]   value   value
+ * \param[in]   n       number of bytes
+ */
+static void put_le(uint8_t *dest, uint64_t value, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        dest[i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+
+/** \brief  Get \a n bytes in little endian order from \a src
+ *
+ * \param[in]   src     source
+ * \param[in]   n       number of bytes
+ *
+ * \return  value
+ */
+static uint64_t get_le(const uint8_t *src, int n)
+{
+    uint64_t value = 0;
+    int i;
+
+    for (i = n - 1; i >= 0; i--) {
+        value = (value << 8) | src[i];
+    }
+    return value;
+}
+
+
+/** \brief  Calculate 64-bit FNV-1a hash of \a len bytes of \a s
+ *
+ * \param[in]   s   string
+ * \param[in]   len length of \a s
+ *
+ * \return  hash
+ */
+static uint64_t index_hash(const char *s, size_t len)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)s[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+
+/** \brief  Get the text file indexed by an index of \a type
+ *
+ * \param[in]   type    index type
+ *
+ * \return  path to text file
+ */
+static const char *index_source(int type)
+{
+    return type == HVSC_INDEX_SLDB ? hvsc_sldb_path : hvsc_stil_path;
+}
+
+
+/** \brief  Get the key in \a line of a text file
+ *
+ * In the SLDB both the "; /path/to/file" comments and the MD5 digests in front
+ * of the song lengths are keys, in the STIL the lines starting with a path.
+ *
+ * \param[in]   type    index type
+ * \param[in]   line    line of text, without EOL
+ * \param[in]   len     length of \a line
+ * \param[out]  klen    length of the key
+ *
+ * \return  pointer to key in \a line, or `NULL` when \a line holds no key
+ */
+static const char *index_line_key(int type, const char *line, size_t len,
+                                  size_t *klen)
+{
+    if (type == HVSC_INDEX_STIL) {
+        if (len > 0 && line[0] == '/') {
+            *klen = len;
+            return line;
+        }
+        return NULL;
+    }
+
+    if (len > 2 && line[0] == ';' && line[1] == ' ') {
+        *klen = len - 2;
+        return line + 2;
+    }
+    if (len > HVSC_DIGEST_SIZE * 2 && line[HVSC_DIGEST_SIZE * 2] == '=') {
+        *klen = HVSC_DIGEST_SIZE * 2;
+        return line;
+    }
+    return NULL;
+}
+
+
+/** \brief  Get size and modification time of \a path
+ *
+ * \param[in]   path    path to file
+ * \param[out]  size    size of file
+ * \param[out]  mtime   modification time of file
+ *
+ * \return  bool
+ */
+static bool index_stat(const char *path, uint64_t *size, int64_t *mtime)
+{
+    struct stat st;
+
+    if (path == NULL || stat(path, &st) != 0) {
+        return false;
+    }
+    *size = (uint64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+
+/** \brief  Get the path to the index file of \a idx
+ *
+ * \param[in]   idx     index
+ *
+ * \return  heap-allocated path or `NULL` if there's no place to store it
+ */
+static char *index_file_path(const hvsc_index_t *idx)
+{
+#ifndef HVSC_STANDALONE
+    char *dir;
+    char *path = NULL;
+
+    dir = hvsc_paths_join(archdep_user_cache_path(), INDEX_CACHE_DIR);
+    if (archdep_mkdir_recursive(dir, 0755) == 0) {
+        path = hvsc_paths_join(dir, idx->name);
+    }
+    hvsc_free(dir);
+    return path;
+#else
+    return NULL;
+#endif
+}
+
+
+/** \brief  Close index \a idx and free its memory
+ *
+ * \param[in,out]   idx index
+ */
+static void index_close(hvsc_index_t *idx)
+{
+    if (idx->fp != NULL) {
+        fclose(idx->fp);
+        idx->fp = NULL;
+    }
+    if (idx->table != NULL) {
+        hvsc_free(idx->table);
+        idx->table = NULL;
+    }
+    idx->slots = 0;
+    idx->valid = false;
+}
+
+
+/** \brief  Add a key to hash \a table
+ *
+ * \param[in,out]   table   hash table
+ * \param[in]       slots   number of slots in \a table
+ * \param[in]       hash    hash of the key
+ * \param[in]       offset  offset of the line with the key
+ * \param[in]       lineno  line number of the line with the key
+ */
+static void index_insert(uint8_t *table, uint32_t slots, uint64_t hash,
+                         uint32_t offset, uint32_t lineno)
+{
+    uint32_t i = (uint32_t)hash & (slots - 1);
+
+    while (get_le(table + (size_t)i * INDEX_SLOT_SIZE + 12, 4) != 0) {
+        i = (i + 1) & (slots - 1);
+    }
+    put_le(table + (size_t)i * INDEX_SLOT_SIZE, hash, 8);
+    put_le(table + (size_t)i * INDEX_SLOT_SIZE + 8, offset, 4);
+    put_le(table + (size_t)i * INDEX_SLOT_SIZE + 12, lineno, 4);
+}
+
+
+/** \brief  Build the hash table of text file \a path
+ *
+ * The table is kept at most half full.
+ *
+ * \param[in]   type    index type
+ * \param[in]   path    path to text file
+ * \param[out]  slots   number of slots in the table
+ * \param[out]  keys    number of keys in the table
+ *
+ * \return  heap-allocated table or `NULL` on failure
+ */
+static uint8_t *index_build(int type, const char *path, uint32_t *slots,
+                            uint32_t *keys)
+{
+    uint8_t *data;
+    uint8_t *table = NULL;
+    long size;
+    int pass;
+
+    size = hvsc_read_file(&data, path);
+    if (size < 0) {
+        return NULL;
+    }
+    if ((unsigned long)size > 0x7fffffffUL) {
+        hvsc_errno = HVSC_ERR_FILE_TOO_LARGE;
+        hvsc_free(data);
+        return NULL;
+    }
+
+    /* the first pass counts the keys, the second one fills the table */
+    *keys = 0;
+    for (pass = 0; pass < 2; pass++) {
+        size_t pos = 0;
+        uint32_t lineno = 0;
+
+        if (pass == 1) {
+            *slots = 64;
+            while (*slots < *keys * 2) {
+                *slots <<= 1;
+            }
+            table = hvsc_calloc(*slots, INDEX_SLOT_SIZE);
+        }
+
+        while (pos < (size_t)size) {
+            const char *line = (const char *)data + pos;
+            const char *eol = memchr(line, '\n', (size_t)size - pos);
+            size_t len = eol != NULL ? (size_t)(eol - line) : (size_t)size - pos;
+            size_t next = pos + len + 1;
+            const char *key;
+            size_t klen;
+
+            lineno++;
+            if (len > 0 && line[len - 1] == '\r') {
+                len--;
+            }
+            key = index_line_key(type, line, len, &klen);
+            if (key != NULL) {
+                if (pass == 0) {
+                    (*keys)++;
+                } else {
+                    index_insert(table, *slots, index_hash(key, klen),
+                                 (uint32_t)pos, lineno);
+                }
+            }
+            pos = next;
+        }
+    }
+
+    hvsc_free(data);
+    return table;
+}
+
+
+/** \brief  Write index file \a path
+ *
+ * The magic is written last, so an interrupted write leaves an index file
+ * which is rejected later.
+ *
+ * \param[in]   idx     index
+ * \param[in]   path    path to index file
+ * \param[in]   table   hash table
+ * \param[in]   slots   number of slots in \a table
+ * \param[in]   keys    number of keys in \a table
+ *
+ * \return  bool
+ */
+static bool index_write(const hvsc_index_t *idx, const char *path,
+                        const uint8_t *table, uint32_t slots, uint32_t keys)
+{
+    uint8_t header[INDEX_HEADER_SIZE];
+    FILE *fp;
+    bool ok;
+
+    fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return false;
+    }
+
+    memset(header, 0, sizeof header);
+    put_le(header + 8, idx->path_hash, 8);
+    put_le(header + 16, idx->size, 8);
+    put_le(header + 24, (uint64_t)idx->mtime, 8);
+    put_le(header + 32, slots, 4);
+    put_le(header + 36, keys, 4);
+
+    ok = fwrite(header, 1, sizeof header, fp) == sizeof header
+        && fwrite(table, INDEX_SLOT_SIZE, slots, fp) == slots
+        && fflush(fp) == 0
+        && fseek(fp, 0, SEEK_SET) == 0
+        && fwrite(INDEX_MAGIC, 1, 8, fp) == 8;
+    if (fclose(fp) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        remove(path);
+    }
+    return ok;
+}
+
+
+/** \brief  Open index file \a path for \a idx
+ *
+ * The index file is only used when it belongs to the current text file.
+ *
+ * \param[in,out]   idx     index
+ * \param[in]       path    path to index file
+ *
+ * \return  bool
+ */
+static bool index_open(hvsc_index_t *idx, const char *path)
+{
+    uint8_t header[INDEX_HEADER_SIZE];
+    uint32_t slots;
+
+    idx->fp = fopen(path, "rb");
+    if (idx->fp == NULL) {
+        return false;
+    }
+    if (fread(header, 1, sizeof header, idx->fp) == sizeof header
+            && memcmp(header, INDEX_MAGIC, 8) == 0
+            && get_le(header + 8, 8) == idx->path_hash
+            && get_le(header + 16, 8) == idx->size
+            && (int64_t)get_le(header + 24, 8) == idx->mtime) {
+        slots = (uint32_t)get_le(header + 32, 4);
+        if (slots != 0 && (slots & (slots - 1)) == 0) {
+            idx->slots = slots;
+            return true;
+        }
+    }
+    fclose(idx->fp);
+    idx->fp = NULL;
+    return false;
+}
+
+
+/** \brief  Get the index of \a type, (re)building it when required
+ *
+ * \param[in]   type    index type
+ *
+ * \return  index or `NULL` if the text file cannot be indexed
+ */
+static hvsc_index_t *index_get(int type)
+{
+    hvsc_index_t *idx = &indexes[type];
+    const char *source = index_source(type);
+    uint64_t path_hash;
+    uint64_t size;
+    int64_t mtime;
+    uint8_t *table;
+    uint32_t slots;
+    uint32_t keys;
+    char *path;
+
+    if (!index_stat(source, &size, &mtime)) {
+        index_close(idx);
+        return NULL;
+    }
+    path_hash = index_hash(source, strlen(source));
+    if (idx->valid && idx->path_hash == path_hash && idx->size == size
+            && idx->mtime == mtime) {
+        return idx;
+    }
+
+    index_close(idx);
+    idx->path_hash = path_hash;
+    idx->size = size;
+    idx->mtime = mtime;
+
+    path = index_file_path(idx);
+    if (path != NULL && index_open(idx, path)) {
+        hvsc_free(path);
+        idx->valid = true;
+        return idx;
+    }
+
+    table = index_build(type, source, &slots, &keys);
+    if (table == NULL) {
+        if (path != NULL) {
+            hvsc_free(path);
+        }
+        return NULL;
+    }
+#ifndef HVSC_STANDALONE
+    log_message(LOG_DEFAULT, "Vsid: Indexed %u entries of '%s'.",
+            (unsigned int)keys, source);
+#endif
+
+    if (path != NULL && index_write(idx, path, table, slots, keys)
+            && index_open(idx, path)) {
+        hvsc_free(table);
+    } else {
+        /* keep the table in memory then */
+        idx->table = table;
+        idx->slots = slots;
+    }
+    if (path != NULL) {
+        hvsc_free(path);
+    }
+    idx->valid = true;
+    return idx;
+}
+
+
+/** \brief  Read slot \a i of \a idx
+ *
+ * \param[in]   idx     index
+ * \param[in]   i       slot number
+ * \param[out]  slot    slot data
+ *
+ * \return  bool
+ */
+static bool index_read_slot(hvsc_index_t *idx, uint32_t i, uint8_t *slot)
+{
+    if (idx->table != NULL) {
+        memcpy(slot, idx->table + (size_t)i * INDEX_SLOT_SIZE, INDEX_SLOT_SIZE);
+        return true;
+    }
+    return fseek(idx->fp, INDEX_HEADER_SIZE + (long)i * INDEX_SLOT_SIZE,
+                 SEEK_SET) == 0
+        && fread(slot, 1, INDEX_SLOT_SIZE, idx->fp) == INDEX_SLOT_SIZE;
+}
+
+
+/** \brief  Find the line holding \a key in a text file
+ *
+ * On success the line holding \a key has just been read from \a handle, so
+ * the text following it can be read with hvsc_text_file_read().
+ *
+ * When the index cannot be used \a handle is positioned at the start of the
+ * file, for the caller to fall back to scanning the file.
+ *
+ * \param[in]       type    index type
+ * \param[in,out]   handle  text file handle of the indexed file
+ * \param[in]       key     HVSC path or MD5 digest in lower case hex
+ *
+ * \return  1 when found, 0 when not found, -1 when the index cannot be used
+ */
+int hvsc_index_seek(int type, hvsc_text_file_t *handle, const char *key)
+{
+    hvsc_index_t *idx;
+    uint8_t slot[INDEX_SLOT_SIZE];
+    size_t klen = strlen(key);
+    uint64_t hash;
+    uint32_t i;
+    uint32_t n;
+
+    idx = index_get(type);
+    if (idx == NULL) {
+        return -1;
+    }
+
+    hash = index_hash(key, klen);
+    i = (uint32_t)hash & (idx->slots - 1);
+    for (n = 0; n < idx->slots; n++) {
+        uint32_t lineno;
+
+        if (!index_read_slot(idx, i, slot)) {
+            index_close(idx);
+            break;
+        }
+        lineno = (uint32_t)get_le(slot + 12, 4);
+        if (lineno == 0) {
+            hvsc_errno = HVSC_ERR_NOT_FOUND;
+            return 0;
+        }
+        if (get_le(slot, 8) == hash) {
+            const char *line;
+
+            if (fseek(handle->fp, (long)get_le(slot + 8, 4), SEEK_SET) != 0) {
+                break;
+            }
+            handle->lineno = (long)lineno - 1;
+            line = hvsc_text_file_read(handle);
+            if (line != NULL) {
+                const char *lkey;
+                size_t lklen;
+
+                lkey = index_line_key(type, line, strlen(line), &lklen);
+                if (lkey != NULL && lklen == klen
+                        && memcmp(lkey, key, klen) == 0) {
+                    return 1;
+                }
+            }
+        }
+        i = (i + 1) & (idx->slots - 1);
+    }
+
+    /* something's wrong, let the caller scan the file */
+    rewind(handle->fp);
+    handle->lineno = 0;
+    return -1;
+}
+
+
+/** \brief  Close all indexes and free their memory
+ */
+void hvsc_index_close_all(void)
+{
+    int i;
+
+    for (i = 0; i < HVSC_INDEX_COUNT; i++) {
+        index_close(&indexes[i]);
+    }
+}
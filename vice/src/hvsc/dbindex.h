@@ -0,0 +1,40 @@
+/** \file   src/lib/dbindex.h
+ * \brief   Index of the SLDB and STIL files - header
+ */
+
+/*
+ *  HVSClib - a library to work with High Voltage SID Collection files
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.*
+ */
+
+#ifndef HVSC_DBINDEX_H
+#define HVSC_DBINDEX_H
+
+#include "hvsc.h"
+
+/** \brief  Indexed database files
+ */
+typedef enum hvsc_index_type_e {
+    HVSC_INDEX_SLDB,    /**< Songlengths.md5, by path and by MD5 digest */
+    HVSC_INDEX_STIL,    /**< STIL.txt, by path */
+
+    HVSC_INDEX_COUNT    /**< number of indexed files */
+} hvsc_index_type_t;
+
+int     hvsc_index_seek(int type, hvsc_text_file_t *handle, const char *key);
+void    hvsc_index_close_all(void);
+
+#endif
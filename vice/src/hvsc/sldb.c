@@ -41,6 +41,7 @@
 #include "hvsc.h"
 #include "hvsc_defs.h"
 #include "base.h"
+#include "dbindex.h"
 
 #include "sldb.h"
 
@@ -106,11 +107,24 @@ static char *find_sldb_entry_md5(const char *digest)
 {
     hvsc_text_file_t handle;
     const char *line;
+    char *s;
 
     if (!hvsc_text_file_open(hvsc_sldb_path, &handle)) {
         return NULL;
     }
 
+    switch (hvsc_index_seek(HVSC_INDEX_SLDB, &handle, digest)) {
+        case 1:
+            s = hvsc_strdup(handle.buffer);
+            hvsc_text_file_close(&handle);
+            return s;
+        case 0:
+            hvsc_text_file_close(&handle);
+            return NULL;
+        default:
+            break;
+    }
+
     while (1) {
         line = hvsc_text_file_read(&handle);
         if (line == NULL) {
@@ -122,7 +136,7 @@ static char *find_sldb_entry_md5(const char *digest)
 #endif
         if (memcmp(digest, line, HVSC_DIGEST_SIZE * 2) == 0) {
             /* copy the current line before closing the file */
-            char *s = hvsc_strdup(handle.buffer);
+            s = hvsc_strdup(handle.buffer);
             hvsc_text_file_close(&handle);
             return s;
         }
@@ -146,6 +160,7 @@ static char *find_sldb_entry_txt(const char *path)
     hvsc_text_file_t handle;
     size_t plen;
     const char *line;
+    char *s;
 #ifndef HVSC_STANDALONE
     log_message(LOG_DEFAULT, "Vsid: Opening '%s'.", hvsc_sldb_path);
 #endif
@@ -156,6 +171,25 @@ static char *find_sldb_entry_txt(const char *path)
         return NULL;
     }
 
+    switch (hvsc_index_seek(HVSC_INDEX_SLDB, &handle, path)) {
+        case 1:
+            /* next line contains the actual entry */
+            line = hvsc_text_file_read(&handle);
+            s = line != NULL ? hvsc_strdup(handle.buffer) : NULL;
+            hvsc_text_file_close(&handle);
+            return s;
+        case 0:
+            hvsc_text_file_close(&handle);
+#ifndef HVSC_STANDALONE
+            log_warning(LOG_DEFAULT,
+                    "Vsid: Could not find song length data for current SID.");
+#endif
+            return NULL;
+        default:
+            /* no index, scan the file */
+            break;
+    }
+
     plen = strlen(path);
 
     while (true) {
@@ -173,7 +207,6 @@ static char *find_sldb_entry_txt(const char *path)
         if (*line == ';') {
             if (strncmp(path, line + 2, plen) == 0) {
                 /* next line contains the actual entry */
-                char *s;
                 line = hvsc_text_file_read(&handle);
                 if (line == NULL) {
                     hvsc_text_file_close(&handle);
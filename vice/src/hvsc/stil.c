@@ -40,6 +40,7 @@
 #include "hvsc.h"
 #include "hvsc_defs.h"
 #include "base.h"
+#include "dbindex.h"
 
 #include "stil.h"
 
@@ -463,7 +464,25 @@ bool hvsc_stil_open(const char *psid, hvsc_stil_t *handle)
 #endif
     hvsc_dbg("stripped path is '%s'\n", handle->psid_path);
 
-    /* find the entry */
+    /* find the entry, using the index when possible */
+    switch (hvsc_index_seek(HVSC_INDEX_STIL, &(handle->stil),
+                            handle->psid_path)) {
+        case 1:
+#ifndef HVSC_STANDALONE
+            log_message(LOG_DEFAULT, "Vsid: Found '%s' at line %ld.",
+                    handle->psid_path, handle->stil.lineno);
+#endif
+            return true;
+        case 0:
+#ifndef HVSC_STANDALONE
+            log_message(LOG_DEFAULT, "Vsid: No STIL entry found.");
+#endif
+            hvsc_stil_close(handle);
+            return false;
+        default:
+            break;
+    }
+
     while (true) {
         line = hvsc_text_file_read(&(handle->stil));
         if (line == NULL) {
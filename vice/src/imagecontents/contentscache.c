@@ -0,0 +1,549 @@
+/*
+ * contentscache.c - Cached and background reading of image contents.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Reading the directory of an image means attaching it to a temporary
+ * vdrive (or tape image) and walking it, which for large or compressed
+ * images takes a while.  File browsers do this for every image the user
+ * moves over, and autostart does it again for the image picked.
+ *
+ * The contents read are kept in a small cache, keyed by the file name, the
+ * reader function and the size, modification time and inode of the file,
+ * so an image that hasn't changed is only ever read once.  Looking up an
+ * image only takes a stat().  On file systems with coarse time stamps an
+ * image rewritten right after it was read could keep its modification
+ * time, so for a file changed within the last few seconds the CRC32 of its
+ * contents is part of the key too.  Images that could not be read are
+ * remembered as well.
+ *
+ * contentscache_request() does the reading on a worker thread and hands
+ * the result to a callback, so the UI never has to wait for it.  The
+ * readers go through zfile, fsimage and vdrive, which are shared with the
+ * emulation, so the worker holds the mainlock while it reads an image.
+ * Only one image is read at a time: contentscache_read() waits for the
+ * worker if it's busy.  Without threads requests are handled right away.
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "contentscache.h"
+#include "crc32.h"
+#include "imagecontents.h"
+#include "lib.h"
+#include "log.h"
+#include "mainlock.h"
+#include "types.h"
+
+#ifdef USE_VICE_THREAD
+#   include <pthread.h>
+#   define LOCK() pthread_mutex_lock(&lock)
+#   define UNLOCK() pthread_mutex_unlock(&lock)
+#   define READ_LOCK() (pthread_once(&read_lock_once, read_lock_init), \
+                        pthread_mutex_lock(&read_lock))
+#   define READ_UNLOCK() pthread_mutex_unlock(&read_lock)
+#else
+#   define LOCK()
+#   define UNLOCK()
+#   define READ_LOCK()
+#   define READ_UNLOCK()
+#endif
+
+/* number of images whose contents are kept */
+#define CONTENTSCACHE_ENTRIES 64
+
+/* seconds after a change during which the CRC32 of a file is checked */
+#define CONTENTSCACHE_RECENT 2
+
+/* identifies a version of an image file */
+typedef struct contentscache_key_s {
+    int64_t size;
+    int64_t mtime;
+    long mtime_nsec;
+    uint64_t ino;
+    int has_crc;            /* the file was changed just before */
+    uint32_t crc;
+} contentscache_key_t;
+
+typedef struct contentscache_entry_s {
+    char *path;                     /* NULL if unused */
+    read_contents_func_type func;
+    contentscache_key_t key;
+    image_contents_t *contents;     /* NULL if the image couldn't be read */
+    unsigned int stamp;
+} contentscache_entry_t;
+
+static contentscache_entry_t cache[CONTENTSCACHE_ENTRIES];
+static unsigned int cache_stamp = 0;
+
+#ifdef USE_VICE_THREAD
+typedef struct contentscache_job_s {
+    unsigned int id;
+    char *path;
+    read_contents_func_type func;
+    contentscache_callback_t callback;
+    void *data;
+    struct contentscache_job_s *next;
+} contentscache_job_t;
+
+/* protects the cache and the queue */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/* held while an image is read, recursive since a reader function may use
+   contentscache_read() itself */
+static pthread_mutex_t read_lock;
+static pthread_once_t read_lock_once = PTHREAD_ONCE_INIT;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_t worker;
+static int worker_state = 0;    /* 0: not started, 1: running, -1: failed */
+static int worker_quit = 0;
+
+static contentscache_job_t *queue_first = NULL;
+static contentscache_job_t *queue_last = NULL;
+static unsigned int next_id = 1;
+
+static unsigned int running_id = 0;     /* job being handled by the worker */
+static int running_cancelled = 0;
+static int running_callback = 0;        /* its callback is being called */
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef USE_VICE_THREAD
+static void read_lock_init(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&read_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+#endif
+
+/* Identify the current version of an image */
+static int file_identify(const char *path, contentscache_key_t *key)
+{
+    struct stat st;
+    time_t now;
+
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return -1;
+    }
+    key->size = (int64_t)st.st_size;
+    key->mtime = (int64_t)st.st_mtime;
+#if defined(HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC)
+    key->mtime_nsec = (long)st.st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC_TV_NSEC)
+    key->mtime_nsec = (long)st.st_mtimespec.tv_nsec;
+#else
+    key->mtime_nsec = 0;
+#endif
+    key->ino = (uint64_t)st.st_ino;
+
+    now = time(NULL);
+    key->has_crc = (key->mtime >= (int64_t)now - CONTENTSCACHE_RECENT
+                    && key->mtime <= (int64_t)now + CONTENTSCACHE_RECENT);
+    key->crc = key->has_crc ? crc32_file(path) : 0;
+    return 0;
+}
+
+/* Is the file the same version as the one read?  An entry read while the
+   file was recently changed is only trusted while the CRC32 can be
+   compared, after that it's read once more.  */
+static int key_match(const contentscache_key_t *entry, const contentscache_key_t *key)
+{
+    if (entry->size != key->size || entry->mtime != key->mtime
+        || entry->mtime_nsec != key->mtime_nsec || entry->ino != key->ino
+        || entry->has_crc != key->has_crc) {
+        return 0;
+    }
+    return !entry->has_crc || entry->crc == key->crc;
+}
+
+static image_contents_t *contents_copy(const image_contents_t *src)
+{
+    image_contents_t *dest;
+    image_contents_file_list_t *p, *node, *last = NULL;
+
+    if (src == NULL) {
+        return NULL;
+    }
+
+    dest = image_contents_new();
+    memcpy(dest->name, src->name, sizeof(dest->name));
+    memcpy(dest->id, src->id, sizeof(dest->id));
+    dest->blocks_free = src->blocks_free;
+    dest->partition = src->partition;
+
+    for (p = src->file_list; p != NULL; p = p->next) {
+        node = lib_malloc(sizeof(image_contents_file_list_t));
+        memcpy(node, p, sizeof(image_contents_file_list_t));
+        node->prev = last;
+        node->next = NULL;
+        if (last == NULL) {
+            dest->file_list = node;
+        } else {
+            last->next = node;
+        }
+        last = node;
+    }
+    return dest;
+}
+
+/* Look up an image, must be called with the lock held */
+static contentscache_entry_t *cache_find(const char *path, read_contents_func_type func,
+                                         const contentscache_key_t *key)
+{
+    int i;
+
+    for (i = 0; i < CONTENTSCACHE_ENTRIES; i++) {
+        contentscache_entry_t *e = &cache[i];
+
+        if (e->path != NULL && e->func == func && strcmp(e->path, path) == 0) {
+            if (key_match(&e->key, key)) {
+                e->stamp = ++cache_stamp;
+                return e;
+            }
+            /* the file has changed */
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+/* Get a copy of the cached contents of an image, returns 0 if it isn't
+   cached */
+static int cache_lookup(const char *path, read_contents_func_type func,
+                        const contentscache_key_t *key, image_contents_t **contents)
+{
+    contentscache_entry_t *e;
+
+    LOCK();
+    e = cache_find(path, func, key);
+    if (e != NULL) {
+        *contents = contents_copy(e->contents);
+    }
+    UNLOCK();
+    return e != NULL;
+}
+
+static void entry_clear(contentscache_entry_t *e)
+{
+    lib_free(e->path);
+    e->path = NULL;
+    if (e->contents != NULL) {
+        image_contents_destroy(e->contents);
+        e->contents = NULL;
+    }
+}
+
+/* Remember the contents of an image, must be called with the lock held */
+static void cache_store(const char *path, read_contents_func_type func,
+                        const contentscache_key_t *key,
+                        const image_contents_t *contents)
+{
+    contentscache_entry_t *e = NULL;
+    int i;
+
+    /* replace an older version of the same image, an unused or the least
+       recently used entry */
+    for (i = 0; i < CONTENTSCACHE_ENTRIES; i++) {
+        if (cache[i].path != NULL && cache[i].func == func && strcmp(cache[i].path, path) == 0) {
+            e = &cache[i];
+            break;
+        }
+        if (e == NULL
+            || (e->path != NULL && (cache[i].path == NULL || cache[i].stamp < e->stamp))) {
+            e = &cache[i];
+        }
+    }
+
+    entry_clear(e);
+    e->path = lib_strdup(path);
+    e->func = func;
+    e->key = *key;
+    e->contents = contents_copy(contents);
+    e->stamp = ++cache_stamp;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Read the contents of an image identified by \a key, using the cache */
+static image_contents_t *read_identified(const char *path, read_contents_func_type func,
+                                         const contentscache_key_t *key)
+{
+    image_contents_t *contents;
+
+    READ_LOCK();
+    if (cache_lookup(path, func, key, &contents)) {
+        READ_UNLOCK();
+        return contents;
+    }
+
+    contents = func(path);
+
+    LOCK();
+    cache_store(path, func, key, contents);
+    UNLOCK();
+    READ_UNLOCK();
+    return contents;
+}
+
+/** \brief  Read the contents of an image, using the cache
+ *
+ * \param[in]   path    image file
+ * \param[in]   func    function to read the contents with, for example
+ *                      diskcontents_filesystem_read() or tapecontents_read()
+ *
+ * \return  contents, to be freed with image_contents_destroy(), or NULL if
+ *          the image could not be read
+ */
+image_contents_t *contentscache_read(const char *path, read_contents_func_type func)
+{
+    contentscache_key_t key;
+
+    if (path == NULL || func == NULL) {
+        return NULL;
+    }
+    if (file_identify(path, &key) < 0) {
+        image_contents_t *contents;
+
+        /* let the reader deal with it */
+        READ_LOCK();
+        contents = func(path);
+        READ_UNLOCK();
+        return contents;
+    }
+    return read_identified(path, func, &key);
+}
+
+#ifdef USE_VICE_THREAD
+static void job_free(contentscache_job_t *job)
+{
+    lib_free(job->path);
+    lib_free(job);
+}
+
+static void *worker_thread(void *unused)
+{
+    contentscache_job_t *job;
+    image_contents_t *contents;
+    contentscache_key_t key;
+
+    LOCK();
+    while (!worker_quit) {
+        if (queue_first == NULL) {
+            pthread_cond_wait(&cond, &lock);
+            continue;
+        }
+        job = queue_first;
+        queue_first = job->next;
+        if (queue_first == NULL) {
+            queue_last = NULL;
+        }
+        running_id = job->id;
+        running_cancelled = 0;
+        UNLOCK();
+
+        /* only hold up the emulation if the image has to be read; the
+           mainlock has to be taken before the read lock, as on the UI and
+           the VICE thread */
+        if (file_identify(job->path, &key) < 0) {
+            mainlock_worker_obtain();
+            contents = contentscache_read(job->path, job->func);
+            mainlock_worker_release();
+        } else if (!cache_lookup(job->path, job->func, &key, &contents)) {
+            mainlock_worker_obtain();
+            contents = read_identified(job->path, job->func, &key);
+            mainlock_worker_release();
+        }
+
+        LOCK();
+        if (!running_cancelled && !worker_quit) {
+            running_callback = 1;
+            UNLOCK();
+            job->callback(job->path, contents, job->data);
+            LOCK();
+            running_callback = 0;
+        } else if (contents != NULL) {
+            image_contents_destroy(contents);
+        }
+        running_id = 0;
+        job_free(job);
+        pthread_cond_broadcast(&cond);
+    }
+    UNLOCK();
+    return NULL;
+}
+
+/* Start the worker on the first request, returns 0 if it's running */
+static int worker_start(void)
+{
+    if (worker_state == 0) {
+        worker_quit = 0;
+        if (pthread_create(&worker, NULL, worker_thread, NULL)) {
+            log_warning(LOG_DEFAULT, "Image contents: cannot start worker thread, reading directly.");
+            worker_state = -1;
+        } else {
+            worker_state = 1;
+        }
+    }
+    return worker_state > 0 ? 0 : -1;
+}
+#endif
+
+/** \brief  Read the contents of an image in the background
+ *
+ * The callback is called with the contents once they have been read,
+ * normally on the worker thread, or right away if there is no worker
+ * thread.  Checking the cache means reading the whole image to get its
+ * CRC32, so that is left to the worker as well.
+ *
+ * \param[in]   path        image file
+ * \param[in]   func        function to read the contents with
+ * \param[in]   callback    function to call with the contents
+ * \param[in]   data        data for the callback
+ *
+ * \return  request ID for contentscache_cancel(), 0 if the callback has
+ *          already been called
+ */
+unsigned int contentscache_request(const char *path, read_contents_func_type func,
+                                   contentscache_callback_t callback, void *data)
+{
+#ifdef USE_VICE_THREAD
+    contentscache_job_t *job;
+    unsigned int id;
+
+    if (path != NULL && func != NULL) {
+        LOCK();
+        if (worker_start() == 0) {
+            job = lib_malloc(sizeof(contentscache_job_t));
+            id = next_id++;
+            if (id == 0) {
+                id = next_id++;
+            }
+            job->id = id;
+            job->path = lib_strdup(path);
+            job->func = func;
+            job->callback = callback;
+            job->data = data;
+            job->next = NULL;
+            if (queue_last == NULL) {
+                queue_first = job;
+            } else {
+                queue_last->next = job;
+            }
+            queue_last = job;
+            pthread_cond_broadcast(&cond);
+            UNLOCK();
+            return id;
+        }
+        UNLOCK();
+    }
+#endif
+    callback(path, contentscache_read(path, func), data);
+    return 0;
+}
+
+/** \brief  Cancel a request
+ *
+ * When this returns the callback of the request won't be called anymore,
+ * or has returned already.  Must not be called from the callback.
+ *
+ * \param[in]   id  request ID, 0 is ignored
+ */
+void contentscache_cancel(unsigned int id)
+{
+#ifdef USE_VICE_THREAD
+    contentscache_job_t *job, *prev = NULL;
+
+    if (id == 0) {
+        return;
+    }
+
+    LOCK();
+    for (job = queue_first; job != NULL; prev = job, job = job->next) {
+        if (job->id == id) {
+            if (prev == NULL) {
+                queue_first = job->next;
+            } else {
+                prev->next = job->next;
+            }
+            if (queue_last == job) {
+                queue_last = prev;
+            }
+            job_free(job);
+            UNLOCK();
+            return;
+        }
+    }
+    if (running_id == id) {
+        running_cancelled = 1;
+        while (running_id == id && running_callback) {
+            pthread_cond_wait(&cond, &lock);
+        }
+    }
+    UNLOCK();
+#endif
+}
+
+/** \brief  Stop the worker thread and free the cache
+ *
+ * Callbacks of pending requests are not called anymore.
+ */
+void contentscache_shutdown(void)
+{
+    int i;
+
+#ifdef USE_VICE_THREAD
+    contentscache_job_t *job;
+
+    LOCK();
+    while (queue_first != NULL) {
+        job = queue_first;
+        queue_first = job->next;
+        job_free(job);
+    }
+    queue_last = NULL;
+    if (worker_state > 0) {
+        worker_quit = 1;
+        pthread_cond_broadcast(&cond);
+        UNLOCK();
+        pthread_join(worker, NULL);
+        LOCK();
+    }
+    worker_state = 0;
+#endif
+
+    for (i = 0; i < CONTENTSCACHE_ENTRIES; i++) {
+        entry_clear(&cache[i]);
+    }
+    UNLOCK();
+}
@@ -0,0 +1,45 @@
+/*
+ * contentscache.h - Cached and background reading of image contents.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_CONTENTSCACHE_H
+#define VICE_CONTENTSCACHE_H
+
+#include "imagecontents.h"
+
+/** \brief  Callback for contentscache_request()
+ *
+ * \param[in]   path        image file
+ * \param[in]   contents    contents, owned by the callee, or NULL on error
+ * \param[in]   data        data passed to contentscache_request()
+ */
+typedef void (*contentscache_callback_t)(const char *path,
+                                         image_contents_t *contents,
+                                         void *data);
+
+image_contents_t *contentscache_read(const char *path, read_contents_func_type func);
+unsigned int contentscache_request(const char *path, read_contents_func_type func,
+                                   contentscache_callback_t callback, void *data);
+void contentscache_cancel(unsigned int id);
+void contentscache_shutdown(void);
+
+#endif
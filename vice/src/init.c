@@ -40,6 +40,7 @@
 #include "machine-video.h"
 #include "machine.h"
 #include "maincpu.h"
+#include "mediacache.h"
 #include "monitor.h"
 #ifdef HAVE_NETWORK
 #include "monitor_binary.h"
@@ -112,6 +113,10 @@ int init_resources(void)
         init_resource_fail("keyboard");
         return -1;
     }
+    if (mediacache_resources_init() < 0) {
+        init_resource_fail("media cache");
+        return -1;
+    }
     if (machine_video_resources_init() < 0) {
         init_resource_fail("machine video");
         return -1;
@@ -195,6 +200,10 @@ int init_cmdline_options(void)
         init_cmdline_options_fail("keyboard");
         return -1;
     }
+    if (mediacache_cmdline_options_init() < 0) {
+        init_cmdline_options_fail("media cache");
+        return -1;
+    }
     if (video_cmdline_options_init() < 0) {
         init_cmdline_options_fail("video");
         return -1;
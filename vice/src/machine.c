@@ -37,6 +37,7 @@
 #include "autostart.h"
 #include "cmdline.h"
 #include "console.h"
+#include "contentscache.h"
 #include "diskimage.h"
 #include "drive.h"
 #include "vice-event.h"
@@ -53,12 +54,14 @@
 #include "machine-video.h"
 #include "machine.h"
 #include "maincpu.h"
+#include "mediacache.h"
 #include "mem.h"
 #include "monitor.h"
 #include "monitor_network.h"
 #include "monitor_binary.h"
 #include "network.h"
 #include "palette.h"
+#include "perfcounters.h"
 #include "printer.h"
 #include "resources.h"
 #include "romset.h"
@@ -93,6 +96,10 @@ static bool is_jammed = false;
 static char *jam_reason = NULL;
 static int jam_action = MACHINE_JAM_ACTION_DIALOG;
 int machine_keymap_index;
+
+/* Used by maincpu.c, defined here so the resource can live with the other
+   common ones.  */
+int maincpu_idle_skip = MAINCPU_IDLE_SKIP_NONE;
 static char *ExitScreenshotName = NULL;
 static char *ExitScreenshotName1 = NULL;
 static bool is_first_reset = true;
@@ -336,6 +343,7 @@ void machine_shutdown(void)
     screenshot_shutdown();
 
     file_system_detach_disk_shutdown();
+    contentscache_shutdown();
 
     machine_specific_shutdown();
 
@@ -403,6 +411,10 @@ void machine_shutdown(void)
     joystick_resources_shutdown();
     sysfile_resources_shutdown();
     zfile_shutdown();
+    mediacache_shutdown();
+#ifdef FEATURE_PERFCOUNTERS
+    perfcounters_shutdown();
+#endif
     ui_resources_shutdown();
     log_resources_shutdown();
     fliplist_resources_shutdown();
@@ -456,6 +468,22 @@ static int set_exit_screenshot_name1(const char *val, void *param)
     return 0;
 }
 
+static int set_maincpu_idle_skip(int val, void *param)
+{
+    switch (val) {
+        case MAINCPU_IDLE_SKIP_NONE:
+        case MAINCPU_IDLE_SKIP_ENABLED:
+        case MAINCPU_IDLE_SKIP_VERIFY:
+            break;
+        default:
+            return -1;
+    }
+
+    maincpu_idle_skip = val;
+
+    return 0;
+}
+
 static resource_string_t resources_string[] = {
     { "ExitScreenshotName", "", RES_EVENT_NO, NULL,
       &ExitScreenshotName, set_exit_screenshot_name, NULL },
@@ -474,6 +502,26 @@ static const resource_int_t resources_int[] = {
     RESOURCE_INT_LIST_END
 };
 
+static const resource_int_t resources_int_idle_skip[] = {
+    { "MainCPUIdleSkip", MAINCPU_IDLE_SKIP_NONE, RES_EVENT_NO, NULL,
+      &maincpu_idle_skip, set_maincpu_idle_skip, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+/* Machines whose CPU emulation (maincpu.c) can skip idle loops.  */
+static int machine_has_idle_skip(void)
+{
+    switch (machine_class) {
+        case VICE_MACHINE_C64:
+        case VICE_MACHINE_PET:
+        case VICE_MACHINE_CBM5x0:
+        case VICE_MACHINE_CBM6x0:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
 int machine_common_resources_init(void)
 {
     if (machine_class != VICE_MACHINE_VSID) {
@@ -486,6 +534,11 @@ int machine_common_resources_init(void)
             }
         }
     }
+    if (machine_has_idle_skip()) {
+        if (resources_register_int(resources_int_idle_skip) < 0) {
+            return -1;
+        }
+    }
     return resources_register_int(resources_int);
 }
 
@@ -528,8 +581,21 @@ static const cmdline_option_t cmdline_options_vsid[] =
     CMDLINE_LIST_END
 };
 
+static const cmdline_option_t cmdline_options_idle_skip[] =
+{
+    { "-idleskip", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "MainCPUIdleSkip", NULL,
+      "<Mode>", "Skip idle loops of the main CPU: (0: None, 1: Skip, 2: Verify against normal execution)" },
+    CMDLINE_LIST_END
+};
+
 int machine_common_cmdline_options_init(void)
 {
+    if (machine_has_idle_skip()) {
+        if (cmdline_register_options(cmdline_options_idle_skip) < 0) {
+            return -1;
+        }
+    }
     if (machine_class == VICE_MACHINE_C128) {
         return cmdline_register_options(cmdline_options_c128);
     } else if (machine_class == VICE_MACHINE_VSID) {
@@ -34,6 +34,7 @@
 #include "alarm.h"
 #include "archdep.h"
 #include "autostart.h"
+#include "cpudispatch.h"
 #include "debug.h"
 #include "interrupt.h"
 #include "log.h"
@@ -246,7 +247,7 @@ void maincpu_resync_limits(void)
     }
 }
 
-void maincpu_mainloop(void)
+OPCODE_DISPATCH_FUNC void maincpu_mainloop(void)
 {
     /* Notice that using a struct for these would make it a lot slower (at
        least, on gcc 2.7.2.x).  */
@@ -346,16 +347,23 @@ void maincpu_mainloop(void)
 
 #define GLOBAL_REGS maincpu_regs
 
-#include "65816core.c"
+/* Run by the core after every opcode */
+#define CPU_LOOP_TAIL                                                   \
+    {                                                                   \
+        maincpu_int_status->num_dma_per_opcode = 0;                     \
+                                                                        \
+        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {   \
+            log_error(LOG_DEFAULT, "cycle limit reached.");             \
+            archdep_vice_exit(EXIT_FAILURE);                            \
+        }                                                               \
+                                                                        \
+        autostart_advance();                                            \
+    }
 
-        maincpu_int_status->num_dma_per_opcode = 0;
+#define CPU_LOOP_CONTINUES() 1
 
-        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
-            log_error(LOG_DEFAULT, "cycle limit reached.");
-            archdep_vice_exit(EXIT_FAILURE);
-        }
+#include "65816core.c"
 
-        autostart_advance();
 #if 0
         if (CLK > 246171754)
             debug.maincpu_traceflg = 1;
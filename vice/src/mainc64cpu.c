@@ -39,6 +39,7 @@
 #include "c64pla.h"
 #endif
 
+#include "cpudispatch.h"
 #include "debug.h"
 #include "interrupt.h"
 #include "machine.h"
@@ -658,7 +659,7 @@ void maincpu_resync_limits(void)
     }
 }
 
-void maincpu_mainloop(void)
+OPCODE_DISPATCH_FUNC void maincpu_mainloop(void)
 {
     /* Notice that using a struct for these would make it a lot slower (at
        least, on gcc 2.7.2.x).  */
@@ -731,16 +732,23 @@ void maincpu_mainloop(void)
 
 #define GLOBAL_REGS maincpu_regs
 
-#include "6510dtvcore.c"
+/* Run by the core after every opcode */
+#define CPU_LOOP_TAIL                                                   \
+    {                                                                   \
+        maincpu_int_status->num_dma_per_opcode = 0;                     \
+                                                                        \
+        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {   \
+            log_error(LOG_DEFAULT, "cycle limit reached.");             \
+            archdep_vice_exit(EXIT_FAILURE);                            \
+        }                                                               \
+                                                                        \
+        autostart_advance();                                            \
+    }
 
-        maincpu_int_status->num_dma_per_opcode = 0;
+#define CPU_LOOP_CONTINUES() 1
 
-        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
-            log_error(LOG_DEFAULT, "cycle limit reached.");
-            archdep_vice_exit(EXIT_FAILURE);
-        }
+#include "6510dtvcore.c"
 
-        autostart_advance();
 #if 0
         if (CLK > 246171754) {
             debug.maincpu_traceflg = 1;
@@ -34,6 +34,7 @@
 #include "alarm.h"
 #include "archdep.h"
 #include "autostart.h"
+#include "cpudispatch.h"
 #include "debug.h"
 #include "interrupt.h"
 #include "log.h"
@@ -66,6 +67,7 @@
  - PAGE_ONE
  - STORE_IND
  - LOAD_IND
+ - HAVE_IDLE_SKIP
 
 */
 
@@ -458,7 +460,311 @@ void maincpu_resync_limits(void)
     }
 }
 
-void maincpu_mainloop(void)
+#ifdef HAVE_IDLE_SKIP
+/* ------------------------------------------------------------------------- */
+
+/* Idle loop skipping.
+
+   A loop is idle if it only reads plain RAM or ROM, writes nothing and
+   leaves the registers as it found them: every further pass does exactly the
+   same until an alarm fires, and interrupts are only raised from alarms.  The
+   loop is run twice to measure the cycles of one pass, then `maincpu_clk' is
+   advanced by as many whole passes as fit before the next pending alarm, so
+   the alarm and everything after it happens at the same clock as before.
+
+   In verify mode nothing is skipped; the loop is run normally and the state
+   reached at the clock the skip would have stopped at is compared with the
+   state the skip would have produced.  */
+
+/* Longest loop body looked at, in instructions.  */
+#define IDLE_MAX_INSNS 8
+
+typedef struct idle_state_s {
+    uint8_t a, x, y;
+    uint8_t n, z, c, v;
+} idle_state_t;
+
+/* Loop found on the last pass, ~0 if none.  */
+static unsigned int idle_pc = ~0U;
+static CLOCK idle_clk;
+static CLOCK idle_alarm_clk;
+
+/* Pending verification.  */
+static int idle_verify_pending = 0;
+static unsigned int idle_verify_pc;
+static CLOCK idle_verify_clk;
+static idle_state_t idle_verify_state;
+static uint8_t idle_verify_sp;
+
+/* Fetch a byte of the loop the way the opcode fetch does, fails unless the
+   address is plain memory.  */
+static int idle_fetch(unsigned int addr, uint8_t *value)
+{
+    uint8_t *base;
+    int start, limit;
+
+    addr &= 0xffff;
+    if (addr < 2) {
+        return -1;
+    }
+    mem_mmu_translate(addr, &base, &start, &limit);
+    if (base == NULL) {
+        return -1;
+    }
+    *value = base[addr];
+    return 0;
+}
+
+/* Read a data byte, fails unless the address is plain memory.  */
+static int idle_read(unsigned int addr, uint8_t *value)
+{
+    uint8_t dummy;
+
+    if (idle_fetch(addr, &dummy) < 0) {
+        return -1;
+    }
+    *value = (*_mem_read_tab_ptr[addr >> 8])((uint16_t)addr);
+    return 0;
+}
+
+static int idle_branch_taken(uint8_t opcode, const idle_state_t *s)
+{
+    static const int flag_index[4] = { 0, 3, 2, 1 };
+    const uint8_t flags[4] = { s->n, s->z, s->c, s->v };
+
+    return ((opcode & 0x20) != 0) == (flags[flag_index[opcode >> 6]] != 0);
+}
+
+static int idle_state_equal(const idle_state_t *a, const idle_state_t *b)
+{
+    return a->a == b->a && a->x == b->x && a->y == b->y
+           && a->n == b->n && a->z == b->z && a->c == b->c && a->v == b->v;
+}
+
+/* Run one pass of the loop starting at `pc' on `s'.  Return 0 if the code at
+   `pc' is a loop that only reads plain memory and ends in a branch or jump
+   back to `pc' which is taken, -1 otherwise.  */
+static int idle_loop_pass(unsigned int pc, idle_state_t *s)
+{
+    unsigned int addr = pc;
+    int i;
+
+    for (i = 0; i < IDLE_MAX_INSNS; i++) {
+        uint8_t opcode, lo, hi, value;
+
+        if (idle_fetch(addr, &opcode) < 0 || idle_fetch(addr + 1, &lo) < 0) {
+            return -1;
+        }
+
+        switch (opcode) {
+            case 0x4c:  /* JMP abs */
+                if (idle_fetch(addr + 2, &hi) < 0) {
+                    return -1;
+                }
+                return ((unsigned int)(lo | (hi << 8)) == pc) ? 0 : -1;
+            case 0x10:  /* BPL */
+            case 0x30:  /* BMI */
+            case 0x50:  /* BVC */
+            case 0x70:  /* BVS */
+            case 0x90:  /* BCC */
+            case 0xb0:  /* BCS */
+            case 0xd0:  /* BNE */
+            case 0xf0:  /* BEQ */
+                if (((addr + 2 + (unsigned int)(int8_t)lo) & 0xffff) != pc) {
+                    return -1;
+                }
+                return idle_branch_taken(opcode, s) ? 0 : -1;
+            case 0xea:  /* NOP */
+                addr++;
+                continue;
+            default:
+                break;
+        }
+
+        switch (opcode & 0x0c) {
+            case 0x04:  /* zero page */
+                if (lo < 2) {
+                    return -1;
+                }
+                value = PAGE_ZERO[lo];
+                addr += 2;
+                break;
+            case 0x0c:  /* absolute */
+                if (idle_fetch(addr + 2, &hi) < 0
+                    || idle_read((unsigned int)(lo | (hi << 8)), &value) < 0) {
+                    return -1;
+                }
+                addr += 3;
+                break;
+            default:    /* immediate */
+                value = lo;
+                addr += 2;
+                break;
+        }
+
+        switch (opcode) {
+            case 0xa9:  /* LDA */
+            case 0xa5:
+            case 0xad:
+                s->a = value;
+                break;
+            case 0xa2:  /* LDX */
+            case 0xa6:
+            case 0xae:
+                s->x = value;
+                break;
+            case 0xa0:  /* LDY */
+            case 0xa4:
+            case 0xac:
+                s->y = value;
+                break;
+            case 0x29:  /* AND */
+            case 0x25:
+            case 0x2d:
+                s->a &= value;
+                value = s->a;
+                break;
+            case 0x09:  /* ORA */
+            case 0x05:
+            case 0x0d:
+                s->a |= value;
+                value = s->a;
+                break;
+            case 0x49:  /* EOR */
+            case 0x45:
+            case 0x4d:
+                s->a ^= value;
+                value = s->a;
+                break;
+            case 0xc9:  /* CMP */
+            case 0xc5:
+            case 0xcd:
+                s->c = s->a >= value;
+                value = (uint8_t)(s->a - value);
+                break;
+            case 0xe0:  /* CPX */
+            case 0xe4:
+            case 0xec:
+                s->c = s->x >= value;
+                value = (uint8_t)(s->x - value);
+                break;
+            case 0xc0:  /* CPY */
+            case 0xc4:
+            case 0xcc:
+                s->c = s->y >= value;
+                value = (uint8_t)(s->y - value);
+                break;
+            case 0x24:  /* BIT */
+            case 0x2c:
+                s->n = (value & 0x80) ? 1 : 0;
+                s->v = (value & 0x40) ? 1 : 0;
+                s->z = (s->a & value) ? 0 : 1;
+                continue;
+            default:
+                return -1;
+        }
+        s->n = (value & 0x80) ? 1 : 0;
+        s->z = value ? 0 : 1;
+    }
+    return -1;
+}
+
+/* Called after every opcode with the current registers.  */
+static void idle_skip_check(const idle_state_t *s, uint8_t sp)
+{
+    idle_state_t pass;
+    CLOCK next_clk, cycles, passes;
+    unsigned int last_opcode;
+
+    if (idle_verify_pending) {
+        if (maincpu_clk < idle_verify_clk) {
+            return;
+        }
+        if (maincpu_clk != idle_verify_clk || reg_pc != idle_verify_pc
+            || sp != idle_verify_sp || !idle_state_equal(s, &idle_verify_state)) {
+            log_error(LOG_DEFAULT,
+                      "Idle skip of loop at $%04x up to clock %"PRIu64" does not match: "
+                      "normal execution is at $%04x, clock %"PRIu64".",
+                      idle_verify_pc, idle_verify_clk, reg_pc, maincpu_clk);
+        }
+        idle_verify_pending = 0;
+        return;
+    }
+
+    /* Only look at loops that have just gone round, by a branch or jump
+       back to the current PC.  */
+    last_opcode = OPINFO_NUMBER(last_opcode_info);
+    if (reg_pc > last_opcode_addr
+        || (last_opcode != 0x4c && (last_opcode & 0x1f) != 0x10)) {
+        idle_pc = ~0U;
+        return;
+    }
+
+    if (monitor_mask[e_comp_space]
+        || maincpu_int_status->global_pending_int != IK_NONE) {
+        idle_pc = ~0U;
+        return;
+    }
+
+    pass = *s;
+    if (idle_loop_pass(reg_pc, &pass) < 0 || !idle_state_equal(&pass, s)) {
+        idle_pc = ~0U;
+        return;
+    }
+
+    next_clk = alarm_context_next_pending_clk(maincpu_alarm_context);
+
+    if (reg_pc != idle_pc || next_clk != idle_alarm_clk
+        || maincpu_clk <= idle_clk || next_clk <= maincpu_clk) {
+        /* First pass, or an alarm went off in between: measure again.  */
+        idle_pc = reg_pc;
+        idle_clk = maincpu_clk;
+        idle_alarm_clk = next_clk;
+        return;
+    }
+
+    cycles = maincpu_clk - idle_clk;
+    passes = (next_clk - 1 - maincpu_clk) / cycles;
+    idle_clk = maincpu_clk;
+
+    if (passes == 0) {
+        return;
+    }
+
+    if (maincpu_idle_skip == MAINCPU_IDLE_SKIP_VERIFY) {
+        idle_verify_pending = 1;
+        idle_verify_pc = reg_pc;
+        idle_verify_clk = maincpu_clk + passes * cycles;
+        idle_verify_state = *s;
+        idle_verify_sp = sp;
+        idle_pc = ~0U;
+        return;
+    }
+
+    maincpu_clk += passes * cycles;
+    idle_clk = maincpu_clk;
+}
+
+#define IDLE_SKIP_CHECK()                                       \
+    do {                                                        \
+        if (maincpu_idle_skip != MAINCPU_IDLE_SKIP_NONE) {      \
+            idle_state_t state;                                 \
+                                                                \
+            state.a = reg_a;                                    \
+            state.x = reg_x;                                    \
+            state.y = reg_y;                                    \
+            state.n = LOCAL_SIGN() ? 1 : 0;                     \
+            state.z = LOCAL_ZERO() ? 1 : 0;                     \
+            state.c = LOCAL_CARRY() ? 1 : 0;                    \
+            state.v = LOCAL_OVERFLOW() ? 1 : 0;                 \
+            idle_skip_check(&state, reg_sp);                    \
+        }                                                       \
+    } while (0)
+#else
+#define IDLE_SKIP_CHECK()
+#endif
+
+OPCODE_DISPATCH_FUNC void maincpu_mainloop(void)
 {
 #define origin (0)
 #ifndef C64DTV
@@ -564,16 +870,25 @@ void maincpu_mainloop(void)
 
 #define GLOBAL_REGS maincpu_regs
 
-#include "6510core.c"
+/* Run by the core after every opcode */
+#define CPU_LOOP_TAIL                                                   \
+    {                                                                   \
+        maincpu_int_status->num_dma_per_opcode = 0;                     \
+                                                                        \
+        IDLE_SKIP_CHECK();                                              \
+                                                                        \
+        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {   \
+            log_error(LOG_DEFAULT, "cycle limit reached.");             \
+            archdep_vice_exit(1);                                       \
+        }                                                               \
+                                                                        \
+        autostart_advance();                                            \
+    }
 
-        maincpu_int_status->num_dma_per_opcode = 0;
+#define CPU_LOOP_CONTINUES() 1
 
-        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
-            log_error(LOG_DEFAULT, "cycle limit reached.");
-            archdep_vice_exit(1);
-        }
+#include "6510core.c"
 
-        autostart_advance();
 #if 0
         if (CLK > 246171754) {
             debug.maincpu_traceflg = 1;
@@ -59,6 +59,14 @@ extern int maincpu_rmw_flag;
 extern CLOCK maincpu_clk;
 extern CLOCK maincpu_clk_limit;
 
+/* Skipping of idle loops, only done by machines that use maincpu.c and
+   define HAVE_IDLE_SKIP.  */
+#define MAINCPU_IDLE_SKIP_NONE      0
+#define MAINCPU_IDLE_SKIP_ENABLED   1
+#define MAINCPU_IDLE_SKIP_VERIFY    2
+
+extern int maincpu_idle_skip;
+
 /* 8502 cycle stretch indicator */
 extern int maincpu_stretch;
 
@@ -46,6 +46,7 @@
 #include "log.h"
 #include "machine.h"
 #include "mainlock.h"
+#include "video.h"
 #include "vsyncapi.h"
 
 /* This is lock coordinates access to VICE data structures */
@@ -58,7 +59,7 @@ static int              main_lock_obtain_depth;
 static pthread_mutex_t  internal_lock    = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t   ui_waiting_cond  = PTHREAD_COND_INITIALIZER;
 static pthread_cond_t   ui_has_lock_cond = PTHREAD_COND_INITIALIZER;
-static bool             ui_is_waiting    = false;
+static int              ui_waiting_count = 0;     /* threads waiting for the main lock */
 static pthread_t        vice_thread;
 static bool             vice_thread_keepalive  = true;
 static bool             vice_thread_is_running = false;
@@ -98,9 +99,9 @@ static void consider_exit(void)
         /* Setting this lets the UI thread know not to wait for signals in future mainlock_obtain() calls */
         vice_thread_is_running = false;
 
-        if (ui_is_waiting) {
+        if (ui_waiting_count > 0) {
             /* Wake up the UI thread, otherwise it will be waiting forever */
-            pthread_cond_signal(&ui_waiting_cond);
+            pthread_cond_broadcast(&ui_waiting_cond);
         }
 
         pthread_mutex_unlock(&internal_lock);
@@ -167,7 +168,13 @@ void mainlock_yield_begin(void)
      */
 
     pthread_mutex_lock(&internal_lock);
-    if (ui_is_waiting) {
+    if (ui_waiting_count > 0) {
+        /*
+         * Finish any frame conversions still running on the render threads,
+         * the UI is about to be free to change the render configuration.
+         */
+        video_canvas_render_sync_all();
+
         /* Wake up the UI thread */
         pthread_cond_signal(&ui_waiting_cond);
         /* Block until the UI has the main lock */
@@ -198,6 +205,27 @@ void mainlock_yield_and_sleep(tick_t ticks)
 
 /****/
 
+/* Wait for the VICE thread to yield and take the main lock */
+static void obtain_main_lock(void)
+{
+    pthread_mutex_lock(&internal_lock);
+
+    if (vice_thread_is_running) {
+        /* Block until the VICE thread signals us */
+        ui_waiting_count++;
+        pthread_cond_wait(&ui_waiting_cond, &internal_lock);
+        ui_waiting_count--;
+    }
+
+    pthread_mutex_unlock(&internal_lock);
+
+    /* Get the main lock */
+    pthread_mutex_lock(&main_lock);
+
+    /* Let the VICE thread know we have the mainlock now */
+    pthread_cond_signal(&ui_has_lock_cond);
+}
+
 void mainlock_obtain(void)
 {
 #ifdef DEBUG
@@ -227,22 +255,28 @@ void mainlock_obtain(void)
         return;
     }
 
-    pthread_mutex_lock(&internal_lock);
+    obtain_main_lock();
+}
 
-    if (vice_thread_is_running) {
-        /* Block until the VICE thread signals us */
-        ui_is_waiting = true;
-        pthread_cond_wait(&ui_waiting_cond, &internal_lock);
-        ui_is_waiting = false;
-    }
 
-    pthread_mutex_unlock(&internal_lock);
+/** \brief Obtain the mainlock from a background thread
+ *
+ * For threads other than the UI and the VICE thread which need to access
+ * VICE data structures, such as the image contents reader.  Unlike
+ * mainlock_obtain() this doesn't nest, and every call must be paired with
+ * mainlock_worker_release().
+ */
+void mainlock_worker_obtain(void)
+{
+    obtain_main_lock();
+}
 
-    /* Get the main lock */
-    pthread_mutex_lock(&main_lock);
 
-    /* Let the VICE thread know we have the mainlock now */
-    pthread_cond_signal(&ui_has_lock_cond);
+/** \brief Release the mainlock obtained with mainlock_worker_obtain()
+ */
+void mainlock_worker_release(void)
+{
+    pthread_mutex_unlock(&main_lock);
 }
 
 
@@ -50,6 +50,9 @@ void mainlock_yield_end(void);
 void mainlock_obtain(void);
 void mainlock_release(void);
 
+void mainlock_worker_obtain(void);
+void mainlock_worker_release(void);
+
 bool mainlock_is_vice_thread(void);
 
 #define mainlock_assert_is_not_vice_thread() assert(!mainlock_is_vice_thread())
@@ -65,6 +68,9 @@ bool mainlock_is_vice_thread(void);
 #define mainlock_obtain()
 #define mainlock_release()
 
+#define mainlock_worker_obtain()
+#define mainlock_worker_release()
+
 #define mainlock_assert_is_not_vice_thread()
 #define mainlock_assert_is_vice_thread()
 
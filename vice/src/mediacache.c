@@ -0,0 +1,606 @@
+/** \file   mediacache.c
+ * \brief   On-disk cache of decompressed and converted media images
+ *
+ * Attaching a compressed image means running it through zfile, which may
+ * have to spawn an external archiver, and then converting the image to the
+ * format the drive emulation works with.  This cache keeps the results of
+ * both steps in the user's cache directory, keyed by a hash of the data they
+ * were derived from, so attaching the same image again is cheap.
+ *
+ * Every entry is a single file holding a small header and the payload.  The
+ * last-use order of the entries is kept in an index file, which is used to
+ * evict the least recently used entries once the cache grows beyond the
+ * size set with the "MediaCacheSize" resource.
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "cmdline.h"
+#include "crc32.h"
+#include "lib.h"
+#include "log.h"
+#include "resources.h"
+#include "util.h"
+
+#include "mediacache.h"
+
+#ifdef USE_VICE_THREAD
+#   include <pthread.h>
+static pthread_mutex_t mediacache_lock = PTHREAD_MUTEX_INITIALIZER;
+#   define MEDIACACHE_LOCK() pthread_mutex_lock(&mediacache_lock)
+#   define MEDIACACHE_UNLOCK() pthread_mutex_unlock(&mediacache_lock)
+#else
+#   define MEDIACACHE_LOCK()
+#   define MEDIACACHE_UNLOCK()
+#endif
+
+/** \brief  Subdirectory of the user cache directory used for the cache */
+#define MEDIACACHE_DIR          "media"
+
+/** \brief  Name of the index file */
+#define MEDIACACHE_INDEX        "index"
+
+/** \brief  Extension of the entry files */
+#define MEDIACACHE_EXT          ".bin"
+
+/** \brief  Magic at the start of each entry file */
+#define MEDIACACHE_MAGIC        "VICEMC01"
+
+/** \brief  Size of the entry header: magic, tag, payload size and CRC32 */
+#define MEDIACACHE_HEADER_SIZE  20
+
+/** \brief  Maximum length of a key */
+#define MEDIACACHE_KEY_MAX      128
+
+/** \brief  Cache entry as recorded in the index */
+typedef struct mediacache_entry_s {
+    char *key;              /**< key, also the name of the file without extension */
+    size_t size;            /**< size of the file, including the header */
+    unsigned long stamp;    /**< last use, higher is more recent */
+} mediacache_entry_t;
+
+static mediacache_entry_t *entries = NULL;
+static int num_entries = 0;
+static int max_entries = 0;
+static unsigned long stamp_counter = 0;
+
+static int index_loaded = 0;
+
+/* Set when only the use stamps changed since the index was last written.
+   Lookups do not rewrite the index, it is written on the next insertion or
+   removal, or on shutdown.  */
+static int index_dirty = 0;
+static char *cache_dir = NULL;
+
+static log_t mediacache_log = LOG_DEFAULT;
+
+/** \brief  MediaCache resource: enable the cache */
+static int cache_enabled = 0;
+
+/** \brief  MediaCacheSize resource: maximum size of the cache in MiB */
+static int cache_size_mb = 256;
+
+
+static int set_cache_enabled(int val, void *param)
+{
+    cache_enabled = val ? 1 : 0;
+    return 0;
+}
+
+static int set_cache_size(int val, void *param)
+{
+    if (val < 1) {
+        return -1;
+    }
+    cache_size_mb = val;
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "MediaCache", 0, RES_EVENT_NO, NULL,
+      &cache_enabled, set_cache_enabled, NULL },
+    { "MediaCacheSize", 256, RES_EVENT_NO, NULL,
+      &cache_size_mb, set_cache_size, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int mediacache_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-mediacache", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "MediaCache", (resource_value_t)1,
+      NULL, "Cache decompressed and converted media images on disk" },
+    { "+mediacache", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "MediaCache", (resource_value_t)0,
+      NULL, "Do not cache decompressed and converted media images (default)" },
+    { "-mediacachesize", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "MediaCacheSize", NULL,
+      "<MiB>", "Set the maximum size of the media image cache" },
+    CMDLINE_LIST_END
+};
+
+int mediacache_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+/** \brief  Check whether the cache is enabled
+ *
+ * \return  bool
+ */
+int mediacache_enabled(void)
+{
+    return cache_enabled;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/** \brief  Create key with \a prefix for \a size bytes of \a data
+ *
+ * The key combines a 64-bit FNV-1a hash, the CRC32 and the size of the data.
+ *
+ * \param[in]   prefix  prefix, identifying what kind of data is cached
+ * \param[in]   data    data
+ * \param[in]   size    size of \a data
+ *
+ * \return  key, free with lib_free()
+ */
+char *mediacache_key_from_buffer(const char *prefix, const uint8_t *data, size_t size)
+{
+    uint64_t fnv = 0xcbf29ce484222325ULL;
+    uint32_t crc;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        fnv = (fnv ^ data[i]) * 0x100000001b3ULL;
+    }
+    crc = crc32_buf((const char *)data, (unsigned int)size);
+
+    return lib_msprintf("%s-%08x%08x%08x-%lx", prefix,
+                        (unsigned int)(fnv >> 32), (unsigned int)fnv,
+                        (unsigned int)crc, (unsigned long)size);
+}
+
+/** \brief  Create key with \a prefix for the contents of \a filename
+ *
+ * \param[in]   prefix      prefix, identifying what kind of data is cached
+ * \param[in]   filename    file to hash
+ *
+ * \return  key, free with lib_free(), or NULL if the file cannot be read
+ */
+char *mediacache_key_from_file(const char *prefix, const char *filename)
+{
+    FILE *fd;
+    uint8_t *data;
+    off_t len;
+    char *key = NULL;
+
+    fd = fopen(filename, MODE_READ);
+    if (fd == NULL) {
+        return NULL;
+    }
+    len = archdep_file_size(fd);
+    if (len >= 0) {
+        data = lib_malloc(len > 0 ? (size_t)len : 1);
+        if (len == 0 || fread(data, (size_t)len, 1, fd) == 1) {
+            key = mediacache_key_from_buffer(prefix, data, (size_t)len);
+        }
+        lib_free(data);
+    }
+    fclose(fd);
+
+    return key;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static char *entry_path(const char *key)
+{
+    char *name = util_concat(key, MEDIACACHE_EXT, NULL);
+    char *path = util_join_paths(cache_dir, name, NULL);
+
+    lib_free(name);
+    return path;
+}
+
+static int find_entry(const char *key)
+{
+    int i;
+
+    for (i = 0; i < num_entries; i++) {
+        if (strcmp(entries[i].key, key) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void add_entry(const char *key, size_t size, unsigned long stamp)
+{
+    if (num_entries == max_entries) {
+        max_entries = max_entries ? max_entries * 2 : 64;
+        entries = lib_realloc(entries, sizeof(mediacache_entry_t) * (size_t)max_entries);
+    }
+    entries[num_entries].key = lib_strdup(key);
+    entries[num_entries].size = size;
+    entries[num_entries].stamp = stamp;
+    num_entries++;
+
+    if (stamp > stamp_counter) {
+        stamp_counter = stamp;
+    }
+}
+
+static void remove_entry(int i, int delete_file)
+{
+    if (delete_file) {
+        char *path = entry_path(entries[i].key);
+        archdep_remove(path);
+        lib_free(path);
+    }
+    lib_free(entries[i].key);
+    entries[i] = entries[--num_entries];
+}
+
+/* Only accept keys that are safe to use as file names.  */
+static int valid_key(const char *key)
+{
+    size_t len = strlen(key);
+    size_t i;
+
+    if (len == 0 || len > MEDIACACHE_KEY_MAX) {
+        return 0;
+    }
+    for (i = 0; i < len; i++) {
+        if (!((key[i] >= '0' && key[i] <= '9') || (key[i] >= 'a' && key[i] <= 'z')
+              || (key[i] >= 'A' && key[i] <= 'Z') || key[i] == '-' || key[i] == '_')) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Replace `dest' with `src'; `dest' keeps its old contents on error.  */
+static int replace_file(const char *src, const char *dest)
+{
+    if (archdep_replace_file(src, dest) == 0) {
+        return 0;
+    }
+    archdep_remove(src);
+    return -1;
+}
+
+static void save_index(void)
+{
+    char *path, *tmp_path;
+    FILE *fd;
+    int i, error = 0;
+
+    path = util_join_paths(cache_dir, MEDIACACHE_INDEX, NULL);
+    tmp_path = util_concat(path, ".tmp", NULL);
+
+    fd = fopen(tmp_path, MODE_WRITE_TEXT);
+    if (fd != NULL) {
+        for (i = 0; i < num_entries && !error; i++) {
+            if (fprintf(fd, "%s %lu %lu\n", entries[i].key,
+                        (unsigned long)entries[i].size, entries[i].stamp) < 0) {
+                error = 1;
+            }
+        }
+        if (fclose(fd) != 0 || error) {
+            archdep_remove(tmp_path);
+        } else {
+            replace_file(tmp_path, path);
+        }
+    }
+    index_dirty = 0;
+
+    lib_free(tmp_path);
+    lib_free(path);
+}
+
+/* Load the index, creating the cache directory if needed.  Entry files that
+   are missing from the index, written by another instance for example, are
+   adopted as least recently used.  */
+static int load_index(void)
+{
+    char *path;
+    FILE *fd;
+    archdep_dir_t *dir;
+    const char *name;
+    char line[MEDIACACHE_KEY_MAX + 64];
+
+    if (index_loaded) {
+        return cache_dir != NULL ? 0 : -1;
+    }
+    index_loaded = 1;
+
+    if (mediacache_log == LOG_DEFAULT) {
+        mediacache_log = log_open("MediaCache");
+    }
+
+    cache_dir = util_join_paths(archdep_user_cache_path(), MEDIACACHE_DIR, NULL);
+    if (archdep_mkdir_recursive(cache_dir, 0755) < 0) {
+        log_error(mediacache_log, "Cannot create cache directory `%s'.", cache_dir);
+        lib_free(cache_dir);
+        cache_dir = NULL;
+        return -1;
+    }
+
+    path = util_join_paths(cache_dir, MEDIACACHE_INDEX, NULL);
+    fd = fopen(path, MODE_READ_TEXT);
+    lib_free(path);
+    if (fd != NULL) {
+        while (fgets(line, (int)sizeof(line), fd) != NULL) {
+            char key[MEDIACACHE_KEY_MAX + 1];
+            unsigned long size, stamp;
+            size_t real_size;
+            unsigned int isdir;
+            char *entry;
+
+            if (sscanf(line, "%128s %lu %lu", key, &size, &stamp) != 3
+                || !valid_key(key) || find_entry(key) >= 0) {
+                continue;
+            }
+            entry = entry_path(key);
+            if (archdep_stat(entry, &real_size, &isdir) == 0 && !isdir) {
+                add_entry(key, real_size, stamp);
+            }
+            lib_free(entry);
+        }
+        fclose(fd);
+    }
+
+    dir = archdep_opendir(cache_dir, ARCHDEP_OPENDIR_ALL_FILES);
+    if (dir != NULL) {
+        while ((name = archdep_readdir(dir)) != NULL) {
+            size_t len = strlen(name);
+            size_t ext_len = strlen(MEDIACACHE_EXT);
+            char key[MEDIACACHE_KEY_MAX + 1];
+            size_t real_size;
+            unsigned int isdir;
+            char *entry;
+
+            if (len <= ext_len || len - ext_len > MEDIACACHE_KEY_MAX
+                || strcmp(name + len - ext_len, MEDIACACHE_EXT) != 0) {
+                continue;
+            }
+            memcpy(key, name, len - ext_len);
+            key[len - ext_len] = '\0';
+            if (!valid_key(key) || find_entry(key) >= 0) {
+                continue;
+            }
+            entry = entry_path(key);
+            if (archdep_stat(entry, &real_size, &isdir) == 0 && !isdir) {
+                add_entry(key, real_size, 0);
+            }
+            lib_free(entry);
+        }
+        archdep_closedir(dir);
+    }
+
+    log_message(mediacache_log, "Using `%s', %d entries.", cache_dir, num_entries);
+
+    return 0;
+}
+
+/* Evict least recently used entries until the cache fits its size limit,
+   never evicting entry `keep'.  */
+static void evict(int keep)
+{
+    size_t limit = (size_t)cache_size_mb * 1024 * 1024;
+    size_t total = 0;
+    int i;
+
+    for (i = 0; i < num_entries; i++) {
+        total += entries[i].size;
+    }
+
+    while (total > limit && num_entries > 1) {
+        int oldest = -1;
+
+        for (i = 0; i < num_entries; i++) {
+            if (i != keep && (oldest < 0 || entries[i].stamp < entries[oldest].stamp)) {
+                oldest = i;
+            }
+        }
+        total -= entries[oldest].size;
+        /* remove_entry() moves the last entry into the freed slot */
+        if (keep == num_entries - 1) {
+            keep = oldest;
+        }
+        remove_entry(oldest, 1);
+    }
+}
+
+/** \brief  Look up \a key in the cache
+ *
+ * \param[in]   key     key
+ * \param[out]  tag     tag stored with the data
+ * \param[out]  size    size of the data
+ *
+ * \return  data, free with lib_free(), or NULL if not cached
+ */
+uint8_t *mediacache_get(const char *key, uint32_t *tag, size_t *size)
+{
+    uint8_t header[MEDIACACHE_HEADER_SIZE];
+    uint8_t *data = NULL;
+    char *path;
+    FILE *fd;
+    int i;
+
+    if (!cache_enabled || !valid_key(key)) {
+        return NULL;
+    }
+
+    MEDIACACHE_LOCK();
+
+    if (load_index() < 0 || (i = find_entry(key)) < 0) {
+        MEDIACACHE_UNLOCK();
+        return NULL;
+    }
+
+    path = entry_path(key);
+    fd = fopen(path, MODE_READ);
+    lib_free(path);
+    if (fd != NULL) {
+        if (fread(header, MEDIACACHE_HEADER_SIZE, 1, fd) == 1
+            && memcmp(header, MEDIACACHE_MAGIC, 8) == 0) {
+            size_t len = util_le_buf_to_dword(header + 12);
+
+            data = lib_malloc(len > 0 ? len : 1);
+            if ((len > 0 && fread(data, len, 1, fd) != 1)
+                || crc32_buf((const char *)data, (unsigned int)len) != util_le_buf_to_dword(header + 16)) {
+                lib_free(data);
+                data = NULL;
+            } else {
+                *tag = util_le_buf_to_dword(header + 8);
+                *size = len;
+            }
+        }
+        fclose(fd);
+    }
+
+    if (data != NULL) {
+        entries[i].stamp = ++stamp_counter;
+        index_dirty = 1;
+    } else {
+        log_warning(mediacache_log, "Removing damaged entry `%s'.", key);
+        remove_entry(i, 1);
+        save_index();
+    }
+
+    MEDIACACHE_UNLOCK();
+
+    return data;
+}
+
+/** \brief  Store \a size bytes of \a data in the cache under \a key
+ *
+ * \param[in]   key     key
+ * \param[in]   tag     tag to store with the data, returned by mediacache_get()
+ * \param[in]   data    data
+ * \param[in]   size    size of \a data
+ *
+ * \return  0 on success, -1 on error
+ */
+int mediacache_put(const char *key, uint32_t tag, const uint8_t *data, size_t size)
+{
+    uint8_t header[MEDIACACHE_HEADER_SIZE];
+    char *path, *tmp_path;
+    FILE *fd;
+    int i, error = 0;
+
+    if (!cache_enabled || !valid_key(key)
+        || size + MEDIACACHE_HEADER_SIZE > (size_t)cache_size_mb * 1024 * 1024
+        || size > 0xffffffffUL) {
+        return -1;
+    }
+
+    MEDIACACHE_LOCK();
+
+    if (load_index() < 0) {
+        MEDIACACHE_UNLOCK();
+        return -1;
+    }
+
+    memcpy(header, MEDIACACHE_MAGIC, 8);
+    util_dword_to_le_buf(header + 8, tag);
+    util_dword_to_le_buf(header + 12, (uint32_t)size);
+    util_dword_to_le_buf(header + 16, crc32_buf((const char *)data, (unsigned int)size));
+
+    /* Write to a temporary file first so readers never see partial entries.  */
+    path = entry_path(key);
+    tmp_path = util_concat(path, ".tmp", NULL);
+    fd = fopen(tmp_path, MODE_WRITE);
+    if (fd == NULL) {
+        error = 1;
+    } else {
+        if (fwrite(header, MEDIACACHE_HEADER_SIZE, 1, fd) != 1
+            || (size > 0 && fwrite(data, size, 1, fd) != 1)) {
+            error = 1;
+        }
+        if (fclose(fd) != 0 || error) {
+            archdep_remove(tmp_path);
+            error = 1;
+        } else if (replace_file(tmp_path, path) < 0) {
+            error = 1;
+        }
+    }
+    lib_free(tmp_path);
+    lib_free(path);
+
+    if (error) {
+        log_warning(mediacache_log, "Cannot write entry `%s'.", key);
+        MEDIACACHE_UNLOCK();
+        return -1;
+    }
+
+    i = find_entry(key);
+    if (i < 0) {
+        add_entry(key, size + MEDIACACHE_HEADER_SIZE, 0);
+        i = num_entries - 1;
+    }
+    entries[i].size = size + MEDIACACHE_HEADER_SIZE;
+    entries[i].stamp = ++stamp_counter;
+
+    evict(i);
+    save_index();
+
+    MEDIACACHE_UNLOCK();
+
+    return 0;
+}
+
+/** \brief  Write pending index changes and free memory used by the cache */
+void mediacache_shutdown(void)
+{
+    MEDIACACHE_LOCK();
+    if (index_dirty && cache_dir != NULL) {
+        save_index();
+    }
+    index_dirty = 0;
+    while (num_entries > 0) {
+        remove_entry(num_entries - 1, 0);
+    }
+    lib_free(entries);
+    entries = NULL;
+    max_entries = 0;
+    stamp_counter = 0;
+    if (cache_dir != NULL) {
+        lib_free(cache_dir);
+        cache_dir = NULL;
+    }
+    index_loaded = 0;
+    MEDIACACHE_UNLOCK();
+}
@@ -0,0 +1,44 @@
+/** \file   mediacache.h
+ * \brief   On-disk cache of decompressed and converted media images - header
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_MEDIACACHE_H
+#define VICE_MEDIACACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+int mediacache_resources_init(void);
+int mediacache_cmdline_options_init(void);
+void mediacache_shutdown(void);
+
+int mediacache_enabled(void);
+
+char *mediacache_key_from_buffer(const char *prefix, const uint8_t *data, size_t size);
+char *mediacache_key_from_file(const char *prefix, const char *filename);
+
+uint8_t *mediacache_get(const char *key, uint32_t *tag, size_t *size);
+int mediacache_put(const char *key, uint32_t tag, const uint8_t *data, size_t size);
+
+#endif
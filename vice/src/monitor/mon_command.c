@@ -734,6 +734,34 @@ static const mon_cmds_t mon_cmd_array[] = {
       FILENAME_ARG
     },
 
+    { "profile", "prof",
+      "[on|off|toggle]",
+      "Turn the cycle profiler on or off.  While it is on, the cycles used by\n"
+      "every instruction of the computer and drive CPUs are accumulated per\n"
+      "address and per call stack.",
+      NO_FILENAME_ARG
+    },
+
+    { "profilesave", "profsave",
+      "\"<filename>\" <Format>",
+      "Save the profile. Format is:\n"
+      "0 = callgrind (for kcachegrind), 1 = folded stacks (for flamegraphs).",
+      FILENAME_ARG
+    },
+
+    { "profileshow", "profsh",
+      "[<count>]",
+      "Show the <count> most expensive functions and addresses of the\n"
+      "default device.",
+      NO_FILENAME_ARG
+    },
+
+    { "profilezap", "profzap",
+      NULL,
+      "Clear the profile.",
+      NO_FILENAME_ARG
+    },
+
     { "print", "p",
       "<expression>",
       "Evaluate the specified expression and output the result.",
@@ -800,10 +828,27 @@ static const mon_cmds_t mon_cmd_array[] = {
       NO_FILENAME_ARG
     },
 
+    { "tracestart", "trstart",
+      "\"<filename>\"",
+      "Start recording a binary trace of every instruction executed by the\n"
+      "computer and drive CPUs, including the memory accesses of the\n"
+      "computer's CPU, to the specified file.  Use the vicetrace tool to\n"
+      "decode, filter and compare traces.",
+      FILENAME_ARG
+    },
+
+    { "tracestop", "trstop",
+      NULL,
+      "Stop recording the binary trace.",
+      NO_FILENAME_ARG
+    },
+
     { "warp", "",
       "[on|off|toggle]",
       "Turn warp mode on or off. If the argument is 'toggle' then the current mode\n"
-      "is toggled. When no argument is given the current mode is displayed.",
+      "is toggled. When no argument is given the current mode is displayed,\n"
+      "along with the emulation speed and the number of frames skipped by\n"
+      "AdaptiveFrameSkip.",
       NO_FILENAME_ARG
     },
 
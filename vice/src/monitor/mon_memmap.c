@@ -39,6 +39,8 @@
 #include "machine.h"
 #include "mon_disassemble.h"
 #include "mon_memmap.h"
+#include "mon_profile.h"
+#include "mon_trace.h"
 #include "monitor.h"
 #include "montypes.h"
 #include "screenshot.h"
@@ -138,6 +140,10 @@ void monitor_cpuhistory_store(CLOCK cycle, unsigned int addr, unsigned int op,
         return;
     }
 
+    if (mon_trace_enabled) {
+        mon_trace_store(cycle, addr, op, p1, p2, reg_a, reg_x, reg_y, reg_sp, reg_st, origin);
+    }
+
     ++cpuhistory_i;
     if (cpuhistory_i == cpuhistory_lines) {
         cpuhistory_i = 0;
@@ -153,10 +159,21 @@ void monitor_cpuhistory_store(CLOCK cycle, unsigned int addr, unsigned int op,
     cpuhistory[cpuhistory_i].reg_sp = reg_sp;
     cpuhistory[cpuhistory_i].reg_st = reg_st;
     cpuhistory[cpuhistory_i].origin = origin;
+
+    /* last, so the arguments need not be kept across the call */
+    if (mon_profile_enabled) {
+        mon_profile_store(cycle, addr, op, p1, p2, reg_sp, origin);
+    }
 }
 
 void monitor_cpuhistory_fix_p2(unsigned int p2)
 {
+    if (mon_profile_enabled) {
+        mon_profile_fix_p2(p2);
+    }
+    if (mon_trace_enabled) {
+        mon_trace_fix_p2(p2);
+    }
     cpuhistory[cpuhistory_i].p2 = p2;
 }
 
@@ -341,6 +358,10 @@ void monitor_memmap_store(unsigned int addr, unsigned int type)
         return;
     }
 
+    if (mon_trace_enabled) {
+        mon_trace_access(addr, type);
+    }
+
     mon_memmap[addr & mon_memmap_mask] |= type;
 }
 
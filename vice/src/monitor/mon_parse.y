@@ -60,6 +60,8 @@ char *alloca();
 #include "mon_file.h"
 #include "mon_memmap.h"
 #include "mon_memory.h"
+#include "mon_profile.h"
+#include "mon_trace.h"
 #include "mon_register.h"
 #include "mon_util.h"
 #include "montypes.h"
@@ -68,6 +70,7 @@ char *alloca();
 #include "types.h"
 #include "uimon.h"
 #include "vsync.h"
+#include "vsyncapi.h"
 
 #define join_ints(x,y) (LO16_TO_HI16(x)|y)
 #define separate_int1(x) (HI16_TO_LO16(x))
@@ -143,6 +146,8 @@ int yylex(void);
 %token CMD_RESOURCE_GET CMD_RESOURCE_SET CMD_LOAD_RESOURCES CMD_SAVE_RESOURCES
 %token CMD_ATTACH CMD_DETACH CMD_MON_RESET CMD_TAPECTRL CMD_CARTFREEZE CMD_UPDB CMD_JPDB
 %token CMD_CPUHISTORY CMD_MEMMAPZAP CMD_MEMMAPSHOW CMD_MEMMAPSAVE
+%token CMD_PROFILE CMD_PROFILEZAP CMD_PROFILESHOW CMD_PROFILESAVE
+%token CMD_TRACESTART CMD_TRACESTOP
 %token CMD_COMMENT CMD_LIST CMD_STOPWATCH RESET
 %token CMD_EXPORT CMD_AUTOSTART CMD_AUTOLOAD CMD_MAINCPU_TRACE
 %token CMD_WARP
@@ -277,8 +282,17 @@ machine_state_rules: CMD_BANK end_cmd
                      { mon_display_screen($2); }
                    | CMD_WARP end_cmd
                      {
+                        double cpu_percent, emulated_fps, skipped_fps;
+                        int warp_enabled;
+                        unsigned long skipped_frames;
+
                         mon_out("Warp mode is %s.\n",
                                 vsync_get_warp_mode() ? "on" : "off");
+
+                        vsyncarch_get_metrics(&cpu_percent, &emulated_fps, &warp_enabled,
+                                              &skipped_fps, &skipped_frames);
+                        mon_out("Speed: %.1f%% cpu, %.1f fps, %lu frames skipped (%.1f per second).\n",
+                                cpu_percent, emulated_fps, skipped_frames, skipped_fps);
                      }
                    | CMD_WARP TOGGLE end_cmd
                      {
@@ -383,6 +397,20 @@ memory_rules: CMD_MOVE address_range opt_sep address end_cmd
               { mon_memmap_show($3,$4[0],$4[1]); }
             | CMD_MEMMAPSAVE filename opt_sep expression end_cmd
               { mon_memmap_save($2,$4); }
+            | CMD_PROFILE TOGGLE end_cmd
+              { mon_profile_set($2); }
+            | CMD_PROFILEZAP end_cmd
+              { mon_profile_zap(); }
+            | CMD_PROFILESHOW end_cmd
+              { mon_profile_show(0); }
+            | CMD_PROFILESHOW opt_sep expression end_cmd
+              { mon_profile_show($3); }
+            | CMD_PROFILESAVE filename opt_sep expression end_cmd
+              { mon_profile_save($2,$4); }
+            | CMD_TRACESTART filename end_cmd
+              { mon_trace_start($2); }
+            | CMD_TRACESTOP end_cmd
+              { mon_trace_stop(); }
             ;
 
 checkpoint_rules: CMD_BREAK opt_mem_op address_opt_range opt_if_cond_expr end_cmd
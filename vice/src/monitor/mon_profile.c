@@ -0,0 +1,771 @@
+/*
+ * mon_profile.c - The VICE built-in monitor, cycle profiler.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * The profiler is fed by the same per instruction hook as the cpu history.
+ * The cycles between two instructions are charged to the address of the
+ * first one, both per function and per node of a call tree.  Functions are
+ * tracked by watching the stack pointer: JSR, BRK and interrupts open a
+ * frame, and a frame is closed as soon as the stack pointer climbs back
+ * above the value it had when the frame was opened.  This copes with code
+ * that drops its return address or returns through RTI.
+ *
+ * The result can be saved in the callgrind format (for kcachegrind and
+ * friends) or as folded stacks (for flamegraph.pl and speedscope).
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "lib.h"
+#include "mon_profile.h"
+#include "monitor.h"
+#include "montypes.h"
+#include "types.h"
+
+
+/* Globals */
+
+int mon_profile_enabled = 0;
+
+#ifdef FEATURE_CPUMEMHISTORY
+
+/* Defines */
+
+#define PROFILE_NUM_CPUS    (NUM_MEMSPACES - 1)
+#define PROFILE_STACK_SIZE  256
+#define PROFILE_HASH_SIZE   0x1000
+#define PROFILE_NODES_SIZE  0x400
+
+#define OP_BRK 0x00
+#define OP_PHP 0x08
+#define OP_JSR 0x20
+#define OP_PLP 0x28
+#define OP_RTI 0x40
+#define OP_PHA 0x48
+#define OP_RTS 0x60
+#define OP_PLA 0x68
+#define OP_TXS 0x9a
+
+/* Functions are numbered by entry address, the top level is -1.  Encoded
+   in keys they are offset by one so they always fit in 17 bits. */
+#define FUNC_TOP        (-1)
+#define FUNC_ENC(f)     ((uint64_t)((f) + 1))
+#define FUNC_DEC(k)     ((int)((k) & 0x1ffff) - 1)
+
+/* Key layout: bit 63 marks a used slot, bits 40-56 the function, bit 39
+   is set for call edges, bits 20-35 the address and bits 0-16 the called
+   function.  Sorting the keys groups everything by function, costs first. */
+#define KEY_USED        ((uint64_t)1 << 63)
+#define KEY_EDGE        ((uint64_t)1 << 39)
+#define KEY_COST(f, pc) (KEY_USED | (FUNC_ENC(f) << 40) | ((uint64_t)(pc) << 20))
+#define KEY_CALL(f, pc, callee) (KEY_COST(f, pc) | KEY_EDGE | FUNC_ENC(callee))
+#define KEY_FUNC(k)     FUNC_DEC((k) >> 40)
+#define KEY_PC(k)       ((unsigned int)((k) >> 20) & 0xffff)
+#define KEY_CALLEE(k)   FUNC_DEC(k)
+
+/* Types */
+
+typedef struct profile_entry_s {
+    uint64_t key;
+    CLOCK cycles;   /* exclusive cycles, or inclusive ones for call edges */
+    CLOCK calls;
+} profile_entry_t;
+
+typedef struct profile_node_s {
+    int parent;
+    int func;
+    int first_child;
+    int next_sibling;
+    CLOCK self;
+} profile_node_t;
+
+/* Exclusive cycles of an address not yet added to the hash, with the
+   function they belong to. */
+typedef struct profile_pending_s {
+    int32_t func;
+    uint32_t cycles;
+} profile_pending_t;
+
+typedef struct profile_frame_s {
+    int node;
+    int func;
+    uint16_t call_pc;
+    uint8_t sp_entry;
+    CLOCK call_clk;
+    CLOCK self;     /* cycles not yet added to the node */
+} profile_frame_t;
+
+typedef struct profile_cpu_s {
+    int valid;
+
+    /* the previous instruction */
+    CLOCK last_clk;
+    uint16_t last_pc;
+    uint16_t last_target;
+    uint8_t last_op;
+    uint8_t last_sp;
+
+    profile_frame_t stack[PROFILE_STACK_SIZE];
+    int depth;
+
+    profile_entry_t *hash;
+    unsigned int hash_size;
+    unsigned int hash_used;
+
+    profile_pending_t *pending;
+
+    profile_node_t *nodes;
+    int nodes_size;
+    int nodes_used;
+
+    CLOCK total;
+} profile_cpu_t;
+
+static profile_cpu_t profile_cpu[PROFILE_NUM_CPUS];
+static profile_cpu_t *profile_last_cpu = NULL;
+
+/* What each opcode does to the stack pointer, filled in by mon_profile_set().
+   A table lookup, as a switch on the opcode is mispredicted on most
+   instructions. */
+static int8_t profile_stack_delta[256];
+
+static const char * const profile_cpu_name[PROFILE_NUM_CPUS] = {
+    "maincpu", "drive8", "drive9", "drive10", "drive11"
+};
+
+/* ------------------------------------------------------------------------- */
+
+static inline unsigned int profile_hash_index(uint64_t key, unsigned int size)
+{
+    key ^= key >> 29;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 32;
+    return (unsigned int)key & (size - 1);
+}
+
+static void profile_hash_grow(profile_cpu_t *cpu)
+{
+    profile_entry_t *old = cpu->hash;
+    unsigned int old_size = cpu->hash_size;
+    unsigned int i, j;
+
+    cpu->hash_size = old_size ? old_size * 2 : PROFILE_HASH_SIZE;
+    cpu->hash = lib_calloc(cpu->hash_size, sizeof(profile_entry_t));
+
+    for (i = 0; i < old_size; i++) {
+        if (old[i].key) {
+            j = profile_hash_index(old[i].key, cpu->hash_size);
+            while (cpu->hash[j].key) {
+                j = (j + 1) & (cpu->hash_size - 1);
+            }
+            cpu->hash[j] = old[i];
+        }
+    }
+    lib_free(old);
+}
+
+static profile_entry_t *profile_hash_get(profile_cpu_t *cpu, uint64_t key)
+{
+    unsigned int i;
+
+    if (cpu->hash_used * 2 >= cpu->hash_size) {
+        profile_hash_grow(cpu);
+    }
+
+    i = profile_hash_index(key, cpu->hash_size);
+    while (cpu->hash[i].key != key) {
+        if (cpu->hash[i].key == 0) {
+            cpu->hash[i].key = key;
+            cpu->hash_used++;
+            break;
+        }
+        i = (i + 1) & (cpu->hash_size - 1);
+    }
+    return &cpu->hash[i];
+}
+
+static int profile_node_child(profile_cpu_t *cpu, int parent, int func)
+{
+    profile_node_t *node;
+    int *link;
+    int i;
+
+    /* a found child is moved to the front, calls from a function tend to
+       go to the same few functions */
+    for (link = &cpu->nodes[parent].first_child; *link >= 0; link = &cpu->nodes[*link].next_sibling) {
+        i = *link;
+        if (cpu->nodes[i].func == func) {
+            *link = cpu->nodes[i].next_sibling;
+            cpu->nodes[i].next_sibling = cpu->nodes[parent].first_child;
+            cpu->nodes[parent].first_child = i;
+            return i;
+        }
+    }
+
+    if (cpu->nodes_used == cpu->nodes_size) {
+        cpu->nodes_size *= 2;
+        cpu->nodes = lib_realloc(cpu->nodes, cpu->nodes_size * sizeof(profile_node_t));
+    }
+    i = cpu->nodes_used++;
+    node = &cpu->nodes[i];
+    node->parent = parent;
+    node->func = func;
+    node->first_child = -1;
+    node->next_sibling = cpu->nodes[parent].first_child;
+    node->self = 0;
+    cpu->nodes[parent].first_child = i;
+    return i;
+}
+
+/* Add the pending cycles of `addr' to the hash. */
+static void profile_flush_addr(profile_cpu_t *cpu, unsigned int addr)
+{
+    profile_pending_t *pending = &cpu->pending[addr];
+
+    profile_hash_get(cpu, KEY_COST(pending->func, addr))->cycles += pending->cycles;
+    pending->cycles = 0;
+}
+
+/* Add the cycles of `frame' to its node of the call tree. */
+static void profile_flush_frame(profile_cpu_t *cpu, profile_frame_t *frame)
+{
+    cpu->nodes[frame->node].self += frame->self;
+    cpu->total += frame->self;
+    frame->self = 0;
+}
+
+/* Add the cycles of all open frames to the call tree.  Not inlined, as it
+   would slow down mon_profile_store() for the rare case it is needed in. */
+static VICE_ATTR_NOINLINE void profile_flush_frames(profile_cpu_t *cpu)
+{
+    int i;
+
+    for (i = 0; i <= cpu->depth; i++) {
+        profile_flush_frame(cpu, &cpu->stack[i]);
+    }
+}
+
+/* Bring the hash and the call tree up to date before they are read. */
+static void profile_flush(profile_cpu_t *cpu)
+{
+    unsigned int addr;
+
+    for (addr = 0; addr < 0x10000; addr++) {
+        if (cpu->pending[addr].cycles) {
+            profile_flush_addr(cpu, addr);
+        }
+    }
+    profile_flush_frames(cpu);
+}
+
+static void profile_cpu_reset(profile_cpu_t *cpu)
+{
+    if (cpu->hash) {
+        memset(cpu->hash, 0, cpu->hash_size * sizeof(profile_entry_t));
+    }
+    cpu->hash_used = 0;
+
+    if (cpu->pending == NULL) {
+        cpu->pending = lib_calloc(0x10000, sizeof(profile_pending_t));
+    } else {
+        memset(cpu->pending, 0, 0x10000 * sizeof(profile_pending_t));
+    }
+
+    if (cpu->nodes == NULL) {
+        cpu->nodes_size = PROFILE_NODES_SIZE;
+        cpu->nodes = lib_malloc(cpu->nodes_size * sizeof(profile_node_t));
+    }
+    cpu->nodes[0].parent = -1;
+    cpu->nodes[0].func = FUNC_TOP;
+    cpu->nodes[0].first_child = -1;
+    cpu->nodes[0].next_sibling = -1;
+    cpu->nodes[0].self = 0;
+    cpu->nodes_used = 1;
+
+    cpu->depth = 0;
+    cpu->stack[0].node = 0;
+    cpu->stack[0].self = 0;
+
+    cpu->total = 0;
+    cpu->valid = 0;
+}
+
+/* Open a new frame for `func', entered from `call_pc' with the stack
+   pointer at `sp_entry'. */
+static void profile_push(profile_cpu_t *cpu, int func, uint16_t call_pc,
+                         uint8_t sp_entry, CLOCK clk)
+{
+    profile_frame_t *frame;
+
+    if (cpu->depth == PROFILE_STACK_SIZE - 1) {
+        return;
+    }
+
+    frame = &cpu->stack[++cpu->depth];
+    frame->node = profile_node_child(cpu, cpu->stack[cpu->depth - 1].node, func);
+    frame->func = func;
+    frame->call_pc = call_pc;
+    frame->sp_entry = sp_entry;
+    frame->call_clk = clk;
+    frame->self = 0;
+}
+
+/* Close all frames whose stack has been released. */
+static void profile_pop(profile_cpu_t *cpu, uint8_t sp, CLOCK clk)
+{
+    profile_frame_t *frame;
+    profile_entry_t *entry;
+
+    while (cpu->depth > 0 && sp >= cpu->stack[cpu->depth].sp_entry) {
+        frame = &cpu->stack[cpu->depth--];
+        profile_flush_frame(cpu, frame);
+        entry = profile_hash_get(cpu, KEY_CALL(cpu->stack[cpu->depth].func,
+                                               frame->call_pc, frame->func));
+        entry->calls++;
+        entry->cycles += clk - frame->call_clk;
+    }
+}
+
+/* Open and close frames after the previous instruction moved the stack
+   pointer by `delta'.  Not inlined either, see profile_flush_frames(). */
+static VICE_ATTR_NOINLINE void profile_stack_changed(profile_cpu_t *cpu, unsigned int addr,
+                                                     uint8_t reg_sp, int delta, CLOCK cycle)
+{
+    int expected, interrupted;
+
+    if (cpu->last_op == OP_TXS) {
+        expected = delta;
+    } else {
+        expected = profile_stack_delta[cpu->last_op];
+    }
+    /* an interrupt taken after the instruction pushed three more bytes */
+    interrupted = (delta == expected + 3);
+
+    profile_pop(cpu, (uint8_t)(interrupted ? reg_sp + 3 : reg_sp), cycle);
+
+    if (cpu->last_op == OP_JSR && delta >= 2) {
+        if (interrupted) {
+            profile_push(cpu, cpu->last_target, cpu->last_pc, cpu->last_sp, cycle);
+        } else {
+            profile_push(cpu, addr, cpu->last_pc, cpu->last_sp, cycle);
+        }
+    } else if (cpu->last_op == OP_BRK && delta == 3) {
+        profile_push(cpu, addr, cpu->last_pc, cpu->last_sp, cycle);
+    }
+    if (interrupted) {
+        profile_push(cpu, addr, cpu->last_pc, (uint8_t)(reg_sp + 3), cycle);
+    }
+}
+
+/* Called for every instruction before it is executed, see
+   monitor_cpuhistory_store(). */
+void mon_profile_store(CLOCK cycle, unsigned int addr, unsigned int op,
+                       unsigned int p1, unsigned int p2, uint8_t reg_sp,
+                       uint8_t origin)
+{
+    profile_cpu_t *cpu;
+    profile_frame_t *top;
+    profile_pending_t *pending;
+    CLOCK cycles;
+    int delta;
+
+    if (origin >= PROFILE_NUM_CPUS) {
+        return;
+    }
+    cpu = &profile_cpu[origin];
+    profile_last_cpu = cpu;
+
+    if (!cpu->valid || cycle < cpu->last_clk) {
+        profile_flush_frames(cpu);
+        cpu->depth = 0;
+        cpu->stack[0].node = 0;
+        cpu->stack[0].func = FUNC_TOP;
+        cpu->valid = 1;
+        goto done;
+    }
+
+    /* charge the previous instruction, the hash is only updated when its
+       address is run by another function, or when the profile is read */
+    top = &cpu->stack[cpu->depth];
+    cycles = cycle - cpu->last_clk;
+    pending = &cpu->pending[cpu->last_pc];
+    if (pending->func != top->func || pending->cycles > UINT32_MAX - cycles) {
+        if (pending->cycles) {
+            profile_flush_addr(cpu, cpu->last_pc);
+        }
+        pending->func = top->func;
+    }
+    pending->cycles += (uint32_t)cycles;
+    top->self += cycles;
+
+    /* find out what the previous instruction did to the stack */
+    delta = (int8_t)(cpu->last_sp - reg_sp);
+    if (delta == 0 && profile_stack_delta[cpu->last_op] == 0) {
+        /* most instructions leave the stack alone, they can neither open
+           nor close a frame */
+        goto done;
+    }
+    profile_stack_changed(cpu, addr, reg_sp, delta, cycle);
+
+done:
+    cpu->last_clk = cycle;
+    cpu->last_pc = (uint16_t)addr;
+    cpu->last_op = (uint8_t)op;
+    cpu->last_sp = reg_sp;
+    cpu->last_target = (uint16_t)(p1 | (p2 << 8));
+}
+
+/* The cpu cores only know the high byte of the JSR target after storing
+   the history entry. */
+void mon_profile_fix_p2(unsigned int p2)
+{
+    if (profile_last_cpu != NULL) {
+        profile_last_cpu->last_target = (uint16_t)((profile_last_cpu->last_target & 0xff) | (p2 << 8));
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+int mon_profile_set(int state)
+{
+    int i;
+
+    if (state == e_TOGGLE) {
+        state = mon_profile_enabled ? e_OFF : e_ON;
+    }
+
+    if (state == e_ON && !mon_profile_enabled) {
+        profile_stack_delta[OP_JSR] = 2;
+        profile_stack_delta[OP_BRK] = 3;
+        profile_stack_delta[OP_PHA] = 1;
+        profile_stack_delta[OP_PHP] = 1;
+        profile_stack_delta[OP_PLA] = -1;
+        profile_stack_delta[OP_PLP] = -1;
+        profile_stack_delta[OP_RTS] = -2;
+        profile_stack_delta[OP_RTI] = -3;
+        for (i = 0; i < PROFILE_NUM_CPUS; i++) {
+            if (profile_cpu[i].nodes == NULL) {
+                profile_cpu_reset(&profile_cpu[i]);
+            }
+            /* do not charge the time spent while disabled */
+            profile_cpu[i].valid = 0;
+        }
+    }
+    mon_profile_enabled = (state == e_ON);
+    return 0;
+}
+
+void mon_profile_zap(void)
+{
+    int i;
+
+    for (i = 0; i < PROFILE_NUM_CPUS; i++) {
+        if (profile_cpu[i].nodes != NULL) {
+            profile_cpu_reset(&profile_cpu[i]);
+        }
+    }
+}
+
+static int profile_entry_compare(const void *a, const void *b)
+{
+    uint64_t ka = ((const profile_entry_t *)a)->key;
+    uint64_t kb = ((const profile_entry_t *)b)->key;
+
+    return (ka > kb) - (ka < kb);
+}
+
+static int profile_entry_compare_cycles(const void *a, const void *b)
+{
+    CLOCK ca = ((const profile_entry_t *)a)->cycles;
+    CLOCK cb = ((const profile_entry_t *)b)->cycles;
+
+    return (ca < cb) - (ca > cb);
+}
+
+/* Return the used entries of `cpu' sorted by key. */
+static profile_entry_t *profile_sorted_entries(profile_cpu_t *cpu, unsigned int *num)
+{
+    profile_entry_t *list;
+    unsigned int i, n = 0;
+
+    list = lib_malloc((cpu->hash_used + 1) * sizeof(profile_entry_t));
+    for (i = 0; i < cpu->hash_size; i++) {
+        if (cpu->hash[i].key) {
+            list[n++] = cpu->hash[i];
+        }
+    }
+    qsort(list, n, sizeof(profile_entry_t), profile_entry_compare);
+    *num = n;
+    return list;
+}
+
+static const char *profile_func_name(int origin, int func, char *buf)
+{
+    char *label;
+
+    if (func == FUNC_TOP) {
+        return "[top]";
+    }
+    label = mon_symbol_table_lookup_name((MEMSPACE)(origin + 1), (uint16_t)func);
+    if (label != NULL) {
+        return label;
+    }
+    sprintf(buf, "$%04x", (unsigned int)func & 0xffff);
+    return buf;
+}
+
+void mon_profile_show(int count)
+{
+    profile_cpu_t *cpu;
+    profile_entry_t *list, *funcs;
+    unsigned int i, n, nfuncs;
+    int origin;
+    char buf[8];
+
+    origin = (int)default_memspace - 1;
+    if (origin < 0 || origin >= PROFILE_NUM_CPUS || profile_cpu[origin].nodes == NULL) {
+        mon_out("No profile data.\n");
+        return;
+    }
+    cpu = &profile_cpu[origin];
+    if (count < 1) {
+        count = 10;
+    }
+    profile_flush(cpu);
+
+    mon_out("Profiling is %s, %"PRIu64" cycles recorded.\n",
+            mon_profile_enabled ? "on" : "off", cpu->total);
+    if (cpu->total == 0) {
+        return;
+    }
+
+    /* sum up the costs of each function, edges are sorted after them */
+    list = profile_sorted_entries(cpu, &n);
+    funcs = lib_malloc((n + 1) * sizeof(profile_entry_t));
+    nfuncs = 0;
+    for (i = 0; i < n; i++) {
+        if (list[i].key & KEY_EDGE) {
+            continue;
+        }
+        if (nfuncs == 0 || funcs[nfuncs - 1].key != (uint64_t)KEY_FUNC(list[i].key)) {
+            funcs[nfuncs].key = (uint64_t)KEY_FUNC(list[i].key);
+            funcs[nfuncs].cycles = 0;
+            nfuncs++;
+        }
+        funcs[nfuncs - 1].cycles += list[i].cycles;
+    }
+
+    qsort(funcs, nfuncs, sizeof(profile_entry_t), profile_entry_compare_cycles);
+    mon_out("\nFunction              Cycles      %%\n");
+    for (i = 0; i < nfuncs && i < (unsigned int)count; i++) {
+        mon_out("%-16s %11"PRIu64" %6.2f\n",
+                profile_func_name(origin, (int)funcs[i].key, buf),
+                funcs[i].cycles, funcs[i].cycles * 100.0 / cpu->total);
+    }
+
+    /* the remaining entries are the per address costs */
+    for (i = n = 0; i < cpu->hash_size; i++) {
+        if (cpu->hash[i].key && !(cpu->hash[i].key & KEY_EDGE)) {
+            list[n++] = cpu->hash[i];
+        }
+    }
+    qsort(list, n, sizeof(profile_entry_t), profile_entry_compare_cycles);
+    mon_out("\nAddress               Cycles      %%\n");
+    for (i = 0; i < n && i < (unsigned int)count; i++) {
+        mon_out("$%04x            %11"PRIu64" %6.2f\n",
+                KEY_PC(list[i].key), list[i].cycles,
+                list[i].cycles * 100.0 / cpu->total);
+    }
+
+    lib_free(funcs);
+    lib_free(list);
+}
+
+static void profile_save_callgrind(FILE *fp)
+{
+    profile_cpu_t *cpu;
+    profile_entry_t *list;
+    unsigned int i, n;
+    int origin, func;
+    char buf[8];
+
+    fprintf(fp, "version: 1\n");
+    fprintf(fp, "creator: VICE %s\n", VERSION);
+    fprintf(fp, "positions: instr\n");
+    fprintf(fp, "events: Cycles\n");
+
+    for (origin = 0; origin < PROFILE_NUM_CPUS; origin++) {
+        cpu = &profile_cpu[origin];
+        if (cpu->nodes == NULL) {
+            continue;
+        }
+        profile_flush(cpu);
+        if (cpu->total == 0) {
+            continue;
+        }
+
+        fprintf(fp, "\nob=%s\n", profile_cpu_name[origin]);
+        list = profile_sorted_entries(cpu, &n);
+        func = FUNC_TOP - 1;
+        for (i = 0; i < n; i++) {
+            if (KEY_FUNC(list[i].key) != func) {
+                func = KEY_FUNC(list[i].key);
+                fprintf(fp, "fn=%s\n", profile_func_name(origin, func, buf));
+            }
+            if (list[i].key & KEY_EDGE) {
+                fprintf(fp, "cfn=%s\n",
+                        profile_func_name(origin, KEY_CALLEE(list[i].key), buf));
+                fprintf(fp, "calls=%"PRIu64" 0x%04x\n", list[i].calls,
+                        (unsigned int)KEY_CALLEE(list[i].key) & 0xffff);
+            }
+            fprintf(fp, "0x%04x %"PRIu64"\n", KEY_PC(list[i].key), list[i].cycles);
+        }
+        lib_free(list);
+    }
+}
+
+static void profile_save_folded_node(FILE *fp, profile_cpu_t *cpu, int origin,
+                                     int index)
+{
+    profile_node_t *node = &cpu->nodes[index];
+    int path[PROFILE_STACK_SIZE];
+    int depth = 0, i;
+    char buf[8];
+
+    if (node->self > 0) {
+        for (i = index; i > 0 && depth < PROFILE_STACK_SIZE; i = cpu->nodes[i].parent) {
+            path[depth++] = cpu->nodes[i].func;
+        }
+        fprintf(fp, "%s", profile_cpu_name[origin]);
+        while (depth > 0) {
+            fprintf(fp, ";%s", profile_func_name(origin, path[--depth], buf));
+        }
+        fprintf(fp, " %"PRIu64"\n", node->self);
+    }
+}
+
+static void profile_save_folded(FILE *fp)
+{
+    profile_cpu_t *cpu;
+    int origin, i;
+
+    for (origin = 0; origin < PROFILE_NUM_CPUS; origin++) {
+        cpu = &profile_cpu[origin];
+        if (cpu->nodes == NULL) {
+            continue;
+        }
+        profile_flush(cpu);
+        for (i = 0; i < cpu->nodes_used; i++) {
+            profile_save_folded_node(fp, cpu, origin, i);
+        }
+    }
+}
+
+int mon_profile_save(const char *filename, int format)
+{
+    FILE *fp;
+
+    if (format != MON_PROFILE_FORMAT_CALLGRIND && format != MON_PROFILE_FORMAT_FOLDED) {
+        mon_out("Unknown profile format %d.\n", format);
+        return -1;
+    }
+
+    if (NULL == (fp = fopen(filename, MODE_WRITE_TEXT))) {
+        mon_out("Saving for `%s' failed.\n", filename);
+        return -1;
+    }
+
+    mon_out("Saving profile to `%s'...\n", filename);
+    if (format == MON_PROFILE_FORMAT_CALLGRIND) {
+        profile_save_callgrind(fp);
+    } else {
+        profile_save_folded(fp);
+    }
+    fclose(fp);
+    return 0;
+}
+
+void mon_profile_shutdown(void)
+{
+    int i;
+
+    mon_profile_enabled = 0;
+    for (i = 0; i < PROFILE_NUM_CPUS; i++) {
+        lib_free(profile_cpu[i].hash);
+        lib_free(profile_cpu[i].pending);
+        lib_free(profile_cpu[i].nodes);
+        memset(&profile_cpu[i], 0, sizeof(profile_cpu_t));
+    }
+    profile_last_cpu = NULL;
+}
+
+#else /* !FEATURE_CPUMEMHISTORY */
+
+/* stubs */
+static void mon_profile_stub(void)
+{
+    mon_out("Disabled. configure with --enable-cpuhistory and recompile.\n");
+}
+
+void mon_profile_store(CLOCK cycle, unsigned int addr, unsigned int op,
+                       unsigned int p1, unsigned int p2, uint8_t reg_sp,
+                       uint8_t origin)
+{
+}
+
+void mon_profile_fix_p2(unsigned int p2)
+{
+}
+
+int mon_profile_set(int state)
+{
+    mon_profile_stub();
+    return -1;
+}
+
+void mon_profile_zap(void)
+{
+    mon_profile_stub();
+}
+
+void mon_profile_show(int count)
+{
+    mon_profile_stub();
+}
+
+int mon_profile_save(const char *filename, int format)
+{
+    mon_profile_stub();
+    return -1;
+}
+
+void mon_profile_shutdown(void)
+{
+}
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * mon_profile.h - The VICE built-in monitor, cycle profiler.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_MON_PROFILE_H
+#define VICE_MON_PROFILE_H
+
+#include "montypes.h"
+#include "types.h"
+
+/* Formats for mon_profile_save() */
+#define MON_PROFILE_FORMAT_CALLGRIND 0
+#define MON_PROFILE_FORMAT_FOLDED    1
+
+extern int mon_profile_enabled;
+
+void mon_profile_store(CLOCK cycle, unsigned int addr, unsigned int op,
+                       unsigned int p1, unsigned int p2, uint8_t reg_sp,
+                       uint8_t origin);
+void mon_profile_fix_p2(unsigned int p2);
+
+int mon_profile_set(int state);
+void mon_profile_zap(void);
+void mon_profile_show(int count);
+int mon_profile_save(const char *filename, int format);
+
+void mon_profile_shutdown(void);
+
+#endif
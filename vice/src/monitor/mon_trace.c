@@ -0,0 +1,585 @@
+/*
+ * mon_trace.c - The VICE built-in monitor, binary execution trace recorder.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * The trace is fed by the cpu history hooks and streamed to a file.  The
+ * emulation thread only appends to a ring buffer, which a writer thread
+ * empties into the file; without threads the buffer is written whenever it
+ * fills up.  The tools/vicetrace program decodes, filters and compares
+ * traces.
+ *
+ * File format (all numbers little endian):
+ *
+ *   "VICETRC" <version> <number of cpus>
+ *   <number of cpus> times 256 bytes: instruction length of each opcode
+ *   records...
+ *
+ * Instruction record, the tag has bit 7 clear:
+ *
+ *   <tag> [<cpu>] [<pc lo> <pc hi>] <cycles> <opcode> [<operands>]
+ *   [<a>] [<x>] [<y>] [<sp>] [<status>]
+ *
+ *   The optional fields are present if their tag bit is set: 0x40 cpu,
+ *   0x01 pc, 0x02 a, 0x04 x, 0x08 y, 0x10 sp, 0x20 status.  The cpu (0 for
+ *   the computer, 1-4 for drive 8-11) applies to all following records.
+ *   The pc is only stored if it does not follow the previous instruction
+ *   of the same cpu, and the registers only when they have changed.
+ *   <cycles> is the clock difference to the previous instruction of the
+ *   same cpu, or the clock itself for the first one, as unsigned LEB128.
+ *   The registers are those before the instruction is executed.
+ *
+ * Bus access record of the computer's cpu, bits 3-5 of the tag are clear:
+ *
+ *   <0x80 | kind> <address difference>    (signed byte)
+ *   <0xc0 | kind> <addr lo> <addr hi>
+ *
+ *   kind is 1 RAM read, 2 RAM write, 3 ROM read, 4 ROM write, 5 I/O read,
+ *   6 I/O write.  The accesses follow the instruction causing them.
+ *
+ * 0xfe <cpu> resets the clock of the cpu to 0, 0xff ends the trace.
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "asm.h"
+#include "lib.h"
+#include "mon_trace.h"
+#include "monitor.h"
+#include "montypes.h"
+#include "types.h"
+
+#ifdef USE_VICE_THREAD
+#   include <pthread.h>
+#   include <stdatomic.h>
+#   define TRACE_POS_T atomic_size_t
+#   define TRACE_LOAD(v) atomic_load_explicit(&(v), memory_order_acquire)
+#   define TRACE_STORE(v, x) atomic_store_explicit(&(v), (x), memory_order_release)
+#else
+#   define TRACE_POS_T size_t
+#   define TRACE_LOAD(v) (v)
+#   define TRACE_STORE(v, x) ((v) = (x))
+#endif
+
+
+/* Globals */
+
+int mon_trace_enabled = 0;
+
+#ifdef FEATURE_CPUMEMHISTORY
+
+/* Defines */
+
+#define TRACE_VERSION       1
+#define TRACE_NUM_CPUS      (NUM_MEMSPACES - 1)
+
+/* must be a power of two */
+#define TRACE_BUFFER_SIZE   (4 * 1024 * 1024)
+#define TRACE_BUFFER_MASK   (TRACE_BUFFER_SIZE - 1)
+
+/* more than any single record takes */
+#define TRACE_RECORD_MAX    32
+
+/* amount of data that wakes up the writer */
+#define TRACE_WAKE_SIZE     (64 * 1024)
+
+#define TRACE_PC            0x01
+#define TRACE_A             0x02
+#define TRACE_X             0x04
+#define TRACE_Y             0x08
+#define TRACE_SP            0x10
+#define TRACE_ST            0x20
+#define TRACE_CPU           0x40
+
+#define TRACE_ACCESS        0x80
+#define TRACE_ACCESS_ADDR   0x40
+#define TRACE_RAM_READ      1
+#define TRACE_RAM_WRITE     2
+#define TRACE_ROM_READ      3
+#define TRACE_ROM_WRITE     4
+#define TRACE_IO_READ       5
+#define TRACE_IO_WRITE      6
+
+#define TRACE_CLOCK_RESET   0xfe
+#define TRACE_END           0xff
+
+#define NONE ((size_t)-1)
+
+/* Types */
+
+typedef struct trace_cpu_s {
+    int valid;
+    CLOCK clk;
+    uint16_t next_pc;
+    uint8_t reg_a;
+    uint8_t reg_x;
+    uint8_t reg_y;
+    uint8_t reg_sp;
+    uint8_t reg_st;
+    uint8_t len[0x100];
+} trace_cpu_t;
+
+static trace_cpu_t trace_cpu[TRACE_NUM_CPUS];
+
+static FILE *trace_file = NULL;
+static uint8_t *trace_buffer = NULL;
+static int trace_error;
+
+/* Positions only ever grow; the emulation thread writes at `trace_head'
+   and hands everything before `trace_committed' to the writer, which
+   releases it by moving `trace_tail'. */
+static size_t trace_head;
+static size_t trace_tail_seen;
+static size_t trace_woken;
+static TRACE_POS_T trace_committed;
+static TRACE_POS_T trace_tail;
+
+/* the JSR high byte is patched until the instruction is committed */
+static size_t trace_p2_pos;
+
+static int trace_last_origin;
+static int trace_access_valid;
+static unsigned int trace_last_access;
+static unsigned long trace_instructions;
+
+#ifdef USE_VICE_THREAD
+static pthread_t trace_writer;
+static pthread_mutex_t trace_lock;
+static pthread_cond_t trace_data_cond;
+static pthread_cond_t trace_space_cond;
+static int trace_threaded;
+static int trace_quit;
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+/* Write the data from `from' to `to' to the file. */
+static void trace_write(size_t from, size_t to)
+{
+    size_t start = from & TRACE_BUFFER_MASK;
+    size_t len = to - from;
+    size_t first = TRACE_BUFFER_SIZE - start;
+
+    if (trace_error || len == 0) {
+        return;
+    }
+    if (first > len) {
+        first = len;
+    }
+    if (fwrite(trace_buffer + start, 1, first, trace_file) != first
+        || fwrite(trace_buffer, 1, len - first, trace_file) != len - first) {
+        trace_error = 1;
+    }
+}
+
+#ifdef USE_VICE_THREAD
+static void *trace_writer_thread(void *arg)
+{
+    size_t tail = TRACE_LOAD(trace_tail);
+    size_t committed;
+
+    pthread_mutex_lock(&trace_lock);
+    for (;;) {
+        committed = TRACE_LOAD(trace_committed);
+        if (committed == tail) {
+            if (trace_quit) {
+                break;
+            }
+            pthread_cond_wait(&trace_data_cond, &trace_lock);
+            continue;
+        }
+        pthread_mutex_unlock(&trace_lock);
+        trace_write(tail, committed);
+        tail = committed;
+        TRACE_STORE(trace_tail, tail);
+        pthread_mutex_lock(&trace_lock);
+        pthread_cond_signal(&trace_space_cond);
+    }
+    pthread_mutex_unlock(&trace_lock);
+    return NULL;
+}
+#endif
+
+/* Hand everything written so far to the writer. */
+static inline void trace_commit(void)
+{
+    TRACE_STORE(trace_committed, trace_head);
+#ifdef USE_VICE_THREAD
+    if (trace_threaded && trace_head - trace_woken >= TRACE_WAKE_SIZE) {
+        trace_woken = trace_head;
+        pthread_mutex_lock(&trace_lock);
+        pthread_cond_signal(&trace_data_cond);
+        pthread_mutex_unlock(&trace_lock);
+    }
+#endif
+}
+
+/* Make room for another record, waiting for the writer if needed. */
+static void trace_make_room(void)
+{
+    size_t committed = TRACE_LOAD(trace_committed);
+
+#ifdef USE_VICE_THREAD
+    if (trace_threaded) {
+        trace_tail_seen = TRACE_LOAD(trace_tail);
+        if (trace_head - trace_tail_seen > TRACE_BUFFER_SIZE - TRACE_RECORD_MAX) {
+            pthread_mutex_lock(&trace_lock);
+            while (trace_head - (trace_tail_seen = TRACE_LOAD(trace_tail))
+                   > TRACE_BUFFER_SIZE - TRACE_RECORD_MAX) {
+                pthread_cond_signal(&trace_data_cond);
+                pthread_cond_wait(&trace_space_cond, &trace_lock);
+            }
+            pthread_mutex_unlock(&trace_lock);
+        }
+        return;
+    }
+#endif
+    trace_write(trace_tail_seen, committed);
+    trace_tail_seen = committed;
+    TRACE_STORE(trace_tail, committed);
+}
+
+static inline void trace_reserve(void)
+{
+    if (trace_head - trace_tail_seen > TRACE_BUFFER_SIZE - TRACE_RECORD_MAX) {
+        trace_make_room();
+    }
+}
+
+static inline void trace_put(uint8_t b)
+{
+    trace_buffer[trace_head++ & TRACE_BUFFER_MASK] = b;
+}
+
+static inline void trace_put_clock(CLOCK clk)
+{
+    while (clk >= 0x80) {
+        trace_put((uint8_t)(clk | 0x80));
+        clk >>= 7;
+    }
+    trace_put((uint8_t)clk);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Called for every instruction before it is executed, see
+   monitor_cpuhistory_store(). */
+void mon_trace_store(CLOCK cycle, unsigned int addr, unsigned int op,
+                     unsigned int p1, unsigned int p2,
+                     uint8_t reg_a, uint8_t reg_x, uint8_t reg_y,
+                     uint8_t reg_sp, unsigned int reg_st, uint8_t origin)
+{
+    trace_cpu_t *cpu;
+    size_t tag_pos;
+    uint8_t tag = 0;
+    unsigned int len;
+
+    if (origin >= TRACE_NUM_CPUS) {
+        return;
+    }
+    cpu = &trace_cpu[origin];
+    op &= 0xff;
+
+    /* the previous instruction is complete now */
+    trace_commit();
+    trace_p2_pos = NONE;
+    trace_reserve();
+
+    if (cycle < cpu->clk) {
+        trace_put(TRACE_CLOCK_RESET);
+        trace_put(origin);
+        cpu->clk = 0;
+    }
+
+    tag_pos = trace_head++;
+    if (origin != trace_last_origin) {
+        tag |= TRACE_CPU;
+        trace_put(origin);
+        trace_last_origin = origin;
+    }
+    if (!cpu->valid || addr != cpu->next_pc) {
+        tag |= TRACE_PC;
+        trace_put((uint8_t)(addr & 0xff));
+        trace_put((uint8_t)(addr >> 8));
+    }
+    trace_put_clock(cycle - cpu->clk);
+    trace_put((uint8_t)op);
+    len = cpu->len[op];
+    if (len > 1) {
+        trace_put((uint8_t)p1);
+    }
+    if (len > 2) {
+        trace_p2_pos = trace_head;
+        trace_put((uint8_t)p2);
+    }
+    if (!cpu->valid || reg_a != cpu->reg_a) {
+        tag |= TRACE_A;
+        trace_put(reg_a);
+    }
+    if (!cpu->valid || reg_x != cpu->reg_x) {
+        tag |= TRACE_X;
+        trace_put(reg_x);
+    }
+    if (!cpu->valid || reg_y != cpu->reg_y) {
+        tag |= TRACE_Y;
+        trace_put(reg_y);
+    }
+    if (!cpu->valid || reg_sp != cpu->reg_sp) {
+        tag |= TRACE_SP;
+        trace_put(reg_sp);
+    }
+    if (!cpu->valid || (uint8_t)reg_st != cpu->reg_st) {
+        tag |= TRACE_ST;
+        trace_put((uint8_t)reg_st);
+    }
+    trace_buffer[tag_pos & TRACE_BUFFER_MASK] = tag;
+
+    cpu->valid = 1;
+    cpu->clk = cycle;
+    cpu->next_pc = (uint16_t)(addr + len);
+    cpu->reg_a = reg_a;
+    cpu->reg_x = reg_x;
+    cpu->reg_y = reg_y;
+    cpu->reg_sp = reg_sp;
+    cpu->reg_st = (uint8_t)reg_st;
+    trace_instructions++;
+}
+
+void mon_trace_fix_p2(unsigned int p2)
+{
+    if (trace_p2_pos != NONE) {
+        trace_buffer[trace_p2_pos & TRACE_BUFFER_MASK] = (uint8_t)p2;
+    }
+}
+
+/* Called for the memory accesses of the computer's cpu, see
+   monitor_memmap_store(). */
+void mon_trace_access(unsigned int addr, unsigned int type)
+{
+    uint8_t kind;
+    int delta;
+
+    switch (type) {
+        case MEMMAP_RAM_R:
+            kind = TRACE_RAM_READ;
+            break;
+        case MEMMAP_RAM_W:
+            kind = TRACE_RAM_WRITE;
+            break;
+        case MEMMAP_ROM_R:
+            kind = TRACE_ROM_READ;
+            break;
+        case MEMMAP_ROM_W:
+            kind = TRACE_ROM_WRITE;
+            break;
+        case MEMMAP_I_O_R:
+            kind = TRACE_IO_READ;
+            break;
+        case MEMMAP_I_O_W:
+            kind = TRACE_IO_WRITE;
+            break;
+        default:
+            /* opcode fetches are in the instruction records */
+            return;
+    }
+
+    trace_reserve();
+    delta = (int)addr - (int)trace_last_access;
+    if (trace_access_valid && delta >= -128 && delta <= 127) {
+        trace_put(TRACE_ACCESS | kind);
+        trace_put((uint8_t)delta);
+    } else {
+        trace_put(TRACE_ACCESS | TRACE_ACCESS_ADDR | kind);
+        trace_put((uint8_t)(addr & 0xff));
+        trace_put((uint8_t)(addr >> 8));
+    }
+    trace_last_access = addr;
+    trace_access_valid = 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Instruction lengths of the cpu in `mem', everything is stored for cpus
+   the monitor does not know. */
+static void trace_init_lengths(trace_cpu_t *cpu, MEMSPACE mem)
+{
+    monitor_cpu_type_t *cpu_type = monitor_cpu_for_memspace[mem];
+    const asm_opcode_info_t *opinfo;
+    unsigned int op, len;
+
+    for (op = 0; op < 0x100; op++) {
+        len = 3;
+        if (cpu_type != NULL) {
+            opinfo = (cpu_type->asm_opcode_info_get)(op, 0, 0, 0);
+            len = (cpu_type->asm_addr_mode_get_size)
+                      ((unsigned int)(opinfo->addr_mode & ~ASM_ADDR_MODE_UNDOC), op, 0, 0, 0);
+            if (len < 1 || len > 3) {
+                len = 3;
+            }
+        }
+        cpu->len[op] = (uint8_t)len;
+    }
+}
+
+int mon_trace_start(const char *filename)
+{
+    uint8_t header[9] = { 'V', 'I', 'C', 'E', 'T', 'R', 'C', TRACE_VERSION, TRACE_NUM_CPUS };
+    int i;
+
+    if (mon_trace_enabled) {
+        mon_out("Already tracing, stop the current trace first.\n");
+        return -1;
+    }
+
+    trace_file = fopen(filename, MODE_WRITE);
+    if (trace_file == NULL) {
+        mon_out("Saving for `%s' failed.\n", filename);
+        return -1;
+    }
+
+    memset(trace_cpu, 0, sizeof(trace_cpu));
+    fwrite(header, 1, sizeof(header), trace_file);
+    for (i = 0; i < TRACE_NUM_CPUS; i++) {
+        trace_init_lengths(&trace_cpu[i], (MEMSPACE)(i + 1));
+        fwrite(trace_cpu[i].len, 1, sizeof(trace_cpu[i].len), trace_file);
+    }
+
+    trace_buffer = lib_malloc(TRACE_BUFFER_SIZE);
+    trace_head = 0;
+    trace_tail_seen = 0;
+    trace_woken = 0;
+    TRACE_STORE(trace_committed, 0);
+    TRACE_STORE(trace_tail, 0);
+    trace_p2_pos = NONE;
+    trace_last_origin = -1;
+    trace_access_valid = 0;
+    trace_instructions = 0;
+    trace_error = 0;
+
+#ifdef USE_VICE_THREAD
+    pthread_mutex_init(&trace_lock, NULL);
+    pthread_cond_init(&trace_data_cond, NULL);
+    pthread_cond_init(&trace_space_cond, NULL);
+    trace_quit = 0;
+    trace_threaded = 1;
+    if (pthread_create(&trace_writer, NULL, trace_writer_thread, NULL)) {
+        mon_out("Cannot start the trace writer thread, writing directly.\n");
+        trace_threaded = 0;
+    }
+#endif
+
+    mon_out("Tracing to `%s'...\n", filename);
+    mon_trace_enabled = 1;
+    return 0;
+}
+
+void mon_trace_stop(void)
+{
+    size_t length;
+
+    if (!mon_trace_enabled) {
+        mon_out("Not tracing.\n");
+        return;
+    }
+    mon_trace_enabled = 0;
+
+    trace_commit();
+    trace_reserve();
+    trace_put(TRACE_END);
+    trace_commit();
+
+#ifdef USE_VICE_THREAD
+    if (trace_threaded) {
+        pthread_mutex_lock(&trace_lock);
+        trace_quit = 1;
+        pthread_cond_signal(&trace_data_cond);
+        pthread_mutex_unlock(&trace_lock);
+        pthread_join(trace_writer, NULL);
+    }
+    pthread_cond_destroy(&trace_space_cond);
+    pthread_cond_destroy(&trace_data_cond);
+    pthread_mutex_destroy(&trace_lock);
+#endif
+    trace_write(TRACE_LOAD(trace_tail), trace_head);
+    length = trace_head;
+
+    if (fclose(trace_file) != 0) {
+        trace_error = 1;
+    }
+    trace_file = NULL;
+    lib_free(trace_buffer);
+    trace_buffer = NULL;
+
+    if (trace_error) {
+        mon_out("Writing the trace failed.\n");
+    } else {
+        mon_out("Traced %lu instructions in %lu bytes.\n",
+                trace_instructions, (unsigned long)length);
+    }
+}
+
+void mon_trace_shutdown(void)
+{
+    if (mon_trace_enabled) {
+        mon_trace_stop();
+    }
+}
+
+#else /* !FEATURE_CPUMEMHISTORY */
+
+/* stubs */
+void mon_trace_store(CLOCK cycle, unsigned int addr, unsigned int op,
+                     unsigned int p1, unsigned int p2,
+                     uint8_t reg_a, uint8_t reg_x, uint8_t reg_y,
+                     uint8_t reg_sp, unsigned int reg_st, uint8_t origin)
+{
+}
+
+void mon_trace_fix_p2(unsigned int p2)
+{
+}
+
+void mon_trace_access(unsigned int addr, unsigned int type)
+{
+}
+
+int mon_trace_start(const char *filename)
+{
+    mon_out("Disabled. configure with --enable-cpuhistory and recompile.\n");
+    return -1;
+}
+
+void mon_trace_stop(void)
+{
+    mon_out("Disabled. configure with --enable-cpuhistory and recompile.\n");
+}
+
+void mon_trace_shutdown(void)
+{
+}
+
+#endif
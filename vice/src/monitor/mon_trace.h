@@ -0,0 +1,43 @@
+/*
+ * mon_trace.h - The VICE built-in monitor, binary execution trace recorder.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_MON_TRACE_H
+#define VICE_MON_TRACE_H
+
+#include "types.h"
+
+extern int mon_trace_enabled;
+
+void mon_trace_store(CLOCK cycle, unsigned int addr, unsigned int op,
+                     unsigned int p1, unsigned int p2,
+                     uint8_t reg_a, uint8_t reg_x, uint8_t reg_y,
+                     uint8_t reg_sp, unsigned int reg_st, uint8_t origin);
+void mon_trace_fix_p2(unsigned int p2);
+void mon_trace_access(unsigned int addr, unsigned int type);
+
+int mon_trace_start(const char *filename);
+void mon_trace_stop(void);
+
+void mon_trace_shutdown(void);
+
+#endif
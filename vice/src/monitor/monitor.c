@@ -66,6 +66,8 @@
 #include "mon_disassemble.h"
 #include "mon_memmap.h"
 #include "mon_memory.h"
+#include "mon_profile.h"
+#include "mon_trace.h"
 #include "asm.h"
 
 #include "mon_parse.h"
@@ -1538,6 +1540,8 @@ void monitor_shutdown(void)
     }
 
     mon_memmap_shutdown();
+    mon_profile_shutdown();
+    mon_trace_shutdown();
 
     while (playback_fp_stack_size) {
         playback_end_file();
@@ -49,9 +49,12 @@
 #include "screenshot.h"
 #include "machine-video.h"
 #include "palette.h"
+#include "perfcounters.h"
+#include "video.h"
 
 #include "mon_breakpoint.h"
 #include "mon_file.h"
+#include "mon_profile.h"
 #include "mon_register.h"
 
 #include "version.h"
@@ -102,6 +105,10 @@ enum t_binary_command {
     e_MON_CMD_REGISTERS_AVAILABLE = 0x83,
     e_MON_CMD_DISPLAY_GET = 0x84,
     e_MON_CMD_VICE_INFO = 0x85,
+    e_MON_CMD_FRAME_LATENCY_GET = 0x86,
+    e_MON_CMD_PROFILE_SET = 0x87,
+    e_MON_CMD_PROFILE_SAVE = 0x88,
+    e_MON_CMD_PERFCOUNTERS_GET = 0x89,
 
     e_MON_CMD_PALETTE_GET = 0x91,
 
@@ -150,6 +157,10 @@ enum t_binary_response {
     e_MON_RESPONSE_REGISTERS_AVAILABLE = 0x83,
     e_MON_RESPONSE_DISPLAY_GET = 0x84,
     e_MON_RESPONSE_VICE_INFO = 0x85,
+    e_MON_RESPONSE_FRAME_LATENCY_GET = 0x86,
+    e_MON_RESPONSE_PROFILE_SET = 0x87,
+    e_MON_RESPONSE_PROFILE_SAVE = 0x88,
+    e_MON_RESPONSE_PERFCOUNTERS_GET = 0x89,
 
     e_MON_RESPONSE_PALETTE_GET = 0x91,
 
@@ -296,6 +307,15 @@ static unsigned char *write_uint32(uint32_t input, unsigned char *output) {
     return output + 4;
 }
 
+#ifdef FEATURE_PERFCOUNTERS
+/*! \internal \brief Write uint64 to buffer and return pointer to byte after */
+static unsigned char *write_uint64(uint64_t input, unsigned char *output) {
+    output = write_uint32((uint32_t)(input & 0xFFFFFFFFu), output);
+
+    return write_uint32((uint32_t)(input >> 32), output);
+}
+#endif
+
 /*! \internal \brief Write string to buffer and return pointer to byte after */
 static unsigned char *write_string(uint8_t length, unsigned char *input, unsigned char *output) {
     output[0] = length;
@@ -1403,6 +1423,183 @@ static void monitor_binary_process_vice_info(binary_command_t *command)
     monitor_binary_response(sizeof(response), e_MON_RESPONSE_VICE_INFO, e_MON_ERR_OK, command->request_id, response);
 }
 
+static void monitor_binary_process_frame_latency_get(binary_command_t *command)
+{
+    video_latency_stats_t stats;
+    unsigned char *response, *response_cursor;
+    uint32_t response_length;
+    struct video_canvas_s *canvas;
+    uint8_t item_size = 4 * (4 + VIDEO_LATENCY_NUM_BUCKETS);
+    int stage, i;
+
+    if (command->length < 1) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    /* Same canvas selection as MON_CMD_DISPLAY_GET, optional here */
+    if (machine_class == VICE_MACHINE_C128 && command->length >= 2 && command->body[1]) {
+        canvas = machine_video_canvas_get(1);
+    } else {
+        canvas = machine_video_canvas_get(0);
+    }
+
+    response_length = 2 + 4 * VIDEO_LATENCY_NUM_BUCKETS
+                      + VIDEO_LATENCY_NUM_STAGES * (item_size + 1);
+    response = lib_malloc(response_length);
+    response_cursor = response;
+
+    *response_cursor++ = VIDEO_LATENCY_NUM_STAGES;
+    *response_cursor++ = VIDEO_LATENCY_NUM_BUCKETS;
+    for (i = 0; i < VIDEO_LATENCY_NUM_BUCKETS; i++) {
+        response_cursor = write_uint32((uint32_t)video_latency_bucket_limit(i), response_cursor);
+    }
+
+    for (stage = 0; stage < VIDEO_LATENCY_NUM_STAGES; stage++) {
+        video_latency_get_stats(canvas, stage, &stats);
+
+        *response_cursor++ = item_size;
+        response_cursor = write_uint32((uint32_t)stats.count, response_cursor);
+        response_cursor = write_uint32((uint32_t)stats.last, response_cursor);
+        response_cursor = write_uint32((uint32_t)stats.average, response_cursor);
+        response_cursor = write_uint32((uint32_t)stats.max, response_cursor);
+        for (i = 0; i < VIDEO_LATENCY_NUM_BUCKETS; i++) {
+            response_cursor = write_uint32((uint32_t)stats.buckets[i], response_cursor);
+        }
+    }
+
+    if (command->body[0]) {
+        video_latency_reset(canvas);
+    }
+
+    monitor_binary_response(response_length, e_MON_RESPONSE_FRAME_LATENCY_GET, e_MON_ERR_OK, command->request_id, response);
+
+    lib_free(response);
+}
+
+static void monitor_binary_process_profile_set(binary_command_t *command)
+{
+    unsigned char *body = command->body;
+
+    if (command->length < 2) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    if (body[1]) {
+        mon_profile_zap();
+    }
+
+    if (mon_profile_set(body[0] ? e_ON : e_OFF) < 0) {
+        monitor_binary_error(e_MON_ERR_CMD_FAILURE, command->request_id);
+        return;
+    }
+
+    monitor_binary_response(0, e_MON_RESPONSE_PROFILE_SET, e_MON_ERR_OK, command->request_id, NULL);
+}
+
+static void monitor_binary_process_profile_save(binary_command_t *command)
+{
+    unsigned char *body = command->body;
+    uint8_t format = body[0];
+    uint8_t filename_length = body[1];
+    unsigned char* filename = &body[2];
+
+    if (command->length < 2 + filename_length) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    /* This should be changed later if other fields are added after it */
+    filename[filename_length] = '\0';
+
+    if (mon_profile_save((char *)filename, format) < 0) {
+        monitor_binary_error(e_MON_ERR_CMD_FAILURE, command->request_id);
+        return;
+    }
+
+    monitor_binary_response(0, e_MON_RESPONSE_PROFILE_SAVE, e_MON_ERR_OK, command->request_id, NULL);
+}
+
+static void monitor_binary_process_perfcounters_get(binary_command_t *command)
+{
+#ifdef FEATURE_PERFCOUNTERS
+    unsigned char *response, *response_cursor;
+    uint32_t response_length;
+    perfcounters_named_t *entry;
+    uint8_t item_size = 8 * 4;
+    int num_alarms, num_io;
+    size_t name_length;
+    int i;
+
+    if (command->length < 1) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    num_alarms = perfcounters_named_count(PERFCOUNTERS_KIND_ALARM);
+    num_io = perfcounters_named_count(PERFCOUNTERS_KIND_IO);
+
+    response_length = 1 + PERFCOUNTERS_NUM_BLOCKS * (item_size + 1) + 2 + 2;
+    for (i = 0; i < num_alarms; i++) {
+        name_length = strlen(perfcounters_named_entry(PERFCOUNTERS_KIND_ALARM, i)->name);
+        response_length += 1 + 8 + 1 + (uint32_t)(name_length > 255 ? 255 : name_length);
+    }
+    for (i = 0; i < num_io; i++) {
+        name_length = strlen(perfcounters_named_entry(PERFCOUNTERS_KIND_IO, i)->name);
+        response_length += 1 + 16 + 1 + (uint32_t)(name_length > 255 ? 255 : name_length);
+    }
+
+    response = lib_malloc(response_length);
+    response_cursor = response;
+
+    *response_cursor++ = PERFCOUNTERS_NUM_BLOCKS;
+    for (i = 0; i < PERFCOUNTERS_NUM_BLOCKS; i++) {
+        *response_cursor++ = item_size;
+        response_cursor = write_uint64(perfcounters_block[i].c.instructions, response_cursor);
+        response_cursor = write_uint64(perfcounters_block[i].c.sid_flushes, response_cursor);
+        response_cursor = write_uint64(perfcounters_block[i].c.raster_lines, response_cursor);
+        response_cursor = write_uint64(perfcounters_block[i].c.rotation_bits, response_cursor);
+    }
+
+    response_cursor = write_uint16((uint16_t)num_alarms, response_cursor);
+    for (i = 0; i < num_alarms; i++) {
+        entry = perfcounters_named_entry(PERFCOUNTERS_KIND_ALARM, i);
+        name_length = strlen(entry->name);
+        if (name_length > 255) {
+            name_length = 255;
+        }
+        *response_cursor++ = (uint8_t)(8 + 1 + name_length);
+        response_cursor = write_uint64(entry->count[0], response_cursor);
+        response_cursor = write_string((uint8_t)name_length, (unsigned char *)entry->name, response_cursor);
+    }
+
+    response_cursor = write_uint16((uint16_t)num_io, response_cursor);
+    for (i = 0; i < num_io; i++) {
+        entry = perfcounters_named_entry(PERFCOUNTERS_KIND_IO, i);
+        name_length = strlen(entry->name);
+        if (name_length > 255) {
+            name_length = 255;
+        }
+        *response_cursor++ = (uint8_t)(16 + 1 + name_length);
+        response_cursor = write_uint64(entry->count[0], response_cursor);
+        response_cursor = write_uint64(entry->count[1], response_cursor);
+        response_cursor = write_string((uint8_t)name_length, (unsigned char *)entry->name, response_cursor);
+    }
+
+    if (command->body[0]) {
+        perfcounters_reset();
+    }
+
+    monitor_binary_response(response_length, e_MON_RESPONSE_PERFCOUNTERS_GET, e_MON_ERR_OK, command->request_id, response);
+
+    lib_free(response);
+#else
+    log_message(LOG_DEFAULT, "monitor binary perfcounters: Disabled. configure with --enable-perfcounters and recompile.");
+    monitor_binary_error(e_MON_ERR_CMD_FAILURE, command->request_id);
+#endif
+}
+
 static void monitor_binary_process_mem_get(binary_command_t *command)
 {
     unsigned char *response;
@@ -1614,6 +1811,14 @@ static void monitor_binary_process_command(unsigned char * pbuffer)
         monitor_binary_process_display_get(&command);
     } else if (command_type == e_MON_CMD_VICE_INFO) {
         monitor_binary_process_vice_info(&command);
+    } else if (command_type == e_MON_CMD_FRAME_LATENCY_GET) {
+        monitor_binary_process_frame_latency_get(&command);
+    } else if (command_type == e_MON_CMD_PROFILE_SET) {
+        monitor_binary_process_profile_set(&command);
+    } else if (command_type == e_MON_CMD_PROFILE_SAVE) {
+        monitor_binary_process_profile_save(&command);
+    } else if (command_type == e_MON_CMD_PERFCOUNTERS_GET) {
+        monitor_binary_process_perfcounters_get(&command);
 
     } else if (command_type == e_MON_CMD_EXIT) {
         monitor_binary_process_exit(&command);
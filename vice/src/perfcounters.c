@@ -0,0 +1,124 @@
+/*
+ * perfcounters.c - Hot-path event counters.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#ifdef FEATURE_PERFCOUNTERS
+
+#include <string.h>
+
+#include "drive.h"
+#include "lib.h"
+#include "perfcounters.h"
+#include "types.h"
+
+#if PERFCOUNTERS_NUM_BLOCKS != NUM_DISK_UNITS + 1
+#error PERFCOUNTERS_NUM_BLOCKS must be NUM_DISK_UNITS + 1
+#endif
+
+#ifdef __GNUC__
+perfcounters_block_t perfcounters_block[PERFCOUNTERS_NUM_BLOCKS]
+    __attribute__((aligned(PERFCOUNTERS_CACHE_LINE)));
+#else
+perfcounters_block_t perfcounters_block[PERFCOUNTERS_NUM_BLOCKS];
+#endif
+
+/* Named counters, one growing list per kind.  Lookups only happen when an
+   alarm or I/O source is created, never on the hot path.  */
+typedef struct perfcounters_list_s {
+    perfcounters_named_t **entries;
+    int num;
+    int size;
+} perfcounters_list_t;
+
+static perfcounters_list_t named_list[2];
+
+perfcounters_named_t *perfcounters_named_get(int kind, const char *name)
+{
+    perfcounters_list_t *list = &named_list[kind];
+    perfcounters_named_t *entry;
+    int i;
+
+    if (name == NULL) {
+        name = "(unnamed)";
+    }
+
+    for (i = 0; i < list->num; i++) {
+        if (strcmp(list->entries[i]->name, name) == 0) {
+            return list->entries[i];
+        }
+    }
+
+    if (list->num == list->size) {
+        list->size = list->size ? list->size * 2 : 32;
+        list->entries = lib_realloc(list->entries, sizeof(perfcounters_named_t *) * (size_t)list->size);
+    }
+
+    entry = lib_calloc(1, sizeof(perfcounters_named_t));
+    entry->name = lib_strdup(name);
+    list->entries[list->num++] = entry;
+
+    return entry;
+}
+
+int perfcounters_named_count(int kind)
+{
+    return named_list[kind].num;
+}
+
+perfcounters_named_t *perfcounters_named_entry(int kind, int index)
+{
+    return named_list[kind].entries[index];
+}
+
+void perfcounters_reset(void)
+{
+    int kind, i;
+
+    memset(perfcounters_block, 0, sizeof(perfcounters_block));
+
+    for (kind = 0; kind < 2; kind++) {
+        for (i = 0; i < named_list[kind].num; i++) {
+            named_list[kind].entries[i]->count[0] = 0;
+            named_list[kind].entries[i]->count[1] = 0;
+        }
+    }
+}
+
+void perfcounters_shutdown(void)
+{
+    int kind, i;
+
+    for (kind = 0; kind < 2; kind++) {
+        for (i = 0; i < named_list[kind].num; i++) {
+            lib_free(named_list[kind].entries[i]->name);
+            lib_free(named_list[kind].entries[i]);
+        }
+        lib_free(named_list[kind].entries);
+        named_list[kind].entries = NULL;
+        named_list[kind].num = 0;
+        named_list[kind].size = 0;
+    }
+}
+
+#endif
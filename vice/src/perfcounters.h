@@ -0,0 +1,94 @@
+/*
+ * perfcounters.h - Hot-path event counters.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_PERFCOUNTERS_H
+#define VICE_PERFCOUNTERS_H
+
+#include "types.h"
+
+/* The counters only exist when configured with --enable-perfcounters.
+   Otherwise all the PERFCOUNTERS_*() macros expand to nothing, so the
+   instrumented code is exactly the same as without them.  */
+
+/* Counter block of the main CPU context.  */
+#define PERFCOUNTERS_MAIN       0
+
+/* Counter block of drive `dnr' (0...NUM_DISK_UNITS-1).  This matches the
+   `origin' numbering used by the CPU history.  */
+#define PERFCOUNTERS_DRIVE(dnr) ((dnr) + 1)
+
+#define PERFCOUNTERS_NUM_BLOCKS 5
+
+#define PERFCOUNTERS_CACHE_LINE 64
+
+#ifdef FEATURE_PERFCOUNTERS
+
+/* One block of counters per execution context (main CPU, each drive CPU).
+   Every block is padded to a whole cache line and the array is aligned, so
+   contexts never bump counters on a line shared with another context.  */
+typedef union perfcounters_block_u {
+    struct {
+        uint64_t instructions;  /* CPU instructions executed */
+        uint64_t sid_flushes;   /* sound chip catch-ups (main only) */
+        uint64_t raster_lines;  /* raster lines drawn (main only) */
+        uint64_t rotation_bits; /* bits passed under the head (drives only) */
+    } c;
+    uint8_t pad[PERFCOUNTERS_CACHE_LINE];
+} perfcounters_block_t;
+
+extern perfcounters_block_t perfcounters_block[PERFCOUNTERS_NUM_BLOCKS];
+
+/* Counters kept per name, for alarms (count[0] = dispatches) and I/O
+   sources (count[0] = reads, count[1] = stores).  Entries are never freed
+   so the pointers handed out stay valid for the whole session.  */
+typedef struct perfcounters_named_s {
+    char *name;
+    uint64_t count[2];
+} perfcounters_named_t;
+
+#define PERFCOUNTERS_KIND_ALARM 0
+#define PERFCOUNTERS_KIND_IO    1
+
+perfcounters_named_t *perfcounters_named_get(int kind, const char *name);
+int perfcounters_named_count(int kind);
+perfcounters_named_t *perfcounters_named_entry(int kind, int index);
+
+void perfcounters_reset(void);
+void perfcounters_shutdown(void);
+
+#define PERFCOUNTERS_INC(block, counter) \
+    (perfcounters_block[(block)].c.counter++)
+#define PERFCOUNTERS_ADD(block, counter, n) \
+    (perfcounters_block[(block)].c.counter += (uint64_t)(n))
+#define PERFCOUNTERS_NAMED_INC(named, n) \
+    ((named)->count[(n)]++)
+
+#else
+
+#define PERFCOUNTERS_INC(block, counter)
+#define PERFCOUNTERS_ADD(block, counter, n)
+#define PERFCOUNTERS_NAMED_INC(named, n)
+
+#endif
+
+#endif
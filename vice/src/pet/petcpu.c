@@ -49,6 +49,7 @@
  - LOAD_IND
  - DMA_FUNC
  - DMA_ON_RESET
+ - HAVE_IDLE_SKIP
 
 */
 
@@ -65,6 +66,8 @@
 
 #define HAVE_6809_REGS
 
+#define HAVE_IDLE_SKIP
+
 #ifdef FEATURE_CPUMEMHISTORY
 static void memmap_mem_store(unsigned int addr, unsigned int value)
 {
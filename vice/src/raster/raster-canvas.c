@@ -107,11 +107,19 @@ inline static void refresh_canvas(raster_t *raster)
 
 void raster_canvas_handle_end_of_frame(raster_t *raster)
 {
+    int skipped;
+
     if (video_disabled_mode) {
         return;
     }
 
-    if (vsync_should_skip_frame(raster->canvas)) {
+    /* Decide now whether the next frame is drawn and rendered */
+    skipped = raster->skip_frame;
+    raster->skip_frame = vsync_should_skip_frame(raster->canvas);
+
+    if (skipped) {
+        /* The lines of this frame may not have been drawn, redraw them all next time */
+        raster->dont_cache = 1;
         return;
     }
 
@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "perfcounters.h"
 #include "raster-cache.h"
 #include "raster-canvas.h"
 #include "raster-changes.h"
@@ -648,6 +649,24 @@ inline static void handle_visible_line(raster_t *raster)
     }
 }
 
+/* Lines of a skipped frame are handled like off-screen lines, except where
+   drawing has a side effect: chips with sprites compute the sprite to
+   background collisions while drawing, so lines showing sprites (or
+   changing their registers) are still drawn.  */
+inline static int line_is_skipped(raster_t *raster)
+{
+    raster_sprite_status_t *sprite_status = raster->sprite_status;
+
+    if (!raster->skip_frame) {
+        return 0;
+    }
+    if (sprite_status == NULL) {
+        return 1;
+    }
+    return !(sprite_status->dma_msk || sprite_status->new_dma_msk)
+           && raster->changes->sprites->count == 0;
+}
+
 void raster_line_emulate(raster_t *raster)
 {
     raster_draw_buffer_ptr_update(raster);
@@ -660,12 +679,15 @@ void raster_line_emulate(raster_t *raster)
         raster->blank_enabled = 1;
     }
 
-    if ((raster->current_line >= raster->geometry->first_displayed_line
-         && raster->current_line <= raster->geometry->last_displayed_line)
-        /* handle the case when lines 0+ are displayed in the lower border */
-        || (raster->current_line <= raster->geometry->last_displayed_line - raster->geometry->screen_size.height
-            && raster->geometry->screen_size.height <= raster->geometry->last_displayed_line)
+    if (!line_is_skipped(raster)
+        && ((raster->current_line >= raster->geometry->first_displayed_line
+             && raster->current_line <= raster->geometry->last_displayed_line)
+            /* handle the case when lines 0+ are displayed in the lower border */
+            || (raster->current_line <= raster->geometry->last_displayed_line - raster->geometry->screen_size.height
+                && raster->geometry->screen_size.height <= raster->geometry->last_displayed_line))
         ) {
+        PERFCOUNTERS_INC(PERFCOUNTERS_MAIN, raster_lines);
+
         /* handle lines with no border or with changes that may affect
            the border as visible lines */
         if (raster->can_disable_border && (raster->border_disable || raster->changes->have_on_this_line)) {
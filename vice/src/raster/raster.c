@@ -267,6 +267,7 @@ int raster_init(raster_t *raster,
     raster->dont_cache = 1;
     raster->dont_cache_all = 1;
     raster->num_cached_lines = 0;
+    raster->skip_frame = 0;
 
     raster->fake_draw_buffer_line = NULL;
 
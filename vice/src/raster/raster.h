@@ -153,6 +153,11 @@ struct raster_s {
     /* Don't cache anything, for cycle based emulation */
     int dont_cache_all;
 
+    /* This is != 0 if the current frame is not rendered, see
+       vsync_should_skip_frame(). Its lines are not drawn either, except
+       those showing sprites whose collisions are computed while drawing. */
+    int skip_frame;
+
     /* Number of lines that have been recalculated.  When this value reaches
        the number of lines that are displayed in the output, then the cache
        is valid again.  */
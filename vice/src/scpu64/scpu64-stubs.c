@@ -91,6 +91,25 @@ int tap_seek_to_offset(tap_t *tap, unsigned long offset)
     return 0;
 }
 
+int tap_index_total(tap_t *tap, tap_index_point_t *point)
+{
+    return -1;
+}
+
+int tap_index_next_point(tap_t *tap, int offset, tap_index_point_t *point)
+{
+    return -1;
+}
+
+int tap_index_prev_point(tap_t *tap, int offset, tap_index_point_t *point)
+{
+    return -1;
+}
+
+void tap_index_invalidate(tap_t *tap)
+{
+}
+
 int tape_image_create(const char *name, unsigned int type)
 {
     return 0;
@@ -49,6 +49,7 @@
 #include "machine.h"
 #include "maincpu.h"
 #include "monitor.h"
+#include "perfcounters.h"
 #include "resources.h"
 #include "sound.h"
 #include "types.h"
@@ -1355,6 +1356,8 @@ static int sound_run_sound(void)
         }
     }
 
+    PERFCOUNTERS_INC(PERFCOUNTERS_MAIN, sid_flushes);
+
     /* Handling of cycle based sound engines. */
     if (cycle_based) {
         delta_t = maincpu_clk - snddata.lastclk;
@@ -53,6 +53,19 @@
 
 struct tape_init_s;
 struct tape_file_record_s;
+struct tap_index_s;
+
+/* A point of the pulse index of a TAP image.  */
+typedef struct tap_index_point_s {
+    /* Offset in the data area of the image.  */
+    int offset;
+
+    /* Pulses before this point (pairs of half waves for version 2).  */
+    int pulse;
+
+    /* Length of these pulses in cycles.  */
+    uint64_t cycles;
+} tap_index_point_t;
 
 typedef struct tap_s {
     /* File name.  */
@@ -113,6 +126,9 @@ typedef struct tap_s {
 
     /* Has the tap changed? We correct the size then.  */
     int has_changed;
+
+    /* Index of pulse positions and files, built on demand.  */
+    struct tap_index_s *index;
 } tap_t;
 
 void tap_init(const struct tape_init_s *init);
@@ -129,6 +145,11 @@ struct tape_file_record_s *tap_get_current_file_record(tap_t *tap);
 
 int tap_read(tap_t *tap, uint8_t *buf, size_t size);
 
+int tap_index_total(tap_t *tap, tap_index_point_t *point);
+int tap_index_next_point(tap_t *tap, int offset, tap_index_point_t *point);
+int tap_index_prev_point(tap_t *tap, int offset, tap_index_point_t *point);
+void tap_index_invalidate(tap_t *tap);
+
 int tap_cmdline_options_init(void);
 
 #endif
@@ -33,9 +33,11 @@
 
 #include "archdep.h"
 #include "cmdline.h"
+#include "crc32.h"
 #include "datasette.h"
 #include "lib.h"
 #include "log.h"
+#include "mediacache.h"
 #include "tap.h"
 #include "tape.h"
 #include "types.h"
@@ -264,6 +266,8 @@ tap_t *tap_open(const char *name, unsigned int *read_only)
     return new;
 }
 
+static void tap_index_free(tap_t *tap, int save);
+
 int tap_close(tap_t *tap)
 {
     int retval;
@@ -282,6 +286,7 @@ int tap_close(tap_t *tap)
             util_dword_to_le_buf(buf, tap->size);
             util_fpwrite(tap->fd, buf, 4, TAP_HDR_LEN);
         }
+        tap_index_free(tap, 1);
         retval = zfile_fclose(tap->fd);
         tap->fd = NULL;
     } else {
@@ -1548,6 +1553,465 @@ static int tap_skip_file(tap_t *tap)
     return ret;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Index of pulse positions and files */
+
+/* pulses between two points of the index */
+#define TAP_INDEX_STEP      1024
+
+#define TAP_INDEX_MAGIC     "VTAPIDX1"
+#define TAP_INDEX_HDR_SIZE  20
+#define TAP_INDEX_POINT_SIZE 16
+#define TAP_INDEX_FILE_SIZE 27
+
+typedef struct tap_index_file_s {
+    /* position of the header in the TAP file */
+    long fpos;
+    tape_file_record_t record;
+} tap_index_file_t;
+
+typedef struct tap_index_s {
+    /* a point every TAP_INDEX_STEP pulses, the first is the start and the
+       last the end of the tape */
+    tap_index_point_t *points;
+    int num_points;
+
+    /* files in the order found by tap_seek_to_next_file() */
+    tap_index_file_t *files;
+    int num_files;
+    int max_files;
+
+    /* no more files after the last one */
+    int files_complete;
+
+    /* changed since loaded from the media cache */
+    int dirty;
+
+    /* media cache key, or NULL if not cached */
+    char *cache_key;
+} tap_index_t;
+
+/* the pulse thresholds decide which files are found */
+static uint32_t tap_index_tag(void)
+{
+    uint8_t buf[40];
+
+    util_dword_to_le_buf(buf, (uint32_t)tap_pulse_short_min);
+    util_dword_to_le_buf(buf + 4, (uint32_t)tap_pulse_short_max);
+    util_dword_to_le_buf(buf + 8, (uint32_t)tap_pulse_middle_min);
+    util_dword_to_le_buf(buf + 12, (uint32_t)tap_pulse_middle_max);
+    util_dword_to_le_buf(buf + 16, (uint32_t)tap_pulse_long_min);
+    util_dword_to_le_buf(buf + 20, (uint32_t)tap_pulse_long_max);
+    util_dword_to_le_buf(buf + 24, (uint32_t)tap_pulse_tt_short_min);
+    util_dword_to_le_buf(buf + 28, (uint32_t)tap_pulse_tt_short_max);
+    util_dword_to_le_buf(buf + 32, (uint32_t)tap_pulse_tt_long_min);
+    util_dword_to_le_buf(buf + 36, (uint32_t)tap_pulse_tt_long_max);
+
+    return crc32_buf((const char *)buf, sizeof(buf));
+}
+
+static void tap_index_load(tap_index_t *idx)
+{
+    uint8_t *data, *p;
+    uint32_t tag;
+    size_t size;
+    int num_points, num_files, i;
+
+    data = mediacache_get(idx->cache_key, &tag, &size);
+    if (data == NULL) {
+        return;
+    }
+
+    if (tag != tap_index_tag()
+        || size < TAP_INDEX_HDR_SIZE
+        || memcmp(data, TAP_INDEX_MAGIC, 8) != 0) {
+        lib_free(data);
+        return;
+    }
+
+    num_points = (int)util_le_buf_to_dword(data + 8);
+    num_files = (int)util_le_buf_to_dword(data + 12);
+    if (num_points < 0 || num_files < 0
+        || size != TAP_INDEX_HDR_SIZE + (size_t)num_points * TAP_INDEX_POINT_SIZE
+                   + (size_t)num_files * TAP_INDEX_FILE_SIZE) {
+        lib_free(data);
+        return;
+    }
+
+    p = data + TAP_INDEX_HDR_SIZE;
+    if (num_points > 0) {
+        idx->points = lib_malloc(num_points * sizeof(tap_index_point_t));
+        for (i = 0; i < num_points; i++, p += TAP_INDEX_POINT_SIZE) {
+            idx->points[i].offset = (int)util_le_buf_to_dword(p);
+            idx->points[i].pulse = (int)util_le_buf_to_dword(p + 4);
+            idx->points[i].cycles = util_le_buf_to_dword(p + 8)
+                                    | ((uint64_t)util_le_buf_to_dword(p + 12) << 32);
+        }
+        idx->num_points = num_points;
+    }
+    if (num_files > 0) {
+        idx->files = lib_malloc(num_files * sizeof(tap_index_file_t));
+        for (i = 0; i < num_files; i++, p += TAP_INDEX_FILE_SIZE) {
+            idx->files[i].fpos = (long)util_le_buf_to_dword(p);
+            memcpy(idx->files[i].record.name, p + 4, 17);
+            idx->files[i].record.type = p[21];
+            idx->files[i].record.encoding = p[22];
+            idx->files[i].record.start_addr = util_le_buf_to_word(p + 23);
+            idx->files[i].record.end_addr = util_le_buf_to_word(p + 25);
+        }
+        idx->num_files = idx->max_files = num_files;
+    }
+    idx->files_complete = (int)util_le_buf_to_dword(data + 16);
+
+    lib_free(data);
+}
+
+static void tap_index_save(tap_index_t *idx)
+{
+    uint8_t *data, *p;
+    size_t size;
+    int i;
+
+    size = TAP_INDEX_HDR_SIZE + (size_t)idx->num_points * TAP_INDEX_POINT_SIZE
+           + (size_t)idx->num_files * TAP_INDEX_FILE_SIZE;
+    data = lib_malloc(size);
+
+    memcpy(data, TAP_INDEX_MAGIC, 8);
+    util_dword_to_le_buf(data + 8, (uint32_t)idx->num_points);
+    util_dword_to_le_buf(data + 12, (uint32_t)idx->num_files);
+    util_dword_to_le_buf(data + 16, (uint32_t)idx->files_complete);
+
+    p = data + TAP_INDEX_HDR_SIZE;
+    for (i = 0; i < idx->num_points; i++, p += TAP_INDEX_POINT_SIZE) {
+        util_dword_to_le_buf(p, (uint32_t)idx->points[i].offset);
+        util_dword_to_le_buf(p + 4, (uint32_t)idx->points[i].pulse);
+        util_dword_to_le_buf(p + 8, (uint32_t)idx->points[i].cycles);
+        util_dword_to_le_buf(p + 12, (uint32_t)(idx->points[i].cycles >> 32));
+    }
+    for (i = 0; i < idx->num_files; i++, p += TAP_INDEX_FILE_SIZE) {
+        util_dword_to_le_buf(p, (uint32_t)idx->files[i].fpos);
+        memcpy(p + 4, idx->files[i].record.name, 17);
+        p[21] = idx->files[i].record.type;
+        p[22] = idx->files[i].record.encoding;
+        util_word_to_le_buf(p + 23, idx->files[i].record.start_addr);
+        util_word_to_le_buf(p + 25, idx->files[i].record.end_addr);
+    }
+
+    mediacache_put(idx->cache_key, tap_index_tag(), data, size);
+    lib_free(data);
+}
+
+static tap_index_t *tap_index_get(tap_t *tap)
+{
+    tap_index_t *idx = tap->index;
+
+    if (idx == NULL) {
+        idx = lib_calloc(1, sizeof(tap_index_t));
+        /* a tape written to is not worth caching */
+        if (mediacache_enabled() && !tap->has_changed) {
+            idx->cache_key = mediacache_key_from_file("tap", tap->file_name);
+            if (idx->cache_key != NULL) {
+                tap_index_load(idx);
+            }
+        }
+        tap->index = idx;
+    }
+    return idx;
+}
+
+static void tap_index_free(tap_t *tap, int save)
+{
+    tap_index_t *idx = tap->index;
+
+    if (idx == NULL) {
+        return;
+    }
+
+    if (save && idx->dirty && idx->cache_key != NULL && !tap->has_changed) {
+        tap_index_save(idx);
+    }
+
+    lib_free(idx->points);
+    lib_free(idx->files);
+    lib_free(idx->cache_key);
+    lib_free(idx);
+    tap->index = NULL;
+}
+
+/* Buffered reading of the image while building the index.  */
+typedef struct tap_index_reader_s {
+    FILE *fd;
+    uint8_t buf[0x10000];
+    size_t len;
+    size_t pos;
+    int offset;
+} tap_index_reader_t;
+
+inline static int tap_index_read_byte(tap_index_reader_t *r)
+{
+    if (r->pos >= r->len) {
+        r->len = fread(r->buf, 1, sizeof(r->buf), r->fd);
+        r->pos = 0;
+        if (r->len == 0) {
+            return -1;
+        }
+    }
+    r->offset++;
+    return r->buf[r->pos++];
+}
+
+/* same as tap_get_pulse(), but in cycles and keeping long gaps exact */
+static int tap_index_read_pulse(tap_t *tap, tap_index_reader_t *r, uint32_t *cycles)
+{
+    int halfwaves = (tap->version == 2) ? 2 : 1;
+    int data, i;
+
+    *cycles = 0;
+    while (halfwaves--) {
+        data = tap_index_read_byte(r);
+        if (data < 0) {
+            return -1;
+        }
+        if (data != 0) {
+            *cycles += (uint32_t)data * 8;
+        } else if (tap->version == 0) {
+            *cycles += 256 * 8;
+        } else {
+            uint32_t len = 0;
+
+            for (i = 0; i < 3; i++) {
+                data = tap_index_read_byte(r);
+                if (data < 0) {
+                    return -1;
+                }
+                len |= (uint32_t)data << (i * 8);
+            }
+            *cycles += len;
+        }
+    }
+    return 0;
+}
+
+/* walk the whole tape once, noting a point every TAP_INDEX_STEP pulses */
+static int tap_index_build_points(tap_t *tap, tap_index_t *idx)
+{
+    tap_index_reader_t *r;
+    tap_index_point_t point;
+    int max_points;
+    uint32_t cycles;
+    long fpos;
+
+    if (idx->num_points > 0) {
+        return 0;
+    }
+    if (tap->fd == NULL) {
+        return -1;
+    }
+
+    fpos = ftell(tap->fd);
+    if (fseek(tap->fd, tap->offset, SEEK_SET) != 0) {
+        return -1;
+    }
+
+    r = lib_malloc(sizeof(tap_index_reader_t));
+    r->fd = tap->fd;
+    r->len = r->pos = 0;
+    r->offset = 0;
+
+    max_points = tap->size / TAP_INDEX_STEP + 2;
+    idx->points = lib_malloc(max_points * sizeof(tap_index_point_t));
+    idx->num_points = 0;
+
+    point.offset = 0;
+    point.pulse = 0;
+    point.cycles = 0;
+
+    while (1) {
+        if ((point.pulse % TAP_INDEX_STEP) == 0) {
+            if (idx->num_points == max_points) {
+                max_points *= 2;
+                idx->points = lib_realloc(idx->points, max_points * sizeof(tap_index_point_t));
+            }
+            idx->points[idx->num_points++] = point;
+        }
+        if (tap_index_read_pulse(tap, r, &cycles) < 0) {
+            break;
+        }
+        point.offset = r->offset;
+        point.pulse++;
+        point.cycles += cycles;
+    }
+
+    /* the end of the tape */
+    if (idx->points[idx->num_points - 1].pulse != point.pulse) {
+        if (idx->num_points == max_points) {
+            idx->points = lib_realloc(idx->points, (max_points + 1) * sizeof(tap_index_point_t));
+        }
+        idx->points[idx->num_points++] = point;
+    }
+
+    lib_free(r);
+    fseek(tap->fd, fpos, SEEK_SET);
+    idx->dirty = 1;
+
+    return 0;
+}
+
+/** \brief  Get the end of the tape from the index
+ *
+ * \param[in]   tap     TAP image
+ * \param[out]  point   end of the tape
+ *
+ * \return  0 on success, -1 on error
+ */
+int tap_index_total(tap_t *tap, tap_index_point_t *point)
+{
+    tap_index_t *idx = tap_index_get(tap);
+
+    if (tap_index_build_points(tap, idx) < 0) {
+        return -1;
+    }
+    *point = idx->points[idx->num_points - 1];
+    return 0;
+}
+
+/** \brief  Find the first point of the index after \a offset
+ *
+ * \param[in]   tap     TAP image
+ * \param[in]   offset  offset in the data area of the image
+ * \param[out]  point   point found
+ *
+ * \return  0 on success, -1 if there is none
+ */
+int tap_index_next_point(tap_t *tap, int offset, tap_index_point_t *point)
+{
+    tap_index_t *idx = tap_index_get(tap);
+    int lo, hi;
+
+    if (tap_index_build_points(tap, idx) < 0) {
+        return -1;
+    }
+
+    lo = 0;
+    hi = idx->num_points;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (idx->points[mid].offset <= offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == idx->num_points) {
+        return -1;
+    }
+    *point = idx->points[lo];
+    return 0;
+}
+
+/** \brief  Find the last point of the index before \a offset
+ *
+ * \param[in]   tap     TAP image
+ * \param[in]   offset  offset in the data area of the image
+ * \param[out]  point   point found
+ *
+ * \return  0 on success, -1 if there is none
+ */
+int tap_index_prev_point(tap_t *tap, int offset, tap_index_point_t *point)
+{
+    tap_index_t *idx = tap_index_get(tap);
+    int lo, hi;
+
+    if (tap_index_build_points(tap, idx) < 0) {
+        return -1;
+    }
+
+    lo = 0;
+    hi = idx->num_points;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (idx->points[mid].offset < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return -1;
+    }
+    *point = idx->points[lo - 1];
+    return 0;
+}
+
+/** \brief  Forget the index after the image was written to
+ *
+ * \param[in]   tap     TAP image
+ */
+void tap_index_invalidate(tap_t *tap)
+{
+    tap_index_free(tap, 0);
+}
+
+/* Is the image positioned at the start of the current file, as noted in the
+   index? Only then the files in the index can be used. */
+static int tap_index_at_file(tap_t *tap)
+{
+    tap_index_t *idx = tap_index_get(tap);
+    long fpos = ftell(tap->fd);
+
+    if (tap->current_file_number < 0) {
+        return fpos == tap->offset;
+    }
+    return tap->current_file_number < idx->num_files
+           && fpos == idx->files[tap->current_file_number].fpos;
+}
+
+/* 0: positioned at the file, 1: there is no such file, -1: not known yet */
+static int tap_index_seek_file(tap_t *tap, int file_number)
+{
+    tap_index_t *idx = tap_index_get(tap);
+
+    if (file_number < idx->num_files) {
+        fseek(tap->fd, idx->files[file_number].fpos, SEEK_SET);
+        tap->current_file_seek_position = (int)idx->files[file_number].fpos;
+        *tap->tap_file_record = idx->files[file_number].record;
+        tap->current_file_number = file_number;
+        return 0;
+    }
+    return idx->files_complete ? 1 : -1;
+}
+
+/* note the header tap_find_header() just found */
+static void tap_index_add_file(tap_t *tap, int file_number)
+{
+    tap_index_t *idx = tap_index_get(tap);
+
+    if (file_number != idx->num_files || idx->files_complete) {
+        return;
+    }
+    if (idx->num_files == idx->max_files) {
+        idx->max_files = idx->max_files ? idx->max_files * 2 : 16;
+        idx->files = lib_realloc(idx->files, idx->max_files * sizeof(tap_index_file_t));
+    }
+    idx->files[idx->num_files].fpos = ftell(tap->fd);
+    idx->files[idx->num_files].record = *tap->tap_file_record;
+    idx->num_files++;
+    idx->dirty = 1;
+}
+
+/* note that tap_find_header() found nothing after the last file */
+static void tap_index_end_of_files(tap_t *tap, int file_number)
+{
+    tap_index_t *idx = tap_index_get(tap);
+
+    if (file_number == idx->num_files && !idx->files_complete) {
+        idx->files_complete = 1;
+        idx->dirty = 1;
+    }
+}
+
 /* ------------------------------------------------------------------------- */
 
 tape_file_record_t *tap_get_current_file_record(tap_t *tap)
@@ -1571,6 +2035,19 @@ int tap_seek_start(tap_t *tap)
 int tap_seek_to_file(tap_t *tap, unsigned int file_number)
 {
     tap_seek_start(tap);
+
+    /* start from the last file known before it */
+    if (tap_index_at_file(tap)) {
+        int known = tap->index->num_files - 1;
+
+        if (known > (int)file_number) {
+            known = (int)file_number;
+        }
+        if (known >= 0) {
+            tap_index_seek_file(tap, known);
+        }
+    }
+
     while ((int) file_number > tap->current_file_number) {
         if (tap_seek_to_next_file(tap, 0) < 0) {
             return -1;
@@ -1582,6 +2059,8 @@ int tap_seek_to_file(tap_t *tap, unsigned int file_number)
 
 int tap_seek_to_next_file(tap_t *tap, unsigned int allow_rewind)
 {
+    int next, known, found = -1;
+
     if (tap == NULL) {
         return -1;
     }
@@ -1591,24 +2070,53 @@ int tap_seek_to_next_file(tap_t *tap, unsigned int allow_rewind)
     lib_free(tap->current_file_data);
     tap->current_file_data = NULL;
 
-    /* skip over current and find NEXT pilot
-       (only if not at beginning of tape) */
-    if (tap->current_file_number >= 0) {
-        tap_skip_file(tap);
+    next = tap->current_file_number + 1;
+
+    /* jump to the next file if it was found before */
+    known = tap_index_at_file(tap);
+    if (known) {
+        found = tap_index_seek_file(tap, next);
     }
 
-    if (tap_find_header(tap) < 0) {
-        if (allow_rewind) {
-            tap_seek_start(tap);
-            if (tap_find_header(tap) < 0) {
-                return -1;
+    if (found < 0) {
+        /* skip over current and find NEXT pilot
+           (only if not at beginning of tape) */
+        if (tap->current_file_number >= 0) {
+            tap_skip_file(tap);
+        }
+
+        if (tap_find_header(tap) < 0) {
+            if (known) {
+                tap_index_end_of_files(tap, next);
             }
+            found = 1;
         } else {
+            if (known) {
+                tap_index_add_file(tap, next);
+            }
+            tap->current_file_number = next;
+            found = 0;
+        }
+    }
+
+    if (found > 0) {
+        if (!allow_rewind) {
             return -1;
         }
+        tap_seek_start(tap);
+        found = tap_index_seek_file(tap, 0);
+        if (found > 0) {
+            return -1;
+        } else if (found < 0) {
+            if (tap_find_header(tap) < 0) {
+                tap_index_end_of_files(tap, 0);
+                return -1;
+            }
+            tap_index_add_file(tap, 0);
+            tap->current_file_number = 0;
+        }
     }
 
-    tap->current_file_number++;
     return 0;
 }
 
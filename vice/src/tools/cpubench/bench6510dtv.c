@@ -0,0 +1,186 @@
+/*
+ * bench6510dtv.c - Cycle exact 6510 core of the opcode dispatch benchmark.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "cpubench.h"
+
+#include "6510core.h"
+#include "alarm.h"
+#include "cpudispatch.h"
+#include "interrupt.h"
+#include "monitor.h"
+#include "mos6510.h"
+#include "perfcounters.h"
+#include "traps.h"
+
+/* Same hooks as vic20cpu.c and mainviccpu.c, on flat RAM.  */
+
+#define NEED_REG_PC
+
+#define JUMP(addr) reg_pc = (unsigned int)(addr)
+
+#define STORE(addr, value)            cpubench_store((addr), (uint8_t)(value))
+#define LOAD(addr)                    cpubench_read(addr)
+#define STORE_ZERO(addr, value)       cpubench_store((addr) & 0xff, (uint8_t)(value))
+#define LOAD_ZERO(addr)               cpubench_read((addr) & 0xff)
+#define STORE_DUMMY(addr, value)      STORE(addr, value)
+#define LOAD_DUMMY(addr)              LOAD(addr)
+#define STORE_ZERO_DUMMY(addr, value) STORE_ZERO(addr, value)
+#define LOAD_ZERO_DUMMY(addr)         LOAD_ZERO(addr)
+#define LOAD_CHECK_BA_LOW(addr)       LOAD(addr)
+#define LOAD_CHECK_BA_LOW_DUMMY(addr) LOAD(addr)
+
+#define LOAD_ADDR(addr)               (LOAD(addr) | (LOAD((addr) + 1) << 8))
+#define LOAD_ZERO_ADDR(addr)          (LOAD_ZERO(addr) | (LOAD_ZERO((addr) + 1) << 8))
+
+#define PUSH(val)    cpubench_store(0x100 + (reg_sp--), (uint8_t)(val))
+#define PULL()       cpubench_read(0x100 + (++reg_sp))
+#define STACK_PEEK() cpubench_read(0x100 + reg_sp)
+
+#define REWIND_FETCH_OPCODE(clock)
+#define CLK_INC() CLK++
+#define SKIP_CYCLE 0
+
+#define opcode_t          \
+    struct {              \
+        uint8_t ins;      \
+        union {           \
+            uint8_t op8[2];  \
+            uint16_t op16;   \
+        } op;             \
+    }
+
+#define p0 (opcode.ins)
+#define p1 (opcode.op.op8[0])
+#define p2 (opcode.op.op16)
+
+#define SET_OPCODE(o)                          \
+    do {                                       \
+        opcode.ins = (o) & 0xff;               \
+        opcode.op.op16 = ((o) >> 8) & 0xffff;  \
+    } while (0)
+
+#define FETCH_OPCODE(o)                                           \
+    do {                                                          \
+        if (((int)reg_pc) < bank_limit) {                         \
+            (o).ins = *(bank_base + reg_pc);                      \
+            CLK_INC();                                            \
+            (o).op.op16 = *(bank_base + reg_pc + 1);              \
+            CLK_INC();                                            \
+            if (fetch_tab[(o).ins]) {                             \
+                (o).op.op16 |= (*(bank_base + reg_pc + 2) << 8);  \
+                CLK_INC();                                        \
+            }                                                     \
+        } else {                                                  \
+            (o).ins = LOAD(reg_pc);                               \
+            CLK_INC();                                            \
+            (o).op.op16 = LOAD(reg_pc + 1);                       \
+            CLK_INC();                                            \
+            if (fetch_tab[(o).ins]) {                             \
+                (o).op.op16 |= (LOAD(reg_pc + 2) << 8);           \
+                CLK_INC();                                        \
+            }                                                     \
+        }                                                         \
+    } while (0)
+
+#define STORE_IND(addr, value)        STORE((addr), (value))
+#define LOAD_IND(addr)                LOAD((addr))
+
+#define DMA_FUNC
+#define DMA_ON_RESET
+
+static interrupt_cpu_status_t bench_int_status;
+static alarm_context_t bench_alarm_context;
+static mos6510_regs_t bench_regs;
+
+static CLOCK bench_clk;
+static unsigned int bench_last_opcode_info;
+static unsigned int bench_last_opcode_addr;
+static unsigned int reg_pc;
+
+/* The bank is the whole memory, so the opcode fetch always takes the fast
+   path.  */
+static uint8_t *bank_base = cpubench_mem;
+static int bank_start = 0;
+static int bank_limit = CPUBENCH_MEM_SIZE - 3;
+
+static void cpu_reset(void)
+{
+}
+
+inline static int interrupt_check_nmi_delay(interrupt_cpu_status_t *cs,
+                                            CLOCK cpu_clk)
+{
+    return 0;
+}
+
+inline static int interrupt_check_irq_delay(interrupt_cpu_status_t *cs,
+                                            CLOCK cpu_clk)
+{
+    return 0;
+}
+
+OPCODE_DISPATCH_FUNC void cpubench_6510dtv_run(CLOCK cycles)
+{
+#define origin (0)
+    uint8_t reg_a = 0;
+    uint8_t reg_x = 0;
+    uint8_t reg_y = 0;
+    uint8_t reg_p = 0;
+    uint8_t reg_sp = 0xff;
+    uint8_t flag_n = 0;
+    uint8_t flag_z = 0;
+    CLOCK stop_clk;
+
+    bench_int_status.global_pending_int = IK_NONE;
+    bench_int_status.last_opcode_info_ptr = &bench_last_opcode_info;
+    bench_alarm_context.next_pending_alarm_clk = CLOCK_MAX;
+
+    bench_clk = 0;
+    stop_clk = cycles;
+    reg_pc = 0x1000;
+
+    while (bench_clk < stop_clk) {
+#define CLK bench_clk
+#define LAST_OPCODE_INFO bench_last_opcode_info
+#define LAST_OPCODE_ADDR bench_last_opcode_addr
+
+#define CPU_INT_STATUS (&bench_int_status)
+
+#define ALARM_CONTEXT (&bench_alarm_context)
+
+#define ROM_TRAP_HANDLER() 0
+
+#define JAM() CLK++
+
+#define CALLER e_comp_space
+
+#define ROM_TRAP_ALLOWED() 0
+
+#define GLOBAL_REGS bench_regs
+
+#define CPU_LOOP_CONTINUES() (bench_clk < stop_clk)
+
+#include "6510dtvcore.c"
+    }
+}
@@ -0,0 +1,146 @@
+/*
+ * bench65816.c - 65816 core of the opcode dispatch benchmark.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "cpubench.h"
+
+#include "6510core.h"
+#include "alarm.h"
+#include "cpudispatch.h"
+#include "interrupt.h"
+#include "monitor.h"
+#include "perfcounters.h"
+#include "traps.h"
+#include "wdc65816.h"
+#include "traps.h"
+
+/* Same hooks as main65816cpu.c, on flat RAM.  The program runs in
+   emulation mode, in bank 0.  */
+
+#define NEED_REG_PC
+
+#define JUMP(addr) reg_pc = (unsigned int)(addr)
+
+/* Every memory access takes a cycle, as in scpu64cpu.c.  */
+#define STORE_LONG(addr, value) (cpubench_store((addr), (uint8_t)(value)), CLK_INC(CLK))
+#define LOAD_LONG(addr)         (CLK_INC(CLK), cpubench_read(addr))
+
+#define DMA_FUNC
+#define DMA_ON_RESET
+
+static interrupt_cpu_status_t bench_int_status;
+static alarm_context_t bench_alarm_context;
+static WDC65816_regs_t bench_regs;
+
+static CLOCK bench_clk;
+static unsigned int bench_last_opcode_info;
+static unsigned int bench_last_opcode_addr;
+static unsigned int reg_pc;
+
+/* The bank is the whole memory, so the opcode fetch always takes the fast
+   path.  */
+static uint8_t *bank_base = cpubench_mem;
+static int bank_start = 0;
+static int bank_limit = CPUBENCH_MEM_SIZE - 3;
+
+static void cpu_reset(void)
+{
+}
+
+inline static int interrupt_check_nmi_delay(interrupt_cpu_status_t *cs,
+                                            CLOCK cpu_clk)
+{
+    return 0;
+}
+
+inline static int interrupt_check_irq_delay(interrupt_cpu_status_t *cs,
+                                            CLOCK cpu_clk)
+{
+    return 0;
+}
+
+OPCODE_DISPATCH_FUNC void cpubench_65816_run(CLOCK cycles)
+{
+#define origin (0)
+    union regs {
+        uint16_t reg_s;
+        uint8_t reg_q[2];
+    } regs65802;
+
+#define reg_c regs65802.reg_s
+#ifndef WORDS_BIGENDIAN
+#define reg_a regs65802.reg_q[0]
+#define reg_b regs65802.reg_q[1]
+#else
+#define reg_a regs65802.reg_q[1]
+#define reg_b regs65802.reg_q[0]
+#endif
+
+    uint16_t reg_x = 0;
+    uint16_t reg_y = 0;
+    uint8_t reg_pbr = 0;
+    uint8_t reg_dbr = 0;
+    uint16_t reg_dpr = 0;
+    uint8_t reg_p = 0;
+    uint16_t reg_sp = 0x1ff;
+    uint8_t flag_n = 0;
+    uint8_t flag_z = 0;
+    uint8_t reg_emul = 1;
+    int interrupt65816 = IK_NONE;
+    CLOCK stop_clk;
+
+    bench_int_status.global_pending_int = IK_NONE;
+    bench_int_status.last_opcode_info_ptr = &bench_last_opcode_info;
+    bench_alarm_context.next_pending_alarm_clk = CLOCK_MAX;
+
+    bench_clk = 0;
+    stop_clk = cycles;
+    reg_c = 0;
+    reg_pc = 0x1000;
+
+    while (bench_clk < stop_clk) {
+#define CLK bench_clk
+#define LAST_OPCODE_INFO bench_last_opcode_info
+#define LAST_OPCODE_ADDR bench_last_opcode_addr
+
+#define CPU_INT_STATUS (&bench_int_status)
+
+#define ALARM_CONTEXT (&bench_alarm_context)
+
+#define ROM_TRAP_HANDLER() 0
+
+#define CALLER e_comp_space
+
+#define ROM_TRAP_ALLOWED() 0
+
+#define GLOBAL_REGS bench_regs
+
+#define STP_65816() CLK++
+#define WAI_65816() CLK++
+#define COP_65816(value) CLK++
+
+#define CPU_LOOP_CONTINUES() (bench_clk < stop_clk)
+
+#include "65816core.c"
+    }
+}
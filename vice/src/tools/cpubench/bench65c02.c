@@ -0,0 +1,139 @@
+/*
+ * bench65c02.c - 65C02 core of the opcode dispatch benchmark.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "cpubench.h"
+
+#include "6510core.h"
+#include "alarm.h"
+#include "cpudispatch.h"
+#include "interrupt.h"
+#include "monitor.h"
+#include "perfcounters.h"
+#include "r65c02.h"
+#include "traps.h"
+
+/* Same hooks as the turbomaster cartridge, on flat RAM.  */
+
+#define NEED_REG_PC
+
+#define JUMP(addr) reg_pc = (unsigned int)(addr)
+
+#define STORE(addr, value)            cpubench_store((addr), (uint8_t)(value))
+#define LOAD(addr)                    cpubench_read(addr)
+#define STORE_ZERO(addr, value)       cpubench_store((addr) & 0xff, (uint8_t)(value))
+#define LOAD_ZERO(addr)               cpubench_read((addr) & 0xff)
+
+#define LOAD_ADDR(addr)               (LOAD(addr) | (LOAD((addr) + 1) << 8))
+#define LOAD_ZERO_ADDR(addr)          (LOAD_ZERO(addr) | (LOAD_ZERO((addr) + 1) << 8))
+
+#define PAGE_ONE  (cpubench_mem + 0x100)
+
+#define STORE_IND(addr, value)        STORE((addr), (value))
+#define LOAD_IND(addr)                LOAD((addr))
+
+#define DMA_FUNC
+#define DMA_ON_RESET
+
+static interrupt_cpu_status_t bench_int_status;
+static alarm_context_t bench_alarm_context;
+static R65C02_regs_t bench_regs;
+
+static CLOCK bench_clk;
+static unsigned int bench_last_opcode_info;
+static unsigned int bench_last_opcode_addr;
+static unsigned int reg_pc;
+
+/* The bank is the whole memory, so the opcode fetch always takes the fast
+   path.  */
+static uint8_t *bank_base = cpubench_mem;
+static int bank_start = 0;
+static int bank_limit = CPUBENCH_MEM_SIZE - 3;
+
+static void cpu_reset(void)
+{
+}
+
+inline static int interrupt_check_nmi_delay(interrupt_cpu_status_t *cs,
+                                            CLOCK cpu_clk)
+{
+    return 0;
+}
+
+inline static int interrupt_check_irq_delay(interrupt_cpu_status_t *cs,
+                                            CLOCK cpu_clk)
+{
+    return 0;
+}
+
+#define CPU_WDC65C02   0
+#define CPU_R65C02     1
+#define CPU_65SC02     2
+
+OPCODE_DISPATCH_FUNC void cpubench_65c02_run(CLOCK cycles)
+{
+#define origin (0)
+    uint8_t reg_a = 0;
+    uint8_t reg_x = 0;
+    uint8_t reg_y = 0;
+    uint8_t reg_p = 0;
+    uint8_t reg_sp = 0xff;
+    uint8_t flag_n = 0;
+    uint8_t flag_z = 0;
+    int cpu_type = CPU_R65C02;
+    CLOCK stop_clk;
+
+    bench_int_status.global_pending_int = IK_NONE;
+    bench_int_status.last_opcode_info_ptr = &bench_last_opcode_info;
+    bench_alarm_context.next_pending_alarm_clk = CLOCK_MAX;
+
+    bench_clk = 0;
+    stop_clk = cycles;
+    reg_pc = 0x1000;
+
+    while (bench_clk < stop_clk) {
+#define CLK bench_clk
+#define LAST_OPCODE_INFO bench_last_opcode_info
+#define LAST_OPCODE_ADDR bench_last_opcode_addr
+
+#define CPU_INT_STATUS (&bench_int_status)
+
+#define ALARM_CONTEXT (&bench_alarm_context)
+
+#define ROM_TRAP_HANDLER() 0
+
+#define CALLER e_comp_space
+
+#define ROM_TRAP_ALLOWED() 0
+
+#define GLOBAL_REGS bench_regs
+
+/* WDC_STP() and WDC_WAI() are not used on the R65C02. */
+#define WDC_STP()
+#define WDC_WAI()
+
+#define CPU_LOOP_CONTINUES() (bench_clk < stop_clk)
+
+#include "65c02core.c"
+    }
+}
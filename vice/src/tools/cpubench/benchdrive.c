@@ -0,0 +1,199 @@
+/*
+ * benchdrive.c - Drive 6502 core of the opcode dispatch benchmark.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "cpubench.h"
+
+#include <string.h>
+
+#include "6510core.h"
+#include "alarm.h"
+#include "cpudispatch.h"
+#include "interrupt.h"
+#include "monitor.h"
+#include "mos6510.h"
+#include "perfcounters.h"
+#include "traps.h"
+
+/* Same hooks as drivecpu.c, on flat RAM, including the predecoded
+   instructions of the DrivePredecode resource.  */
+
+#define DRIVE_CPU
+
+#define NEED_REG_PC
+
+#define JUMP(addr) reg_pc = (unsigned int)(addr)
+
+#define STORE(addr, value)            cpubench_store((addr), (uint8_t)(value))
+#define LOAD(addr)                    cpubench_read(addr)
+#define STORE_ZERO(addr, value)       cpubench_store((addr) & 0xff, (uint8_t)(value))
+#define LOAD_ZERO(addr)               cpubench_read((addr) & 0xff)
+#define STORE_DUMMY(addr, value)      STORE(addr, value)
+#define LOAD_DUMMY(addr)              LOAD(addr)
+#define LOAD_ZERO_DUMMY(addr)         LOAD_ZERO(addr)
+
+#define LOAD_ADDR(addr)               (LOAD(addr) | (LOAD((addr) + 1) << 8))
+#define LOAD_ZERO_ADDR(addr)          (LOAD_ZERO(addr) | (LOAD_ZERO((addr) + 1) << 8))
+
+#define PAGE_ONE  (cpubench_mem + 0x100)
+
+#define STORE_IND(addr, value)        STORE((addr), (value))
+#define LOAD_IND(addr)                LOAD((addr))
+
+#define DMA_FUNC
+#define DMA_ON_RESET
+
+#define drivecpu_byte_ready_egde_clear()
+#define drivecpu_rotate()
+#define drivecpu_byte_ready() 0
+
+static interrupt_cpu_status_t bench_int_status;
+static alarm_context_t bench_alarm_context;
+
+static CLOCK bench_clk;
+static unsigned int bench_last_opcode_info;
+static unsigned int bench_last_opcode_addr;
+static unsigned int reg_pc;
+
+/* The bank is the whole memory, so the opcode fetch always takes the fast
+   path.  */
+static uint8_t *bank_base = cpubench_mem;
+static int bank_start = 0;
+static int bank_limit = CPUBENCH_MEM_SIZE - 3;
+
+/* Predecoded instructions for the whole memory, used like the drive ROM
+   table (entries trusted) or the drive RAM table (entries checked).  */
+static uint32_t bench_predecode[CPUBENCH_MEM_SIZE];
+static uint32_t *bench_predecode_base;
+static int bench_predecode_check;
+
+static void cpu_reset(void)
+{
+}
+
+inline static int interrupt_check_nmi_delay(interrupt_cpu_status_t *cs,
+                                            CLOCK cpu_clk)
+{
+    return 0;
+}
+
+inline static int interrupt_check_irq_delay(interrupt_cpu_status_t *cs,
+                                            CLOCK cpu_clk)
+{
+    return 0;
+}
+
+OPCODE_DISPATCH_FUNC static void bench_drive_run(CLOCK cycles)
+{
+#define origin (0)
+    uint8_t reg_a = 0;
+    uint8_t reg_x = 0;
+    uint8_t reg_y = 0;
+    uint8_t reg_p = 0;
+    uint8_t reg_sp = 0xff;
+    uint8_t flag_n = 0;
+    uint8_t flag_z = 0;
+    uint32_t predecoded;
+    CLOCK stop_clk;
+
+    bench_int_status.global_pending_int = IK_NONE;
+    bench_int_status.last_opcode_info_ptr = &bench_last_opcode_info;
+    bench_alarm_context.next_pending_alarm_clk = CLOCK_MAX;
+
+    bench_clk = 0;
+    stop_clk = cycles;
+    reg_pc = 0x1000;
+
+    while (bench_clk < stop_clk) {
+#define CLK bench_clk
+#define LAST_OPCODE_INFO bench_last_opcode_info
+#define LAST_OPCODE_ADDR bench_last_opcode_addr
+#define TRACEFLG 0
+
+#define CPU_INT_STATUS (&bench_int_status)
+
+#define ALARM_CONTEXT (&bench_alarm_context)
+
+#define ROM_TRAP_HANDLER() 0
+
+#define JAM() CLK++
+
+#define CALLER e_comp_space
+
+#define ROM_TRAP_ALLOWED() 0
+
+#define CPU_LOOP_CONTINUES() (bench_clk < stop_clk)
+
+#if !defined WORDS_BIGENDIAN && defined ALLOW_UNALIGNED_ACCESS
+#define PREDECODED_OPCODE(o) (o)
+#define SET_PREDECODED_OPCODE(o, e) ((o) = (e) & 0xffffff)
+#else
+#define PREDECODED_OPCODE(o) ((uint32_t)(o).ins | ((uint32_t)(o).op.op16 << 8))
+#define SET_PREDECODED_OPCODE(o, e) ((o).ins = (uint8_t)(e), (o).op.op16 = (uint16_t)((e) >> 8))
+#endif
+
+#define PREDECODED_BYTES(a) \
+    ((uint32_t)bank_base[(a)] | ((uint32_t)bank_base[(a) + 1] << 8) | ((uint32_t)bank_base[(a) + 2] << 16))
+
+#define FETCH_PREDECODED(o)                                                  \
+    (bench_predecode_base != NULL                                            \
+     && (predecoded = bench_predecode_base[reg_pc]) != 0                     \
+     && (!bench_predecode_check                                              \
+         || (predecoded & 0xffffff) == PREDECODED_BYTES(reg_pc))             \
+     && (SET_PREDECODED_OPCODE(o, predecoded),                               \
+         CLK_ADD(CLK, predecoded >> 24), 1))
+
+#define STORE_PREDECODED(o, cycles)                                          \
+    do {                                                                     \
+        if (bench_predecode_base != NULL) {                                  \
+            bench_predecode_base[reg_pc] = PREDECODED_OPCODE(o)              \
+                                           | ((uint32_t)(cycles) << 24);     \
+        }                                                                    \
+    } while (0)
+
+#include "6510core.c"
+    }
+}
+
+static void bench_drive_predecode(uint32_t *base, int check, CLOCK cycles)
+{
+    memset(bench_predecode, 0, sizeof(bench_predecode));
+    bench_predecode_base = base;
+    bench_predecode_check = check;
+    bench_drive_run(cycles);
+}
+
+void cpubench_drive_run(CLOCK cycles)
+{
+    bench_drive_predecode(NULL, 0, cycles);
+}
+
+void cpubench_drive_rom_run(CLOCK cycles)
+{
+    bench_drive_predecode(bench_predecode, 0, cycles);
+}
+
+void cpubench_drive_ram_run(CLOCK cycles)
+{
+    bench_drive_predecode(bench_predecode, 1, cycles);
+}
@@ -0,0 +1,97 @@
+/*
+ * benchz80.c - Z80 core of the opcode dispatch benchmark.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "cpubench.h"
+
+#include <string.h>
+
+#include "6510core.h"
+#include "alarm.h"
+#include "daa.h"
+#include "interrupt.h"
+#include "maincpu.h"
+#include "monitor.h"
+#include "z80regs.h"
+
+/* Same hooks as c128/z80.c, on flat RAM.  */
+
+static CLOCK bench_clk;
+static CLOCK bench_stop_clk;
+static z80_regs_t z80_regs;
+
+#define CLK bench_clk
+
+/* The whole memory is one fetch window.  */
+static void bench_fetch_translate(int addr, uint8_t **base, int *start, int *limit)
+{
+    *base = cpubench_mem;
+    *start = 0;
+    *limit = CPUBENCH_MEM_SIZE - 1;
+}
+
+#define JUMP(addr)              \
+    do {                        \
+        z80_reg_pc = (addr);    \
+    } while (0)
+
+#define Z80_FETCH_TRANSLATE(addr, base, start, limit) bench_fetch_translate(addr, base, start, limit)
+
+#define LOAD(addr) ((uint32_t)cpubench_read(addr))
+
+#define STORE(addr, value) cpubench_store((addr), (uint8_t)(value))
+
+#undef IN
+#define IN(addr) 0xff
+
+#undef OUT
+#define OUT(addr, value) ((void)(value))
+
+#define Z80_SET_DMA_REQUEST(x)
+#define Z80_LOOP_COND (CLK < bench_stop_clk)
+
+#include "z80core.c"
+
+/* The flag and DAA tables of the Z80 core.  */
+#include "z80flags.c"
+#include "daa.c"
+
+void cpubench_z80_run(CLOCK cycles)
+{
+    interrupt_cpu_status_t int_status;
+    alarm_context_t alarm_context;
+
+    memset(&int_status, 0, sizeof(int_status));
+    int_status.global_pending_int = IK_NONE;
+    int_status.last_opcode_info_ptr = &z80_last_opcode_info;
+    memset(&alarm_context, 0, sizeof(alarm_context));
+    alarm_context.next_pending_alarm_clk = CLOCK_MAX;
+
+    z80core_reset();
+    export_registers();
+
+    bench_clk = 0;
+    bench_stop_clk = cycles;
+
+    z80_maincpu_loop(&int_status, &alarm_context);
+}
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+#
+# Disk image I/O benchmark for c1541.
+#
+# Formats a disk image, then in one c1541 run writes a file to it, reads it
+# back and deletes it again, a number of times.  Prints the bytes copied per
+# second and the read and write system calls of that run, minus those of a
+# run that only attaches the image.  The counts come from /proc/<pid>/io, so
+# they need Linux; seeks and msync() calls are not included.  The copies
+# are checked against the original file, and the hash of the final image
+# shows if two builds leave the same image behind.
+#
+# usage: c1541bench.py [--copies N] [--size KiB] [--image d64|d71|d81]
+#                      <c1541>
+
+
+import argparse
+import hashlib
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def run(args, cwd):
+    """Run c1541, return the wall time, rusage and /proc/<pid>/io."""
+    start = time.perf_counter()
+    proc = subprocess.Popen(args, cwd=cwd, stdout=subprocess.DEVNULL)
+    # wait without reaping, the io counters go with the process
+    os.waitid(os.P_PID, proc.pid, os.WEXITED | os.WNOWAIT)
+    secs = time.perf_counter() - start
+    io = {}
+    try:
+        with open('/proc/%d/io' % proc.pid) as f:
+            for line in f:
+                key, value = line.split(':')
+                io[key] = int(value)
+    except OSError:
+        pass
+    _, status, usage = os.wait4(proc.pid, 0)
+    if status != 0:
+        sys.exit('%s failed' % ' '.join(args))
+    return secs, usage, io
+
+
+def main():
+    parser = argparse.ArgumentParser(description='c1541 disk image I/O benchmark')
+    parser.add_argument('--copies', type=int, default=40,
+                        help='write/read/delete cycles in one run')
+    parser.add_argument('--size', type=int, default=120,
+                        help='file size in KiB')
+    parser.add_argument('--image', default='d64', choices=('d64', 'd71', 'd81'),
+                        help='disk image type')
+    parser.add_argument('c1541')
+    args = parser.parse_args()
+
+    c1541 = os.path.abspath(args.c1541)
+    tmp = tempfile.mkdtemp()
+    try:
+        data = random.Random(1541).randbytes(args.size * 1024)
+        with open(os.path.join(tmp, 'data'), 'wb') as f:
+            f.write(data)
+
+        image = 'bench.' + args.image
+        run([c1541, '-format', 'bench,01', args.image, image], tmp)
+        base_secs, base_usage, base_io = run([c1541, '-attach', image], tmp)
+
+        cmd = [c1541, '-attach', image]
+        for i in range(args.copies):
+            cmd += ['-write', 'data', 'bench',
+                    '-read', 'bench', 'copy%d' % (i % 2),
+                    '-delete', 'bench']
+        secs, usage, io = run(cmd, tmp)
+
+        for i in range(min(args.copies, 2)):
+            with open(os.path.join(tmp, 'copy%d' % i), 'rb') as f:
+                if f.read() != data:
+                    sys.exit('copy %d differs from the file written' % i)
+        with open(os.path.join(tmp, image), 'rb') as f:
+            state = hashlib.sha1(f.read()).hexdigest()
+    finally:
+        shutil.rmtree(tmp)
+
+    copied = 2 * args.copies * len(data)
+    cpu = (usage.ru_utime + usage.ru_stime
+           - base_usage.ru_utime - base_usage.ru_stime)
+    print('%-4s %4d copies of %d KiB %8.3f s %8.3f s cpu %10.1f KiB/s'
+          % (args.image, args.copies, args.size, secs - base_secs, cpu,
+             copied / 1024 / (secs - base_secs)))
+    if io:
+        print('read syscalls %d, write syscalls %d'
+              % (io['syscr'] - base_io['syscr'],
+                 io['syscw'] - base_io['syscw']))
+    print('state %s' % state)
+
+
+if __name__ == '__main__':
+    main()
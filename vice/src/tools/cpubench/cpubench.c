@@ -0,0 +1,142 @@
+/*
+ * cpubench.c - Opcode dispatch benchmark for the CPU emulation cores.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Runs every CPU core on a fixed instruction mix in flat RAM, without
+ * interrupts or alarms, and prints the executed instructions per second.
+ * `make benchmark' builds this once with switch and once with threaded
+ * dispatch and runs both.
+ */
+
+#include "vice.h"
+#include "cpubench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Cycles run by each core, unless given on the command line */
+#define CPUBENCH_CYCLES 200000000
+
+uint8_t cpubench_mem[CPUBENCH_MEM_SIZE + 4];
+uint64_t cpubench_instructions;
+
+/* 6502 instruction mix at $1000, also run by the 65816 in emulation mode */
+static const uint8_t prg_6502[] = {
+    0xa2, 0x00,             /* $1000  LDX #$00      */
+    0xbd, 0x00, 0x20,       /* $1002  LDA $2000,X   */
+    0x18,                   /* $1005  CLC           */
+    0x69, 0x03,             /* $1006  ADC #$03      */
+    0x9d, 0x00, 0x21,       /* $1008  STA $2100,X   */
+    0xa4, 0x10,             /* $100b  LDY $10       */
+    0xc8,                   /* $100d  INY           */
+    0x84, 0x10,             /* $100e  STY $10       */
+    0x51, 0x20,             /* $1010  EOR ($20),Y   */
+    0x48,                   /* $1012  PHA           */
+    0x68,                   /* $1013  PLA           */
+    0x20, 0x20, 0x10,       /* $1014  JSR $1020     */
+    0xe8,                   /* $1017  INX           */
+    0xd0, 0xe8,             /* $1018  BNE $1002     */
+    0x4c, 0x00, 0x10,       /* $101a  JMP $1000     */
+    0xea, 0xea, 0xea,       /* $101d  NOP (padding) */
+    0x0a,                   /* $1020  ASL A         */
+    0x4a,                   /* $1021  LSR A         */
+    0x60                    /* $1022  RTS           */
+};
+
+/* Z80 instruction mix at $0000 */
+static const uint8_t prg_z80[] = {
+    0x21, 0x00, 0x20,       /* $0000  LD HL,$2000   */
+    0x06, 0x00,             /* $0003  LD B,$00      */
+    0x7e,                   /* $0005  LD A,(HL)     */
+    0xc6, 0x03,             /* $0006  ADD A,$03     */
+    0x77,                   /* $0008  LD (HL),A     */
+    0x23,                   /* $0009  INC HL        */
+    0xe5,                   /* $000a  PUSH HL       */
+    0xe1,                   /* $000b  POP HL        */
+    0xcd, 0x20, 0x00,       /* $000c  CALL $0020    */
+    0x10, 0xf4,             /* $000f  DJNZ $0005    */
+    0xc3, 0x00, 0x00,       /* $0011  JP $0000      */
+    0x00, 0x00, 0x00, 0x00, /* $0014  NOP (padding) */
+    0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00,
+    0xa9,                   /* $0020  XOR C         */
+    0x07,                   /* $0021  RLCA          */
+    0xc9                    /* $0022  RET           */
+};
+
+typedef struct cpubench_core_s {
+    const char *name;
+    void (*run)(CLOCK cycles);
+    const uint8_t *prg;
+    size_t prg_size;
+    unsigned int prg_addr;
+} cpubench_core_t;
+
+static const cpubench_core_t cores[] = {
+    { "6510",     cpubench_6510_run,      prg_6502, sizeof(prg_6502), 0x1000 },
+    { "6510dtv",  cpubench_6510dtv_run,   prg_6502, sizeof(prg_6502), 0x1000 },
+    { "65c02",    cpubench_65c02_run,     prg_6502, sizeof(prg_6502), 0x1000 },
+    { "drive",    cpubench_drive_run,     prg_6502, sizeof(prg_6502), 0x1000 },
+    { "driverom", cpubench_drive_rom_run, prg_6502, sizeof(prg_6502), 0x1000 },
+    { "driveram", cpubench_drive_ram_run, prg_6502, sizeof(prg_6502), 0x1000 },
+    { "65816",    cpubench_65816_run,     prg_6502, sizeof(prg_6502), 0x1000 },
+    { "z80",      cpubench_z80_run,       prg_z80,  sizeof(prg_z80),  0x0000 },
+    { NULL,       NULL,                   NULL,     0,                0      }
+};
+
+int main(int argc, char **argv)
+{
+    const cpubench_core_t *core;
+    CLOCK cycles = CPUBENCH_CYCLES;
+
+    if (argc > 1) {
+        cycles = strtoull(argv[1], NULL, 0);
+    }
+
+#ifdef CPUBENCH_THREADED
+    printf("threaded dispatch, %lu cycles per core\n", (unsigned long)cycles);
+#else
+    printf("switch dispatch, %lu cycles per core\n", (unsigned long)cycles);
+#endif
+
+    for (core = cores; core->name != NULL; core++) {
+        clock_t start;
+        double secs;
+
+        memset(cpubench_mem, 0, sizeof(cpubench_mem));
+        memcpy(cpubench_mem + core->prg_addr, core->prg, core->prg_size);
+        cpubench_instructions = 0;
+
+        start = clock();
+        core->run(cycles);
+        secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        printf("%-8s %12lu instructions %8.3f s %10.2f M instructions/s\n",
+               core->name, (unsigned long)cpubench_instructions, secs,
+               secs > 0.0 ? cpubench_instructions / secs / 1e6 : 0.0);
+    }
+
+    return EXIT_SUCCESS;
+}
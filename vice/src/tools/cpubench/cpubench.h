@@ -0,0 +1,78 @@
+/*
+ * cpubench.h - Opcode dispatch benchmark for the CPU emulation cores.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_CPUBENCH_H
+#define VICE_CPUBENCH_H
+
+/* Included right after vice.h by every benchmark source.  The same sources
+   are built twice, once with CPUBENCH_THREADED and once without, so the
+   dispatch does not depend on how VICE itself was configured.  */
+#ifdef CPUBENCH_THREADED
+#ifndef USE_THREADED_DISPATCH
+#define USE_THREADED_DISPATCH
+#endif
+#else
+#undef USE_THREADED_DISPATCH
+#endif
+
+/* Only the dispatch is measured, not the monitor hooks.  */
+#undef FEATURE_CPUMEMHISTORY
+#undef FEATURE_PERFCOUNTERS
+
+#include "types.h"
+#include "perfcounters.h"
+
+/* The cores count their instructions through the performance counter
+   hook.  */
+extern uint64_t cpubench_instructions;
+
+#undef PERFCOUNTERS_INC
+#define PERFCOUNTERS_INC(block, counter) cpubench_instructions++
+
+/* Memory of the benchmarked CPU, with some slack for the fetches of the
+   6502 cores, which read up to three bytes past the PC.  */
+#define CPUBENCH_MEM_SIZE 0x10000
+extern uint8_t cpubench_mem[CPUBENCH_MEM_SIZE + 4];
+
+inline static uint8_t cpubench_read(unsigned int addr)
+{
+    return cpubench_mem[addr & 0xffff];
+}
+
+inline static void cpubench_store(unsigned int addr, uint8_t value)
+{
+    cpubench_mem[addr & 0xffff] = value;
+}
+
+/* Run a core for (at least) `cycles' cycles on the program in
+   `cpubench_mem'.  */
+extern void cpubench_6510_run(CLOCK cycles);
+extern void cpubench_6510dtv_run(CLOCK cycles);
+extern void cpubench_65c02_run(CLOCK cycles);
+extern void cpubench_drive_run(CLOCK cycles);
+extern void cpubench_drive_rom_run(CLOCK cycles);
+extern void cpubench_drive_ram_run(CLOCK cycles);
+extern void cpubench_65816_run(CLOCK cycles);
+extern void cpubench_z80_run(CLOCK cycles);
+
+#endif
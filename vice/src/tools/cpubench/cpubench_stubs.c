@@ -0,0 +1,88 @@
+/*
+ * cpubench_stubs.c - Emulator functions referenced by the benchmarked cores.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * The benchmark raises no interrupts, has no alarms and never enables the
+ * monitor, so none of these is ever called.
+ */
+
+#include "vice.h"
+#include "cpubench.h"
+
+#include "alarm.h"
+#include "interrupt.h"
+#include "log.h"
+#include "maincpu.h"
+#include "monitor.h"
+
+unsigned monitor_mask[NUM_MEMSPACES];
+
+/* Only used for the last opcode address of the Z80.  */
+unsigned int reg_pc;
+
+void maincpu_reset(void)
+{
+}
+
+int log_warning(log_t log, const char *format, ...)
+{
+    return 0;
+}
+
+void interrupt_ack_dma(interrupt_cpu_status_t *cs)
+{
+}
+
+void interrupt_ack_reset(interrupt_cpu_status_t *cs)
+{
+}
+
+void interrupt_do_trap(interrupt_cpu_status_t *cs, uint16_t address)
+{
+}
+
+void monitor_startup(MEMSPACE mem)
+{
+}
+
+int monitor_force_import(MEMSPACE mem)
+{
+    return 0;
+}
+
+void monitor_check_icount(uint16_t a)
+{
+}
+
+void monitor_check_icount_interrupt(void)
+{
+}
+
+void monitor_check_watchpoints(unsigned int lastpc, unsigned int pc)
+{
+}
+
+int monitor_check_breakpoints(MEMSPACE mem, uint16_t addr)
+{
+    return 0;
+}
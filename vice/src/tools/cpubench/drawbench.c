@@ -0,0 +1,224 @@
+/*
+ * drawbench.c - Benchmark for the x64sc VIC-II drawing code.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Runs vicii_draw_cycle() on PAL frames of a text, a bitmap and a scrolled
+ * multicolor text screen without sprites, for a chip with (6569) and
+ * without (8565) color latency, and prints the drawn cycles per second.
+ * The frames are driven like vicii_cycle() does, using the cycle table of
+ * the chip model, with the fetched data taken from a fixed pseudo random
+ * screen.  The checksum over the drawn lines tells if two builds draw the
+ * same pixels.
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "types.h"
+#include "vicii.h"
+#include "vicii-chip-model.h"
+#include "vicii-draw-cycle.h"
+#include "vicii-resources.h"
+#include "viciitypes.h"
+
+/* Cycles drawn for each screen, unless given on the command line */
+#define DRAWBENCH_CYCLES 20000000
+
+#define DRAWBENCH_LINES 312
+
+/* Screen data: 25 rows of 40 characters, 8 graphics bytes per cell */
+static uint8_t screen_vbuf[25][VICII_SCREEN_TEXTCOLS];
+static uint8_t screen_cbuf[25][VICII_SCREEN_TEXTCOLS];
+static uint8_t screen_gbuf[25 * 8][VICII_SCREEN_TEXTCOLS];
+
+typedef struct drawbench_screen_s {
+    const char *name;
+    uint8_t d011;
+    uint8_t d016;
+} drawbench_screen_t;
+
+static const drawbench_screen_t screens[] = {
+    { "text",    0x1b, 0xc8 },
+    { "bitmap",  0x3b, 0xc8 },
+    { "mctext",  0x1b, 0xd3 },  /* multicolor, xscroll 3 */
+    { NULL,      0,    0    }
+};
+
+typedef struct drawbench_model_s {
+    const char *name;
+    int model;
+} drawbench_model_t;
+
+static const drawbench_model_t models[] = {
+    { "6569", VICII_MODEL_6569 },
+    { "8565", VICII_MODEL_8565 },
+    { NULL,   0                }
+};
+
+static void init_screen(void)
+{
+    uint32_t seed = 0x12345678;
+    int row, col;
+
+    for (row = 0; row < 25 * 8; row++) {
+        for (col = 0; col < VICII_SCREEN_TEXTCOLS; col++) {
+            seed = seed * 1103515245 + 12345;
+            screen_gbuf[row][col] = (uint8_t)(seed >> 16);
+            if (row < 25) {
+                screen_vbuf[row][col] = (uint8_t)(seed >> 8);
+                screen_cbuf[row][col] = (uint8_t)(seed >> 24) & 0x0f;
+            }
+        }
+    }
+}
+
+static uint64_t draw_line_checksum(uint64_t sum)
+{
+    int offs;
+
+    for (offs = 0; offs < vicii.dbuf_offset; offs += 8) {
+        uint64_t pixels;
+
+        memcpy(&pixels, vicii.dbuf + offs, 8);
+        sum = (sum ^ pixels) * 0x100000001b3ULL;
+    }
+    return sum;
+}
+
+static uint64_t draw_frames(const drawbench_screen_t *screen, CLOCK cycles)
+{
+    unsigned int line = 0;
+    unsigned int cycle = 0;
+    int col = 0;
+    uint64_t sum = 0xcbf29ce484222325ULL;
+    CLOCK n;
+
+    vicii.regs[0x11] = screen->d011;
+    vicii.regs[0x16] = screen->d016;
+    vicii.vborder = 1;
+    vicii.main_border = 1;
+    vicii.idle_state = 0;
+
+    for (n = 0; n < cycles; n++) {
+        unsigned int flags = vicii.cycle_table[cycle];
+        int csel = vicii.regs[0x16] & 0x08;
+        int row = (int)line - VICII_25ROW_START_LINE;
+
+        vicii.raster_line = line;
+        vicii.raster_cycle = cycle;
+        vicii.cycle_flags = flags;
+
+        /* c-access of the whole row on its bad line */
+        if (cycle == 0 && row >= 0 && row < 25 * 8 && (row & 7) == 0) {
+            memcpy(vicii.vbuf, screen_vbuf[row >> 3], VICII_SCREEN_TEXTCOLS);
+            memcpy(vicii.cbuf, screen_cbuf[row >> 3], VICII_SCREEN_TEXTCOLS);
+        }
+
+        /* g-access */
+        if (cycle == 0) {
+            col = 0;
+        }
+        if (cycle_is_fetch_g(flags)) {
+            if (row >= 0 && row < 25 * 8 && col < VICII_SCREEN_TEXTCOLS) {
+                vicii.gbuf = screen_gbuf[row][col++];
+            } else {
+                vicii.gbuf = 0;
+            }
+        }
+
+        /* same as check_hborder() for a 25 row screen */
+        if (cycle_is_check_border_l(flags, csel)) {
+            vicii.vborder = (line < VICII_25ROW_START_LINE || line >= VICII_25ROW_STOP_LINE);
+            if (vicii.vborder == 0) {
+                vicii.main_border = 0;
+            }
+        }
+        if (cycle_is_check_border_r(flags, csel)) {
+            vicii.main_border = 1;
+        }
+
+        /* the previous line is complete before cycle 1 starts the next */
+        if (cycle == 1) {
+            sum = draw_line_checksum(sum);
+        }
+
+        vicii_draw_cycle();
+
+        if (++cycle == (unsigned int)vicii.cycles_per_line) {
+            cycle = 0;
+            if (++line == DRAWBENCH_LINES) {
+                line = 0;
+            }
+        }
+    }
+
+    return sum;
+}
+
+int main(int argc, char **argv)
+{
+    const drawbench_screen_t *screen;
+    const drawbench_model_t *model;
+    CLOCK cycles = DRAWBENCH_CYCLES;
+
+    if (argc > 1) {
+        cycles = strtoull(argv[1], NULL, 0);
+    }
+
+    printf("vicii_draw_cycle(), %lu cycles per screen\n", (unsigned long)cycles);
+
+    init_screen();
+
+    for (model = models; model->name != NULL; model++) {
+        for (screen = screens; screen->name != NULL; screen++) {
+            clock_t start;
+            double secs;
+            uint64_t sum;
+
+            memset(&vicii, 0, sizeof(vicii));
+            vicii_resources.model = model->model;
+            vicii_chip_model_init();
+            vicii_draw_cycle_init();
+
+            vicii_monitor_colreg_store(0x20, 0x0e);
+            vicii_monitor_colreg_store(0x21, 0x06);
+            vicii_monitor_colreg_store(0x22, 0x01);
+            vicii_monitor_colreg_store(0x23, 0x02);
+
+            start = clock();
+            sum = draw_frames(screen, cycles);
+            secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+            printf("%-8s %-4s %10lu cycles %8.3f s %8.2f M cycles/s %016llx\n",
+                   screen->name, model->name, (unsigned long)cycles, secs,
+                   secs > 0.0 ? cycles / secs / 1e6 : 0.0,
+                   (unsigned long long)sum);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+/*
+ * drawbench_stubs.c - Emulator functions referenced by the benchmarked
+ *                     drawing code.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#include "log.h"
+#include "snapshot.h"
+#include "types.h"
+#include "vicii-color.h"
+#include "vicii-resources.h"
+
+vicii_resources_t vicii_resources;
+
+int log_message(log_t log, const char *format, ...)
+{
+    return 0;
+}
+
+int log_error(log_t log, const char *format, ...)
+{
+    return 0;
+}
+
+int log_verbose(const char *format, ...)
+{
+    return 0;
+}
+
+int vicii_color_update_palette(struct video_canvas_s *canvas)
+{
+    return 0;
+}
+
+/* Snapshots are never taken.  */
+
+int snapshot_module_write_byte(snapshot_module_t *m, uint8_t data)
+{
+    return -1;
+}
+
+int snapshot_module_write_dword(snapshot_module_t *m, uint32_t data)
+{
+    return -1;
+}
+
+int snapshot_module_write_byte_array(snapshot_module_t *m, const uint8_t *data, unsigned int num)
+{
+    return -1;
+}
+
+int snapshot_module_read_byte(snapshot_module_t *m, uint8_t *b_return)
+{
+    return -1;
+}
+
+int snapshot_module_read_dword(snapshot_module_t *m, uint32_t *dw_return)
+{
+    return -1;
+}
+
+int snapshot_module_read_byte_array(snapshot_module_t *m, uint8_t *b_return, unsigned int num)
+{
+    return -1;
+}
+
+int snapshot_module_read_byte_into_int(snapshot_module_t *m, int *value_return)
+{
+    return -1;
+}
+
+int snapshot_module_read_dword_into_int(snapshot_module_t *m, int *value_return)
+{
+    return -1;
+}
+
+int snapshot_module_read_dword_into_uint(snapshot_module_t *m, unsigned int *value_return)
+{
+    return -1;
+}
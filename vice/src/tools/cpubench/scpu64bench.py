@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+#
+# Memory access benchmark for xscpu64.
+#
+# No SuperCPU ROM comes with VICE, so this builds a small one: it copies a
+# test loop to $0800, which then reads and writes bank 0 SRAM, mirrored C64
+# RAM, bank 1, the SIMM (directly and through $f6), and the ROM, in all four
+# optimisation modes, once with a SIMM configuration matching the installed
+# SIMM and once with a remapped one.  The loop reads memory it has not
+# written, so the RAM (and the SIMM, which is filled when its size is set)
+# is initialised without random bits.
+#
+# xscpu64 runs the ROM in warp mode and enters the monitor through the JAM
+# action at the STP that ends the test.  The CPU time the emulator takes for
+# the test gives the instructions per second.  The state printed at the end
+# is a hash of the registers, SRAM banks 0 and 1, SIMM banks 2 and $f6, the
+# screen (the C64 RAM written through the mirror) and the CIA timers and
+# raster line read at the end, so two builds that emulate the accesses and
+# their timing the same way print the same state.
+#
+# usage: scpu64bench.py [--rounds N] [--simmsize MB] [--port N]
+#                       <xscpu64> <data directory>
+
+
+import argparse
+import hashlib
+import os
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+
+# Boot code at $e000 of the ROM
+BOOT = bytes([
+    0x78,                   # $e000  SEI
+    0xd8,                   # $e001  CLD
+    0xa2, 0xff,             # $e002  LDX #$ff
+    0x9a,                   # $e004  TXS
+    0x8d, 0x7e, 0xd0,       # $e005  STA $d07e      hardware registers on
+    0xa9, 0xff,             # $e008  LDA #$ff
+    0x8d, 0x04, 0xdc,       # $e00a  STA $dc04      CIA 1 timer A latch
+    0x8d, 0x05, 0xdc,       # $e00d  STA $dc05
+    0x8d, 0x06, 0xdc,       # $e010  STA $dc06      CIA 1 timer B latch
+    0x8d, 0x07, 0xdc,       # $e013  STA $dc07
+    0xa9, 0x11,             # $e016  LDA #$11
+    0x8d, 0x0e, 0xdc,       # $e018  STA $dc0e      load and start timer A
+    0xa9, 0x51,             # $e01b  LDA #$51
+    0x8d, 0x0f, 0xdc,       # $e01d  STA $dc0f      timer B counts timer A
+    0xa2, 0x00,             # $e020  LDX #$00
+    0xbd, 0x00, 0xe1,       # $e022  LDA $e100,X    copy the test to $0800
+    0x9d, 0x00, 0x08,       # $e025  STA $0800,X
+    0xe8,                   # $e028  INX
+    0xd0, 0xf7,             # $e029  BNE $e022
+    0x4c, 0x00, 0x08        # $e02b  JMP $0800
+])
+BOOT_INSTRUCTIONS = 14 + 256 * 4 + 1
+
+# Test at $0800, copied from $e100 of the ROM
+TEST = bytes([
+    0x8d, 0xb6, 0xd0,       # $0800  STA $d0b6      boot map off
+    0xa0, 0x00,             # $0803  LDY #$00
+    0xb9, 0xf0, 0x08,       # $0805  LDA $08f0,Y    optimisation mode
+    0xaa,                   # $0808  TAX
+    0x9d, 0x74, 0xd0,       # $0809  STA $d074,X
+    0xb9, 0xf8, 0x08,       # $080c  LDA $08f8,Y    SIMM configuration
+    0x8d, 0x78, 0xd0,       # $080f  STA $d078
+    0xa9, 0x00,             # $0812  LDA #$00
+    0x85, 0x10,             # $0814  STA $10
+    0xa9, 0x00,             # $0816  LDA #rounds    patched in
+    0x85, 0x11,             # $0818  STA $11
+    0xa2, 0x00,             # $081a  LDX #$00
+    0xbd, 0x00, 0x20,       # $081c  LDA $2000,X    bank 0 SRAM
+    0x69, 0x01,             # $081f  ADC #$01
+    0x9d, 0x00, 0x21,       # $0821  STA $2100,X
+    0x9d, 0x00, 0x04,       # $0824  STA $0400,X    screen, mirrored
+    0xbf, 0x00, 0x20, 0x01, # $0827  LDA $012000,X  bank 1
+    0x7f, 0x00, 0x00, 0xf8, # $082b  ADC $f80000,X  ROM
+    0x9f, 0x00, 0x30, 0x01, # $082f  STA $013000,X
+    0x9f, 0x00, 0x20, 0x02, # $0833  STA $022000,X  SIMM
+    0x5f, 0x00, 0x21, 0x02, # $0837  EOR $022100,X
+    0x9f, 0x00, 0x00, 0xf6, # $083b  STA $f60000,X  SIMM through $f6
+    0x7f, 0x00, 0x01, 0xf6, # $083f  ADC $f60100,X
+    0x9f, 0x00, 0x00, 0xf8, # $0843  STA $f80000,X  ROM, only costs time
+    0x9d, 0x00, 0xc0,       # $0847  STA $c000,X
+    0xe8,                   # $084a  INX
+    0xd0, 0xcf,             # $084b  BNE $081c
+    0xc6, 0x10,             # $084d  DEC $10
+    0xd0, 0xcb,             # $084f  BNE $081c
+    0xc6, 0x11,             # $0851  DEC $11
+    0xd0, 0xc7,             # $0853  BNE $081c
+    0xc8,                   # $0855  INY
+    0xc0, 0x08,             # $0856  CPY #$08
+    0xd0, 0xab,             # $0858  BNE $0805
+    0xad, 0x04, 0xdc,       # $085a  LDA $dc04      timing of the whole run
+    0x8d, 0x00, 0x03,       # $085d  STA $0300
+    0xad, 0x05, 0xdc,       # $0860  LDA $dc05
+    0x8d, 0x01, 0x03,       # $0863  STA $0301
+    0xad, 0x06, 0xdc,       # $0866  LDA $dc06
+    0x8d, 0x02, 0x03,       # $0869  STA $0302
+    0xad, 0x07, 0xdc,       # $086c  LDA $dc07
+    0x8d, 0x03, 0x03,       # $086f  STA $0303
+    0xad, 0x12, 0xd0,       # $0872  LDA $d012
+    0x8d, 0x04, 0x03,       # $0875  STA $0304
+    0xdb                    # $0878  STP            enter the monitor
+])
+TEST_ROUNDS = 0x17
+TEST_MODES = 0xf0
+TEST_SIMMS = 0xf8
+
+# $d074-$d077 and $d078 values of the eight phases
+MODES = bytes([0, 1, 2, 3, 0, 1, 2, 3])
+SIMMS = bytes([4, 4, 4, 4, 3, 3, 3, 3])
+
+# Instructions per inner loop, per 256 of them and per round
+LOOP_INSTRUCTIONS = 14
+BLOCK_INSTRUCTIONS = 256 * LOOP_INSTRUCTIONS + 2
+ROUND_INSTRUCTIONS = 256 * BLOCK_INSTRUCTIONS + 2
+
+
+def build_rom(rounds):
+    rom = bytearray(0x10000)
+    test = bytearray(0x100)
+
+    test[:len(TEST)] = TEST
+    test[TEST_ROUNDS] = rounds
+    test[TEST_MODES:TEST_MODES + len(MODES)] = MODES
+    test[TEST_SIMMS:TEST_SIMMS + len(SIMMS)] = SIMMS
+
+    rom[0xe000:0xe000 + len(BOOT)] = BOOT
+    rom[0xe100:0xe200] = test
+    rom[0xfffc] = 0x00
+    rom[0xfffd] = 0xe0
+    return bytes(rom)
+
+
+def instructions(rounds):
+    phase = 10 + rounds * ROUND_INSTRUCTIONS + 3
+    return BOOT_INSTRUCTIONS + 2 + len(MODES) * phase + 11
+
+
+class BinaryMonitor:
+    """Just enough of the binary monitor protocol, see vice.texi."""
+
+    def __init__(self, port):
+        for _ in range(600):
+            try:
+                self.sock = socket.create_connection(('127.0.0.1', port))
+                break
+            except OSError:
+                time.sleep(0.1)
+        else:
+            sys.exit('cannot connect to the binary monitor')
+        self.request_id = 0
+
+    def _read(self, n):
+        data = b''
+        while len(data) < n:
+            chunk = self.sock.recv(n - len(data))
+            if not chunk:
+                sys.exit('binary monitor connection closed')
+            data += chunk
+        return data
+
+    def response(self):
+        header = self._read(12)
+        length, = struct.unpack('<I', header[2:6])
+        request_id, = struct.unpack('<I', header[8:12])
+        return header[6], header[7], request_id, self._read(length)
+
+    def command(self, kind, body=b''):
+        self.request_id += 1
+        self.sock.sendall(bytes([0x02, 0x02])
+                          + struct.pack('<II', len(body), self.request_id)
+                          + bytes([kind]) + body)
+        while True:
+            rtype, error, request_id, data = self.response()
+            if request_id == self.request_id:
+                if error:
+                    sys.exit('binary monitor command $%02x failed: $%02x'
+                             % (kind, error))
+                return data
+
+    def wait_stopped(self):
+        while self.response()[0] != 0x62:
+            pass
+
+    def memory(self, bank, start=0x0000, end=0xffff):
+        return self.command(0x01, struct.pack('<BHHBH', 0, start, end, 0,
+                                              bank))[2:]
+
+
+def cpu_seconds(pid):
+    """User and system time of the emulator, wall time where there is no
+    /proc."""
+    try:
+        with open('/proc/%d/stat' % pid) as f:
+            fields = f.read().rsplit(')', 1)[1].split()
+        return (int(fields[11]) + int(fields[12])) / os.sysconf('SC_CLK_TCK')
+    except OSError:
+        return time.perf_counter()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='xscpu64 memory access benchmark')
+    parser.add_argument('--rounds', type=int, default=16,
+                        help='rounds of 64K loops per phase (1-255)')
+    parser.add_argument('--simmsize', type=int, default=16,
+                        help='SIMM size in MiB (0/1/4/8/16)')
+    parser.add_argument('--port', type=int, default=6502,
+                        help='binary monitor port')
+    parser.add_argument('xscpu64')
+    parser.add_argument('data')
+    args = parser.parse_args()
+
+    if not 1 <= args.rounds <= 255:
+        sys.exit('rounds must be 1-255')
+
+    fd, rom_name = tempfile.mkstemp(suffix='.bin')
+    with os.fdopen(fd, 'wb') as f:
+        f.write(build_rom(args.rounds))
+
+    emu = subprocess.Popen([args.xscpu64, '-default',
+                            '-directory', args.data,
+                            '-sounddev', 'dummy', '-warp',
+                            '-jamaction', '2',
+                            '-raminitrandomchance', '0',
+                            '-scpu64', rom_name,
+                            '-simmsize', str(args.simmsize),
+                            '-binarymonitor',
+                            '-binarymonitoraddress',
+                            'ip4://127.0.0.1:%d' % args.port,
+                            '-initbreak', '0xe000'],
+                           stdout=subprocess.DEVNULL,
+                           stderr=subprocess.DEVNULL)
+    try:
+        mon = BinaryMonitor(args.port)
+
+        # stopped at the reset entry, the STP at the end of the test stops
+        # again without the per instruction check of a checkpoint
+        start = cpu_seconds(emu.pid)
+        mon.command(0xaa)
+        mon.wait_stopped()
+        secs = cpu_seconds(emu.pid) - start
+
+        state = hashlib.sha1(mon.command(0x31, bytes([0])))
+        # ram00, ram01, ram02 and ramf6 in the bank list of scpu64mem.c
+        for bank in (5, 6, 7, 251):
+            state.update(mon.memory(bank))
+        # the screen shows the C64 RAM the mirrored writes went to
+        state.update(mon.command(0x84, bytes([0, 0])))
+        mon.command(0xbb)
+    finally:
+        try:
+            emu.wait(timeout=30)
+        except subprocess.TimeoutExpired:
+            emu.kill()
+        os.unlink(rom_name)
+
+    count = instructions(args.rounds)
+    print('%-8s %12d instructions %8.3f s %10.2f M instructions/s'
+          % ('scpu64', count, secs, count / secs / 1e6))
+    print('state %s' % state.hexdigest())
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,579 @@
+/*
+ * vicetrace.c - Decode, filter and compare VICE execution traces.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Traces are recorded with the `tracestart' monitor command, the file
+ * format is described in src/monitor/mon_trace.c.
+ */
+
+#include "vice.h"
+
+#include "version.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define TRACE_VERSION       1
+#define TRACE_HEADER_SIZE   9
+#define TRACE_MAX_CPUS      8
+
+#define TRACE_PC            0x01
+#define TRACE_A             0x02
+#define TRACE_X             0x04
+#define TRACE_Y             0x08
+#define TRACE_SP            0x10
+#define TRACE_ST            0x20
+#define TRACE_CPU           0x40
+
+#define TRACE_ACCESS        0x80
+#define TRACE_ACCESS_ADDR   0x40
+#define TRACE_ACCESS_KIND   0x07
+
+#define TRACE_CLOCK_RESET   0xfe
+#define TRACE_END           0xff
+
+/* bus accesses kept per instruction */
+#define MAX_ACCESSES        32
+
+/* default number of instructions shown before a difference */
+#define DEFAULT_CONTEXT     10
+
+typedef struct trace_access_s {
+    uint8_t kind;
+    uint16_t addr;
+} trace_access_t;
+
+/* one decoded instruction with the bus accesses it caused */
+typedef struct trace_event_s {
+    int cpu;
+    uint64_t clk;
+    uint16_t pc;
+    uint8_t bytes[3];
+    uint8_t len;
+    uint8_t reg_a;
+    uint8_t reg_x;
+    uint8_t reg_y;
+    uint8_t reg_sp;
+    uint8_t reg_st;
+    int num_accesses;
+    trace_access_t accesses[MAX_ACCESSES];
+} trace_event_t;
+
+typedef struct trace_cpu_s {
+    uint64_t clk;
+    uint16_t next_pc;
+    uint8_t reg_a;
+    uint8_t reg_x;
+    uint8_t reg_y;
+    uint8_t reg_sp;
+    uint8_t reg_st;
+    uint8_t len[0x100];
+} trace_cpu_t;
+
+typedef struct trace_reader_s {
+    FILE *file;
+    const char *name;
+    int num_cpus;
+    trace_cpu_t cpu[TRACE_MAX_CPUS];
+    int cur_cpu;
+    uint16_t last_access;
+
+    /* the computer's cpu instruction still collecting bus accesses */
+    trace_event_t pending;
+    int have_pending;
+    int ended;
+} trace_reader_t;
+
+/* filters */
+typedef struct trace_filter_s {
+    int cpu;            /* -1 for all */
+    uint64_t from;
+    uint64_t to;
+    unsigned int pc_from;
+    unsigned int pc_to;
+    int relative;
+    uint64_t base;
+    int have_base;
+} trace_filter_t;
+
+static const char * const cpu_names[TRACE_MAX_CPUS] = {
+    "C", "8", "9", "10", "11", "?", "?", "?"
+};
+
+static const char * const access_names[8] = {
+    "?", "rd", "wr", "romrd", "romwr", "iord", "iowr", "?"
+};
+
+static int show_accesses = 1;
+
+/* ------------------------------------------------------------------------- */
+
+static int read_byte(trace_reader_t *reader)
+{
+    int c = getc(reader->file);
+
+    if (c == EOF) {
+        fprintf(stderr, "%s: unexpected end of trace\n", reader->name);
+        reader->ended = 1;
+        return 0;
+    }
+    return c;
+}
+
+static uint64_t read_clock(trace_reader_t *reader)
+{
+    uint64_t value = 0;
+    int shift = 0;
+    int c;
+
+    do {
+        c = read_byte(reader);
+        if (shift < 64) {
+            value |= (uint64_t)(c & 0x7f) << shift;
+        }
+        shift += 7;
+    } while ((c & 0x80) && !reader->ended);
+    return value;
+}
+
+static int trace_open(trace_reader_t *reader, const char *name)
+{
+    uint8_t header[TRACE_HEADER_SIZE];
+    int i;
+
+    memset(reader, 0, sizeof(trace_reader_t));
+    reader->name = name;
+    reader->file = fopen(name, "rb");
+    if (reader->file == NULL) {
+        fprintf(stderr, "cannot open %s\n", name);
+        return -1;
+    }
+
+    if (fread(header, 1, sizeof(header), reader->file) != sizeof(header)
+        || memcmp(header, "VICETRC", 7) != 0) {
+        fprintf(stderr, "%s is not a VICE trace\n", name);
+        return -1;
+    }
+    if (header[7] != TRACE_VERSION) {
+        fprintf(stderr, "%s: unsupported trace version %d\n", name, header[7]);
+        return -1;
+    }
+    reader->num_cpus = header[8];
+    if (reader->num_cpus < 1 || reader->num_cpus > TRACE_MAX_CPUS) {
+        fprintf(stderr, "%s: bad number of cpus %d\n", name, reader->num_cpus);
+        return -1;
+    }
+    for (i = 0; i < reader->num_cpus; i++) {
+        if (fread(reader->cpu[i].len, 1, 0x100, reader->file) != 0x100) {
+            fprintf(stderr, "%s: truncated header\n", name);
+            return -1;
+        }
+    }
+    reader->cur_cpu = 0;
+    return 0;
+}
+
+static void trace_close(trace_reader_t *reader)
+{
+    if (reader->file != NULL) {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
+
+static void read_instruction(trace_reader_t *reader, int tag, trace_event_t *event)
+{
+    trace_cpu_t *cpu;
+    int i;
+
+    if (tag & TRACE_CPU) {
+        reader->cur_cpu = read_byte(reader) % reader->num_cpus;
+    }
+    cpu = &reader->cpu[reader->cur_cpu];
+
+    event->cpu = reader->cur_cpu;
+    if (tag & TRACE_PC) {
+        event->pc = (uint16_t)read_byte(reader);
+        event->pc |= (uint16_t)(read_byte(reader) << 8);
+    } else {
+        event->pc = cpu->next_pc;
+    }
+    cpu->clk += read_clock(reader);
+    event->clk = cpu->clk;
+
+    event->bytes[0] = (uint8_t)read_byte(reader);
+    event->len = cpu->len[event->bytes[0]];
+    for (i = 1; i < 3; i++) {
+        event->bytes[i] = (i < event->len) ? (uint8_t)read_byte(reader) : 0;
+    }
+
+    if (tag & TRACE_A) {
+        cpu->reg_a = (uint8_t)read_byte(reader);
+    }
+    if (tag & TRACE_X) {
+        cpu->reg_x = (uint8_t)read_byte(reader);
+    }
+    if (tag & TRACE_Y) {
+        cpu->reg_y = (uint8_t)read_byte(reader);
+    }
+    if (tag & TRACE_SP) {
+        cpu->reg_sp = (uint8_t)read_byte(reader);
+    }
+    if (tag & TRACE_ST) {
+        cpu->reg_st = (uint8_t)read_byte(reader);
+    }
+    event->reg_a = cpu->reg_a;
+    event->reg_x = cpu->reg_x;
+    event->reg_y = cpu->reg_y;
+    event->reg_sp = cpu->reg_sp;
+    event->reg_st = cpu->reg_st;
+    event->num_accesses = 0;
+
+    cpu->next_pc = (uint16_t)(event->pc + event->len);
+}
+
+static void read_access(trace_reader_t *reader, int tag)
+{
+    trace_access_t *access;
+    uint16_t addr;
+
+    if (tag & TRACE_ACCESS_ADDR) {
+        addr = (uint16_t)read_byte(reader);
+        addr |= (uint16_t)(read_byte(reader) << 8);
+    } else {
+        addr = (uint16_t)(reader->last_access + (int8_t)read_byte(reader));
+    }
+    reader->last_access = addr;
+
+    /* bus accesses are those of the computer's cpu */
+    if (reader->have_pending && reader->pending.num_accesses < MAX_ACCESSES) {
+        access = &reader->pending.accesses[reader->pending.num_accesses++];
+        access->kind = tag & TRACE_ACCESS_KIND;
+        access->addr = addr;
+    }
+}
+
+/* Read the next complete instruction, returns 0 at the end of the trace.
+   Instructions of the computer's cpu are complete once the next one of
+   that cpu starts, so drive instructions may come first. */
+static int trace_next(trace_reader_t *reader, trace_event_t *event)
+{
+    trace_event_t current;
+    int tag;
+
+    while (!reader->ended) {
+        tag = getc(reader->file);
+        if (tag == EOF) {
+            fprintf(stderr, "%s: trace not terminated\n", reader->name);
+            reader->ended = 1;
+            break;
+        }
+        if (tag == TRACE_END) {
+            reader->ended = 1;
+            break;
+        }
+        if (tag == TRACE_CLOCK_RESET) {
+            reader->cpu[read_byte(reader) % reader->num_cpus].clk = 0;
+            continue;
+        }
+        if (tag & TRACE_ACCESS) {
+            read_access(reader, tag);
+            continue;
+        }
+
+        read_instruction(reader, tag, &current);
+        if (current.cpu != 0) {
+            *event = current;
+            return 1;
+        }
+        if (reader->have_pending) {
+            *event = reader->pending;
+            reader->pending = current;
+            return 1;
+        }
+        reader->pending = current;
+        reader->have_pending = 1;
+    }
+
+    if (reader->have_pending) {
+        *event = reader->pending;
+        reader->have_pending = 0;
+        return 1;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int filter_match(trace_filter_t *filter, trace_event_t *event)
+{
+    if (filter->cpu >= 0 && event->cpu != filter->cpu) {
+        return 0;
+    }
+    if (event->pc < filter->pc_from || event->pc > filter->pc_to) {
+        return 0;
+    }
+    if (event->clk < filter->from || event->clk > filter->to) {
+        return 0;
+    }
+    if (!filter->have_base) {
+        filter->base = event->clk;
+        filter->have_base = 1;
+    }
+    return 1;
+}
+
+/* Read the next instruction passing the filter. */
+static int trace_next_filtered(trace_reader_t *reader, trace_filter_t *filter,
+                               trace_event_t *event)
+{
+    while (trace_next(reader, event)) {
+        if (filter_match(filter, event)) {
+            if (filter->relative) {
+                event->clk -= filter->base;
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void print_event(const char *prefix, trace_event_t *event)
+{
+    char bytes[10];
+    int i;
+
+    switch (event->len) {
+        case 1:
+            sprintf(bytes, "%02X", event->bytes[0]);
+            break;
+        case 2:
+            sprintf(bytes, "%02X %02X", event->bytes[0], event->bytes[1]);
+            break;
+        default:
+            sprintf(bytes, "%02X %02X %02X", event->bytes[0], event->bytes[1], event->bytes[2]);
+            break;
+    }
+
+    printf("%s.%s:%04x  %-8s  A:%02x X:%02x Y:%02x SP:%02x %c%c-%c%c%c%c%c %12" PRIu64,
+           prefix, cpu_names[event->cpu], event->pc, bytes,
+           event->reg_a, event->reg_x, event->reg_y, event->reg_sp,
+           (event->reg_st & 0x80) ? 'N' : '.',
+           (event->reg_st & 0x40) ? 'V' : '.',
+           (event->reg_st & 0x10) ? 'B' : '.',
+           (event->reg_st & 0x08) ? 'D' : '.',
+           (event->reg_st & 0x04) ? 'I' : '.',
+           (event->reg_st & 0x02) ? 'Z' : '.',
+           (event->reg_st & 0x01) ? 'C' : '.',
+           event->clk);
+    if (show_accesses) {
+        for (i = 0; i < event->num_accesses; i++) {
+            printf(" %s:%04x", access_names[event->accesses[i].kind], event->accesses[i].addr);
+        }
+    }
+    printf("\n");
+}
+
+static int event_compare(trace_event_t *a, trace_event_t *b)
+{
+    int i;
+
+    if (a->cpu != b->cpu || a->pc != b->pc || a->clk != b->clk
+        || a->len != b->len || memcmp(a->bytes, b->bytes, a->len) != 0
+        || a->reg_a != b->reg_a || a->reg_x != b->reg_x || a->reg_y != b->reg_y
+        || a->reg_sp != b->reg_sp || a->reg_st != b->reg_st) {
+        return 1;
+    }
+    if (show_accesses) {
+        if (a->num_accesses != b->num_accesses) {
+            return 1;
+        }
+        for (i = 0; i < a->num_accesses; i++) {
+            if (a->accesses[i].kind != b->accesses[i].kind
+                || a->accesses[i].addr != b->accesses[i].addr) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int decode(const char *name, trace_filter_t *filter, uint64_t count)
+{
+    trace_reader_t reader;
+    trace_event_t event;
+    uint64_t n = 0;
+
+    if (trace_open(&reader, name) < 0) {
+        trace_close(&reader);
+        return 1;
+    }
+    while (n < count && trace_next_filtered(&reader, filter, &event)) {
+        print_event("", &event);
+        n++;
+    }
+    trace_close(&reader);
+    return 0;
+}
+
+static int diff(const char *name1, const char *name2, trace_filter_t *filter,
+                uint64_t count, int context)
+{
+    trace_reader_t reader1, reader2;
+    trace_filter_t filter2 = *filter;
+    trace_event_t event1, event2;
+    trace_event_t *history;
+    uint64_t n = 0;
+    int have1, have2, i, first, res = 0;
+
+    if (trace_open(&reader1, name1) < 0 || trace_open(&reader2, name2) < 0) {
+        trace_close(&reader1);
+        trace_close(&reader2);
+        return 2;
+    }
+    history = malloc((context + 1) * sizeof(trace_event_t));
+
+    while (n < count) {
+        have1 = trace_next_filtered(&reader1, filter, &event1);
+        have2 = trace_next_filtered(&reader2, &filter2, &event2);
+        if (!have1 || !have2) {
+            if (have1 != have2) {
+                printf("%s ends after %" PRIu64 " instructions\n",
+                       have1 ? name2 : name1, n);
+                res = 1;
+            }
+            break;
+        }
+        if (event_compare(&event1, &event2)) {
+            first = (n > (uint64_t)context) ? 0 : context - (int)n;
+            for (i = first; i < context; i++) {
+                print_event("  ", &history[(n + i - context) % (context + 1)]);
+            }
+            print_event("- ", &event1);
+            print_event("+ ", &event2);
+            printf("traces differ after %" PRIu64 " instructions\n", n);
+            res = 1;
+            break;
+        }
+        if (context > 0) {
+            history[n % (context + 1)] = event1;
+        }
+        n++;
+    }
+    if (res == 0) {
+        printf("traces are identical (%" PRIu64 " instructions)\n", n);
+    }
+
+    free(history);
+    trace_close(&reader1);
+    trace_close(&reader2);
+    return res;
+}
+
+static void usage(void)
+{
+    printf("vicetrace (VICE %s) - decode, filter and compare execution traces\n\n"
+           "decode:  vicetrace [options] <trace>\n"
+           "compare: vicetrace [options] -diff <trace1> <trace2>\n\n"
+           "-cpu <n>            only show cpu n (0 = computer, 8-11 = drives)\n"
+           "-from <cycle>       skip instructions before the cycle\n"
+           "-to <cycle>         skip instructions after the cycle\n"
+           "-pc <from>[-<to>]   only show instructions in the address range (hex)\n"
+           "-count <n>          stop after n instructions\n"
+           "-relative           count cycles from the first instruction shown\n"
+           "-noaccess           hide (and do not compare) bus accesses\n"
+           "-context <n>        instructions shown before a difference (default %d)\n"
+           "-h, -help           show this help\n",
+           VERSION, DEFAULT_CONTEXT);
+}
+
+int main(int argc, char **argv)
+{
+    trace_filter_t filter;
+    const char *names[2];
+    int num_names = 0;
+    int do_diff = 0;
+    int context = DEFAULT_CONTEXT;
+    uint64_t count = UINT64_MAX;
+    int i, n;
+
+    memset(&filter, 0, sizeof(filter));
+    filter.cpu = -1;
+    filter.to = UINT64_MAX;
+    filter.pc_to = 0xffff;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "-help")) {
+            usage();
+            return 0;
+        } else if (!strcmp(argv[i], "-diff")) {
+            do_diff = 1;
+        } else if (!strcmp(argv[i], "-noaccess")) {
+            show_accesses = 0;
+        } else if (!strcmp(argv[i], "-relative")) {
+            filter.relative = 1;
+        } else if (!strcmp(argv[i], "-cpu") && i + 1 < argc) {
+            n = atoi(argv[++i]);
+            filter.cpu = (n >= 8) ? n - 7 : n;
+        } else if (!strcmp(argv[i], "-from") && i + 1 < argc) {
+            filter.from = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-to") && i + 1 < argc) {
+            filter.to = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-count") && i + 1 < argc) {
+            count = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-context") && i + 1 < argc) {
+            context = atoi(argv[++i]);
+            if (context < 0) {
+                context = 0;
+            }
+        } else if (!strcmp(argv[i], "-pc") && i + 1 < argc) {
+            i++;
+            if (sscanf(argv[i], "%x-%x", &filter.pc_from, &filter.pc_to) < 2) {
+                filter.pc_to = filter.pc_from;
+            }
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            usage();
+            return 2;
+        } else if (num_names < 2) {
+            names[num_names++] = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    if (num_names != (do_diff ? 2 : 1)) {
+        usage();
+        return 2;
+    }
+    if (do_diff) {
+        return diff(names[0], names[1], &filter, count, context);
+    }
+    return decode(names[0], &filter, count);
+}
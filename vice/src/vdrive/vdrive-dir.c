@@ -54,6 +54,7 @@
 #include "types.h"
 #include "vdrive-bam.h"
 #include "vdrive-dir.h"
+#include "vdrive-dirindex.h"
 #include "vdrive-iec.h"
 #include "vdrive-rel.h"
 #include "vdrive.h"
@@ -226,6 +227,10 @@ void vdrive_dir_find_first_slot(vdrive_t *vdrive, const uint8_t *name,
     dir->find_length = length;
     dir->find_type = type;
 
+    /* names without wildcards can be looked up in the index */
+    dir->find_indexed = length > 0 && vdrive_dirindex_usable(dir->find_nslot);
+    dir->find_pos = 0;
+
     dir->track = vdrive->Header_Track;
     dir->sector = vdrive->Header_Sector;
     dir->slot = 7;
@@ -275,6 +280,26 @@ uint8_t *vdrive_dir_find_next_slot(vdrive_dir_context_t *dir)
     log_debug("DIR: vdrive_dir_find_next_slot start (t:%u/s:%u) #%u",
             dir->track, dir->sector, dir->slot);
 #endif
+    while (dir->find_indexed) {
+        int found = vdrive_dirindex_find_next(dir);
+
+        if (found < 0) {
+            /* walk the chain from the last match on */
+            dir->find_indexed = 0;
+            break;
+        }
+        if (!found) {
+            return NULL;
+        }
+        memcpy(return_slot, &dir->buffer[dir->slot * 32], 32);
+        t = date_to_int(return_slot[SLOT_GEOS_YEAR], return_slot[SLOT_GEOS_MONTH],
+            return_slot[SLOT_GEOS_DATE], return_slot[SLOT_GEOS_HOUR],
+            return_slot[SLOT_GEOS_MINUTE] );
+        if (t >= dir->time_low && t <= dir->time_high) {
+            return return_slot;
+        }
+    }
+
     /*
      * Loop all directory blocks starting from track 18, sector 1 (1541).
      */
@@ -865,6 +890,7 @@ void vdrive_dir_part_find_first_slot(vdrive_t *vdrive, const uint8_t *name,
     dir->vdrive = vdrive;
     dir->find_length = length;
     dir->find_type = type;
+    dir->find_indexed = 0;
 
     dir->track = 1;
     dir->sector = 0;
@@ -71,6 +71,8 @@ typedef struct vdrive_dir_context_s {
     unsigned int sector;
     unsigned int time_low;
     unsigned int time_high;
+    int find_indexed;      /* name is looked up in the directory index */
+    unsigned int find_pos; /* index position after the last match */
     struct vdrive_s *vdrive;
 } vdrive_dir_context_t;
 
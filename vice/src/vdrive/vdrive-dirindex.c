@@ -0,0 +1,507 @@
+/*
+ * vdrive-dirindex.c - Virtual disk-drive implementation.
+ *                     Directory index for file name lookups.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Finding a file by name means walking the directory sector chain, so on
+ * images with large directories (D81, DNP, CMD partitions) every OPEN, LOAD,
+ * SCRATCH or RENAME gets slower the more files there are.
+ *
+ * The index maps hashes of the file names to their position in the directory
+ * and is used for names without wildcards.  It is built on the first lookup
+ * in a directory and updated whenever a directory sector is written through
+ * vdrive_write_sector().  Each directory entry found through the index is
+ * read from disk and compared before it is returned; if it doesn't match
+ * the index is dropped and the lookup falls back to walking the chain.
+ */
+
+#include "vice.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cbmdos.h"
+#include "diskimage.h"
+#include "lib.h"
+#include "types.h"
+#include "vdrive-dir.h"
+#include "vdrive-dirindex.h"
+#include "vdrive.h"
+
+/* Position of a removed entry */
+#define DIRINDEX_DEAD       0xffffffffU
+
+/* Upper limit of the number of directory sectors, to catch loops */
+#define DIRINDEX_MAX_SECTORS 0x10000
+
+typedef struct dirindex_sector_s {
+    uint8_t track;
+    uint8_t sector;
+    uint8_t next_track;         /* link as last seen on disk */
+    uint8_t next_sector;
+} dirindex_sector_t;
+
+typedef struct dirindex_entry_s {
+    uint32_t hash;              /* hash of the file name */
+    uint32_t pos;               /* directory sector number * 8 + slot */
+    int next;                   /* next entry in the same bucket, -1 if none */
+} dirindex_entry_t;
+
+typedef struct vdrive_dirindex_s {
+    /* the directory this index is for */
+    struct disk_image_s *image;
+    unsigned int offset;
+    unsigned int header_track;
+    unsigned int header_sector;
+    unsigned int dir_track;
+    unsigned int dir_sector;
+    unsigned int format;
+    unsigned long stamp;        /* last use, for replacing the oldest index */
+
+    dirindex_sector_t *sectors; /* directory sectors in chain order */
+    unsigned int num_sectors;
+    unsigned int max_sectors;
+    int *sector_hash;           /* track/sector -> directory sector number */
+    unsigned int sector_hash_size;
+
+    dirindex_entry_t *entries;
+    unsigned int num_entries;
+    unsigned int max_entries;
+    unsigned int num_dead;
+    int *buckets;               /* first entry for each hash value */
+    unsigned int num_buckets;
+} vdrive_dirindex_t;
+
+static unsigned long dirindex_stamp = 0;
+
+/* Hash the part of a file name the wildcard compare looks at, i.e. up to the
+   first shifted space.  */
+static uint32_t dirindex_name_hash(const uint8_t *name)
+{
+    uint32_t hash = 0x811c9dc5U;
+    int i;
+
+    for (i = 0; i < CBMDOS_SLOT_NAME_LENGTH && name[i] != 0xa0; i++) {
+        hash = (hash ^ name[i]) * 0x01000193U;
+    }
+    return hash;
+}
+
+static unsigned int dirindex_sector_key(unsigned int track, unsigned int sector)
+{
+    return ((track << 8) | sector) * 0x9e3779b1U;
+}
+
+static int dirindex_find_sector(const vdrive_dirindex_t *idx, unsigned int track,
+                                unsigned int sector)
+{
+    unsigned int mask = idx->sector_hash_size - 1;
+    unsigned int i = dirindex_sector_key(track, sector) & mask;
+    int n;
+
+    while ((n = idx->sector_hash[i]) >= 0) {
+        if (idx->sectors[n].track == track && idx->sectors[n].sector == sector) {
+            return n;
+        }
+        i = (i + 1) & mask;
+    }
+    return -1;
+}
+
+static void dirindex_hash_sector(vdrive_dirindex_t *idx, int n)
+{
+    unsigned int mask = idx->sector_hash_size - 1;
+    unsigned int i = dirindex_sector_key(idx->sectors[n].track, idx->sectors[n].sector) & mask;
+
+    while (idx->sector_hash[i] >= 0) {
+        i = (i + 1) & mask;
+    }
+    idx->sector_hash[i] = n;
+}
+
+/* Append a sector to the directory chain, returns its number */
+static int dirindex_add_sector(vdrive_dirindex_t *idx, unsigned int track, unsigned int sector,
+                               unsigned int next_track, unsigned int next_sector)
+{
+    unsigned int i;
+    int n = (int)idx->num_sectors;
+
+    if (idx->num_sectors == idx->max_sectors) {
+        idx->max_sectors *= 2;
+        idx->sectors = lib_realloc(idx->sectors, idx->max_sectors * sizeof(dirindex_sector_t));
+    }
+    idx->sectors[n].track = (uint8_t)track;
+    idx->sectors[n].sector = (uint8_t)sector;
+    idx->sectors[n].next_track = (uint8_t)next_track;
+    idx->sectors[n].next_sector = (uint8_t)next_sector;
+    idx->num_sectors++;
+
+    /* keep the sector hash at most half full */
+    if (idx->num_sectors * 2 > idx->sector_hash_size) {
+        idx->sector_hash_size *= 2;
+        idx->sector_hash = lib_realloc(idx->sector_hash, idx->sector_hash_size * sizeof(int));
+        for (i = 0; i < idx->sector_hash_size; i++) {
+            idx->sector_hash[i] = -1;
+        }
+        for (i = 0; i < idx->num_sectors; i++) {
+            dirindex_hash_sector(idx, (int)i);
+        }
+    } else {
+        dirindex_hash_sector(idx, n);
+    }
+    return n;
+}
+
+static void dirindex_add_entry(vdrive_dirindex_t *idx, uint32_t hash, uint32_t pos)
+{
+    dirindex_entry_t *e;
+    unsigned int i;
+
+    if (idx->num_entries == idx->max_entries) {
+        idx->max_entries *= 2;
+        idx->entries = lib_realloc(idx->entries, idx->max_entries * sizeof(dirindex_entry_t));
+    }
+
+    /* keep the chains short */
+    if (idx->num_entries >= idx->num_buckets * 2) {
+        idx->num_buckets *= 2;
+        idx->buckets = lib_realloc(idx->buckets, idx->num_buckets * sizeof(int));
+        for (i = 0; i < idx->num_buckets; i++) {
+            idx->buckets[i] = -1;
+        }
+        for (i = 0; i < idx->num_entries; i++) {
+            e = &idx->entries[i];
+            e->next = idx->buckets[e->hash & (idx->num_buckets - 1)];
+            idx->buckets[e->hash & (idx->num_buckets - 1)] = (int)i;
+        }
+    }
+
+    e = &idx->entries[idx->num_entries];
+    e->hash = hash;
+    e->pos = pos;
+    e->next = idx->buckets[hash & (idx->num_buckets - 1)];
+    idx->buckets[hash & (idx->num_buckets - 1)] = (int)idx->num_entries;
+    idx->num_entries++;
+}
+
+/* Add the used slots of directory sector `n' */
+static void dirindex_add_slots(vdrive_dirindex_t *idx, int n, const uint8_t *buf)
+{
+    unsigned int slot;
+
+    for (slot = 0; slot < 8; slot++) {
+        const uint8_t *p = &buf[slot * SLOT_SIZE];
+
+        if (p[SLOT_TYPE_OFFSET]) {
+            dirindex_add_entry(idx, dirindex_name_hash(&p[SLOT_NAME_OFFSET]),
+                               (uint32_t)n * 8 + slot);
+        }
+    }
+}
+
+static void dirindex_free(vdrive_dirindex_t *idx)
+{
+    lib_free(idx->sectors);
+    lib_free(idx->sector_hash);
+    lib_free(idx->entries);
+    lib_free(idx->buckets);
+    lib_free(idx);
+}
+
+static int dirindex_is_current(const vdrive_dirindex_t *idx, const vdrive_t *vdrive)
+{
+    return idx->image == vdrive->image
+           && idx->offset == vdrive->current_offset
+           && idx->format == vdrive->image_format
+           && idx->header_track == vdrive->Header_Track
+           && idx->header_sector == vdrive->Header_Sector
+           && idx->dir_track == vdrive->Dir_Track
+           && idx->dir_sector == vdrive->Dir_Sector;
+}
+
+/* Walk the directory chain the same way vdrive_dir_find_next_slot() does */
+static vdrive_dirindex_t *dirindex_build(vdrive_t *vdrive)
+{
+    vdrive_dirindex_t *idx;
+    uint8_t buf[256];
+    unsigned int t, s;
+    unsigned int i;
+    int n;
+
+    if (vdrive_read_sector(vdrive, buf, vdrive->Header_Track, vdrive->Header_Sector) != 0) {
+        return NULL;
+    }
+    if (vdrive->image_format != VDRIVE_IMAGE_FORMAT_NP) {
+        t = vdrive->Dir_Track;
+        s = vdrive->Dir_Sector;
+    } else {
+        t = buf[0];
+        s = buf[1];
+    }
+
+    idx = lib_calloc(1, sizeof(vdrive_dirindex_t));
+    idx->image = vdrive->image;
+    idx->offset = vdrive->current_offset;
+    idx->format = vdrive->image_format;
+    idx->header_track = vdrive->Header_Track;
+    idx->header_sector = vdrive->Header_Sector;
+    idx->dir_track = vdrive->Dir_Track;
+    idx->dir_sector = vdrive->Dir_Sector;
+
+    idx->max_sectors = 16;
+    idx->sectors = lib_malloc(idx->max_sectors * sizeof(dirindex_sector_t));
+    idx->sector_hash_size = 32;
+    idx->sector_hash = lib_malloc(idx->sector_hash_size * sizeof(int));
+    for (i = 0; i < idx->sector_hash_size; i++) {
+        idx->sector_hash[i] = -1;
+    }
+    idx->max_entries = 128;
+    idx->entries = lib_malloc(idx->max_entries * sizeof(dirindex_entry_t));
+    idx->num_buckets = 64;
+    idx->buckets = lib_malloc(idx->num_buckets * sizeof(int));
+    for (i = 0; i < idx->num_buckets; i++) {
+        idx->buckets[i] = -1;
+    }
+
+    while (t != 0) {
+        /* give up on loops and unreadable sectors, the caller walks the
+           chain itself then */
+        if (t > 255 || s > 255
+            || idx->num_sectors >= DIRINDEX_MAX_SECTORS
+            || dirindex_find_sector(idx, t, s) >= 0
+            || vdrive_read_sector(vdrive, buf, t, s) != 0) {
+            dirindex_free(idx);
+            return NULL;
+        }
+        n = dirindex_add_sector(idx, t, s, buf[0], buf[1]);
+        dirindex_add_slots(idx, n, buf);
+        t = buf[0];
+        s = buf[1];
+    }
+    return idx;
+}
+
+/* Get the index of the current directory, building it if `build' is set */
+static vdrive_dirindex_t *dirindex_get(vdrive_t *vdrive, int build)
+{
+    vdrive_dirindex_t *idx;
+    int i, victim = 0;
+
+    for (i = 0; i < VDRIVE_DIRINDEX_MAX; i++) {
+        idx = vdrive->dirindex[i];
+        if (idx != NULL && dirindex_is_current(idx, vdrive)) {
+            idx->stamp = ++dirindex_stamp;
+            return idx;
+        }
+    }
+    if (!build || vdrive->image == NULL) {
+        return NULL;
+    }
+
+    /* replace an unused or the least recently used index */
+    for (i = 0; i < VDRIVE_DIRINDEX_MAX; i++) {
+        if (vdrive->dirindex[i] == NULL) {
+            victim = i;
+            break;
+        }
+        if (vdrive->dirindex[i]->stamp < vdrive->dirindex[victim]->stamp) {
+            victim = i;
+        }
+    }
+    idx = dirindex_build(vdrive);
+    if (idx == NULL) {
+        return NULL;
+    }
+    if (vdrive->dirindex[victim] != NULL) {
+        dirindex_free(vdrive->dirindex[victim]);
+    }
+    vdrive->dirindex[victim] = idx;
+    idx->stamp = ++dirindex_stamp;
+    return idx;
+}
+
+static void dirindex_drop(vdrive_t *vdrive, vdrive_dirindex_t *idx)
+{
+    int i;
+
+    for (i = 0; i < VDRIVE_DIRINDEX_MAX; i++) {
+        if (vdrive->dirindex[i] == idx) {
+            vdrive->dirindex[i] = NULL;
+        }
+    }
+    dirindex_free(idx);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Returns non-zero if a search for the name in `nslot' can use the index,
+   i.e. the name has no wildcards.  */
+int vdrive_dirindex_usable(const uint8_t *nslot)
+{
+    int i;
+
+    for (i = 0; i < CBMDOS_SLOT_NAME_LENGTH && nslot[i] != 0xa0; i++) {
+        if (nslot[i] == '*' || nslot[i] == '?') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Find the next directory entry matching the name and type of `dir' after
+   the one found last.  On a match the directory sector is read into the
+   context like vdrive_dir_find_next_slot() does.
+   Returns 1 when found, 0 when there is no (further) match and -1 when the
+   index cannot be used, the context is unchanged then.  */
+int vdrive_dirindex_find_next(vdrive_dir_context_t *dir)
+{
+    vdrive_t *vdrive = dir->vdrive;
+    vdrive_dirindex_t *idx;
+    uint8_t buf[256];
+    uint32_t hash, after, best;
+    const uint8_t *p;
+    int e;
+
+    idx = dirindex_get(vdrive, 1);
+    if (idx == NULL) {
+        return -1;
+    }
+
+    hash = dirindex_name_hash(dir->find_nslot);
+    after = dir->find_pos;  /* first position to consider */
+
+    while (1) {
+        /* the entries of a bucket are not in directory order */
+        best = DIRINDEX_DEAD;
+        for (e = idx->buckets[hash & (idx->num_buckets - 1)]; e >= 0; e = idx->entries[e].next) {
+            const dirindex_entry_t *entry = &idx->entries[e];
+
+            if (entry->hash == hash && entry->pos != DIRINDEX_DEAD
+                && entry->pos >= after && entry->pos < best) {
+                best = entry->pos;
+            }
+        }
+        if (best == DIRINDEX_DEAD) {
+            return 0;
+        }
+
+        if (vdrive_read_sector(vdrive, buf, idx->sectors[best >> 3].track,
+                               idx->sectors[best >> 3].sector) != 0) {
+            return -1;
+        }
+        p = &buf[(best & 7) * SLOT_SIZE];
+        if (!p[SLOT_TYPE_OFFSET]
+            || !cbmdos_parse_wildcard_compare(dir->find_nslot, &p[SLOT_NAME_OFFSET])) {
+            /* out of date, somebody wrote to the image behind our back */
+            dirindex_drop(vdrive, idx);
+            return -1;
+        }
+        if (dir->find_type == CBMDOS_FT_DEL || dir->find_type == (p[SLOT_TYPE_OFFSET] & 0x07u)) {
+            break;
+        }
+        after = best + 1;
+    }
+
+    memcpy(dir->buffer, buf, 256);
+    dir->track = idx->sectors[best >> 3].track;
+    dir->sector = idx->sectors[best >> 3].sector;
+    dir->slot = best & 7;
+    dir->find_pos = best + 1;
+    return 1;
+}
+
+/* Keep the indexes up to date with a sector written to the current
+   partition.  */
+void vdrive_dirindex_sector_written(vdrive_t *vdrive, const uint8_t *buf,
+                                    unsigned int track, unsigned int sector)
+{
+    vdrive_dirindex_t *idx;
+    dirindex_sector_t *ds;
+    unsigned int i;
+    int j, n;
+
+    for (j = 0; j < VDRIVE_DIRINDEX_MAX; j++) {
+        idx = vdrive->dirindex[j];
+        /* subdirectories share the sectors of their partition */
+        if (idx == NULL || idx->image != vdrive->image || idx->offset != vdrive->current_offset) {
+            continue;
+        }
+
+        /* the header of an NP directory holds the link to the first sector */
+        if (idx->format == VDRIVE_IMAGE_FORMAT_NP
+            && track == idx->header_track && sector == idx->header_sector) {
+            if (idx->num_sectors == 0
+                ? buf[0] != 0
+                : (buf[0] != idx->sectors[0].track || buf[1] != idx->sectors[0].sector)) {
+                dirindex_drop(vdrive, idx);
+            }
+            continue;
+        }
+
+        n = dirindex_find_sector(idx, track, sector);
+        if (n < 0) {
+            continue;
+        }
+
+        for (i = 0; i < idx->num_entries; i++) {
+            if (idx->entries[i].pos != DIRINDEX_DEAD && (idx->entries[i].pos >> 3) == (uint32_t)n) {
+                idx->entries[i].pos = DIRINDEX_DEAD;
+                idx->num_dead++;
+            }
+        }
+        dirindex_add_slots(idx, n, buf);
+
+        ds = &idx->sectors[n];
+        if (buf[0] != ds->next_track || (buf[0] != 0 && buf[1] != ds->next_sector)) {
+            /* a new sector linked to the end of the chain is fine, anything
+               else is rebuilt on the next lookup */
+            if (ds->next_track == 0 && n == (int)idx->num_sectors - 1
+                && dirindex_find_sector(idx, buf[0], buf[1]) < 0) {
+                ds->next_track = buf[0];
+                ds->next_sector = buf[1];
+                dirindex_add_sector(idx, buf[0], buf[1], 0, 0xff);
+            } else {
+                dirindex_drop(vdrive, idx);
+                continue;
+            }
+        }
+
+        if (idx->num_dead > idx->num_entries / 2 + 64) {
+            dirindex_drop(vdrive, idx);
+        }
+    }
+}
+
+/* Forget all indexes, used when the image changes in a way the index can't
+   follow.  */
+void vdrive_dirindex_invalidate(vdrive_t *vdrive)
+{
+    int i;
+
+    for (i = 0; i < VDRIVE_DIRINDEX_MAX; i++) {
+        if (vdrive->dirindex[i] != NULL) {
+            dirindex_free(vdrive->dirindex[i]);
+            vdrive->dirindex[i] = NULL;
+        }
+    }
+}
@@ -0,0 +1,43 @@
+/*
+ * vdrive-dirindex.h - Virtual disk-drive implementation.
+ *                     Directory index for file name lookups.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_VDRIVE_DIRINDEX_H
+#define VICE_VDRIVE_DIRINDEX_H
+
+#include "types.h"
+
+struct vdrive_s;
+struct vdrive_dir_context_s;
+
+/* Number of directories (images, partitions, subdirectories) indexed per drive */
+#define VDRIVE_DIRINDEX_MAX     4
+
+int vdrive_dirindex_usable(const uint8_t *nslot);
+int vdrive_dirindex_find_next(struct vdrive_dir_context_s *dir);
+
+void vdrive_dirindex_sector_written(struct vdrive_s *vdrive, const uint8_t *buf,
+                                    unsigned int track, unsigned int sector);
+void vdrive_dirindex_invalidate(struct vdrive_s *vdrive);
+
+#endif
@@ -162,6 +162,8 @@ int vdrive_device_setup(vdrive_t *vdrive, unsigned int unit)
     vdrive->dir_part = 0;
     vdrive->last_code = CBMDOS_IPE_OK;
 
+    vdrive_dirindex_invalidate(vdrive);
+
     return 0;
 }
 
@@ -177,6 +179,7 @@ void vdrive_device_shutdown(vdrive_t *vdrive)
             vdrive_free_buffer(p);
             lib_free(p->buffer);
         }
+        vdrive_dirindex_invalidate(vdrive);
     }
 }
 
@@ -198,6 +201,9 @@ log_debug("VDRIVE: refresh unit %u", unit);
 
     vdrive_bam_setup_bam(vdrive);
 
+    /* the image may have been changed by the true drive emulation */
+    vdrive_dirindex_invalidate(vdrive);
+
     vdrive->current_offset = 0;
     vdrive->sys_offset = UINT32_MAX;
     vdrive->image = NULL;
@@ -349,6 +355,8 @@ void vdrive_detach_image(disk_image_t *image, unsigned int unit,
 
     disk_image_detach_log(image, vdrive_log, unit, drive);
 
+    vdrive_dirindex_invalidate(vdrive);
+
     /* shutdown everything on that drive */
     if (vdrive->haspt) {
         vdrive_close_all_channels(vdrive);
@@ -422,6 +430,8 @@ int vdrive_attach_image(disk_image_t *image, unsigned int unit,
 
     disk_image_attach_log(image, vdrive_log, unit, drive);
 
+    vdrive_dirindex_invalidate(vdrive);
+
     /* fix the number of tracks here as extended tracks aren't supported */
     switch (image->type) {
         case DISK_IMAGE_TYPE_D64:
@@ -989,6 +999,9 @@ int vdrive_write_sector(vdrive_t *vdrive, const uint8_t *buf, unsigned int track
     ui_display_drive_track(vdrive->unit - 8, 0, dadr.track * 2);
 #endif
     ret = disk_image_write_sector(vdrive->image, buf, &dadr);
+    if (ret == 0) {
+        vdrive_dirindex_sector_written(vdrive, buf, track, sector);
+    }
 
 #ifdef DEBUG_DRIVE
     log_debug("VDRIVE: write_sector %u %u = %d", dadr.track, dadr.sector, ret);
@@ -1010,6 +1023,7 @@ int vdrive_write_sector_physical(vdrive_t *vdrive, const uint8_t *buf, unsigned
     disk_addr_t dadr;
     dadr.track = track;
     dadr.sector = sector;
+    vdrive_dirindex_invalidate(vdrive);
     return disk_image_write_sector(vdrive->image, buf, &dadr);
 }
 
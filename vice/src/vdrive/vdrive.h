@@ -32,6 +32,7 @@
 
 #include "types.h"
 #include "vdrive-dir.h"
+#include "vdrive-dirindex.h"
 
 #define NUM_DRIVES              2
 
@@ -185,6 +186,7 @@ typedef struct vdrive_s {
 
     unsigned int bam_size;
     uint8_t *bam;              /* Disk header blk (if any) followed by BAM blocks */
+    struct vdrive_dirindex_s *dirindex[VDRIVE_DIRINDEX_MAX]; /* directory name indexes */
     bufferinfo_t buffers[16];
 
     /* Memory read command buffer.  */
@@ -289,6 +289,7 @@ static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
     while (current) {
         if (current->device->read != NULL) {
             if ((addr >= current->device->start_address) && (addr <= current->device->end_address)) {
+                PERFCOUNTERS_NAMED_INC(current->perf, 0);
                 retval = current->device->read((uint16_t)(addr & (current->device->address_mask & 0x3ff)));
                 if (current->device->io_source_valid) {
                     if (current->device->io_source_prio == 1) {
@@ -387,6 +388,7 @@ static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value
     while (current) {
         if (current->device->store != NULL) {
             if (addr >= current->device->start_address && addr <= current->device->end_address) {
+                PERFCOUNTERS_NAMED_INC(current->perf, 1);
                 current->device->store((uint16_t)(addr & (current->device->address_mask & 0x3ff)), value);
             }
         }
@@ -430,6 +432,9 @@ io_source_list_t *io_source_register(io_source_t *device)
     current->next = retval;
     retval->previous = current;
     retval->device = device;
+#ifdef FEATURE_PERFCOUNTERS
+    retval->perf = perfcounters_named_get(PERFCOUNTERS_KIND_IO, device->name);
+#endif
     retval->next = NULL;
     retval->device->order = order++;
 
@@ -143,6 +143,14 @@
 #define VICE_ATTR_RESPRINTF
 #endif
 
+/* keeps a rarely called function out of a hot caller, whose register saving
+   would otherwise grow with it */
+#if defined(__GNUC__)
+#define VICE_ATTR_NOINLINE  __attribute__((noinline))
+#else
+#define VICE_ATTR_NOINLINE
+#endif
+
 /* M_PI is non-standard, so in order for -std=c99 to work we define it here */
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
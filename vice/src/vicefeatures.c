@@ -64,6 +64,13 @@ static const feature_list_t featurelist[] = {
 #else
         1 },
 #endif
+/* (all) */
+    { "FEATURE_PERFCOUNTERS", "Count hot-path events for the binary monitor.",
+#ifndef FEATURE_PERFCOUNTERS
+        0 },
+#else
+        1 },
+#endif
 #ifdef MACOS_COMPILE /* (osx) */
     { "HAS_HIDMGR", "Enable Mac IOHIDManager Joystick driver.",
 #ifndef HAS_HIDMGR
@@ -417,8 +417,8 @@ static void init_drawing_tables(void)
         uint32_t __m;                                               \
         int __p;                                                 \
                                                                  \
-        for (__m = 1 << ((size) - 1), __p = 0;                   \
-             __p < (size);                                       \
+        for (__m = 1U << ((size) - 1), __p = 0;                  \
+             __p < (size) && ((msk) & ((__m << 1) - 1));         \
              __p++, __m >>= 1) {                                 \
             if ((msk) & __m) {                                   \
                 if ((gfxmsk) & __m) {                            \
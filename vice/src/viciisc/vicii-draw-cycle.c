@@ -141,6 +141,34 @@ static const uint8_t colors[] = {
     COL_NONE, COL_NONE, COL_NONE, COL_NONE          /* ECM=1 BMM=1 MCM=1 */
 };
 
+/* resolve the pixel sources that do not refer to a color register */
+static DRAW_INLINE uint8_t resolve_graphics_color(uint8_t cc, uint8_t vbuf, uint8_t cbuf)
+{
+    switch (cc) {
+        case COL_NONE:
+            cc = 0;
+            break;
+        case COL_VBUF_L:
+            cc = vbuf & 0x0f;
+            break;
+        case COL_VBUF_H:
+            cc = vbuf >> 4;
+            break;
+        case COL_CBUF:
+            cc = cbuf;
+            break;
+        case COL_CBUF_MC:
+            cc = cbuf & 0x07;
+            break;
+        case COL_D02X_EXT:
+            cc = COL_D021 + (vbuf >> 6);
+            break;
+        default:
+            break;
+    }
+    return cc;
+}
+
 static DRAW_INLINE void draw_graphics(int i)
 {
     uint8_t px;
@@ -197,39 +225,125 @@ static DRAW_INLINE void draw_graphics(int i)
     cc = colors[vmode | px];
 
     /* lookup colors and render pixel */
-    switch (cc) {
-        case COL_NONE:
-            cc = 0;
-            break;
-        case COL_VBUF_L:
-            cc = vbuf_reg & 0x0f;
-            break;
-        case COL_VBUF_H:
-            cc = vbuf_reg >> 4;
-            break;
-        case COL_CBUF:
-            cc = cbuf_reg;
-            break;
-        case COL_CBUF_MC:
-            cc = cbuf_reg & 0x07;
-            break;
-        case COL_D02X_EXT:
-            cc = COL_D021 + (vbuf_reg >> 6);
-            break;
-        default:
-            break;
-    }
+    cc = resolve_graphics_color(cc, vbuf_reg, cbuf_reg);
 
     render_buffer[i] = cc;
     pri_buffer[i] = pixel_pri;
 }
 
-static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
+/*
+ * Word at a time rendering.
+ *
+ * As long as none of the mode bits change in the middle of a cycle, the
+ * eight pixels of a cycle are a function of the gbuf byte(s) shifted out and
+ * the vbuf/cbuf values that go with them.  The pixel values (0-3) for a gbuf
+ * byte are precomputed, one byte per pixel in memory order, and turned into
+ * colors for all eight pixels at once.  Cycles with mid cycle mode changes
+ * fall back to draw_graphics().
+ */
+
+/* pixel values of a gbuf byte in hires and multicolor mode */
+static uint64_t gbuf_hires_pixels[0x100];
+static uint64_t gbuf_mc_pixels[0x100];
+
+#define PIXELS_EACH(v) ((uint64_t)(v) * 0x0101010101010101ULL)
+
+/* move pixels n positions to the right, and get/set pixel n of a word */
+#ifdef WORDS_BIGENDIAN
+#define PIXELS_SHIFT(x, n) ((x) >> (8 * (n)))
+#define PIXEL_GET(x, n)    ((uint8_t)((x) >> (8 * (7 - (n)))))
+#define PIXEL_SET(v, n)    ((uint64_t)(v) << (8 * (7 - (n))))
+#else
+#define PIXELS_SHIFT(x, n) ((x) << (8 * (n)))
+#define PIXEL_GET(x, n)    ((uint8_t)((x) >> (8 * (n))))
+#define PIXEL_SET(v, n)    ((uint64_t)(v) << (8 * (n)))
+#endif
+
+static void init_graphics_pixels(void)
 {
-    int vis_en;
+    int b, i;
+    uint8_t hires[8];
+    uint8_t mc[8];
+
+    for (b = 0; b < 0x100; b++) {
+        for (i = 0; i < 8; i++) {
+            hires[i] = (b & (0x80 >> i)) ? 3 : 0;
+            mc[i] = (b >> (6 - (i & ~1))) & 3;
+        }
+        memcpy(&gbuf_hires_pixels[b], hires, 8);
+        memcpy(&gbuf_mc_pixels[b], mc, 8);
+    }
+}
 
-    vis_en = cycle_is_visible(cycle_flags);
+/* pixel values of a gbuf byte with the current mode, see draw_graphics() */
+static DRAW_INLINE uint64_t graphics_pixels8(uint8_t gbuf, uint8_t cbuf)
+{
+    if ((vmode11_pipe & 0x08) || (cbuf & 0x08)) {
+        if (vmode16_pipe2) {
+            return gbuf_mc_pixels[gbuf];
+        }
+        return gbuf_hires_pixels[gbuf] & PIXELS_EACH(0x02);
+    }
+    return gbuf_hires_pixels[gbuf];
+}
+
+/* colors for eight pixel values */
+static DRAW_INLINE uint64_t graphics_colors8(uint64_t px8, uint8_t vmode, uint8_t vbuf, uint8_t cbuf)
+{
+    uint64_t c0 = PIXELS_EACH(resolve_graphics_color(colors[vmode | 0], vbuf, cbuf));
+    uint64_t c1 = PIXELS_EACH(resolve_graphics_color(colors[vmode | 1], vbuf, cbuf));
+    uint64_t c2 = PIXELS_EACH(resolve_graphics_color(colors[vmode | 2], vbuf, cbuf));
+    uint64_t c3 = PIXELS_EACH(resolve_graphics_color(colors[vmode | 3], vbuf, cbuf));
+    uint64_t sel0 = (px8 & PIXELS_EACH(0x01)) * 0xff;
+    uint64_t sel1 = ((px8 >> 1) & PIXELS_EACH(0x01)) * 0xff;
+    uint64_t lo = c0 ^ (sel0 & (c0 ^ c1));
+    uint64_t hi = c2 ^ (sel0 & (c2 ^ c3));
+
+    return lo ^ (sel1 & (lo ^ hi));
+}
+
+/* draw_graphics() for pixels 0-7 when no mode bits change during the cycle */
+static DRAW_INLINE void draw_graphics8_steady(void)
+{
+    uint8_t vmode = vmode11_pipe | vmode16_pipe;
+    int xs = xscroll_pipe;
+    uint64_t px8, gfx8, px_old, mask;
+
+    /* pixels xs-7 come from the values latched at xs */
+    px8 = PIXELS_SHIFT(graphics_pixels8(gbuf_pipe1_reg, cbuf_pipe1_reg), xs);
+    gfx8 = graphics_colors8(px8, vmode, vbuf_pipe1_reg, cbuf_pipe1_reg);
+
+    /* pixels 0-(xs-1) are what is left of the previous values */
+    if (xs) {
+        if (vmode16_pipe2 && !gbuf_mc_flop
+            && ((vmode11_pipe & 0x08) || (cbuf_reg & 0x08))) {
+            /* in the middle of a mc pixel */
+            px_old = PIXELS_SHIFT(gbuf_mc_pixels[(uint8_t)(gbuf_reg << 1)], 1)
+                     | PIXEL_SET(gbuf_pixel_reg, 0);
+        } else {
+            px_old = graphics_pixels8(gbuf_reg, cbuf_reg);
+        }
+        mask = PIXELS_SHIFT(~(uint64_t)0, xs);
+        px8 |= px_old & ~mask;
+        gfx8 = (gfx8 & mask)
+               | (graphics_colors8(px_old, vmode, vbuf_reg, cbuf_reg) & ~mask);
+    }
+
+    /* leave the state as 8 calls to draw_graphics() would */
+    gbuf_pixel_reg = PIXEL_GET(px8, 7);
+    vbuf_reg = vbuf_pipe1_reg;
+    cbuf_reg = cbuf_pipe1_reg;
+    gbuf_reg = (uint8_t)(gbuf_pipe1_reg << (8 - xs));
+    gbuf_mc_flop = (xs & 1) ^ 1;
+
+    memcpy(render_buffer, &gfx8, 8);
+    px8 &= PIXELS_EACH(0x02);
+    memcpy(pri_buffer, &px8, 8);
+}
 
+/* draw_graphics8() with the mode changes applied at the pixel they happen */
+static DRAW_INLINE void draw_graphics8_pixels(uint8_t vmode16, uint8_t vmode11)
+{
     /* render pixels */
     /* pixel 0 */
     draw_graphics(0);
@@ -240,10 +354,10 @@ static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
     /* pixel 3 */
     draw_graphics(3);
     /* pixel 4 */
-    vmode16_pipe = ( vicii.regs[0x16] & 0x10 ) >> 2;
+    vmode16_pipe = vmode16;
     if (vicii.color_latency) {
         /* handle rising edge of internal signal */
-        vmode11_pipe |= ( vicii.regs[0x11] & 0x60 ) >> 2;
+        vmode11_pipe |= vmode11;
     }
     draw_graphics(4);
     /* pixel 5 */
@@ -251,7 +365,7 @@ static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
     /* pixel 6 */
     if (vicii.color_latency) {
         /* handle falling edge of internal signal */
-        vmode11_pipe &= ( vicii.regs[0x11] & 0x60 ) >> 2;
+        vmode11_pipe &= vmode11;
     }
     draw_graphics(6);
     /* pixel 7 */
@@ -260,9 +374,27 @@ static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
     }
     vmode16_pipe2 = vmode16_pipe;
     draw_graphics(7);
+}
+
+static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
+{
+    int vis_en;
+    uint8_t vmode16, vmode11;
+
+    vis_en = cycle_is_visible(cycle_flags);
+
+    vmode16 = (vicii.regs[0x16] & 0x10) >> 2;
+    vmode11 = (vicii.regs[0x11] & 0x60) >> 2;
+
+    if (vmode16 == vmode16_pipe && vmode16 == vmode16_pipe2
+        && (!vicii.color_latency || vmode11 == vmode11_pipe)) {
+        draw_graphics8_steady();
+    } else {
+        draw_graphics8_pixels(vmode16, vmode11);
+    }
 
     if (!vicii.color_latency) {
-        vmode11_pipe = ( vicii.regs[0x11] & 0x60 ) >> 2;
+        vmode11_pipe = vmode11;
     }
 
     /* shift and put the next data into the pipe. */
@@ -301,6 +433,35 @@ static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
  * SECTION  draw_sprites()
  *
  ******/
+
+/*
+ * Sprites are evaluated one cycle (8 pixels) at a time.  Each sprite that
+ * can produce output during the cycle is run through all 8 pixels in
+ * draw_sprite8(), with its state held in locals and the mid cycle events
+ * (DMA, halt, register latches) applied at the pixel where they happen.
+ * The result is a per pixel bit mask of the sprites that have a pixel set
+ * plus the color of the highest priority one, from which priority and
+ * collisions are resolved for the whole cycle in one go.
+ */
+
+/* per pixel mask of sprites with a non transparent pixel */
+static uint8_t sprite_pixel_mask[8];
+/* pixel value (1-3) and number of the highest priority sprite */
+static uint8_t sprite_pixel_value[8];
+static uint8_t sprite_pixel_num[8];
+
+/* per cycle values that are the same for all sprites */
+typedef struct sprite_cycle_s {
+    int xpos;
+    int spr_en;
+    int dma_sprite;
+    uint8_t dma_cycle_0;
+    uint8_t dma_cycle_2;
+    uint8_t next_pending_bits;
+    uint8_t next_mc_bits;
+    uint8_t next_expx_bits;
+} sprite_cycle_t;
+
 static DRAW_INLINE uint8_t get_trigger_candidates(int xpos)
 {
     int s;
@@ -315,95 +476,165 @@ static DRAW_INLINE uint8_t get_trigger_candidates(int xpos)
     return candidate_bits;
 }
 
-static DRAW_INLINE void trigger_sprites(int xpos, uint8_t candidate_bits)
+static DRAW_INLINE void draw_sprite8(int s, uint8_t candidate_bits, const sprite_cycle_t *sc)
 {
-    int s;
-
-    /* do nothing if no sprites are candidates or pending */
-    if (!candidate_bits || !sprite_pending_bits) {
-        return;
-    }
+    int i;
+    uint8_t m = 1 << s;
+    int active = (sprite_active_bits & m) ? 1 : 0;
+    int halt = (sprite_halt_bits & m) ? 1 : 0;
+    int pending = (sprite_pending_bits & m) ? 1 : 0;
+    int expx_flop = (sbuf_expx_flops & m) ? 1 : 0;
+    int mc_flop = (sbuf_mc_flops & m) ? 1 : 0;
+    int mc = (sprite_mc_bits & m) ? 1 : 0;
+    int expx = (sprite_expx_bits & m) ? 1 : 0;
+    int next_mc = (sc->next_mc_bits & m) ? 1 : 0;
+    int trigger_pixel = (candidate_bits & m) ? sprite_x_pipe[s] - sc->xpos : -1;
+    uint32_t reg = sbuf_reg[s];
+    uint8_t px = sbuf_pixel_reg[s];
 
-    /* check for pending */
-    for (s = 0; s < 8; s++) {
-        uint8_t m = 1 << s;
+    for (i = 0; i < 8; i++) {
+        /* mid cycle events, see draw_sprites8() for the timing */
+        if (i == 2 && (sc->dma_cycle_2 & m)) {
+            active = 0;
+        }
+        if (i == 3 && (sc->dma_cycle_0 & m)) {
+            halt = 1;
+        }
+        if (i == 4) {
+            if (sc->spr_en) {
+                pending = (sc->next_pending_bits & m) ? 1 : 0;
+            }
+            if (sc->dma_cycle_2 & m) {
+                reg = vicii.sprite[s].data;
+            }
+        }
+        if (i == 6) {
+            if (!vicii.color_latency) {
+                /* 8565: toggle the mc flop unless in the middle of an expanded pixel */
+                if ((mc != next_mc) && !expx_flop) {
+                    mc_flop ^= 1;
+                }
+                mc = next_mc;
+            }
+            expx = (sc->next_expx_bits & m) ? 1 : 0;
+        }
+        if (i == 7) {
+            if (vicii.color_latency) {
+                /* 6569: reset the mc flop */
+                if (mc != next_mc) {
+                    mc_flop = 0;
+                }
+                mc = next_mc;
+            }
+            if (sc->dma_cycle_2 & m) {
+                halt = 0;
+            }
+        }
 
         /* start rendering on position match */
-        if ((candidate_bits & m) && (sprite_pending_bits & m) && !(sprite_active_bits & m) && !(sprite_halt_bits & m)) {
-            if (xpos == sprite_x_pipe[s]) {
-                sbuf_expx_flops |= m;
-                sbuf_mc_flops |= m;
-                sprite_active_bits |= m;
+        if (i == trigger_pixel && pending && !active && !halt) {
+            expx_flop = 1;
+            mc_flop = 1;
+            active = 1;
+        }
+
+        if (!active) {
+            continue;
+        }
+
+        /* render pixels if shift register or pixel reg still contains data */
+        if (!(reg || px)) {
+            active = 0;
+            continue;
+        }
+
+        if (!halt) {
+            if (expx_flop) {
+                if (mc) {
+                    if (mc_flop) {
+                        /* fetch 2 bits */
+                        px = (uint8_t)((reg >> 22) & 0x03);
+                    }
+                    mc_flop ^= 1;
+                } else {
+                    /* fetch 1 bit and make it 0 or 2 */
+                    px = (uint8_t)(((reg >> 23) & 0x01) << 1);
+                }
+                /* shift the sprite buffer */
+                reg <<= 1;
             }
+            /* handle expansion flags */
+            expx_flop = expx ? expx_flop ^ 1 : 1;
+        }
+
+        /*
+         * sprites are processed from 7 down to 0 so the last one
+         * written is the highest priority sprite with a pixel.
+         */
+        if (px) {
+            sprite_pixel_mask[i] |= m;
+            sprite_pixel_value[i] = px;
+            sprite_pixel_num[i] = (uint8_t)s;
         }
     }
+
+    sbuf_reg[s] = reg;
+    sbuf_pixel_reg[s] = px;
+    sprite_active_bits = (sprite_active_bits & ~m) | (active ? m : 0);
+    sprite_halt_bits = (sprite_halt_bits & ~m) | (halt ? m : 0);
+    sbuf_expx_flops = (sbuf_expx_flops & ~m) | (expx_flop ? m : 0);
+    sbuf_mc_flops = (sbuf_mc_flops & ~m) | (mc_flop ? m : 0);
 }
 
-static DRAW_INLINE void draw_sprites(int i)
+/*
+ * Apply the cycle's events to the sprites that are neither active nor
+ * about to be triggered.  Those don't draw, so only the flops and
+ * the shift register load need to be updated.
+ */
+static DRAW_INLINE void update_idle_sprites8(uint8_t idle_bits, const sprite_cycle_t *sc)
 {
-    int s;
-    int active_sprite;
-    uint8_t collision_mask;
+    uint8_t toggled = sc->next_mc_bits ^ sprite_mc_bits;
 
-    /* do nothing if all sprites are inactive */
-    if (!sprite_active_bits) {
-        return;
+    sprite_halt_bits = (sprite_halt_bits & ~idle_bits)
+                       | (((sprite_halt_bits | sc->dma_cycle_0) & ~sc->dma_cycle_2) & idle_bits);
+
+    if (sc->dma_cycle_2 & idle_bits) {
+        sbuf_reg[sc->dma_sprite] = vicii.sprite[sc->dma_sprite].data;
     }
 
-    /* check for active sprites */
-    active_sprite = -1;
-    collision_mask = 0;
-    for (s = 7; s >= 0; --s) {
-        uint8_t m = 1 << s;
-
-        if (sprite_active_bits & m) {
-            /* render pixels if shift register or pixel reg still contains data */
-            if (sbuf_reg[s] || sbuf_pixel_reg[s]) {
-                if (!(sprite_halt_bits & m)) {
-                    if (sbuf_expx_flops & m) {
-                        if (sprite_mc_bits & m) {
-                            if (sbuf_mc_flops & m) {
-                                /* fetch 2 bits */
-                                sbuf_pixel_reg[s] = (uint8_t)((sbuf_reg[s] >> 22) & 0x03);
-                            }
-                            sbuf_mc_flops ^= m;
-                        } else {
-                            /* fetch 1 bit and make it 0 or 2 */
-                            sbuf_pixel_reg[s] = (uint8_t)(((sbuf_reg[s] >> 23) & 0x01 ) << 1);
-                        }
-                    }
+    toggled &= idle_bits;
+    if (vicii.color_latency) {
+        /* 6569 */
+        sbuf_mc_flops &= ~toggled;
+    } else {
+        /* 8565 */
+        sbuf_mc_flops ^= toggled & (~sbuf_expx_flops);
+    }
+}
 
-                    /* shift the sprite buffer and handle expansion flags */
-                    if (sbuf_expx_flops & m) {
-                        sbuf_reg[s] <<= 1;
-                    }
-                    if (sprite_expx_bits & m) {
-                        sbuf_expx_flops ^= m;
-                    } else {
-                        sbuf_expx_flops |= m;
-                    }
-                }
+static DRAW_INLINE void resolve_sprites8(uint8_t old_pri_bits)
+{
+    int i;
+    uint8_t bg_collisions = 0;
+    uint8_t spr_collisions = 0;
 
-                /*
-                 * set collision mask bits and determine the highest
-                 * priority sprite number that has a pixel.
-                 */
-                if (sbuf_pixel_reg[s]) {
-                    active_sprite = s;
-                    collision_mask |= m;
-                }
-            } else {
-                sprite_active_bits &= ~m;
-            }
+    for (i = 0; i < 8; i++) {
+        uint8_t collision_mask = sprite_pixel_mask[i];
+        uint8_t pixel_pri;
+        uint8_t spri;
+        int as;
+
+        if (!collision_mask) {
+            continue;
         }
-    }
+        sprite_pixel_mask[i] = 0;
 
-    if (collision_mask) {
-        uint8_t pixel_pri = pri_buffer[i];
-        int as = active_sprite;
-        uint8_t spri = sprite_pri_bits & (1 << as);
+        /* sprite priority latches at pixel 6 */
+        pixel_pri = pri_buffer[i];
+        as = sprite_pixel_num[i];
+        spri = ((i < 6) ? old_pri_bits : sprite_pri_bits) & (1 << as);
         if (!(pixel_pri && spri)) {
-            switch (sbuf_pixel_reg[as]) {
+            switch (sprite_pixel_value[i]) {
                 case 1:
                     render_buffer[i] = COL_D025;
                     break;
@@ -419,41 +650,16 @@ static DRAW_INLINE void draw_sprites(int i)
         }
         /* if there was a foreground pixel, trigger collision */
         if (pixel_pri) {
-            vicii.sprite_background_collisions |= collision_mask;
+            bg_collisions |= collision_mask;
+        }
+        /* if 2 or more bits are set, trigger collisions */
+        if (collision_mask & (collision_mask - 1)) {
+            spr_collisions |= collision_mask;
         }
     }
 
-    /* if 2 or more bits are set, trigger collisions */
-    if (collision_mask & (collision_mask - 1)) {
-        vicii.sprite_sprite_collisions |= collision_mask;
-    }
-}
-
-
-static DRAW_INLINE void update_sprite_mc_bits_6569(void)
-{
-    uint8_t next_mc_bits = vicii.regs[0x1c];
-    uint8_t toggled = next_mc_bits ^ sprite_mc_bits;
-
-    sbuf_mc_flops &= ~toggled;
-    sprite_mc_bits = next_mc_bits;
-}
-
-static DRAW_INLINE void update_sprite_mc_bits_8565(void)
-{
-    uint8_t next_mc_bits = vicii.regs[0x1c];
-    uint8_t toggled = next_mc_bits ^ sprite_mc_bits;
-
-    sbuf_mc_flops ^= toggled & (~sbuf_expx_flops);
-    sprite_mc_bits = next_mc_bits;
-}
-
-static DRAW_INLINE void update_sprite_data(unsigned int cycle_flags)
-{
-    if (cycle_is_sprite_dma1_dma2(cycle_flags)) {
-        int s = cycle_get_sprite_num(cycle_flags);
-        sbuf_reg[s] = vicii.sprite[s].data;
-    }
+    vicii.sprite_background_collisions |= bg_collisions;
+    vicii.sprite_sprite_collisions |= spr_collisions;
 }
 
 static DRAW_INLINE void update_sprite_xpos(void)
@@ -464,74 +670,71 @@ static DRAW_INLINE void update_sprite_xpos(void)
     }
 }
 
-
-
+/*
+ * Timing of the events within a cycle:
+ *
+ * pixel 2: sprite in DMA1/DMA2 is deactivated
+ * pixel 3: sprite in pointer fetch is halted
+ * pixel 4: display bits are latched, sprite data is loaded into sbuf
+ * pixel 6: $d01b/$d01d are latched, $d01c is latched on 8565
+ * pixel 7: $d01c is latched on 6569, halted sprite is released
+ *
+ * Triggering happens before drawing within each pixel.
+ */
 static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
 {
+    sprite_cycle_t sc;
     uint8_t candidate_bits;
-    uint8_t dma_cycle_0 = 0;
-    uint8_t dma_cycle_2 = 0;
-    int xpos;
-    int spr_en;
-
-    xpos = cycle_get_xpos(cycle_flags);
-
-    spr_en = cycle_is_check_spr_disp(cycle_flags);
+    uint8_t draw_bits;
+    uint8_t old_pri_bits;
+    int s;
 
+    sc.xpos = cycle_get_xpos(cycle_flags);
+    sc.spr_en = cycle_is_check_spr_disp(cycle_flags);
+    sc.dma_sprite = cycle_get_sprite_num(cycle_flags);
+    sc.dma_cycle_0 = 0;
+    sc.dma_cycle_2 = 0;
     if (cycle_is_sprite_ptr_dma0(cycle_flags)) {
-        dma_cycle_0 = 1 << cycle_get_sprite_num(cycle_flags);
+        sc.dma_cycle_0 = 1 << sc.dma_sprite;
     }
     if (cycle_is_sprite_dma1_dma2(cycle_flags)) {
-        dma_cycle_2 = 1 << cycle_get_sprite_num(cycle_flags);
+        sc.dma_cycle_2 = 1 << sc.dma_sprite;
     }
-    candidate_bits = get_trigger_candidates(xpos);
+    sc.next_pending_bits = sc.spr_en ? (uint8_t)vicii.sprite_display_bits : sprite_pending_bits;
+    sc.next_mc_bits = vicii.regs[0x1c];
+    sc.next_expx_bits = vicii.regs[0x1d];
+
+    /* only active sprites and sprites that might trigger can draw */
+    candidate_bits = 0;
+    if (sprite_pending_bits | sc.next_pending_bits) {
+        candidate_bits = get_trigger_candidates(sc.xpos);
+    }
+    draw_bits = sprite_active_bits | candidate_bits;
 
-    /* process and render sprites */
-    /* pixel 0 */
-    trigger_sprites(xpos + 0, candidate_bits);
-    draw_sprites(0);
-    /* pixel 1 */
-    trigger_sprites(xpos + 1, candidate_bits);
-    draw_sprites(1);
-    /* pixel 2 */
-    sprite_active_bits &= ~dma_cycle_2;
-    trigger_sprites(xpos + 2, candidate_bits);
-    draw_sprites(2);
-    /* pixel 3 */
-    sprite_halt_bits |= dma_cycle_0;
-    trigger_sprites(xpos + 3, candidate_bits);
-    draw_sprites(3);
-    /* pixel 4 */
-    if (spr_en) {
-        sprite_pending_bits = vicii.sprite_display_bits;
+    for (s = 7; s >= 0; --s) {
+        if (draw_bits & (1 << s)) {
+            draw_sprite8(s, candidate_bits, &sc);
+        }
     }
-    update_sprite_data(cycle_flags);
-    trigger_sprites(xpos + 4, candidate_bits);
-    draw_sprites(4);
-    /* pixel 5 */
-    trigger_sprites(xpos + 5, candidate_bits);
-    draw_sprites(5);
-    /* pixel 6 */
-    if (!vicii.color_latency) {
-        update_sprite_mc_bits_8565();
+    if ((uint8_t)~draw_bits) {
+        update_idle_sprites8((uint8_t)~draw_bits, &sc);
     }
+
+    /* latch registers */
+    old_pri_bits = sprite_pri_bits;
+    sprite_pending_bits = sc.next_pending_bits;
+    sprite_mc_bits = sc.next_mc_bits;
     sprite_pri_bits = vicii.regs[0x1b];
-    sprite_expx_bits = vicii.regs[0x1d];
-    trigger_sprites(xpos + 6, candidate_bits);
-    draw_sprites(6);
-    /* pixel 7 */
-    if (vicii.color_latency) {
-        update_sprite_mc_bits_6569();
+    sprite_expx_bits = sc.next_expx_bits;
+
+    if (draw_bits) {
+        resolve_sprites8(old_pri_bits);
     }
-    sprite_halt_bits &= ~dma_cycle_2;
-    trigger_sprites(xpos + 7, candidate_bits);
-    draw_sprites(7);
 
     /* pipe xpos */
     update_sprite_xpos();
 }
 
-
 /**************************************************************************
  *
  * SECTION  draw_border()
@@ -589,43 +792,10 @@ static DRAW_INLINE void update_cregs(void)
     vicii.last_color_reg = 0xff;
 }
 
-static DRAW_INLINE void draw_colors_6569(int offs, int i)
-{
-    int lookup_index;
-
-    /* resolve any unresolved colors */
-    lookup_index = (i + 1) & 0x07;
-    pixel_buffer[lookup_index] = cregs[pixel_buffer[lookup_index]];
-
-    /* draw pixel to buffer */
-    vicii.dbuf[offs + i] = pixel_buffer[i];
-
-    pixel_buffer[i] = render_buffer[i];
-}
-
-static DRAW_INLINE void draw_colors_8565(int offs, int i)
-{
-    int lookup_index;
-
-    lookup_index = i;
-    /* resolve any unresolved colors */
-
-    /* special case for grey dot handling */
-    if (i == 0 && pixel_buffer[lookup_index] == last_color_reg) {
-        pixel_buffer[lookup_index] = 0x0f;
-    } else {
-        pixel_buffer[lookup_index] = cregs[pixel_buffer[lookup_index]];
-    }
-
-    /* draw pixel to buffer */
-    vicii.dbuf[offs + i] = pixel_buffer[i];
-
-    pixel_buffer[i] = render_buffer[i];
-}
-
 static DRAW_INLINE void draw_colors8(void)
 {
     int offs = vicii.dbuf_offset;
+    uint8_t *dst;
 
     /* guard (could possibly be removed) */
     if (offs > VICII_DRAW_BUFFER_SIZE - 8) {
@@ -637,25 +807,40 @@ static DRAW_INLINE void draw_colors8(void)
         cregs[last_color_reg] = last_color_value;
     }
 
-    /* render pixels */
+    /*
+     * render pixels
+     *
+     * The pixels of the previous cycle are in pixel_buffer.  On the 6569
+     * pixel 0 was already resolved at the end of the previous cycle, and
+     * pixel 0 of this cycle is resolved right away.
+     */
+    dst = vicii.dbuf + offs;
     if (vicii.color_latency) {
-        draw_colors_6569(offs, 0);
-        draw_colors_6569(offs, 1);
-        draw_colors_6569(offs, 2);
-        draw_colors_6569(offs, 3);
-        draw_colors_6569(offs, 4);
-        draw_colors_6569(offs, 5);
-        draw_colors_6569(offs, 6);
-        draw_colors_6569(offs, 7);
+        dst[0] = pixel_buffer[0];
+        dst[1] = cregs[pixel_buffer[1]];
+        dst[2] = cregs[pixel_buffer[2]];
+        dst[3] = cregs[pixel_buffer[3]];
+        dst[4] = cregs[pixel_buffer[4]];
+        dst[5] = cregs[pixel_buffer[5]];
+        dst[6] = cregs[pixel_buffer[6]];
+        dst[7] = cregs[pixel_buffer[7]];
+        memcpy(pixel_buffer, render_buffer, 8);
+        pixel_buffer[0] = cregs[render_buffer[0]];
     } else {
-        draw_colors_8565(offs, 0);
-        draw_colors_8565(offs, 1);
-        draw_colors_8565(offs, 2);
-        draw_colors_8565(offs, 3);
-        draw_colors_8565(offs, 4);
-        draw_colors_8565(offs, 5);
-        draw_colors_8565(offs, 6);
-        draw_colors_8565(offs, 7);
+        /* special case for grey dot handling */
+        if (pixel_buffer[0] == last_color_reg) {
+            dst[0] = 0x0f;
+        } else {
+            dst[0] = cregs[pixel_buffer[0]];
+        }
+        dst[1] = cregs[pixel_buffer[1]];
+        dst[2] = cregs[pixel_buffer[2]];
+        dst[3] = cregs[pixel_buffer[3]];
+        dst[4] = cregs[pixel_buffer[4]];
+        dst[5] = cregs[pixel_buffer[5]];
+        dst[6] = cregs[pixel_buffer[6]];
+        dst[7] = cregs[pixel_buffer[7]];
+        memcpy(pixel_buffer, render_buffer, 8);
     }
     vicii.dbuf_offset += 8;
 
@@ -707,6 +892,8 @@ void vicii_draw_cycle_init(void)
     vicii.last_color_reg = 0xff;
     last_color_reg = 0xff;
 
+    init_graphics_pixels();
+
     cycle_flags_pipe = 0;
 }
 
@@ -27,6 +27,7 @@
 #ifndef VICE_VIDEO_H
 #define VICE_VIDEO_H
 
+#include "archdep_tick.h"
 #include "types.h"
 
 /* video chip type */
@@ -72,6 +73,15 @@
 #define VIDEO_ASPECT_MODE_CUSTOM        1
 #define VIDEO_ASPECT_MODE_TRUE          2
 
+/* number of frames that can be queued for display (<CHIP>RenderQueueDepth) */
+#define VIDEO_RENDER_QUEUE_DEPTH_MIN    1
+#define VIDEO_RENDER_QUEUE_DEPTH_MAX    4
+#define VIDEO_RENDER_QUEUE_DEPTH_DEFAULT 2
+
+/* which queued frames are displayed (<CHIP>PresentMode) */
+#define VIDEO_PRESENT_MODE_QUEUE        0   /* every frame, in order */
+#define VIDEO_PRESENT_MODE_LATEST       1   /* only the most recent frame */
+
 struct video_canvas_s;
 struct video_cbm_palette_s;
 struct viewport_s;
@@ -223,6 +233,9 @@ struct video_render_config_s {
     int filter;                    /* VIDEO_FILTER_NONE, VIDEO_FILTER_CRT, VIDEO_FILTER_SCALE2X */
     int glfilter;                  /* <CHIP>GLFilter */
     int vsync;                     /* <CHIP>VSync */
+    int threaded_render;           /* <CHIP>ThreadedRender */
+    int render_queue_depth;        /* <CHIP>RenderQueueDepth */
+    int present_mode;              /* <CHIP>PresentMode */
     int external_palette;          /* Use an external palette?  */
     char *external_palette_name;   /* Name of the external palette.  */
     int readable;                  /* reading of frame buffer is safe and fast */
@@ -277,6 +290,12 @@ void video_canvas_map(struct video_canvas_s *canvas);
 void video_canvas_unmap(struct video_canvas_s *canvas);
 void video_canvas_resize(struct video_canvas_s *canvas, char resize_canvas);
 void video_canvas_render(struct video_canvas_s *canvas, uint8_t *trg, int width, int height, int xs, int ys, int xt, int yt, int pitcht);
+void video_canvas_render_update_colors(struct video_canvas_s *canvas);
+unsigned int video_canvas_render_source_size(struct video_canvas_s *canvas);
+void video_canvas_render_copy_source(struct video_canvas_s *canvas, uint8_t *dest);
+void video_canvas_render_prepare(struct video_canvas_s *canvas, int width, int height, int xs, int ys);
+void video_canvas_render_source(struct video_canvas_s *canvas, uint8_t *src, int pitchs, uint8_t *trg, int width, int height, int xs, int ys, int xt, int yt, int pitcht);
+void video_canvas_render_sync_all(void);
 void video_canvas_refresh_all(struct video_canvas_s *canvas);
 char video_canvas_can_resize(struct video_canvas_s *canvas);
 void video_viewport_get(struct video_canvas_s *canvas, struct viewport_s **viewport, struct geometry_s **geometry);
@@ -322,4 +341,36 @@ void video_color_palette_internal(struct video_canvas_s *canvas, struct video_cb
 int video_color_update_palette(struct video_canvas_s *canvas);
 void video_color_palette_free(struct palette_s *palette);
 
+/* Frame latency tracking, see video/video-latency.c */
+
+/* Points of the display pipeline at which a frame is timestamped */
+typedef enum video_latency_stage_e {
+    VIDEO_LATENCY_QUEUED,       /* frame handed to the render queue */
+    VIDEO_LATENCY_DEQUEUED,     /* frame picked up by the render thread */
+    VIDEO_LATENCY_PRESENTED,    /* frame swapped/presented on the host */
+    VIDEO_LATENCY_INTERVAL,     /* time between two presented frames */
+    VIDEO_LATENCY_NUM_STAGES
+} video_latency_stage_t;
+
+#define VIDEO_LATENCY_NUM_BUCKETS 8
+
+typedef struct video_latency_stats_s {
+    unsigned long count;                                /* number of frames */
+    unsigned long buckets[VIDEO_LATENCY_NUM_BUCKETS];   /* histogram */
+    unsigned long last;                                 /* in microseconds */
+    unsigned long max;                                  /* in microseconds */
+    unsigned long average;                              /* in microseconds */
+} video_latency_stats_t;
+
+/* Statistics are kept per canvas, for this many canvases */
+#define VIDEO_LATENCY_MAX_CANVASES 2
+
+void video_latency_record(struct video_canvas_s *canvas, video_latency_stage_t stage, tick_t frame_tick);
+void video_latency_presented(struct video_canvas_s *canvas, tick_t frame_tick);
+void video_latency_get_stats(struct video_canvas_s *canvas, video_latency_stage_t stage, video_latency_stats_t *stats);
+unsigned long video_latency_bucket_limit(int bucket);
+const char *video_latency_stage_name(video_latency_stage_t stage);
+void video_latency_reset(struct video_canvas_s *canvas);
+void video_latency_log(void);
+
 #endif
@@ -38,6 +38,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "lib.h"
 #include "log.h"
@@ -46,6 +47,7 @@
 #include "video-canvas.h"
 #include "video-color.h"
 #include "video-render.h"
+#include "video-sound.h"
 #include "video.h"
 #include "viewport.h"
 
@@ -121,6 +123,23 @@ void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
     ys /= canvas->videoconfig->scaley;
 #endif
 
+    video_canvas_render_update_colors(canvas);
+
+    video_render_main(canvas->videoconfig, canvas->draw_buffer->draw_buffer,
+                      trg, width, height, xs, ys, xt, yt,
+                      canvas->draw_buffer->draw_buffer_width, pitcht,
+                      viewport);
+}
+
+/** \brief Recalculate the palette of a canvas when needed
+ *
+ * Must be called on the emulation thread, and not while a conversion of
+ * this canvas is running on another thread.
+ */
+void video_canvas_render_update_colors(video_canvas_t *canvas)
+{
+    viewport_t *viewport = canvas->viewport;
+
     /* when the color encoding changed, the palette must be recalculated */
     if (viewport->crt_type != canvas->crt_type) {
         canvas->videoconfig->color_tables.updated = 0;
@@ -130,10 +149,91 @@ void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
     if (!canvas->videoconfig->color_tables.updated) { /* update colors as necessary */
         video_color_update_palette(canvas);
     }
-    video_render_main(canvas->videoconfig, canvas->draw_buffer->draw_buffer,
-                      trg, width, height, xs, ys, xt, yt,
-                      canvas->draw_buffer->draw_buffer_width, pitcht,
-                      viewport);
+}
+
+/*
+ * Deferred rendering
+ *
+ * A UI with a render thread per canvas can split video_canvas_render() in two
+ * halves: the emulation thread calls video_canvas_render_prepare() and takes
+ * a copy of the draw buffer with video_canvas_render_copy_source(), and the
+ * render thread later converts that copy with video_canvas_render_source().
+ * This lets the x128 VIC-II and VDC windows be converted in parallel with
+ * each other and with the emulation.
+ */
+
+/** \brief Size in bytes of a draw buffer copy for video_canvas_render_source()
+ *
+ * The copy includes the padding lines before and after the draw buffer, the
+ * CRT and scale2x renderers read into them.
+ */
+unsigned int video_canvas_render_source_size(video_canvas_t *canvas)
+{
+    draw_buffer_t *draw_buffer = canvas->draw_buffer;
+
+    return draw_buffer->draw_buffer_width * (draw_buffer->draw_buffer_height + 4);
+}
+
+/** \brief Copy the current draw buffer of a canvas, including padding
+ *
+ * \param[in]   canvas  canvas
+ * \param[out]  dest    buffer of at least video_canvas_render_source_size()
+ *                      bytes
+ */
+void video_canvas_render_copy_source(video_canvas_t *canvas, uint8_t *dest)
+{
+    draw_buffer_t *draw_buffer = canvas->draw_buffer;
+
+    memcpy(dest, draw_buffer->draw_buffer - draw_buffer->draw_buffer_width * 2,
+           video_canvas_render_source_size(canvas));
+}
+
+/** \brief Emulation thread half of a deferred render
+ *
+ * Updates the palette when needed and feeds the video->audio leak emulation
+ * with the current draw buffer. Takes the same geometry arguments as
+ * video_canvas_render().
+ */
+void video_canvas_render_prepare(video_canvas_t *canvas, int width, int height,
+                                 int xs, int ys)
+{
+#ifdef VIDEO_SCALE_SOURCE
+    xs /= canvas->videoconfig->scalex;
+    ys /= canvas->videoconfig->scaley;
+#endif
+
+    video_canvas_render_update_colors(canvas);
+
+    if (width <= 0) {
+        return;
+    }
+
+    video_sound_update(canvas->videoconfig, canvas->draw_buffer->draw_buffer,
+                       width, height, xs, ys,
+                       canvas->draw_buffer->draw_buffer_width,
+                       canvas->viewport);
+}
+
+/** \brief Render thread half of a deferred render
+ *
+ * Converts a draw buffer copy made by video_canvas_render_copy_source() to
+ * \a trg. \a pitchs is the draw buffer width at the time of the copy. May be
+ * called from any thread, as long as the emulation thread does not call
+ * video_canvas_render_prepare() for the same canvas meanwhile.
+ */
+void video_canvas_render_source(video_canvas_t *canvas, uint8_t *src,
+                                int pitchs, uint8_t *trg, int width, int height,
+                                int xs, int ys, int xt, int yt, int pitcht)
+{
+#ifdef VIDEO_SCALE_SOURCE
+    xs /= canvas->videoconfig->scalex;
+    ys /= canvas->videoconfig->scaley;
+#endif
+
+    video_render_convert(canvas->videoconfig,
+                         src + pitchs * 2, trg, width, height, xs, ys, xt, yt,
+                         pitchs, pitcht,
+                         canvas->viewport);
 }
 
 /** \brief Force refresh all tracked canvases.
@@ -271,6 +271,35 @@ static cmdline_option_t cmdline_options_chip_gloptions[] =
     CMDLINE_LIST_END
 };
 
+#ifdef USE_GTK3UI
+/* render thread and render queue options */
+static const char * const cname_chip_threaded_render[] =
+{
+    "-", "threadedrender", "ThreadedRender",
+    "+", "threadedrender", "ThreadedRender",
+    "-", "renderqueuedepth", "RenderQueueDepth",
+    "-", "presentmode", "PresentMode",
+    NULL
+};
+
+static cmdline_option_t cmdline_options_chip_threaded_render[] =
+{
+    { NULL, SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, NULL, (resource_value_t)1,
+      NULL, "Convert frames on the render thread of the window" },
+    { NULL, SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, NULL, (resource_value_t)0,
+      NULL, "Convert frames on the emulation thread" },
+    { NULL, SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, NULL, NULL,
+      "<frames>", "Set the number of frames that can be queued for display (1-4)" },
+    { NULL, SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, NULL, NULL,
+      "<mode>", "Set present mode (0 = display every frame, 1 = display only the latest frame)" },
+    CMDLINE_LIST_END
+};
+#endif
+
 /* CRT emulation options */
 static const char * const cname_chip_colors[] =
 {
@@ -552,6 +581,26 @@ int video_cmdline_options_chip_init(const char *chipname,
         lib_free(cmdline_options_chip_gloptions[i].resource_name);
     }
 
+#ifdef USE_GTK3UI
+    /* <CHIP>ThreadedRender, <CHIP>RenderQueueDepth, <CHIP>PresentMode */
+    for (i = 0; cname_chip_threaded_render[i * 3] != NULL; i++) {
+        cmdline_options_chip_threaded_render[i].name
+            = util_concat(cname_chip_threaded_render[i * 3], chipname,
+                          cname_chip_threaded_render[i * 3 + 1], NULL);
+        cmdline_options_chip_threaded_render[i].resource_name
+            = util_concat(chipname, cname_chip_threaded_render[i * 3 + 2], NULL);
+    }
+
+    if (cmdline_register_options(cmdline_options_chip_threaded_render) < 0) {
+        return -1;
+    }
+
+    for (i = 0; cname_chip_threaded_render[i * 3] != NULL; i++) {
+        lib_free(cmdline_options_chip_threaded_render[i].name);
+        lib_free(cmdline_options_chip_threaded_render[i].resource_name);
+    }
+#endif
+
     /* color generator */
     for (i = 0; cname_chip_colors[i * 3] != NULL; i++) {
         cmdline_options_chip_colors[i].name
@@ -0,0 +1,267 @@
+/*
+ * video-latency.c - Frame latency and pacing statistics.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Each frame is timestamped with tick_now() when the emulated frame is
+ * complete, right before vsync_do_vsync() is called for it.  The UI code
+ * then records how long it took the frame to reach each stage of the
+ * display pipeline.  The time between two presented frames is recorded as
+ * well, as a measure of the frame pacing.
+ *
+ * The statistics are kept separately for each canvas, as the x128 VIC-II
+ * and VDC windows are displayed independently of each other.
+ *
+ * Stages can be recorded from the emulation thread as well as from the
+ * render threads, so everything is done with the lock held.
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "log.h"
+#include "video.h"
+#include "videoarch.h"
+
+#ifdef USE_VICE_THREAD
+#   include <pthread.h>
+static pthread_mutex_t latency_lock = PTHREAD_MUTEX_INITIALIZER;
+#   define LATENCY_LOCK() pthread_mutex_lock(&latency_lock)
+#   define LATENCY_UNLOCK() pthread_mutex_unlock(&latency_lock)
+#else
+#   define LATENCY_LOCK()
+#   define LATENCY_UNLOCK()
+#endif
+
+typedef struct latency_histogram_s {
+    unsigned long count;
+    unsigned long buckets[VIDEO_LATENCY_NUM_BUCKETS];
+    unsigned long last;
+    unsigned long max;
+    uint64_t total;
+} latency_histogram_t;
+
+/* upper limits of the histogram buckets in microseconds, the last one is open */
+static const unsigned long bucket_limits[VIDEO_LATENCY_NUM_BUCKETS] = {
+    1000, 2000, 4000, 8000, 16700, 33300, 66700, 0
+};
+
+static const char * const stage_names[VIDEO_LATENCY_NUM_STAGES] = {
+    "queued",
+    "dequeued",
+    "presented",
+    "interval"
+};
+
+typedef struct latency_canvas_s {
+    struct video_canvas_s *canvas;
+    latency_histogram_t histograms[VIDEO_LATENCY_NUM_STAGES];
+
+    /* when the last frame was presented, for VIDEO_LATENCY_INTERVAL */
+    tick_t last_present_tick;
+    int last_present_valid;
+} latency_canvas_t;
+
+static latency_canvas_t latency_canvases[VIDEO_LATENCY_MAX_CANVASES];
+
+/* Find the statistics of a canvas, a canvas seen for the first time gets
+   the next free slot.  Must be called with the lock held.  */
+static latency_canvas_t *latency_canvas_get(struct video_canvas_s *canvas, int create)
+{
+    int i;
+
+    for (i = 0; i < VIDEO_LATENCY_MAX_CANVASES; i++) {
+        if (latency_canvases[i].canvas == canvas) {
+            return &latency_canvases[i];
+        }
+        if (latency_canvases[i].canvas == NULL) {
+            if (!create) {
+                break;
+            }
+            latency_canvases[i].canvas = canvas;
+            return &latency_canvases[i];
+        }
+    }
+    return NULL;
+}
+
+static void histogram_add(latency_histogram_t *h, unsigned long us)
+{
+    int i;
+
+    for (i = 0; i < VIDEO_LATENCY_NUM_BUCKETS - 1; i++) {
+        if (us < bucket_limits[i]) {
+            break;
+        }
+    }
+    h->buckets[i]++;
+    h->count++;
+    h->last = us;
+    h->total += us;
+    if (us > h->max) {
+        h->max = us;
+    }
+}
+
+/** \brief  Record that a frame has reached a stage of the display pipeline
+ *
+ * \param[in]   canvas      the canvas the frame belongs to
+ * \param[in]   stage       the stage the frame has reached
+ * \param[in]   frame_tick  tick_now() when the emulated frame was complete
+ */
+void video_latency_record(struct video_canvas_s *canvas, video_latency_stage_t stage, tick_t frame_tick)
+{
+    unsigned long us = TICK_TO_MICRO(tick_now_delta(frame_tick));
+    latency_canvas_t *lc;
+
+    LATENCY_LOCK();
+    lc = latency_canvas_get(canvas, 1);
+    if (lc != NULL) {
+        histogram_add(&lc->histograms[stage], us);
+    }
+    LATENCY_UNLOCK();
+}
+
+/** \brief  Record that a frame has been presented on the host display
+ *
+ * Records both VIDEO_LATENCY_PRESENTED and VIDEO_LATENCY_INTERVAL.
+ *
+ * \param[in]   canvas      the canvas the frame belongs to
+ * \param[in]   frame_tick  tick_now() when the emulated frame was complete
+ */
+void video_latency_presented(struct video_canvas_s *canvas, tick_t frame_tick)
+{
+    tick_t now = tick_now();
+    latency_canvas_t *lc;
+
+    LATENCY_LOCK();
+    lc = latency_canvas_get(canvas, 1);
+    if (lc != NULL) {
+        histogram_add(&lc->histograms[VIDEO_LATENCY_PRESENTED], TICK_TO_MICRO((tick_t)(now - frame_tick)));
+        if (lc->last_present_valid) {
+            histogram_add(&lc->histograms[VIDEO_LATENCY_INTERVAL], TICK_TO_MICRO((tick_t)(now - lc->last_present_tick)));
+        }
+        lc->last_present_tick = now;
+        lc->last_present_valid = 1;
+    }
+    LATENCY_UNLOCK();
+}
+
+/** \brief  Get a copy of the statistics of a stage
+ *
+ * \param[in]   canvas  canvas
+ * \param[in]   stage   stage
+ * \param[out]  stats   statistics, all zero if the canvas has no frames yet
+ */
+void video_latency_get_stats(struct video_canvas_s *canvas, video_latency_stage_t stage, video_latency_stats_t *stats)
+{
+    latency_canvas_t *lc;
+    latency_histogram_t *h;
+
+    LATENCY_LOCK();
+    lc = latency_canvas_get(canvas, 0);
+    if (lc == NULL) {
+        memset(stats, 0, sizeof(video_latency_stats_t));
+    } else {
+        h = &lc->histograms[stage];
+        stats->count = h->count;
+        memcpy(stats->buckets, h->buckets, sizeof(stats->buckets));
+        stats->last = h->last;
+        stats->max = h->max;
+        stats->average = h->count ? (unsigned long)(h->total / h->count) : 0;
+    }
+    LATENCY_UNLOCK();
+}
+
+/** \brief  Get the upper limit of a histogram bucket
+ *
+ * \param[in]   bucket  bucket index
+ *
+ * \return  limit in microseconds, 0 for the last (open) bucket
+ */
+unsigned long video_latency_bucket_limit(int bucket)
+{
+    return bucket_limits[bucket];
+}
+
+const char *video_latency_stage_name(video_latency_stage_t stage)
+{
+    return stage_names[stage];
+}
+
+/** \brief  Clear the statistics of a canvas
+ *
+ * \param[in]   canvas  canvas
+ */
+void video_latency_reset(struct video_canvas_s *canvas)
+{
+    latency_canvas_t *lc;
+
+    LATENCY_LOCK();
+    lc = latency_canvas_get(canvas, 0);
+    if (lc != NULL) {
+        memset(lc->histograms, 0, sizeof(lc->histograms));
+        lc->last_present_valid = 0;
+    }
+    LATENCY_UNLOCK();
+}
+
+/** \brief  Write the statistics of all stages of all canvases to the log */
+void video_latency_log(void)
+{
+    video_latency_stats_t stats;
+    struct video_canvas_s *canvas;
+    char line[256];
+    size_t len;
+    int stage, i, c;
+
+    for (c = 0; c < VIDEO_LATENCY_MAX_CANVASES; c++) {
+        canvas = latency_canvases[c].canvas;
+        if (canvas == NULL) {
+            break;
+        }
+        for (stage = 0; stage < VIDEO_LATENCY_NUM_STAGES; stage++) {
+            video_latency_get_stats(canvas, stage, &stats);
+            if (stats.count == 0) {
+                continue;
+            }
+            len = 0;
+            for (i = 0; i < VIDEO_LATENCY_NUM_BUCKETS && len < sizeof(line); i++) {
+                if (bucket_limits[i]) {
+                    len += snprintf(line + len, sizeof(line) - len, " <%.1fms:%lu",
+                                    bucket_limits[i] / 1000.0, stats.buckets[i]);
+                } else {
+                    len += snprintf(line + len, sizeof(line) - len, " more:%lu",
+                                    stats.buckets[i]);
+                }
+            }
+            log_message(LOG_DEFAULT,
+                        "Frame latency %s %-9s %lu frames, avg %.1fms, max %.1fms,%s",
+                        canvas->videoconfig->chip_name,
+                        stage_names[stage], stats.count,
+                        stats.average / 1000.0, stats.max / 1000.0, line);
+        }
+    }
+}
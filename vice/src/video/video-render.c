@@ -75,8 +75,6 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
                        int width, int height, int xs, int ys, int xt, int yt,
                        int pitchs, int pitcht, viewport_t *viewport)
 {
-    int rendermode;
-
 #if 0
     log_debug("w:%i h:%i xs:%i ys:%i xt:%i yt:%i ps:%i pt:%i d%i",
               width, height, xs, ys, xt, yt, pitchs, pitcht, depth);
@@ -88,6 +86,27 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
 
     video_sound_update(config, src, width, height, xs, ys, pitchs, viewport);
 
+    video_render_convert(config, src, trg, width, height, xs, ys, xt, yt,
+                         pitchs, pitcht, viewport);
+}
+
+/** \brief Convert the palettized source to the target, without side effects
+ *
+ * Unlike video_render_main() this does not touch the video->audio leak
+ * emulation, so it can be called from a thread other than the emulation
+ * thread, provided the color tables of \a config are not being updated
+ * at the same time.
+ */
+void video_render_convert(video_render_config_t *config, uint8_t *src, uint8_t *trg,
+                          int width, int height, int xs, int ys, int xt, int yt,
+                          int pitchs, int pitcht, viewport_t *viewport)
+{
+    int rendermode;
+
+    if (width <= 0) {
+        return; /* some render routines don't like invalid width */
+    }
+
     rendermode = config->rendermode;
 
     switch (rendermode) {
@@ -507,6 +507,69 @@ static resource_string_t resources_chip_gloptions_string[] =
 };
 #endif
 
+#ifdef USE_GTK3UI
+static int set_threaded_render(int val, void *canvas)
+{
+    video_canvas_t *cv = (video_canvas_t *)canvas;
+
+    cv->videoconfig->threaded_render = val ? 1 : 0;
+    return 0;
+}
+
+/** \brief  Resource registration template for "${CHIP}ThreadedRender"
+ *
+ * When enabled the colour conversion of each frame is done by the render
+ * thread of the canvas instead of the emulation thread.
+ */
+static resource_int_t resources_chip_threaded_render[] =
+{
+    { NULL, 1, RES_EVENT_NO, NULL,
+      NULL, set_threaded_render, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+static int set_render_queue_depth(int val, void *canvas)
+{
+    video_canvas_t *cv = (video_canvas_t *)canvas;
+
+    if (val < VIDEO_RENDER_QUEUE_DEPTH_MIN || val > VIDEO_RENDER_QUEUE_DEPTH_MAX) {
+        return -1;
+    }
+    cv->videoconfig->render_queue_depth = val;
+    return 0;
+}
+
+static int set_present_mode(int val, void *canvas)
+{
+    video_canvas_t *cv = (video_canvas_t *)canvas;
+
+    switch (val) {
+        case VIDEO_PRESENT_MODE_QUEUE:
+        case VIDEO_PRESENT_MODE_LATEST:
+            break;
+        default:
+            return -1;
+    }
+    cv->videoconfig->present_mode = val;
+    return 0;
+}
+
+/** \brief  Resource registration template for "${CHIP}RenderQueueDepth" and
+ *          "${CHIP}PresentMode"
+ *
+ * The number of frames that can be waiting for, or being, displayed, and
+ * whether all of them or only the most recent one gets displayed.
+ */
+static resource_int_t resources_chip_render_queue[] =
+{
+    { NULL, VIDEO_RENDER_QUEUE_DEPTH_DEFAULT, RES_EVENT_NO, NULL,
+      NULL, set_render_queue_depth, NULL },
+    { NULL, VIDEO_PRESENT_MODE_QUEUE, RES_EVENT_NO, NULL,
+      NULL, set_present_mode, NULL },
+    RESOURCE_INT_LIST_END
+};
+#endif
+
 /*
       resources for the color/palette generator
 */
@@ -1113,6 +1176,46 @@ int video_resources_chip_init(const char *chipname,
         lib_free(resources_chip_gloptions_string[0].name);
     }
 #endif
+
+#ifdef USE_GTK3UI
+    /* CHIPThreadedRender */
+    if (machine_class != VICE_MACHINE_VSID) {
+        resources_chip_threaded_render[0].name
+            = util_concat(chipname, "ThreadedRender", NULL);
+        resources_chip_threaded_render[0].value_ptr
+            = &((*canvas)->videoconfig->threaded_render);
+        resources_chip_threaded_render[0].param = (void *)*canvas;
+
+        if (resources_register_int(resources_chip_threaded_render) < 0) {
+            lib_free(resources_chip_threaded_render[0].name);
+            return -1;
+        }
+        lib_free(resources_chip_threaded_render[0].name);
+    }
+
+    /* CHIPRenderQueueDepth, CHIPPresentMode */
+    if (machine_class != VICE_MACHINE_VSID) {
+        int res;
+
+        resources_chip_render_queue[0].name
+            = util_concat(chipname, "RenderQueueDepth", NULL);
+        resources_chip_render_queue[0].value_ptr
+            = &((*canvas)->videoconfig->render_queue_depth);
+        resources_chip_render_queue[0].param = (void *)*canvas;
+        resources_chip_render_queue[1].name
+            = util_concat(chipname, "PresentMode", NULL);
+        resources_chip_render_queue[1].value_ptr
+            = &((*canvas)->videoconfig->present_mode);
+        resources_chip_render_queue[1].param = (void *)*canvas;
+
+        res = resources_register_int(resources_chip_render_queue);
+        lib_free(resources_chip_render_queue[0].name);
+        lib_free(resources_chip_render_queue[1].name);
+        if (res < 0) {
+            return -1;
+        }
+    }
+#endif
     return 0;
 }
 
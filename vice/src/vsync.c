@@ -80,6 +80,8 @@
 static double vsync_metric_cpu_percent;
 static double vsync_metric_emulated_fps;
 static int    vsync_metric_warp_enabled;
+static double vsync_metric_skipped_fps;
+static unsigned long vsync_metric_skipped_frames;
 
 #ifdef USE_VICE_THREAD
 #   include <pthread.h>
@@ -163,6 +165,24 @@ static tick_t warp_render_tick_interval;
 /* Triggers the vice thread to update its priorty */
 static volatile int update_thread_priority = 1;
 
+/* "AdaptiveFrameSkip" resource: maximum number of consecutive frames that are
+   not drawn and rendered when emulation is behind schedule, 0 disables. */
+static int adaptive_frame_skip;
+
+/* Upper limit for the "AdaptiveFrameSkip" resource */
+#define ADAPTIVE_FRAME_SKIP_MAX 10
+
+/* Set by vsync_do_end_of_line() when the emulation is more than a frame
+   behind the host clock, or was so far behind that sync had to be reset.
+   Cleared again by the next regular sync, or by vsync_suspend_speed_eval(). */
+static bool sync_is_behind = false;
+
+/* Set when a frame was skipped because of the above, consumed at vsync. */
+static bool frame_skipped = false;
+
+/* Total number of frames skipped because the emulation was behind. */
+static unsigned long skipped_frames;
+
 static int set_relative_speed(int val, void *param)
 {
     if (val == 0) {
@@ -199,6 +219,17 @@ static int set_initial_warp_mode_resource(int val, void *param)
     return 0;
 }
 
+static int set_adaptive_frame_skip(int val, void *param)
+{
+    if (val < 0 || val > ADAPTIVE_FRAME_SKIP_MAX) {
+        return -1;
+    }
+
+    adaptive_frame_skip = val;
+
+    return 0;
+}
+
 /* Vsync-related resources. */
 static const resource_int_t resources_int[] = {
     { "Speed", 100, RES_EVENT_SAME, NULL,
@@ -206,6 +237,8 @@ static const resource_int_t resources_int[] = {
     { "InitialWarpMode", 0, RES_EVENT_STRICT, (resource_value_t)0,
       /* FIXME: maybe RES_EVENT_NO */
       &initial_warp_mode_resource, set_initial_warp_mode_resource, NULL },
+    { "AdaptiveFrameSkip", 0, RES_EVENT_NO, NULL,
+      &adaptive_frame_skip, set_adaptive_frame_skip, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -240,6 +273,9 @@ static const cmdline_option_t cmdline_options[] =
     { "+warp", CALL_FUNCTION, CMDLINE_ATTRIB_NONE,
       set_initial_warp_mode_cmdline, int_to_void_ptr(0), NULL, NULL,
       NULL, "Do not initially enable warp mode (default)" },
+    { "-adaptiveframeskip", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "AdaptiveFrameSkip", NULL,
+      "<frames>", "Skip drawing up to <frames> consecutive frames when emulation falls behind (0: never skip)" },
     CMDLINE_LIST_END
 };
 
@@ -360,6 +396,7 @@ void vsync_suspend_speed_eval(void)
        in vsync_do_vsync() */
     network_suspend();
     sync_reset = true;
+    sync_is_behind = false;
 }
 
 void vsync_reset_hook(void)
@@ -369,13 +406,16 @@ void vsync_reset_hook(void)
     vsync_suspend_speed_eval();
 }
 
-void vsyncarch_get_metrics(double *cpu_percent, double *emulated_fps, int *is_warp_enabled)
+void vsyncarch_get_metrics(double *cpu_percent, double *emulated_fps, int *is_warp_enabled,
+                           double *skipped_fps, unsigned long *skipped_total)
 {
     METRIC_LOCK();
 
     *cpu_percent = vsync_metric_cpu_percent;
     *emulated_fps = vsync_metric_emulated_fps;
     *is_warp_enabled = vsync_metric_warp_enabled;
+    *skipped_fps = vsync_metric_skipped_fps;
+    *skipped_total = vsync_metric_skipped_frames;
 
     METRIC_UNLOCK();
 }
@@ -400,6 +440,10 @@ static CLOCK last_clock;
 static CLOCK clock_deltas[MEASUREMENT_FRAME_WINDOW];
 static uint64_t cumulative_clock_delta;
 
+/* For measuring how many frames per second are skipped */
+static uint8_t skip_deltas[MEASUREMENT_FRAME_WINDOW];
+static unsigned int cumulative_skip_delta;
+
 static void reset_performance_metrics(tick_t frame_tick)
 {
     /*
@@ -415,9 +459,12 @@ static void reset_performance_metrics(tick_t frame_tick)
 
     cumulative_tick_delta = 0;
     cumulative_clock_delta = 0;
+    cumulative_skip_delta = 0;
 
     METRIC_LOCK();
 
+    vsync_metric_skipped_fps = 0.0;
+
     /* The final smoothing function requires that we initialise the public metrics. */
     if (timer_speed > 0) {
         vsync_metric_emulated_fps = (double)timer_speed * refresh_frequency / 100.0;
@@ -450,6 +497,7 @@ static void update_performance_metrics(tick_t frame_tick)
         /* Remove the oldest measurement */
         cumulative_tick_delta -= tick_deltas[next_measurement_index];
         cumulative_clock_delta -= clock_deltas[next_measurement_index];
+        cumulative_skip_delta -= skip_deltas[next_measurement_index];
     } else {
         measurement_count++;
     }
@@ -457,9 +505,11 @@ static void update_performance_metrics(tick_t frame_tick)
     /* Add this frame's measurement */
     tick_deltas[next_measurement_index] = frame_tick - last_tick;
     clock_deltas[next_measurement_index] = main_cpu_clock - last_clock;
+    skip_deltas[next_measurement_index] = frame_skipped ? 1 : 0;
 
     cumulative_tick_delta += tick_deltas[next_measurement_index];
     cumulative_clock_delta += clock_deltas[next_measurement_index];
+    cumulative_skip_delta += skip_deltas[next_measurement_index];
 
     last_tick = frame_tick;
     last_clock = main_cpu_clock;
@@ -474,6 +524,8 @@ static void update_performance_metrics(tick_t frame_tick)
     vsync_metric_cpu_percent  = (MEASUREMENT_SMOOTH_FACTOR * vsync_metric_cpu_percent)  + (1.0 - MEASUREMENT_SMOOTH_FACTOR) * (clock_delta_seconds / frame_timespan_seconds * 100.0);
     vsync_metric_emulated_fps = (MEASUREMENT_SMOOTH_FACTOR * vsync_metric_emulated_fps) + (1.0 - MEASUREMENT_SMOOTH_FACTOR) * ((double)measurement_count / frame_timespan_seconds);
     vsync_metric_warp_enabled = warp_enabled;
+    vsync_metric_skipped_fps  = (MEASUREMENT_SMOOTH_FACTOR * vsync_metric_skipped_fps)  + (1.0 - MEASUREMENT_SMOOTH_FACTOR) * ((double)cumulative_skip_delta / frame_timespan_seconds);
+    vsync_metric_skipped_frames = skipped_frames;
 
     /* printf("%.3f seconds - %0.3f%% cpu, %.3f fps (CLOCK delta: %u)\n", frame_timespan_seconds, vsync_metric_cpu_percent, vsync_metric_emulated_fps, clock_deltas[next_measurement_index]); fflush(stdout); */
 
@@ -540,6 +592,7 @@ void vsync_do_end_of_line(void)
         if (warp_enabled) {
             /* During warp we need to periodically allow the UI a chance with the mainlock */
             mainlock_yield();
+            sync_is_behind = false;
         } else {
             /*
              * Compare the emulated time vs host time.
@@ -571,6 +624,7 @@ void vsync_do_end_of_line(void)
 
             if (ticks_until_target < tick_per_second()) {
                 /* Emulation timing / sync is OK. */
+                sync_is_behind = false;
 
                 /* If we can't rely on the audio device for timing, slow down here. */
                 if (tick_based_sync_timing) {
@@ -583,10 +637,17 @@ void vsync_do_end_of_line(void)
 
                 log_warning(LOG_DEFAULT, "Sync is %.3f ms behind", (double)TICK_TO_MICRO((tick_t)0 - ticks_until_target) / 1000);
                 sync_reset = true;
+
+                /* Keep skipping frames until the next sync shows whether
+                   the emulation catches up after the reset */
+                sync_is_behind = true;
             } else {
                 /* We are running slow - make sure we still yield to the UI thread if it's waiting */
 
                 mainlock_yield();
+
+                /* More than a frame behind, let vsync_should_skip_frame() know */
+                sync_is_behind = (double)((tick_t)0 - ticks_until_target) > ticks_per_frame;
             }
         }
 
@@ -611,6 +672,15 @@ void vsync_do_end_of_line(void)
     }
 }
 
+/** \brief Decide whether the next frame of a canvas should be drawn and rendered
+ *
+ * Called by the raster code at the end of each frame, the answer applies to
+ * the frame that starts next. Frames are skipped to limit the rendering rate
+ * in warp mode, and, when the "AdaptiveFrameSkip" resource is non-zero, for
+ * up to that many consecutive frames while the emulation is behind schedule.
+ * Skipping only saves drawing and rendering, the emulation, and with it the
+ * sound, carries on as usual.
+ */
 bool vsync_should_skip_frame(struct video_canvas_s *canvas)
 {
     tick_t now = tick_now();
@@ -650,6 +720,25 @@ bool vsync_should_skip_frame(struct video_canvas_s *canvas)
         }
     }
 
+    /*
+     * Adaptive frame skip: when we can't keep up with real time, drop
+     * the drawing and rendering of a few frames to catch up.
+     */
+
+    if (adaptive_frame_skip && sync_is_behind) {
+        if (canvas->skipped_frames < adaptive_frame_skip) {
+            canvas->skipped_frames++;
+            if (!frame_skipped) {
+                frame_skipped = true;
+                skipped_frames++;
+            }
+            /* skip this frame */
+            return true;
+        }
+    }
+
+    canvas->skipped_frames = 0;
+
     /* render this frame */
     return false;
 }
@@ -694,6 +783,7 @@ void vsync_do_vsync(struct video_canvas_s *c)
 
     now = tick_now_after(last_vsync);
     update_performance_metrics(now);
+    frame_skipped = false;
 
     vsyncarch_postsync();
 
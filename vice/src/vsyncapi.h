@@ -34,7 +34,8 @@ struct video_canvas_s;
 typedef void (*void_hook_t)(void);
 
 /* current performance metrics */
-void vsyncarch_get_metrics(double *cpu_percent, double *emulated_fps, int *warp_enabled);
+void vsyncarch_get_metrics(double *cpu_percent, double *emulated_fps, int *warp_enabled,
+                           double *skipped_fps, unsigned long *skipped_total);
 
 /* this is called before vsync_do_vsync does the synchroniation */
 void vsyncarch_presync(void);
@@ -24,6 +24,10 @@
  *
  */
 
+#include "cpudispatch.h"
+#include "perfcounters.h"
+#include "z80flags.h"
+
 #ifdef Z80_4MHZ
 #define CLK_ADD(clock, amount) clock = z80cpu_clock_add(clock, amount)
 #else
@@ -71,10 +75,44 @@ static void z80core_reset(void)
 
 #define opcode_t uint32_t
 
-#define FETCH_OPCODE(o) ((o) = (LOAD(z80_reg_pc)               \
-                                | (LOAD(z80_reg_pc + 1) << 8)  \
-                                | (LOAD(z80_reg_pc + 2) << 16) \
-                                | (LOAD(z80_reg_pc + 3) << 24)))
+#define FETCH_OPCODE_LOAD(o) ((o) = (LOAD(z80_reg_pc)               \
+                                     | (LOAD(z80_reg_pc + 1) << 8)  \
+                                     | (LOAD(z80_reg_pc + 2) << 16) \
+                                     | (LOAD(z80_reg_pc + 3) << 24)))
+
+#ifdef Z80_FETCH_TRANSLATE
+/* The machine provides Z80_FETCH_TRANSLATE(addr, &base, &start, &limit),
+   which returns a window [start, limit] around addr where the four opcode
+   bytes can be read from base[pc], or a NULL base if the window has to go
+   through LOAD.  The window is only looked up again when the PC leaves it
+   or after Z80_FETCH_INVALIDATE(), which is used whenever the memory
+   configuration might have changed.  */
+static uint8_t *z80_fetch_base = NULL;
+static int z80_fetch_start = 1;
+static int z80_fetch_limit = 0;
+
+#define Z80_FETCH_INVALIDATE() (z80_fetch_start = 1, z80_fetch_limit = 0)
+
+#define FETCH_OPCODE(o)                                                                       \
+    do {                                                                                      \
+        int fetch_pc = (int)z80_reg_pc;                                                       \
+                                                                                              \
+        if (fetch_pc < z80_fetch_start || fetch_pc > z80_fetch_limit) {                       \
+            Z80_FETCH_TRANSLATE(fetch_pc, &z80_fetch_base, &z80_fetch_start, &z80_fetch_limit); \
+        }                                                                                     \
+        if (z80_fetch_base != NULL) {                                                         \
+            const uint8_t *fetch_ptr = z80_fetch_base + fetch_pc;                             \
+                                                                                              \
+            (o) = fetch_ptr[0] | (fetch_ptr[1] << 8) | (fetch_ptr[2] << 16)                   \
+                  | ((opcode_t)fetch_ptr[3] << 24);                                           \
+        } else {                                                                              \
+            FETCH_OPCODE_LOAD(o);                                                             \
+        }                                                                                     \
+    } while (0)
+#else
+#define Z80_FETCH_INVALIDATE()
+#define FETCH_OPCODE(o) FETCH_OPCODE_LOAD(o)
+#endif
 
 #define p0 (opcode & 0xff)
 #define p1 ((opcode >> 8) & 0xff)
@@ -473,21 +511,17 @@ static void export_registers(void)
 
 /* Opcodes.  */
 
-#define ADC(loadval, clk_inc1, clk_inc2, pc_inc)                                    \
-    do {                                                                            \
-        uint8_t tmp, carry, value;                                                     \
-                                                                                    \
-        CLK_ADD(CLK, clk_inc1);                                                     \
-        value = (uint8_t)(loadval);                                                    \
-        carry = LOCAL_CARRY();                                                      \
-        tmp = reg_a + value + carry;                                                \
-        reg_f = SZP[tmp];                                                           \
-        LOCAL_SET_CARRY((uint16_t)((uint16_t)reg_a + (uint16_t)value + (uint16_t)(carry)) & 0x100); \
-        LOCAL_SET_HALFCARRY((reg_a ^ value ^ tmp) & H_FLAG);                        \
-        LOCAL_SET_PARITY((~(reg_a ^ value)) & (reg_a ^ tmp) & 0x80);                \
-        reg_a = tmp;                                                                \
-        CLK_ADD(CLK, clk_inc2);                                                     \
-        INC_PC(pc_inc);                                                             \
+#define ADC(loadval, clk_inc1, clk_inc2, pc_inc)                    \
+    do {                                                            \
+        uint8_t carry, value;                                       \
+                                                                    \
+        CLK_ADD(CLK, clk_inc1);                                     \
+        value = (uint8_t)(loadval);                                 \
+        carry = LOCAL_CARRY();                                      \
+        reg_f = z80flags_add[(carry << 16) | (reg_a << 8) | value]; \
+        reg_a = (uint8_t)(reg_a + value + carry);                   \
+        CLK_ADD(CLK, clk_inc2);                                     \
+        INC_PC(pc_inc);                                             \
     } while (0)
 
 #define ADCHLREG(reg_valh, reg_vall)                                                       \
@@ -526,20 +560,16 @@ static void export_registers(void)
         INC_PC(2);                                                                          \
     } while (0)
 
-#define ADD(loadval, clk_inc1, clk_inc2, pc_inc)                     \
-    do {                                                             \
-        uint8_t tmp, value;                                             \
-                                                                     \
-        CLK_ADD(CLK, clk_inc1);                                      \
-        value = (uint8_t)(loadval);                                     \
-        tmp = reg_a + value;                                         \
-        reg_f = SZP[tmp];                                            \
-        LOCAL_SET_CARRY((uint16_t)((uint16_t)reg_a + (uint16_t)value) & 0x100);  \
-        LOCAL_SET_HALFCARRY((reg_a ^ value ^ tmp) & H_FLAG);         \
-        LOCAL_SET_PARITY((~(reg_a ^ value)) & (reg_a ^ tmp) & 0x80); \
-        reg_a = tmp;                                                 \
-        CLK_ADD(CLK, clk_inc2);                                      \
-        INC_PC(pc_inc);                                              \
+#define ADD(loadval, clk_inc1, clk_inc2, pc_inc)    \
+    do {                                            \
+        uint8_t value;                              \
+                                                    \
+        CLK_ADD(CLK, clk_inc1);                     \
+        value = (uint8_t)(loadval);                 \
+        reg_f = z80flags_add[(reg_a << 8) | value]; \
+        reg_a = (uint8_t)(reg_a + value);           \
+        CLK_ADD(CLK, clk_inc2);                     \
+        INC_PC(pc_inc);                             \
     } while (0)
 
 #define ADDXXREG(reg_dsth, reg_dstl, reg_valh, reg_vall, clk_inc, pc_inc)                \
@@ -636,19 +666,15 @@ static void export_registers(void)
         INC_PC(pc_inc);                       \
     } while (0)
 
-#define CP(loadval, clk_inc1, clk_inc2, pc_inc)                   \
-    do {                                                          \
-        uint8_t tmp, value;                                          \
-                                                                  \
-        CLK_ADD(CLK, clk_inc1);                                   \
-        value = (uint8_t)(loadval);                                  \
-        tmp = reg_a - value;                                      \
-        reg_f = N_FLAG | SZP[tmp];                                \
-        LOCAL_SET_CARRY(value > reg_a);                           \
-        LOCAL_SET_HALFCARRY((reg_a ^ value ^ tmp) & H_FLAG);      \
-        LOCAL_SET_PARITY((reg_a ^ value) & (reg_a ^ tmp) & 0x80); \
-        CLK_ADD(CLK, clk_inc2);                                   \
-        INC_PC(pc_inc);                                           \
+#define CP(loadval, clk_inc1, clk_inc2, pc_inc)     \
+    do {                                            \
+        uint8_t value;                              \
+                                                    \
+        CLK_ADD(CLK, clk_inc1);                     \
+        value = (uint8_t)(loadval);                 \
+        reg_f = z80flags_sub[(reg_a << 8) | value]; \
+        CLK_ADD(CLK, clk_inc2);                     \
+        INC_PC(pc_inc);                             \
     } while (0)
 
 #define CPDI(HL_FUNC)                                      \
@@ -708,16 +734,14 @@ static void export_registers(void)
 
 #define DECXXIND(reg_val, clk_inc1, clk_inc2, clk_inc3, pc_inc) \
     do {                                                        \
-        uint8_t tmp;                                               \
+        uint8_t tmp;                                            \
                                                                 \
         CLK_ADD(CLK, clk_inc1);                                 \
         tmp = LOAD((reg_val));                                  \
         tmp--;                                                  \
         CLK_ADD(CLK, clk_inc2);                                 \
         STORE((reg_val), tmp);                                  \
-        reg_f = N_FLAG | SZP[tmp] | LOCAL_CARRY();              \
-        LOCAL_SET_PARITY((tmp == 0x7f));                        \
-        LOCAL_SET_HALFCARRY(((tmp & 0x0f) == 0x0f));            \
+        reg_f = z80flags_dec[tmp] | LOCAL_CARRY();              \
         CLK_ADD(CLK, clk_inc3);                                 \
         INC_PC(pc_inc);                                         \
     } while (0)
@@ -729,14 +753,12 @@ static void export_registers(void)
         INC_PC(pc_inc);               \
     } while (0)
 
-#define DECREG(reg_val, clk_inc, pc_inc)                 \
-    do {                                                 \
-        reg_val--;                                       \
-        reg_f = N_FLAG | SZP[reg_val] | LOCAL_CARRY();   \
-        LOCAL_SET_PARITY((reg_val == 0x7f));             \
-        LOCAL_SET_HALFCARRY(((reg_val & 0x0f) == 0x0f)); \
-        CLK_ADD(CLK, clk_inc);                           \
-        INC_PC(pc_inc);                                  \
+#define DECREG(reg_val, clk_inc, pc_inc)               \
+    do {                                               \
+        reg_val--;                                     \
+        reg_f = z80flags_dec[reg_val] | LOCAL_CARRY(); \
+        CLK_ADD(CLK, clk_inc);                         \
+        INC_PC(pc_inc);                                \
     } while (0)
 
 #define DJNZ(value, pc_inc)           \
@@ -877,28 +899,24 @@ static void export_registers(void)
 
 #define INCXXIND(reg_val, clk_inc1, clk_inc2, clk_inc3, pc_inc) \
     do {                                                        \
-        uint8_t tmp;                                               \
+        uint8_t tmp;                                            \
                                                                 \
         CLK_ADD(CLK, clk_inc1);                                 \
         tmp = LOAD((reg_val));                                  \
         tmp++;                                                  \
         CLK_ADD(CLK, clk_inc2);                                 \
         STORE((reg_val), tmp);                                  \
-        reg_f = SZP[tmp] | LOCAL_CARRY();                       \
-        LOCAL_SET_PARITY((tmp == 0x80));                        \
-        LOCAL_SET_HALFCARRY(!(tmp & 0x0f));                     \
+        reg_f = z80flags_inc[tmp] | LOCAL_CARRY();              \
         CLK_ADD(CLK, clk_inc3);                                 \
         INC_PC(pc_inc);                                         \
     } while (0)
 
-#define INCREG(reg_val, clk_inc, pc_inc)        \
-    do {                                        \
-        reg_val++;                              \
-        reg_f = SZP[reg_val] | LOCAL_CARRY();   \
-        LOCAL_SET_PARITY((reg_val == 0x80));    \
-        LOCAL_SET_HALFCARRY(!(reg_val & 0x0f)); \
-        CLK_ADD(CLK, clk_inc);                  \
-        INC_PC(pc_inc);                         \
+#define INCREG(reg_val, clk_inc, pc_inc)               \
+    do {                                               \
+        reg_val++;                                     \
+        reg_f = z80flags_inc[reg_val] | LOCAL_CARRY(); \
+        CLK_ADD(CLK, clk_inc);                         \
+        INC_PC(pc_inc);                                \
     } while (0)
 
 #define INDI(HL_FUNC)           \
@@ -1510,21 +1528,17 @@ static void export_registers(void)
         INC_PC(2);                                                                 \
     } while (0)
 
-#define SBC(loadval, clk_inc1, clk_inc2, pc_inc)                      \
-    do {                                                              \
-        uint8_t tmp, carry, value;                                       \
-                                                                      \
-        CLK_ADD(CLK, clk_inc1);                                       \
-        value = (uint8_t)(loadval);                                      \
-        carry = LOCAL_CARRY();                                        \
-        tmp = reg_a - value - carry;                                  \
-        reg_f = N_FLAG | SZP[tmp];                                    \
-        LOCAL_SET_HALFCARRY((reg_a ^ value ^ tmp) & H_FLAG);          \
-        LOCAL_SET_PARITY((reg_a ^ value) & (reg_a ^ tmp) & 0x80);     \
-        LOCAL_SET_CARRY((uint16_t)((uint16_t)value + (uint16_t)(carry)) > reg_a); \
-        reg_a = tmp;                                                  \
-        CLK_ADD(CLK, clk_inc2);                                       \
-        INC_PC(pc_inc);                                               \
+#define SBC(loadval, clk_inc1, clk_inc2, pc_inc)                    \
+    do {                                                            \
+        uint8_t carry, value;                                       \
+                                                                    \
+        CLK_ADD(CLK, clk_inc1);                                     \
+        value = (uint8_t)(loadval);                                 \
+        carry = LOCAL_CARRY();                                      \
+        reg_f = z80flags_sub[(carry << 16) | (reg_a << 8) | value]; \
+        reg_a = (uint8_t)(reg_a - value - carry);                   \
+        CLK_ADD(CLK, clk_inc2);                                     \
+        INC_PC(pc_inc);                                             \
     } while (0)
 
 #define SCF(clk_inc, pc_inc)    \
@@ -1766,20 +1780,16 @@ static void export_registers(void)
         INC_PC(pc_inc);                                  \
     } while (0)
 
-#define SUB(loadval, clk_inc1, clk_inc2, pc_inc)                  \
-    do {                                                          \
-        uint8_t tmp, value;                                          \
-                                                                  \
-        CLK_ADD(CLK, clk_inc1);                                   \
-        value = (uint8_t)(loadval);                                  \
-        tmp = reg_a - value;                                      \
-        reg_f = N_FLAG | SZP[tmp];                                \
-        LOCAL_SET_HALFCARRY((reg_a ^ value ^ tmp) & H_FLAG);      \
-        LOCAL_SET_PARITY((reg_a ^ value) & (reg_a ^ tmp) & 0x80); \
-        LOCAL_SET_CARRY(value > reg_a);                           \
-        reg_a = tmp;                                              \
-        CLK_ADD(CLK, clk_inc2);                                   \
-        INC_PC(pc_inc);                                           \
+#define SUB(loadval, clk_inc1, clk_inc2, pc_inc)    \
+    do {                                            \
+        uint8_t value;                              \
+                                                    \
+        CLK_ADD(CLK, clk_inc1);                     \
+        value = (uint8_t)(loadval);                 \
+        reg_f = z80flags_sub[(reg_a << 8) | value]; \
+        reg_a = (uint8_t)(reg_a - value);           \
+        CLK_ADD(CLK, clk_inc2);                     \
+        INC_PC(pc_inc);                             \
     } while (0)
 
 #define XOR(value, clk_inc1, clk_inc2, pc_inc) \
@@ -5407,17 +5417,55 @@ static void opcode_fd(uint8_t ip1, uint8_t ip2, uint8_t ip3, uint16_t ip12, uint
 
 /* Z80 mainloop.  */
 
-static void z80_maincpu_loop(interrupt_cpu_status_t *cpu_int_status, alarm_context_t *cpu_alarm_context)
+#define FETCH_NEXT_OPCODE()                                 \
+    do {                                                    \
+        SET_LAST_ADDR(reg_pc);                              \
+        FETCH_OPCODE(opcode);                               \
+        PERFCOUNTERS_INC(PERFCOUNTERS_MAIN, instructions);  \
+    } while (0)
+
+/* With threaded dispatch an opcode goes on with the next one itself,
+   unless the loop is done or an interrupt or alarm is due.  The trace
+   output of debug builds is left to the loop.  */
+#if defined(OPCODE_DISPATCH) && !defined(DEBUG)
+#define OPCODE_CHAINING
+
+#define OPCODE_NEXT                                                    \
+    cpu_int_status->num_dma_per_opcode = 0;                            \
+    if (!(Z80_LOOP_COND)) {                                            \
+        goto opcode_done;                                              \
+    }                                                                  \
+    if (cpu_int_status->global_pending_int == IK_NONE                  \
+        && CLK < alarm_context_next_pending_clk(cpu_alarm_context)) {  \
+        FETCH_NEXT_OPCODE();                                           \
+        SET_LAST_OPCODE(p0);                                           \
+        OPCODE_DISPATCH(p0);                                           \
+    }                                                                  \
+    goto opcode_check_pending
+#else
+#define OPCODE_NEXT break
+#endif
+
+OPCODE_DISPATCH_FUNC static void z80_maincpu_loop(interrupt_cpu_status_t *cpu_int_status, alarm_context_t *cpu_alarm_context)
 {
     opcode_t opcode;
 
+    z80flags_init();
+
     import_registers();
 
+    /* the other CPU may have changed the memory configuration */
+    Z80_FETCH_INVALIDATE();
+
     Z80_SET_DMA_REQUEST(0)
 
     do {
+#ifdef OPCODE_CHAINING
+opcode_check_pending:
+#endif
         while (CLK >= alarm_context_next_pending_clk(cpu_alarm_context)) {
             alarm_context_dispatch(cpu_alarm_context, CLK);
+            Z80_FETCH_INVALIDATE();
         }
         {
             enum cpu_int pending_interrupt;
@@ -5427,12 +5475,12 @@ static void z80_maincpu_loop(interrupt_cpu_status_t *cpu_int_status, alarm_conte
                 DO_INTERRUPT(pending_interrupt);
                 while (CLK >= alarm_context_next_pending_clk(cpu_alarm_context)) {
                     alarm_context_dispatch(cpu_alarm_context, CLK);
+                    Z80_FETCH_INVALIDATE();
                 }
             }
         }
 
-        SET_LAST_ADDR(reg_pc);
-        FETCH_OPCODE(opcode);
+        FETCH_NEXT_OPCODE();
 
 #ifdef DEBUG
         if (debug.maincpu_traceflg) {
@@ -5445,779 +5493,782 @@ static void z80_maincpu_loop(interrupt_cpu_status_t *cpu_int_status, alarm_conte
 
         SET_LAST_OPCODE(p0);
 
-        switch (p0) {
-            case 0x00: /* NOP */
+        OPCODE_SWITCH(p0) {
+            OPCODE_CASE(0x00): /* NOP */
                 NOP(4, 1);
-                break;
-            case 0x01: /* LD BC # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x01): /* LD BC # */
                 LDW(p12, reg_b, reg_c, 10, 0, 3);
-                break;
-            case 0x02: /* LD (BC) A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x02): /* LD (BC) A */
                 STREG(BC_WORD(), reg_a, 4, 3, 1);
-                break;
-            case 0x03: /* INC BC */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x03): /* INC BC */
                 DECINC(INC_BC_WORD(), 6, 1);
-                break;
-            case 0x04: /* INC B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x04): /* INC B */
                 INCREG(reg_b, 4, 1);
-                break;
-            case 0x05: /* DEC B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x05): /* DEC B */
                 DECREG(reg_b, 4, 1);
-                break;
-            case 0x06: /* LD B # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x06): /* LD B # */
                 LDREG(reg_b, p1, 4, 3, 2);
-                break;
-            case 0x07: /* RLCA */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x07): /* RLCA */
                 RLCA(4, 1);
-                break;
-            case 0x08: /* EX AF AF' */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x08): /* EX AF AF' */
                 EXAFAF(8, 1);
-                break;
-            case 0x09: /* ADD HL BC */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x09): /* ADD HL BC */
                 ADDXXREG(reg_h, reg_l, reg_b, reg_c, 11, 1);
-                break;
-            case 0x0a: /* LD A (BC) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x0a): /* LD A (BC) */
                 LDREG(reg_a, LOAD(BC_WORD()), 4, 3, 1);
-                break;
-            case 0x0b: /* DEC BC */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x0b): /* DEC BC */
                 DECINC(DEC_BC_WORD(), 6, 1);
-                break;
-            case 0x0c: /* INC C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x0c): /* INC C */
                 INCREG(reg_c, 4, 1);
-                break;
-            case 0x0d: /* DEC C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x0d): /* DEC C */
                 DECREG(reg_c, 4, 1);
-                break;
-            case 0x0e: /* LD C # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x0e): /* LD C # */
                 LDREG(reg_c, p1, 4, 3, 2);
-                break;
-            case 0x0f: /* RRCA */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x0f): /* RRCA */
                 RRCA(4, 1);
-                break;
-            case 0x10: /* DJNZ */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x10): /* DJNZ */
                 DJNZ(p1, 2);
-                break;
-            case 0x11: /* LD DE # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x11): /* LD DE # */
                 LDW(p12, reg_d, reg_e, 10, 0, 3);
-                break;
-            case 0x12: /* LD (DE) A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x12): /* LD (DE) A */
                 STREG(DE_WORD(), reg_a, 4, 3, 1);
-                break;
-            case 0x13: /* INC DE */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x13): /* INC DE */
                 DECINC(INC_DE_WORD(), 6, 1);
-                break;
-            case 0x14: /* INC D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x14): /* INC D */
                 INCREG(reg_d, 4, 1);
-                break;
-            case 0x15: /* DEC D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x15): /* DEC D */
                 DECREG(reg_d, 4, 1);
-                break;
-            case 0x16: /* LD D # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x16): /* LD D # */
                 LDREG(reg_d, p1, 4, 3, 2);
-                break;
-            case 0x17: /* RLA */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x17): /* RLA */
                 RLA(4, 1);
-                break;
-            case 0x18: /* JR */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x18): /* JR */
                 BRANCH(1, p1, 2);
-                break;
-            case 0x19: /* ADD HL DE */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x19): /* ADD HL DE */
                 ADDXXREG(reg_h, reg_l, reg_d, reg_e, 11, 1);
-                break;
-            case 0x1a: /* LD A (DE) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x1a): /* LD A (DE) */
                 LDREG(reg_a, LOAD(DE_WORD()), 4, 3, 1);
-                break;
-            case 0x1b: /* DEC DE */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x1b): /* DEC DE */
                 DECINC(DEC_DE_WORD(), 6, 1);
-                break;
-            case 0x1c: /* INC E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x1c): /* INC E */
                 INCREG(reg_e, 4, 1);
-                break;
-            case 0x1d: /* DEC E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x1d): /* DEC E */
                 DECREG(reg_e, 4, 1);
-                break;
-            case 0x1e: /* LD E # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x1e): /* LD E # */
                 LDREG(reg_e, p1, 4, 3, 2);
-                break;
-            case 0x1f: /* RRA */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x1f): /* RRA */
                 RRA(4, 1);
-                break;
-            case 0x20: /* JR NZ */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x20): /* JR NZ */
                 BRANCH(!LOCAL_ZERO(), p1, 2);
-                break;
-            case 0x21: /* LD HL # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x21): /* LD HL # */
                 LDW(p12, reg_h, reg_l, 10, 0, 3);
-                break;
-            case 0x22: /* LD (WORD) HL */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x22): /* LD (WORD) HL */
                 STW(p12, reg_h, reg_l, 4, 9, 3, 3);
-                break;
-            case 0x23: /* INC HL */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x23): /* INC HL */
                 DECINC(INC_HL_WORD(), 6, 1);
-                break;
-            case 0x24: /* INC H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x24): /* INC H */
                 INCREG(reg_h, 4, 1);
-                break;
-            case 0x25: /* DEC H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x25): /* DEC H */
                 DECREG(reg_h, 4, 1);
-                break;
-            case 0x26: /* LD H # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x26): /* LD H # */
                 LDREG(reg_h, p1, 4, 3, 2);
-                break;
-            case 0x27: /* DAA */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x27): /* DAA */
                 DAA(4, 1);
-                break;
-            case 0x28: /* JR Z */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x28): /* JR Z */
                 BRANCH(LOCAL_ZERO(), p1, 2);
-                break;
-            case 0x29: /* ADD HL HL */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x29): /* ADD HL HL */
                 ADDXXREG(reg_h, reg_l, reg_h, reg_l, 11, 1);
-                break;
-            case 0x2a: /* LD HL (WORD) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x2a): /* LD HL (WORD) */
                 LDIND(p12, reg_h, reg_l, 4, 4, 8, 3);
-                break;
-            case 0x2b: /* DEC HL */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x2b): /* DEC HL */
                 DECINC(DEC_HL_WORD(), 6, 1);
-                break;
-            case 0x2c: /* INC L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x2c): /* INC L */
                 INCREG(reg_l, 4, 1);
-                break;
-            case 0x2d: /* DEC L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x2d): /* DEC L */
                 DECREG(reg_l, 4, 1);
-                break;
-            case 0x2e: /* LD L # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x2e): /* LD L # */
                 LDREG(reg_l, p1, 4, 3, 2);
-                break;
-            case 0x2f: /* CPL */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x2f): /* CPL */
                 CPL(4, 1);
-                break;
-            case 0x30: /* JR NC */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x30): /* JR NC */
                 BRANCH(!LOCAL_CARRY(), p1, 2);
-                break;
-            case 0x31: /* LD SP # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x31): /* LD SP # */
                 LDSP(p12, 10, 0, 3);
-                break;
-            case 0x32: /* LD (WORD) A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x32): /* LD (WORD) A */
                 STREG(p12, reg_a, 10, 3, 3);
-                break;
-            case 0x33: /* INC SP */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x33): /* INC SP */
                 DECINC(reg_sp++, 6, 1);
-                break;
-            case 0x34: /* INC (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x34): /* INC (HL) */
                 INCXXIND(HL_WORD(), 4, 4, 3, 1);
-                break;
-            case 0x35: /* DEC (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x35): /* DEC (HL) */
                 DECXXIND(HL_WORD(), 4, 4, 3, 1);
-                break;
-            case 0x36: /* LD (HL) # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x36): /* LD (HL) # */
                 STREG(HL_WORD(), p1, 8, 2, 2);
-                break;
-            case 0x37: /* SCF */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x37): /* SCF */
                 SCF(4, 1);
-                break;
-            case 0x38: /* JR C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x38): /* JR C */
                 BRANCH(LOCAL_CARRY(), p1, 2);
-                break;
-            case 0x39: /* ADD HL SP */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x39): /* ADD HL SP */
                 ADDXXSP(reg_h, reg_l, 11, 1);
-                break;
-            case 0x3a: /* LD A (WORD) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x3a): /* LD A (WORD) */
                 LDREG(reg_a, LOAD(p12), 10, 3, 3);
-                break;
-            case 0x3b: /* DEC SP */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x3b): /* DEC SP */
                 DECINC(reg_sp--, 6, 1);
-                break;
-            case 0x3c: /* INC A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x3c): /* INC A */
                 INCREG(reg_a, 4, 1);
-                break;
-            case 0x3d: /* DEC A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x3d): /* DEC A */
                 DECREG(reg_a, 4, 1);
-                break;
-            case 0x3e: /* LD A # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x3e): /* LD A # */
                 LDREG(reg_a, p1, 4, 3, 2);
-                break;
-            case 0x3f: /* CCF */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x3f): /* CCF */
                 CCF(4, 1);
-                break;
-            case 0x40: /* LD B B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x40): /* LD B B */
                 LDREG(reg_b, reg_b, 0, 4, 1);
-                break;
-            case 0x41: /* LD B C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x41): /* LD B C */
                 LDREG(reg_b, reg_c, 0, 4, 1);
-                break;
-            case 0x42: /* LD B D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x42): /* LD B D */
                 LDREG(reg_b, reg_d, 0, 4, 1);
-                break;
-            case 0x43: /* LD B E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x43): /* LD B E */
                 LDREG(reg_b, reg_e, 0, 4, 1);
-                break;
-            case 0x44: /* LD B H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x44): /* LD B H */
                 LDREG(reg_b, reg_h, 0, 4, 1);
-                break;
-            case 0x45: /* LD B L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x45): /* LD B L */
                 LDREG(reg_b, reg_l, 0, 4, 1);
-                break;
-            case 0x46: /* LD B (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x46): /* LD B (HL) */
                 LDREG(reg_b, LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0x47: /* LD B A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x47): /* LD B A */
                 LDREG(reg_b, reg_a, 0, 4, 1);
-                break;
-            case 0x48: /* LD C B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x48): /* LD C B */
                 LDREG(reg_c, reg_b, 0, 4, 1);
-                break;
-            case 0x49: /* LD C C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x49): /* LD C C */
                 LDREG(reg_c, reg_c, 0, 4, 1);
-                break;
-            case 0x4a: /* LD C D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x4a): /* LD C D */
                 LDREG(reg_c, reg_d, 0, 4, 1);
-                break;
-            case 0x4b: /* LD C E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x4b): /* LD C E */
                 LDREG(reg_c, reg_e, 0, 4, 1);
-                break;
-            case 0x4c: /* LD C H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x4c): /* LD C H */
                 LDREG(reg_c, reg_h, 0, 4, 1);
-                break;
-            case 0x4d: /* LD C L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x4d): /* LD C L */
                 LDREG(reg_c, reg_l, 0, 4, 1);
-                break;
-            case 0x4e: /* LD C (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x4e): /* LD C (HL) */
                 LDREG(reg_c, LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0x4f: /* LD C A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x4f): /* LD C A */
                 LDREG(reg_c, reg_a, 0, 4, 1);
-                break;
-            case 0x50: /* LD D B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x50): /* LD D B */
                 LDREG(reg_d, reg_b, 0, 4, 1);
-                break;
-            case 0x51: /* LD D C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x51): /* LD D C */
                 LDREG(reg_d, reg_c, 0, 4, 1);
-                break;
-            case 0x52: /* LD D D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x52): /* LD D D */
                 LDREG(reg_d, reg_d, 0, 4, 1);
-                break;
-            case 0x53: /* LD D E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x53): /* LD D E */
                 LDREG(reg_d, reg_e, 0, 4, 1);
-                break;
-            case 0x54: /* LD D H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x54): /* LD D H */
                 LDREG(reg_d, reg_h, 0, 4, 1);
-                break;
-            case 0x55: /* LD D L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x55): /* LD D L */
                 LDREG(reg_d, reg_l, 0, 4, 1);
-                break;
-            case 0x56: /* LD D (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x56): /* LD D (HL) */
                 LDREG(reg_d, LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0x57: /* LD D A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x57): /* LD D A */
                 LDREG(reg_d, reg_a, 0, 4, 1);
-                break;
-            case 0x58: /* LD E B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x58): /* LD E B */
                 LDREG(reg_e, reg_b, 0, 4, 1);
-                break;
-            case 0x59: /* LD E C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x59): /* LD E C */
                 LDREG(reg_e, reg_c, 0, 4, 1);
-                break;
-            case 0x5a: /* LD E D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x5a): /* LD E D */
                 LDREG(reg_e, reg_d, 0, 4, 1);
-                break;
-            case 0x5b: /* LD E E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x5b): /* LD E E */
                 LDREG(reg_e, reg_e, 0, 4, 1);
-                break;
-            case 0x5c: /* LD E H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x5c): /* LD E H */
                 LDREG(reg_e, reg_h, 0, 4, 1);
-                break;
-            case 0x5d: /* LD E L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x5d): /* LD E L */
                 LDREG(reg_e, reg_l, 0, 4, 1);
-                break;
-            case 0x5e: /* LD E (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x5e): /* LD E (HL) */
                 LDREG(reg_e, LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0x5f: /* LD E A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x5f): /* LD E A */
                 LDREG(reg_e, reg_a, 0, 4, 1);
-                break;
-            case 0x60: /* LD H B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x60): /* LD H B */
                 LDREG(reg_h, reg_b, 0, 4, 1);
-                break;
-            case 0x61: /* LD H C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x61): /* LD H C */
                 LDREG(reg_h, reg_c, 0, 4, 1);
-                break;
-            case 0x62: /* LD H D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x62): /* LD H D */
                 LDREG(reg_h, reg_d, 0, 4, 1);
-                break;
-            case 0x63: /* LD H E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x63): /* LD H E */
                 LDREG(reg_h, reg_e, 0, 4, 1);
-                break;
-            case 0x64: /* LD H H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x64): /* LD H H */
                 LDREG(reg_h, reg_h, 0, 4, 1);
-                break;
-            case 0x65: /* LD H L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x65): /* LD H L */
                 LDREG(reg_h, reg_l, 0, 4, 1);
-                break;
-            case 0x66: /* LD H (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x66): /* LD H (HL) */
                 LDREG(reg_h, LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0x67: /* LD H A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x67): /* LD H A */
                 LDREG(reg_h, reg_a, 0, 4, 1);
-                break;
-            case 0x68: /* LD L B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x68): /* LD L B */
                 LDREG(reg_l, reg_b, 0, 4, 1);
-                break;
-            case 0x69: /* LD L C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x69): /* LD L C */
                 LDREG(reg_l, reg_c, 0, 4, 1);
-                break;
-            case 0x6a: /* LD L D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x6a): /* LD L D */
                 LDREG(reg_l, reg_d, 0, 4, 1);
-                break;
-            case 0x6b: /* LD L E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x6b): /* LD L E */
                 LDREG(reg_l, reg_e, 0, 4, 1);
-                break;
-            case 0x6c: /* LD L H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x6c): /* LD L H */
                 LDREG(reg_l, reg_h, 0, 4, 1);
-                break;
-            case 0x6d: /* LD L L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x6d): /* LD L L */
                 LDREG(reg_l, reg_l, 0, 4, 1);
-                break;
-            case 0x6e: /* LD L (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x6e): /* LD L (HL) */
                 LDREG(reg_l, LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0x6f: /* LD L A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x6f): /* LD L A */
                 LDREG(reg_l, reg_a, 0, 4, 1);
-                break;
-            case 0x70: /* LD (HL) B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x70): /* LD (HL) B */
                 STREG(HL_WORD(), reg_b, 4, 3, 1);
-                break;
-            case 0x71: /* LD (HL) C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x71): /* LD (HL) C */
                 STREG(HL_WORD(), reg_c, 4, 3, 1);
-                break;
-            case 0x72: /* LD (HL) D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x72): /* LD (HL) D */
                 STREG(HL_WORD(), reg_d, 4, 3, 1);
-                break;
-            case 0x73: /* LD (HL) E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x73): /* LD (HL) E */
                 STREG(HL_WORD(), reg_e, 4, 3, 1);
-                break;
-            case 0x74: /* LD (HL) H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x74): /* LD (HL) H */
                 STREG(HL_WORD(), reg_h, 4, 3, 1);
-                break;
-            case 0x75: /* LD (HL) L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x75): /* LD (HL) L */
                 STREG(HL_WORD(), reg_l, 4, 3, 1);
-                break;
-            case 0x76: /* HALT */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x76): /* HALT */
                 HALT();
-                break;
-            case 0x77: /* LD (HL) A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x77): /* LD (HL) A */
                 STREG(HL_WORD(), reg_a, 4, 3, 1);
-                break;
-            case 0x78: /* LD A B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x78): /* LD A B */
                 LDREG(reg_a, reg_b, 0, 4, 1);
-                break;
-            case 0x79: /* LD A C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x79): /* LD A C */
                 LDREG(reg_a, reg_c, 0, 4, 1);
-                break;
-            case 0x7a: /* LD A D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x7a): /* LD A D */
                 LDREG(reg_a, reg_d, 0, 4, 1);
-                break;
-            case 0x7b: /* LD A E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x7b): /* LD A E */
                 LDREG(reg_a, reg_e, 0, 4, 1);
-                break;
-            case 0x7c: /* LD A H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x7c): /* LD A H */
                 LDREG(reg_a, reg_h, 0, 4, 1);
-                break;
-            case 0x7d: /* LD A L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x7d): /* LD A L */
                 LDREG(reg_a, reg_l, 0, 4, 1);
-                break;
-            case 0x7e: /* LD A (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x7e): /* LD A (HL) */
                 LDREG(reg_a, LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0x7f: /* LD A A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x7f): /* LD A A */
                 LDREG(reg_a, reg_a, 0, 4, 1);
-                break;
-            case 0x80: /* ADD B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x80): /* ADD B */
                 ADD(reg_b, 0, 4, 1);
-                break;
-            case 0x81: /* ADD C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x81): /* ADD C */
                 ADD(reg_c, 0, 4, 1);
-                break;
-            case 0x82: /* ADD D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x82): /* ADD D */
                 ADD(reg_d, 0, 4, 1);
-                break;
-            case 0x83: /* ADD E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x83): /* ADD E */
                 ADD(reg_e, 0, 4, 1);
-                break;
-            case 0x84: /* ADD H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x84): /* ADD H */
                 ADD(reg_h, 0, 4, 1);
-                break;
-            case 0x85: /* ADD L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x85): /* ADD L */
                 ADD(reg_l, 0, 4, 1);
-                break;
-            case 0x86: /* ADD (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x86): /* ADD (HL) */
                 ADD(LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0x87: /* ADD A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x87): /* ADD A */
                 ADD(reg_a, 0, 4, 1);
-                break;
-            case 0x88: /* ADC B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x88): /* ADC B */
                 ADC(reg_b, 0, 4, 1);
-                break;
-            case 0x89: /* ADC C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x89): /* ADC C */
                 ADC(reg_c, 0, 4, 1);
-                break;
-            case 0x8a: /* ADC D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x8a): /* ADC D */
                 ADC(reg_d, 0, 4, 1);
-                break;
-            case 0x8b: /* ADC E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x8b): /* ADC E */
                 ADC(reg_e, 0, 4, 1);
-                break;
-            case 0x8c: /* ADC H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x8c): /* ADC H */
                 ADC(reg_h, 0, 4, 1);
-                break;
-            case 0x8d: /* ADC L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x8d): /* ADC L */
                 ADC(reg_l, 0, 4, 1);
-                break;
-            case 0x8e: /* ADC (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x8e): /* ADC (HL) */
                 ADC(LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0x8f: /* ADC A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x8f): /* ADC A */
                 ADC(reg_a, 0, 4, 1);
-                break;
-            case 0x90: /* SUB B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x90): /* SUB B */
                 SUB(reg_b, 0, 4, 1);
-                break;
-            case 0x91: /* SUB C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x91): /* SUB C */
                 SUB(reg_c, 0, 4, 1);
-                break;
-            case 0x92: /* SUB D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x92): /* SUB D */
                 SUB(reg_d, 0, 4, 1);
-                break;
-            case 0x93: /* SUB E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x93): /* SUB E */
                 SUB(reg_e, 0, 4, 1);
-                break;
-            case 0x94: /* SUB H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x94): /* SUB H */
                 SUB(reg_h, 0, 4, 1);
-                break;
-            case 0x95: /* SUB L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x95): /* SUB L */
                 SUB(reg_l, 0, 4, 1);
-                break;
-            case 0x96: /* SUB (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x96): /* SUB (HL) */
                 SUB(LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0x97: /* SUB A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x97): /* SUB A */
                 SUB(reg_a, 0, 4, 1);
-                break;
-            case 0x98: /* SBC B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x98): /* SBC B */
                 SBC(reg_b, 0, 4, 1);
-                break;
-            case 0x99: /* SBC C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x99): /* SBC C */
                 SBC(reg_c, 0, 4, 1);
-                break;
-            case 0x9a: /* SBC D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x9a): /* SBC D */
                 SBC(reg_d, 0, 4, 1);
-                break;
-            case 0x9b: /* SBC E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x9b): /* SBC E */
                 SBC(reg_e, 0, 4, 1);
-                break;
-            case 0x9c: /* SBC H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x9c): /* SBC H */
                 SBC(reg_h, 0, 4, 1);
-                break;
-            case 0x9d: /* SBC L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x9d): /* SBC L */
                 SBC(reg_l, 0, 4, 1);
-                break;
-            case 0x9e: /* SBC (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x9e): /* SBC (HL) */
                 SBC(LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0x9f: /* SBC A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0x9f): /* SBC A */
                 SBC(reg_a, 0, 4, 1);
-                break;
-            case 0xa0: /* AND B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xa0): /* AND B */
                 AND(reg_b, 0, 4, 1);
-                break;
-            case 0xa1: /* AND C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xa1): /* AND C */
                 AND(reg_c, 0, 4, 1);
-                break;
-            case 0xa2: /* AND D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xa2): /* AND D */
                 AND(reg_d, 0, 4, 1);
-                break;
-            case 0xa3: /* AND E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xa3): /* AND E */
                 AND(reg_e, 0, 4, 1);
-                break;
-            case 0xa4: /* AND H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xa4): /* AND H */
                 AND(reg_h, 0, 4, 1);
-                break;
-            case 0xa5: /* AND L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xa5): /* AND L */
                 AND(reg_l, 0, 4, 1);
-                break;
-            case 0xa6: /* AND (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xa6): /* AND (HL) */
                 AND(LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0xa7: /* AND A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xa7): /* AND A */
                 AND(reg_a, 0, 4, 1);
-                break;
-            case 0xa8: /* XOR B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xa8): /* XOR B */
                 XOR(reg_b, 0, 4, 1);
-                break;
-            case 0xa9: /* XOR C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xa9): /* XOR C */
                 XOR(reg_c, 0, 4, 1);
-                break;
-            case 0xaa: /* XOR D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xaa): /* XOR D */
                 XOR(reg_d, 0, 4, 1);
-                break;
-            case 0xab: /* XOR E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xab): /* XOR E */
                 XOR(reg_e, 0, 4, 1);
-                break;
-            case 0xac: /* XOR H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xac): /* XOR H */
                 XOR(reg_h, 0, 4, 1);
-                break;
-            case 0xad: /* XOR L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xad): /* XOR L */
                 XOR(reg_l, 0, 4, 1);
-                break;
-            case 0xae: /* XOR (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xae): /* XOR (HL) */
                 XOR(LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0xaf: /* XOR A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xaf): /* XOR A */
                 XOR(reg_a, 0, 4, 1);
-                break;
-            case 0xb0: /* OR B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xb0): /* OR B */
                 OR(reg_b, 0, 4, 1);
-                break;
-            case 0xb1: /* OR C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xb1): /* OR C */
                 OR(reg_c, 0, 4, 1);
-                break;
-            case 0xb2: /* OR D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xb2): /* OR D */
                 OR(reg_d, 0, 4, 1);
-                break;
-            case 0xb3: /* OR E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xb3): /* OR E */
                 OR(reg_e, 0, 4, 1);
-                break;
-            case 0xb4: /* OR H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xb4): /* OR H */
                 OR(reg_h, 0, 4, 1);
-                break;
-            case 0xb5: /* OR L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xb5): /* OR L */
                 OR(reg_l, 0, 4, 1);
-                break;
-            case 0xb6: /* OR (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xb6): /* OR (HL) */
                 OR(LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0xb7: /* OR A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xb7): /* OR A */
                 OR(reg_a, 0, 4, 1);
-                break;
-            case 0xb8: /* CP B */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xb8): /* CP B */
                 CP(reg_b, 0, 4, 1);
-                break;
-            case 0xb9: /* CP C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xb9): /* CP C */
                 CP(reg_c, 0, 4, 1);
-                break;
-            case 0xba: /* CP D */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xba): /* CP D */
                 CP(reg_d, 0, 4, 1);
-                break;
-            case 0xbb: /* CP E */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xbb): /* CP E */
                 CP(reg_e, 0, 4, 1);
-                break;
-            case 0xbc: /* CP H */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xbc): /* CP H */
                 CP(reg_h, 0, 4, 1);
-                break;
-            case 0xbd: /* CP L */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xbd): /* CP L */
                 CP(reg_l, 0, 4, 1);
-                break;
-            case 0xbe: /* CP (HL) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xbe): /* CP (HL) */
                 CP(LOAD(HL_WORD()), 4, 3, 1);
-                break;
-            case 0xbf: /* CP A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xbf): /* CP A */
                 CP(reg_a, 0, 4, 1);
-                break;
-            case 0xc0: /* RET NZ */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xc0): /* RET NZ */
                 RET_COND(!LOCAL_ZERO(), 4, 4, 2, 5, 1);
-                break;
-            case 0xc1: /* POP BC */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xc1): /* POP BC */
                 POP(reg_b, reg_c, 1);
-                break;
-            case 0xc2: /* JP NZ */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xc2): /* JP NZ */
                 JMP_COND(p12, !LOCAL_ZERO(), 10, 10);
-                break;
-            case 0xc3: /* JP */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xc3): /* JP */
                 JMP(p12, 10);
-                break;
-            case 0xc4: /* CALL NZ */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xc4): /* CALL NZ */
                 CALL_COND(p12, !LOCAL_ZERO(), 3, 3, 4, 10, 3);
-                break;
-            case 0xc5: /* PUSH BC */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xc5): /* PUSH BC */
                 PUSH(reg_b, reg_c, 1);
-                break;
-            case 0xc6: /* ADD # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xc6): /* ADD # */
                 ADD(p1, 4, 3, 2);
-                break;
-            case 0xc7: /* RST 00 */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xc7): /* RST 00 */
                 CALL(0x00, 3, 3, 5, 1);
-                break;
-            case 0xc8: /* RET Z */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xc8): /* RET Z */
                 RET_COND(LOCAL_ZERO(), 4, 4, 2, 5, 1);
-                break;
-            case 0xc9: /* RET */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xc9): /* RET */
                 RET(4, 4, 2);
-                break;
-            case 0xca: /* JP Z */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xca): /* JP Z */
                 JMP_COND(p12, LOCAL_ZERO(), 10, 10);
-                break;
-            case 0xcb: /* OPCODE CB */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xcb): /* OPCODE CB */
                 opcode_cb((uint8_t)p1, (uint8_t)p2, (uint8_t)p3, (uint16_t)p12, (uint16_t)p23);
-                break;
-            case 0xcc: /* CALL Z */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xcc): /* CALL Z */
                 CALL_COND(p12, LOCAL_ZERO(), 3, 3, 4, 10, 3);
-                break;
-            case 0xcd: /* CALL */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xcd): /* CALL */
                 CALL(p12, 3, 3, 11, 3);
-                break;
-            case 0xce: /* ADC # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xce): /* ADC # */
                 ADC(p1, 4, 3, 2);
-                break;
-            case 0xcf: /* RST 08 */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xcf): /* RST 08 */
                 CALL(0x08, 3, 3, 5, 1);
-                break;
-            case 0xd0: /* RET NC */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xd0): /* RET NC */
                 RET_COND(!LOCAL_CARRY(), 4, 4, 2, 5, 1);
-                break;
-            case 0xd1: /* POP DE */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xd1): /* POP DE */
                 POP(reg_d, reg_e, 1);
-                break;
-            case 0xd2: /* JP NC */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xd2): /* JP NC */
                 JMP_COND(p12, !LOCAL_CARRY(), 10, 10);
-                break;
-            case 0xd3: /* OUT A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xd3): /* OUT A */
                 OUTA(p1, 4, 7, 2);
-                break;
-            case 0xd4: /* CALL NC */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xd4): /* CALL NC */
                 CALL_COND(p12, !LOCAL_CARRY(), 3, 3, 4, 10, 3);
-                break;
-            case 0xd5: /* PUSH DE */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xd5): /* PUSH DE */
                 PUSH(reg_d, reg_e, 1);
-                break;
-            case 0xd6: /* SUB # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xd6): /* SUB # */
                 SUB(p1, 4, 3, 2);
-                break;
-            case 0xd7: /* RST 10 */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xd7): /* RST 10 */
                 CALL(0x10, 3, 3, 5, 1);
-                break;
-            case 0xd8: /* RET C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xd8): /* RET C */
                 RET_COND(LOCAL_CARRY(), 4, 4, 2, 5, 1);
-                break;
-            case 0xd9: /* EXX */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xd9): /* EXX */
                 EXX(8, 1);
-                break;
-            case 0xda: /* JP C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xda): /* JP C */
                 JMP_COND(p12, LOCAL_CARRY(), 10, 10);
-                break;
-            case 0xdb: /* IN A */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xdb): /* IN A */
                 INA(p1, 4, 7, 2);
-                break;
-            case 0xdc: /* CALL C */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xdc): /* CALL C */
                 CALL_COND(p12, LOCAL_CARRY(), 3, 3, 4, 10, 3);
-                break;
-            case 0xdd: /*  OPCODE DD */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xdd): /*  OPCODE DD */
                 opcode_dd((uint8_t)p1, (uint8_t)p2, (uint8_t)p3, (uint16_t)p12, (uint16_t)p23);
-                break;
-            case 0xde: /* SBC # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xde): /* SBC # */
                 SBC(p1, 4, 3, 2);
-                break;
-            case 0xdf: /* RST 18 */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xdf): /* RST 18 */
                 CALL(0x18, 3, 3, 5, 1);
-                break;
-            case 0xe0: /* RET PO */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xe0): /* RET PO */
                 RET_COND(!LOCAL_PARITY(), 4, 4, 2, 5, 1);
-                break;
-            case 0xe1: /* POP HL */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xe1): /* POP HL */
                 POP(reg_h, reg_l, 1);
-                break;
-            case 0xe2: /* JP PO */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xe2): /* JP PO */
                 JMP_COND(p12, !LOCAL_PARITY(), 10, 10);
-                break;
-            case 0xe3: /* EX HL (SP) */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xe3): /* EX HL (SP) */
                 EXXXSP(reg_h, reg_l, 4, 4, 4, 4, 3, 1);
-                break;
-            case 0xe4: /* CALL PO */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xe4): /* CALL PO */
                 CALL_COND(p12, !LOCAL_PARITY(), 3, 3, 4, 10, 3);
-                break;
-            case 0xe5: /* PUSH HL */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xe5): /* PUSH HL */
                 PUSH(reg_h, reg_l, 1);
-                break;
-            case 0xe6: /* AND # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xe6): /* AND # */
                 AND(p1, 4, 3, 2);
-                break;
-            case 0xe7: /* RST 20 */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xe7): /* RST 20 */
                 CALL(0x20, 3, 3, 5, 1);
-                break;
-            case 0xe8: /* RET PE */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xe8): /* RET PE */
                 RET_COND(LOCAL_PARITY(), 4, 4, 2, 5, 1);
-                break;
-            case 0xe9: /* LD PC HL */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xe9): /* LD PC HL */
                 JMP((HL_WORD()), 4);
-                break;
-            case 0xea: /* JP PE */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xea): /* JP PE */
                 JMP_COND(p12, LOCAL_PARITY(), 10, 10);
-                break;
-            case 0xeb: /* EX DE HL */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xeb): /* EX DE HL */
                 EXDEHL(4, 1);
-                break;
-            case 0xec: /* CALL PE */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xec): /* CALL PE */
                 CALL_COND(p12, LOCAL_PARITY(), 3, 3, 4, 10, 3);
-                break;
-            case 0xed: /* OPCODE ED */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xed): /* OPCODE ED */
                 opcode_ed((uint8_t)p1, (uint8_t)p2, (uint8_t)p3, (uint16_t)p12, (uint16_t)p23);
-                break;
-            case 0xee: /* XOR # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xee): /* XOR # */
                 XOR(p1, 4, 3, 2);
-                break;
-            case 0xef: /* RST 28 */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xef): /* RST 28 */
                 CALL(0x28, 3, 3, 5, 1);
-                break;
-            case 0xf0: /* RET P */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xf0): /* RET P */
                 RET_COND(!LOCAL_SIGN(), 4, 4, 2, 5, 1);
-                break;
-            case 0xf1: /* POP AF */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xf1): /* POP AF */
                 POP(reg_a, reg_f, 1);
-                break;
-            case 0xf2: /* JP P */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xf2): /* JP P */
                 JMP_COND(p12, !LOCAL_SIGN(), 10, 10);
-                break;
-            case 0xf3: /* DI */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xf3): /* DI */
                 DI(4, 1);
-                break;
-            case 0xf4: /* CALL P */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xf4): /* CALL P */
                 CALL_COND(p12, !LOCAL_SIGN(), 3, 3, 4, 10, 3);
-                break;
-            case 0xf5: /* PUSH AF */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xf5): /* PUSH AF */
                 PUSH(reg_a, reg_f, 1);
-                break;
-            case 0xf6: /* OR # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xf6): /* OR # */
                 OR(p1, 4, 3, 2);
-                break;
-            case 0xf7: /* RST 30 */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xf7): /* RST 30 */
                 CALL(0x30, 3, 3, 5, 1);
-                break;
-            case 0xf8: /* RET M */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xf8): /* RET M */
                 RET_COND(LOCAL_SIGN(), 4, 4, 2, 5, 1);
-                break;
-            case 0xf9: /* LD SP HL */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xf9): /* LD SP HL */
                 LDSP(HL_WORD(), 4, 2, 1);
-                break;
-            case 0xfa: /* JP M */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xfa): /* JP M */
                 JMP_COND(p12, LOCAL_SIGN(), 10, 10);
-                break;
-            case 0xfb: /* EI */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xfb): /* EI */
                 EI(4, 1);
-                break;
-            case 0xfc: /* CALL M */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xfc): /* CALL M */
                 CALL_COND(p12, LOCAL_SIGN(), 3, 3, 4, 10, 3);
-                break;
-            case 0xfd: /* OPCODE FD */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xfd): /* OPCODE FD */
                 opcode_fd((uint8_t)p1, (uint8_t)p2, (uint8_t)p3, (uint16_t)p12, (uint16_t)p23);
-                break;
-            case 0xfe: /* CP # */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xfe): /* CP # */
                 CP(p1, 4, 3, 2);
-                break;
-            case 0xff: /* RST 38 */
+                OPCODE_NEXT;
+            OPCODE_CASE(0xff): /* RST 38 */
                 CALL(0x38, 3, 3, 5, 1);
-                break;
-        }
+                OPCODE_NEXT;
+        } OPCODE_SWITCH_END
 
         cpu_int_status->num_dma_per_opcode = 0;
     } while (Z80_LOOP_COND);
 
+#ifdef OPCODE_CHAINING
+opcode_done:
+#endif
     export_registers();
 }
@@ -34,6 +34,7 @@
 #include "vice.h"
 
 #include <ctype.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -46,14 +47,19 @@
 #ifdef HAVE_ZLIB
 #include <zlib.h>
 #endif
+#ifdef HAVE_LIBBZ2
+#include <bzlib.h>
+#endif
 
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
 #endif
 
 #include "archdep.h"
+#include "crc32.h"
 #include "lib.h"
 #include "log.h"
+#include "mediacache.h"
 #include "util.h"
 #include "zipcode.h"
 
@@ -93,6 +99,10 @@ struct zfile_s {
     struct zfile_s *prev, *next; /* Link to the previous and next nodes.  */
     zfile_action_t action;       /* action on close */
     char *request_string;        /* ui string for action=ZFILE_REQUEST */
+    uint8_t *buffer;             /* Uncompressed data behind a memory stream.  */
+    int have_crc;                /* Non-zero if `size' and `crc' are valid.  */
+    size_t size;                 /* Size of the uncompressed data.  */
+    uint32_t crc;                /* CRC32 of the uncompressed data.  */
 };
 typedef struct zfile_s zfile_t;
 
@@ -100,6 +110,12 @@ static zfile_t *zfile_list = NULL;
 
 static log_t zlog = LOG_ERR;
 
+/* Granularity used when uncompressing into memory.  */
+#define ZFILE_CHUNK_SIZE    0x10000
+
+/* Sanity limit for the size hint found in the gzip trailer.  */
+#define ZFILE_MAX_SIZE_HINT 0x10000000
+
 /* ------------------------------------------------------------------------- */
 
 static int zinit_done = 0;
@@ -127,6 +143,17 @@ static int file_is_gzip(const char *name)
 }
 
 
+/* Check whether the name sounds like a bzipped file by checking the
+   extension.  UNIX variants of bzip v2 use the extension '.bz2'.  bzip v1
+   is obsolete.  */
+static int file_is_bzip(const char *name)
+{
+    size_t l = strlen(name);
+
+    return l >= 5 && util_strcasecmp(name + l - 4, ".bz2") == 0;
+}
+
+
 static void zfile_list_destroy(void)
 {
     zfile_t *p;
@@ -136,6 +163,7 @@ static void zfile_list_destroy(void)
 
         lib_free(p->orig_name);
         lib_free(p->tmp_name);
+        lib_free(p->buffer);
         next = p->next;
         lib_free(p);
         p = next;
@@ -157,8 +185,8 @@ static int zinit(void)
 }
 
 /* Add one zfile to the list.  `orig_name' is automatically expanded to the
-   complete path.  */
-static void zfile_list_add(const char *tmp_name,
+   complete path.  Return the new list item.  */
+static zfile_t *zfile_list_add(const char *tmp_name,
                            const char *orig_name,
                            enum compression_type type,
                            int write_mode,
@@ -177,12 +205,18 @@ static void zfile_list_add(const char *tmp_name,
     new_zfile->type = type;
     new_zfile->action = ZFILE_KEEP;
     new_zfile->request_string = NULL;
+    new_zfile->buffer = NULL;
+    new_zfile->have_crc = 0;
+    new_zfile->size = 0;
+    new_zfile->crc = 0;
     new_zfile->next = zfile_list;
     new_zfile->prev = NULL;
     if (zfile_list != NULL) {
         zfile_list->prev = new_zfile;
     }
     zfile_list = new_zfile;
+
+    return new_zfile;
 }
 
 void zfile_shutdown(void)
@@ -194,55 +228,94 @@ void zfile_shutdown(void)
 
 /* Uncompression.  */
 
-/* If `name' has a gzip-like extension, try to uncompress it into a temporary
-   file using gzip or zlib if available.  If this succeeds, return the name
-   of the temporary file; return NULL otherwise.  */
-static char *try_uncompress_with_gzip(const char *name)
+#if defined(HAVE_ZLIB) || defined(HAVE_LIBBZ2)
+/* Make sure `*buf' has room for at least one more byte after `len'.  */
+static void grow_buffer(uint8_t **buf, size_t *alloc, size_t len)
 {
+    if (len == *alloc) {
+        *alloc *= 2;
+        *buf = lib_realloc(*buf, *alloc);
+    }
+}
+#endif
+
 #ifdef HAVE_ZLIB
-    FILE *fddest;
-    gzFile fdsrc;
-    char *tmp_name = NULL;
-    int len;
+/* Guess the uncompressed size of gzip file `name' from the ISIZE field of
+   its trailer, so the whole file can usually be read with one allocation.  */
+static size_t gzip_size_hint(const char *name)
+{
+    FILE *fd;
+    uint8_t trailer[4];
+    size_t hint = ZFILE_CHUNK_SIZE;
 
-    if (!file_is_gzip(name)) {
-        return NULL;
+    fd = fopen(name, MODE_READ);
+    if (fd == NULL) {
+        return hint;
     }
+    if (fseek(fd, -4, SEEK_END) == 0 && fread(trailer, 1, 4, fd) == 4) {
+        size_t isize = (size_t)trailer[0] | ((size_t)trailer[1] << 8)
+                       | ((size_t)trailer[2] << 16) | ((size_t)trailer[3] << 24);
 
-    fddest = archdep_mkstemp_fd(&tmp_name, MODE_WRITE);
-
-    if (fddest == NULL) {
-        return NULL;
+        /* One extra byte so the final read hitting EOF needs no realloc.  */
+        if (isize >= hint && isize < ZFILE_MAX_SIZE_HINT) {
+            hint = isize + 1;
+        }
     }
+    fclose(fd);
+
+    return hint;
+}
+
+/* Uncompress gzip file `name' into memory.  Return the data, which must be
+   freed with `lib_free()', and store its size in `size'; return NULL on
+   error.  */
+static uint8_t *uncompress_gzip_to_memory(const char *name, size_t *size)
+{
+    gzFile fdsrc;
+    uint8_t *buf;
+    size_t alloc, len = 0;
+    int n;
 
     fdsrc = gzopen(name, MODE_READ);
     if (fdsrc == NULL) {
-        fclose(fddest);
-        archdep_remove(tmp_name);
-        lib_free(tmp_name);
         return NULL;
     }
+    gzbuffer(fdsrc, ZFILE_CHUNK_SIZE);
+
+    alloc = gzip_size_hint(name);
+    buf = lib_malloc(alloc);
 
     do {
-        char buf[256];
+        size_t want;
 
-        len = gzread(fdsrc, (void *)buf, 256);
-        if (len > 0) {
-            if (fwrite((void *)buf, 1, (size_t)len, fddest) < len) {
-                gzclose(fdsrc);
-                fclose(fddest);
-                archdep_remove(tmp_name);
-                lib_free(tmp_name);
-                return NULL;
-            }
+        grow_buffer(&buf, &alloc, len);
+        want = alloc - len;
+        if (want > INT_MAX) {
+            want = INT_MAX;
+        }
+        n = gzread(fdsrc, buf + len, (unsigned int)want);
+        if (n > 0) {
+            len += (size_t)n;
         }
-    } while (len > 0);
+    } while (n > 0);
 
     gzclose(fdsrc);
-    fclose(fddest);
 
-    return tmp_name;
+    if (n < 0) {
+        ZDEBUG(("uncompress_gzip_to_memory: gzread failed"));
+        lib_free(buf);
+        return NULL;
+    }
+
+    *size = len;
+    return buf;
+}
 #else
+/* If `name' has a gzip-like extension, try to uncompress it into a temporary
+   file using gzip.  If this succeeds, return the name of the temporary file;
+   return NULL otherwise.  */
+static char *try_uncompress_with_gzip(const char *name)
+{
     char *tmp_name = NULL;
     int exit_status;
     char *argv[4];
@@ -273,23 +346,94 @@ static char *try_uncompress_with_gzip(const char *name)
         lib_free(tmp_name);
         return NULL;
     }
-#endif
 }
+#endif
 
+#ifdef HAVE_LIBBZ2
+/* Uncompress bzip2 file `name' into memory.  Return the data, which must be
+   freed with `lib_free()', and store its size in `size'; return NULL on
+   error.  Concatenated streams, as written by parallel bzip2 tools, are
+   handled like `bzip2 -d' does.  */
+static uint8_t *uncompress_bzip_to_memory(const char *name, size_t *size)
+{
+    FILE *fdsrc;
+    BZFILE *bz;
+    uint8_t *buf;
+    uint8_t unused[BZ_MAX_UNUSED];
+    int nunused = 0;
+    size_t alloc = ZFILE_CHUNK_SIZE, len = 0;
+    int streams = 0;
+    int bzerror;
+
+    fdsrc = fopen(name, MODE_READ);
+    if (fdsrc == NULL) {
+        return NULL;
+    }
+
+    buf = lib_malloc(alloc);
+
+    do {
+        void *rest;
+        int nrest;
+
+        bz = BZ2_bzReadOpen(&bzerror, fdsrc, 0, 0, unused, nunused);
+        if (bzerror != BZ_OK) {
+            break;
+        }
+        do {
+            size_t want;
+            int n;
+
+            grow_buffer(&buf, &alloc, len);
+            want = alloc - len;
+            if (want > INT_MAX) {
+                want = INT_MAX;
+            }
+            n = BZ2_bzRead(&bzerror, bz, buf + len, (int)want);
+            if (bzerror == BZ_OK || bzerror == BZ_STREAM_END) {
+                len += (size_t)n;
+            }
+        } while (bzerror == BZ_OK);
+
+        if (bzerror != BZ_STREAM_END) {
+            /* Like bzip2, ignore trailing garbage after the first stream.  */
+            int error = (bzerror == BZ_DATA_ERROR_MAGIC && streams > 0)
+                        ? BZ_OK : BZ_DATA_ERROR;
+            BZ2_bzReadClose(&bzerror, bz);
+            bzerror = error;
+            break;
+        }
+        streams++;
+
+        /* Keep what was read beyond the end of this stream for the next.  */
+        BZ2_bzReadGetUnused(&bzerror, bz, &rest, &nrest);
+        memcpy(unused, rest, (size_t)nrest);
+        nunused = nrest;
+        BZ2_bzReadClose(&bzerror, bz);
+    } while (nunused > 0 || (!feof(fdsrc) && ungetc(getc(fdsrc), fdsrc) != EOF));
+
+    fclose(fdsrc);
+
+    if (bzerror != BZ_OK) {
+        ZDEBUG(("uncompress_bzip_to_memory: failed"));
+        lib_free(buf);
+        return NULL;
+    }
+
+    *size = len;
+    return buf;
+}
+#else
 /* If `name' has a bzip-like extension, try to uncompress it into a temporary
    file using bzip.  If this succeeds, return the name of the temporary file;
    return NULL otherwise.  */
 static char *try_uncompress_with_bzip(const char *name)
 {
     char *tmp_name = NULL;
-    size_t l = strlen(name);
     int exit_status;
     char *argv[4];
 
-    /* Check whether the name sounds like a bzipped file by checking the
-       extension.  UNIX variants of bzip v2 use the extension
-       '.bz2'.  bzip v1 is obsolete.  */
-    if (l < 5 || util_strcasecmp(name + l - 4, ".bz2") != 0) {
+    if (!file_is_bzip(name)) {
         return NULL;
     }
 
@@ -316,6 +460,7 @@ static char *try_uncompress_with_bzip(const char *name)
         return NULL;
     }
 }
+#endif
 
 static char *try_uncompress_with_tzx(const char *name)
 {
@@ -774,18 +919,70 @@ static const valid_archives_t valid_archives[] = {
     { NULL, NULL, NULL, NULL, NULL }
 };
 
+/* Check whether `name' looks like a file `try_uncompress()' can handle by
+   its extension alone.  Only such files are looked up in the media cache,
+   so plain images do not have to be hashed.  */
+static int file_is_cacheable(const char *name)
+{
+    size_t l = strlen(name);
+    int i;
+
+    if (file_is_gzip(name) || file_is_bzip(name)
+        || (l >= 4 && util_strcasecmp(name + l - 4, ".tzx") == 0)) {
+        return 1;
+    }
+    for (i = 0; valid_archives[i].program; i++) {
+        size_t len = strlen(valid_archives[i].extension);
+
+        if (l > len && util_strcasecmp(name + l - len, valid_archives[i].extension) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Store the uncompressed contents of temporary file `tmp_name' in the media
+   cache.  */
+static void cache_store_file(const char *key, enum compression_type type,
+                             const char *tmp_name)
+{
+    FILE *fd;
+    uint8_t *data;
+    off_t len;
+
+    fd = fopen(tmp_name, MODE_READ);
+    if (fd == NULL) {
+        return;
+    }
+    len = archdep_file_size(fd);
+    if (len > 0) {
+        data = lib_malloc((size_t)len);
+        if (fread(data, (size_t)len, 1, fd) == 1) {
+            mediacache_put(key, (uint32_t)type, data, (size_t)len);
+        }
+        lib_free(data);
+    }
+    fclose(fd);
+}
+
 /* Try to uncompress file `name' using the algorithms we know of.  If this is
-   not possible, return `COMPR_NONE'.  Otherwise, uncompress the file into a
-   temporary file, return the type of algorithm used and the name of the
-   temporary file in `tmp_name'.  If `write_mode' is non-zero and the
-   returned `tmp_name' has zero length, then the file cannot be accessed in
-   write mode.  */
+   not possible, return `COMPR_NONE'.  Otherwise, return the type of
+   algorithm used, and either uncompress the file into memory and return the
+   data in `data' and `size', or uncompress the file into a temporary file
+   and return the name of the temporary file in `tmp_name'.  If `write_mode'
+   is non-zero and the returned `tmp_name' has zero length, then the file
+   cannot be accessed in write mode.  */
 static enum compression_type try_uncompress(const char *name,
                                             char **tmp_name,
+                                            uint8_t **data,
+                                            size_t *size,
                                             int write_mode)
 {
     int i;
 
+    *tmp_name = NULL;
+    *data = NULL;
+
     for (i = 0; valid_archives[i].program; i++) {
         if ((*tmp_name = try_uncompress_archive(name, write_mode,
                                                 valid_archives[i].program,
@@ -799,13 +996,27 @@ static enum compression_type try_uncompress(const char *name,
     }
 
     /* need this order or .tar.gz is misunderstood */
+#ifdef HAVE_ZLIB
+    if (file_is_gzip(name)
+        && (*data = uncompress_gzip_to_memory(name, size)) != NULL) {
+        return COMPR_GZIP;
+    }
+#else
     if ((*tmp_name = try_uncompress_with_gzip(name)) != NULL) {
         return COMPR_GZIP;
     }
+#endif
 
+#ifdef HAVE_LIBBZ2
+    if (file_is_bzip(name)
+        && (*data = uncompress_bzip_to_memory(name, size)) != NULL) {
+        return COMPR_BZIP;
+    }
+#else
     if ((*tmp_name = try_uncompress_with_bzip(name)) != NULL) {
         return COMPR_BZIP;
     }
+#endif
 
     if ((*tmp_name = try_uncompress_zipcode(name, write_mode)) != NULL) {
         return COMPR_ZIPCODE;
@@ -832,33 +1043,41 @@ static int compress_with_gzip(const char *src, const char *dest)
 #ifdef HAVE_ZLIB
     FILE *fdsrc;
     gzFile fddest;
+    uint8_t *buf;
     size_t len;
+    int retval = 0;
 
-    fdsrc = fopen(dest, MODE_READ);
+    fdsrc = fopen(src, MODE_READ);
     if (fdsrc == NULL) {
         return -1;
     }
 
-    fddest = gzopen(src, MODE_WRITE "9");
+    fddest = gzopen(dest, MODE_WRITE "9");
     if (fddest == NULL) {
         fclose(fdsrc);
         return -1;
     }
 
+    buf = lib_malloc(ZFILE_CHUNK_SIZE);
     do {
-        char buf[256];
-        len = fread((void *)buf, 256, 1, fdsrc);
-        if (len > 0) {
-            gzwrite(fddest, (void *)buf, (unsigned int)len);
+        len = fread(buf, 1, ZFILE_CHUNK_SIZE, fdsrc);
+        if (len > 0 && gzwrite(fddest, buf, (unsigned int)len) != (int)len) {
+            retval = -1;
         }
-    } while (len > 0);
+    } while (len > 0 && retval == 0);
+    lib_free(buf);
 
-    gzclose(fddest);
+    if (ferror(fdsrc)) {
+        retval = -1;
+    }
+    if (gzclose(fddest) != Z_OK) {
+        retval = -1;
+    }
     fclose(fdsrc);
 
-    ZDEBUG(("compress with zlib: OK."));
+    ZDEBUG(("compress with zlib: %s.", retval == 0 ? "OK" : "failed"));
 
-    return 0;
+    return retval;
 #else
     static char *argv[4];
     int exit_status;
@@ -894,6 +1113,61 @@ static int compress_with_gzip(const char *src, const char *dest)
 /* Compress `src' into `dest' using bzip.  */
 static int compress_with_bzip(const char *src, const char *dest)
 {
+#ifdef HAVE_LIBBZ2
+    FILE *fdsrc;
+    FILE *fddest;
+    BZFILE *bz;
+    uint8_t *buf;
+    size_t len;
+    int bzerror;
+    int retval = 0;
+
+    fdsrc = fopen(src, MODE_READ);
+    if (fdsrc == NULL) {
+        return -1;
+    }
+
+    fddest = fopen(dest, MODE_WRITE);
+    if (fddest == NULL) {
+        fclose(fdsrc);
+        return -1;
+    }
+
+    bz = BZ2_bzWriteOpen(&bzerror, fddest, 9, 0, 0);
+    if (bzerror != BZ_OK) {
+        fclose(fddest);
+        fclose(fdsrc);
+        return -1;
+    }
+
+    buf = lib_malloc(ZFILE_CHUNK_SIZE);
+    do {
+        len = fread(buf, 1, ZFILE_CHUNK_SIZE, fdsrc);
+        if (len > 0) {
+            BZ2_bzWrite(&bzerror, bz, buf, (int)len);
+            if (bzerror != BZ_OK) {
+                retval = -1;
+            }
+        }
+    } while (len > 0 && retval == 0);
+    lib_free(buf);
+
+    if (ferror(fdsrc)) {
+        retval = -1;
+    }
+    BZ2_bzWriteClose(&bzerror, bz, retval, NULL, NULL);
+    if (bzerror != BZ_OK) {
+        retval = -1;
+    }
+    if (fclose(fddest) != 0) {
+        retval = -1;
+    }
+    fclose(fdsrc);
+
+    ZDEBUG(("compress with libbz2: %s.", retval == 0 ? "OK" : "failed"));
+
+    return retval;
+#else
     char *argv[4];
     int exit_status;
     char *mdest;
@@ -922,6 +1196,7 @@ static int compress_with_bzip(const char *src, const char *dest)
         ZDEBUG(("compress_with_bzip: failed."));
         return -1;
     }
+#endif
 }
 
 /* Compress `src' into `dest' using algorithm `type'.  */
@@ -1029,12 +1304,112 @@ static int zfile_compress(const char *src, const char *dest,
    opened, we check whether it looks like a compressed file of some kind.
    If so, we uncompress it and then actually open the uncompressed version.
    When a file that was opened for writing is closed, we re-compress the
-   uncompressed version and update the original file.  */
+   uncompressed version and update the original file.
+
+   Where the compression library is available, files are uncompressed into
+   memory.  Read-only files are then handed out as memory streams, so no
+   temporary file is needed at all.  Files opened for writing still get a
+   temporary file, but it is only re-compressed if its contents actually
+   changed.  */
+
+/* Write `size' bytes of `data' to a new temporary file and return its name,
+   or NULL on error.  */
+static char *memory_to_tmpfile(const uint8_t *data, size_t size)
+{
+    char *tmp_name = NULL;
+    FILE *fd;
+
+    fd = archdep_mkstemp_fd(&tmp_name, MODE_WRITE);
+    if (fd == NULL) {
+        return NULL;
+    }
+
+    if (size > 0 && fwrite(data, 1, size, fd) < size) {
+        fclose(fd);
+        archdep_remove(tmp_name);
+        lib_free(tmp_name);
+        return NULL;
+    }
+    if (fclose(fd) != 0) {
+        archdep_remove(tmp_name);
+        lib_free(tmp_name);
+        return NULL;
+    }
+
+    return tmp_name;
+}
+
+/* Open the uncompressed `data' of `name' with `mode'.  Ownership of `data'
+   is taken over.  */
+static FILE *zfile_open_memory(const char *name, const char *mode,
+                               enum compression_type type, int write_mode,
+                               uint8_t *data, size_t size)
+{
+    zfile_t *z;
+    char *tmp_name;
+    FILE *stream;
+    uint32_t crc;
+
+#ifdef HAVE_FMEMOPEN
+    /* A zero-sized buffer is rejected by some fmemopen() implementations.  */
+    if (!write_mode && size > 0) {
+        stream = fmemopen(data, size, mode);
+        if (stream != NULL) {
+            z = zfile_list_add(NULL, name, type, write_mode, stream, NULL);
+            z->buffer = data;
+            return stream;
+        }
+        ZDEBUG(("zfile_open_memory: fmemopen failed, using temporary file"));
+    }
+#endif
+
+    tmp_name = memory_to_tmpfile(data, size);
+    crc = crc32_buf((const char *)data, (unsigned int)size);
+    lib_free(data);
+    if (tmp_name == NULL) {
+        return NULL;
+    }
+
+    stream = fopen(tmp_name, mode);
+    if (stream == NULL) {
+        archdep_remove(tmp_name);
+        lib_free(tmp_name);
+        return NULL;
+    }
+
+    z = zfile_list_add(tmp_name, name, type, write_mode, stream, NULL);
+    z->have_crc = 1;
+    z->size = size;
+    z->crc = crc;
+    lib_free(tmp_name);
+
+    return stream;
+}
+
+/* Check whether the temporary file of `ptr' still holds the data that was
+   uncompressed when it was opened.  */
+static int zfile_unchanged(zfile_t *ptr)
+{
+    size_t size;
+    unsigned int isdir;
+
+    if (!ptr->have_crc) {
+        return 0;
+    }
+    if (archdep_stat(ptr->tmp_name, &size, &isdir) < 0 || size != ptr->size) {
+        return 0;
+    }
+    return crc32_file(ptr->tmp_name) == ptr->crc;
+}
 
 /* `fopen()' wrapper.  */
 FILE *zfile_fopen(const char *name, const char *mode)
 {
     char *tmp_name;
+    uint8_t *data = NULL;
+    size_t size = 0;
+    char *cache_key = NULL;
+    uint32_t tag;
     FILE *stream;
     enum compression_type type;
     int write_mode = 0;
@@ -1057,7 +1432,36 @@ FILE *zfile_fopen(const char *name, const char *mode)
         return NULL;
     }
 
-    type = try_uncompress(name, &tmp_name, write_mode);
+    /* Files that take some effort to uncompress may be in the media cache,
+       keyed by a hash of the compressed file.  */
+    if (mediacache_enabled() && file_is_cacheable(name)) {
+        cache_key = mediacache_key_from_file("z", name);
+    }
+    if (cache_key != NULL
+        && (data = mediacache_get(cache_key, &tag, &size)) != NULL
+        && tag > COMPR_NONE && tag <= COMPR_TZX) {
+        ZDEBUG(("zfile_fopen: `%s' found in media cache", name));
+        lib_free(cache_key);
+        type = (enum compression_type)tag;
+        /* Only gzip and bzip files can be written back, see zfile_compress.  */
+        if (write_mode && type != COMPR_GZIP && type != COMPR_BZIP) {
+            lib_free(data);
+            errno = EACCES;
+            return NULL;
+        }
+        return zfile_open_memory(name, mode, type, write_mode, data, size);
+    }
+    lib_free(data);
+
+    type = try_uncompress(name, &tmp_name, &data, &size, write_mode);
+    if (cache_key != NULL) {
+        if (data != NULL) {
+            mediacache_put(cache_key, (uint32_t)type, data, size);
+        } else if (tmp_name != NULL && *tmp_name != '\0') {
+            cache_store_file(cache_key, type, tmp_name);
+        }
+        lib_free(cache_key);
+    }
     if (type == COMPR_NONE) {
         stream = fopen(name, mode);
         if (stream == NULL) {
@@ -1065,6 +1469,8 @@ FILE *zfile_fopen(const char *name, const char *mode)
         }
         zfile_list_add(NULL, name, type, write_mode, stream, NULL);
         return stream;
+    } else if (data != NULL) {
+        return zfile_open_memory(name, mode, type, write_mode, data, size);
     } else if (*tmp_name == '\0') {
         errno = EACCES;
         return NULL;
@@ -1117,11 +1523,14 @@ static int handle_close(zfile_t *ptr)
             ptr->orig_name, ptr->write_mode));
 
     if (ptr->tmp_name) {
-        /* Recompress into the original file.  */
-        if (ptr->orig_name
-            && ptr->write_mode
-            && zfile_compress(ptr->tmp_name, ptr->orig_name, ptr->type)) {
-            return -1;
+        /* Recompress into the original file, unless nothing was changed.  */
+        if (ptr->orig_name && ptr->write_mode) {
+            if (zfile_unchanged(ptr)) {
+                ZDEBUG(("handle_close: `%s' unchanged, not recompressing",
+                        ptr->orig_name));
+            } else if (zfile_compress(ptr->tmp_name, ptr->orig_name, ptr->type)) {
+                return -1;
+            }
         }
 
         /* Remove temporary file.  */
@@ -1152,6 +1561,9 @@ static int handle_close(zfile_t *ptr)
     if (ptr->request_string) {
         lib_free(ptr->request_string);
     }
+    if (ptr->buffer) {
+        lib_free(ptr->buffer);
+    }
 
     lib_free(ptr);
 
@@ -1187,6 +1599,20 @@ int zfile_fclose(FILE *stream)
     return fclose(stream);
 }
 
+/* Is `stream' the named file itself, rather than an uncompressed copy of
+   it that is compressed again on close?  */
+int zfile_is_plain(FILE *stream)
+{
+    zfile_t *ptr;
+
+    for (ptr = zfile_list; ptr != NULL; ptr = ptr->next) {
+        if (ptr->stream == stream) {
+            return ptr->type == COMPR_NONE;
+        }
+    }
+    return 0;
+}
+
 int zfile_close_action(const char *filename, zfile_action_t action,
                        const char *request_str)
 {
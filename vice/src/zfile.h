@@ -39,6 +39,7 @@ typedef enum {
 
 FILE *zfile_fopen(const char *name, const char *mode);
 int zfile_fclose(FILE *stream);
+int zfile_is_plain(FILE *stream);
 
 void zfile_shutdown(void);
 